@@ -29,6 +29,175 @@ struct CameraSettings {
     bool dcw = true;
     bool colorbar = false;
     int ledDelayMillis = 100;
+    int photoProfile = 0;        // Camera profile for stills: 0=photo, 1=video, 2=night, 3=inference
+    int videoProfile = 1;        // Camera profile for recordings (same numbering)
+    int xclkMHz = 20;            // Sensor clock for stills (fbCount above is the stills buffer count) - set by tune_camera
+    bool fbInPsram = true;       // Stills frame buffers in PSRAM (false = internal DRAM)
+    int videoFbCount = 2;        // Driver configuration used while VideoRecorder runs; the camera is
+    int videoXclkMHz = 20;       // only re-initialised for video when it differs from the stills one
+    bool videoFbInPsram = true;
+};
+
+// Camera-based motion trigger - synced via MQTT/BLE and persisted to NVS
+struct VisualMotionSettings {
+    bool enabled = false;
+    int fps = 2;               // 1-5 frames sampled per second
+    int roiX = 0;              // Region of interest, percent of the frame
+    int roiY = 0;
+    int roiWidth = 100;
+    int roiHeight = 100;
+    int blockDelta = 10;       // Mean luma change for a 32x32 pixel block to count as changed
+    int minBlocks = 3;         // Changed blocks needed to raise a motion event
+    int maxCpuPercent = 15;    // Sampling is slowed down if it would take more CPU than this
+};
+
+// Capture and upload pipeline settings - synced via MQTT/BLE and persisted to
+// NVS as one blob (see PipelineSettingsRegistry). CameraSettings holds only the
+// sensor, its driver configuration and the profile choice.
+struct PipelineSettings {
+    int preTriggerFrames = 0;    // Pre-trigger ring depth: 0 = off, up to 16 frames held in PSRAM
+    int preTriggerFps = 2;       // 1-10 capture rate for the pre-trigger ring
+    int preTriggerSlotKB = 256;  // Max JPEG size per ring slot; ring uses frames x slot KB of PSRAM
+    int cropX = 0;               // Upload region of interest, percent of the frame (SD keeps the full frame)
+    int cropY = 0;
+    int cropWidth = 100;
+    int cropHeight = 100;
+    int uploadTargetKB = 0;      // Adaptive quality: fixed upload size budget (0 = not set)
+    int uploadTargetMs = 0;      // Adaptive quality: budget from measured upload throughput (0 = not set)
+    int burstFrames = 1;         // PIR captures: frames grabbed back to back, sharpest uploaded (1 = single shot, max 5)
+    int burstBudgetMs = 1000;    // Time limit for a burst, including scoring
+    bool dualCapture = false;    // Detections decide on an inference-profile frame; a full frame is taken for the archive afterwards
+    bool archiveUpload = false;  // Upload the archived full frame (?mode=archive) once the main loop is idle
+    bool responseSidecar = false; // Also write each inference response to a .txt next to the image (pre-APP10 layout)
+    bool qualityGate = false;    // Check flash frames for damage and exposure before they are used
+    int gateRecaptures = 2;      // Fresh frames tried when one fails the quality gate (0-3)
+    int uploadTranscodeQuality = 0;  // Uploads requantised to this IJG quality (1-100) with per-image Huffman tables; 0 = send the camera's bytes
+    int inferenceCacheTtlS = 0;  // Reuse an inference result for a near-identical frame this long after the server answered (0 = off)
+    int inferenceCacheDistance = 6; // Perceptual hash bits (of 64) two frames may differ by and still match
+    int daylightCapture = 0;     // Stills without flash or warm-up when bright: 0=off (always flash), 1=when the light sensor (PCF8574 P1) reads bright, 2=always try
+    int daylightMinLuma = 70;    // Mean luma (0-255) a no-flash frame needs to be used
+    int localInference = 0;      // On-device model (SPIFFS /model.bbm): 0=off, 1=fallback when the cloud fails, 2=primary, 3=shadow (compare with the cloud)
+    int idleStandbyS = 0;        // Sensor standby after this long without a capture (0 = never); camera motion detection keeps it awake
+    bool uploadHashOverlap = true; // Hash uploads on the other core while connecting (false = hash, then connect - for comparison)
+
+    // Set with set_change_gate / set_visual_motion rather than set_setting
+    bool changeGate = false;            // Skip inference uploads when the scene is unchanged
+    float changeGateThreshold = 0.02f;  // Fraction of 8x8 luma cells that must change (0-1)
+    VisualMotionSettings visualMotion;
+};
+
+// Adaptive JPEG quality controller state - reported by get_camera_settings
+struct JpegQualityStatus {
+    static constexpr int HISTOGRAM_BUCKETS = 6;
+
+    bool active = false;             // False = jpegQuality is used as-is
+    int quality = 10;                // Quality currently set on the sensor
+    unsigned long targetBytes = 0;   // Current budget (fixed, or derived from throughput)
+    unsigned long throughputBps = 0; // Smoothed upload throughput (bytes/s, 0 = not measured)
+    unsigned long lastBytes = 0;
+    unsigned long lastUploadMs = 0;
+    unsigned long uploads = 0;
+    unsigned int sizeHistogram[HISTOGRAM_BUCKETS] = {};     // <32K, <64K, <128K, <256K, <512K, more
+    unsigned int latencyHistogram[HISTOGRAM_BUCKETS] = {};  // <0.5s, <1s, <2s, <4s, <8s, more
+};
+
+// Frame quality gate counters (copied from the capture controller) - reported by get_status
+struct FrameGateStatus {
+    static constexpr int VERDICT_COUNT = 5;
+
+    unsigned long checked = 0;
+    unsigned long verdicts[VERDICT_COUNT] = {};  // ok, truncated, corrupt, dark, blown_out
+    unsigned long recaptures = 0;
+    unsigned long recovered = 0;     // A recapture passed after a failed frame
+    unsigned long gaveUp = 0;        // Recaptures used up (badly exposed frames are still used)
+    unsigned long meanCostUs = 0;
+    unsigned long maxCostUs = 0;
+};
+
+// Upload transcoder counters (copied from the capture controller) - reported by get_status
+struct UploadTranscodeStatus {
+    unsigned long frames = 0;
+    unsigned long failures = 0;      // Uploaded untranscoded instead
+    unsigned long bytesIn = 0;
+    unsigned long bytesOut = 0;
+    unsigned long meanCostUs = 0;
+    unsigned long maxCostUs = 0;
+};
+
+// Inference result cache counters (copied from the capture controller) - reported by get_status
+struct InferenceCacheStatus {
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    unsigned long latencySavedMs = 0;  // Server latency of the uploads that hits stood in for
+    int entries = 0;                   // Live entries after the last lookup
+    int lastDistance = -1;             // Hash distance of the last hit (-1 = none yet)
+};
+
+// Still-capture lighting policy (copied from the capture controller) - reported by get_status
+struct CapturePolicyStatus {
+    unsigned long daylightFrames = 0;    // Taken without flash or warm-up
+    unsigned long flashFrames = 0;
+    unsigned long daylightRejected = 0;  // Tried without flash, too dark - flash used
+    unsigned long meanDaylightMs = 0;    // Capture start to frame in hand
+    unsigned long meanFlashMs = 0;
+    int lastLuma = -1;                   // Mean luma of the last no-flash frame
+    bool lightSensorBright = false;      // Last light sensor reading
+};
+
+// Camera idle standby (copied from the capture controller) - reported by get_status
+struct CameraStandbyStatus {
+    bool asleep = false;
+    unsigned long standbys = 0;          // Times the sensor was put in standby
+    unsigned long fastResumes = 0;       // Woken by clearing the power-down bit
+    unsigned long fullResumes = 0;       // Needed a driver restart
+    unsigned long lastResumeMs = 0;      // Resume to first valid frame
+    unsigned long meanResumeMs = 0;      // Fast resumes only
+    unsigned long maxResumeMs = 0;
+    unsigned long asleepSeconds = 0;     // Completed standby periods
+};
+
+// Shared HTTPS connection to the API host (copied from ApiConnection) - reported by get_status
+struct ApiConnectionStatus {
+    unsigned long requests = 0;
+    unsigned long handshakes = 0;        // New TCP + TLS connections
+    unsigned long resumedHandshakes = 0; // ...of which resumed a saved TLS session
+    unsigned long reused = 0;            // Requests sent on a warm connection
+    unsigned long staleRetries = 0;      // Warm connection already closed by the server - request repeated
+    unsigned long memoryCloses = 0;      // Not kept open because internal RAM was short
+    unsigned long dnsLookups = 0;
+    unsigned long dnsCacheHits = 0;
+    unsigned long lastConnectMs = 0;     // DNS + TCP + TLS spent on the last request (0 = reused)
+    unsigned long meanConnectMs = 0;     // Per request, reused ones counting 0
+    unsigned long meanHandshakeMs = 0;   // Per new connection
+    bool warm = false;                   // A connection is open now
+};
+
+// Upload payload hashing and time to the first byte on the wire (copied from
+// the capture controller) - reported by get_status
+struct UploadHashStatus {
+    unsigned long fromCapture = 0;         // Hashed in the same pass as the frame copy
+    unsigned long overlapped = 0;          // Hashed on the other core while connecting
+    unsigned long serial = 0;              // Hashed, then connected
+    unsigned long lastHashWaitMs = 0;      // Upload held up by hashing
+    unsigned long lastFirstByteMs = 0;     // Upload start to the first request byte sent
+    unsigned long meanFirstByteCaptureMs = 0;
+    unsigned long meanFirstByteOverlapMs = 0;
+    unsigned long meanFirstByteSerialMs = 0;
+};
+
+// On-device classifier counters (copied from the capture controller) - reported by get_status
+struct LocalInferenceStatus {
+    int mode = 0;                      // PipelineSettings::localInference
+    bool modelLoaded = false;
+    unsigned long runs = 0;
+    unsigned long decisions = 0;       // Results returned instead of a cloud answer
+    unsigned long meanLatencyMs = 0;   // Decode, resize and invoke
+    unsigned long maxLatencyMs = 0;
+    unsigned long compared = 0;        // Shadow runs with a cloud answer to compare against
+    unsigned long agreed = 0;          // Same Boots / not-Boots call as the cloud
+    unsigned long bootsMissed = 0;     // Cloud said Boots, local did not
+    unsigned long bootsFalse = 0;      // Local said Boots, cloud did not
+    unsigned long meanCloudMs = 0;     // Cloud round trip over the compared runs
 };
 
 // SystemState struct definition - shared between main.cpp and BluetoothService
@@ -52,6 +221,17 @@ struct SystemState {
     // Motion detection tracking
     int motionTriggerCount = 0;         // Total PIR motion events detected
     int deterrentActivationCount = 0;   // Times deterrent was activated (Boots detected)
+    int visualTriggerCount = 0;         // Motion events raised by the camera rather than the PIR
+    unsigned long visualMotionCostUs = 0;    // Average cost of one camera motion sample
+    unsigned long visualMotionIntervalMs = 0; // Current camera motion sample interval (after CPU cap)
+
+    // Camera profile in use, and average switch time per from/to profile pair (ms, 0 = not yet seen)
+    int cameraProfile = 0;
+    unsigned long profileSwitchMs[4][4] = {};
+
+    // Flash captures: time from flash-on to the frame used, and total wait saved vs ledDelayMillis
+    unsigned long exposureSettleMs = 0;
+    unsigned long exposureSettleSavedMs = 0;
 
     // Training mode - captures photos without inference/deterrent
     bool trainingMode = false;
@@ -68,8 +248,41 @@ struct SystemState {
     bool dryRun = false;          // When true, skip atomizer but run all other steps
     bool claudeInfer = false;     // When true, send ?claude=1 to infer Lambda for parallel Claude vision
 
+    // Inference uploads skipped by the scene-change gate
+    int uploadsSkippedUnchanged = 0;
+
     // Camera sensor settings
     CameraSettings cameraSettings;
+
+    // Capture/upload pipeline settings, including the scene-change gate and camera motion trigger
+    PipelineSettings pipelineSettings;
+
+    // Adaptive JPEG quality (copied from the capture controller)
+    JpegQualityStatus jpegQualityControl;
+
+    // Frame quality gate (copied from the capture controller)
+    FrameGateStatus frameGate;
+
+    // Upload transcoder (copied from the capture controller)
+    UploadTranscodeStatus uploadTranscode;
+
+    // Inference result cache (copied from the capture controller)
+    InferenceCacheStatus inferenceCache;
+
+    // Daylight vs flash stills (copied from the capture controller)
+    CapturePolicyStatus capturePolicy;
+
+    // On-device classifier (copied from the capture controller)
+    LocalInferenceStatus localInference;
+
+    // Camera idle standby (copied from the capture controller)
+    CameraStandbyStatus cameraStandby;
+
+    // Shared API connection (copied from ApiConnection)
+    ApiConnectionStatus apiConnection;
+
+    // Upload payload hashing (copied from the capture controller)
+    UploadHashStatus uploadHash;
 };
 
 #endif
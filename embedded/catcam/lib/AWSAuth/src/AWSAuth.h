@@ -5,6 +5,8 @@
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <time.h>
+#include <functional>
+#include <mbedtls/md.h>
 #include "SDLogger.h"
 
 struct AWSCredentials {
@@ -28,6 +30,7 @@ struct SigV4Headers {
 class AWSAuth {
 public:
     AWSAuth(const char* region = "eu-west-2");
+    ~AWSAuth();
 
     // Initialize with certificates from secrets.h
     bool initialize(const char* awsCertCA, const char* awsCertCRT, const char* awsCertPrivate,
@@ -47,12 +50,26 @@ public:
                                              size_t payloadSize,
                                              const String& contentType = "application/octet-stream");
 
+    // Create SigV4 signed headers when the payload hash was computed by the caller
+    // (e.g. a file streamed from SD that is never held in memory as a whole)
+    SigV4Headers createSigV4HeadersForPayloadHash(const String& method, const String& uri,
+                                                  const String& host, const String& payloadHash,
+                                                  const String& contentType = "application/octet-stream");
+
     // Calculate SHA256 hash of binary data (returns lowercase hex string)
     String sha256HashBinary(const uint8_t* data, size_t len);
 
+    // Calculate SHA256 hash of a streamed payload using the caller's buffer.
+    // read(buffer, max) returns the number of bytes read, 0 at end of stream.
+    String sha256HashStream(std::function<size_t(uint8_t* buffer, size_t maxLen)> read,
+                            uint8_t* buffer, size_t bufferSize);
+
     // Get current credentials
     AWSCredentials getCurrentCredentials() const { return credentials; }
 
+    // Use credentials obtained elsewhere (drops the cached signing key)
+    void setCredentials(const AWSCredentials& creds);
+
     // Check if credentials are still valid (not expired)
     bool areCredentialsValid() const;
 
@@ -69,6 +86,9 @@ public:
     // Utility methods
     String urlEncode(const String& str);
 
+    // Lowercase hex, as SigV4 wants it (e.g. for a payload hash computed elsewhere)
+    String bytesToHex(const uint8_t* bytes, size_t len);
+
 private:
     String region;
     String credentialsEndpointHost;
@@ -78,26 +98,32 @@ private:
     AWSCredentials credentials;
     class MqttService* _mqttService;
 
-    // Helper methods for SigV4 signing
-    String createCanonicalRequest(const String& method, const String& uri,
-                                 const String& queryString, const String& headers,
-                                 const String& signedHeaders, const String& payloadHash);
-
-    String createStringToSign(const String& algorithm, const String& requestDateTime,
-                             const String& credentialScope, const String& canonicalRequestHash);
-
-    String createSignature(const String& stringToSign, const uint8_t* signingKey);
+    // SigV4 state reused across requests. The signing key depends on the date,
+    // region, service and secret; region and service are fixed here, so it is
+    // derived again only when the date changes or the credentials are
+    // refreshed - as are the scope, the Authorization prefix and the
+    // canonical request's fixed tail (session token and signed headers).
+    static constexpr const char* SERVICE = "execute-api";
+    static constexpr const char* SIGNED_HEADERS = "content-type;host;x-amz-date;x-amz-security-token";
+    uint8_t _signingKey[32];
+    char _signingKeyDate[9] = "";     // Date stamp the cache was built for ("" = none)
+    String _credentialScope;          // <date>/<region>/execute-api/aws4_request
+    String _authorizationPrefix;      // Authorization header up to the signature
+    String _canonicalTail;            // \nx-amz-security-token:<token>\n\n<signed headers>\n
+    mbedtls_md_context_t _md;         // SHA-256 and HMAC, set up once
+    bool _mdReady = false;
+
+    void invalidateSigningCache();
+    void prepareSigningCache(const char* dateStamp);
 
+    // Helper methods for SigV4 signing
     void getSigningKey(uint8_t* output, const String& key, const String& dateStamp,
                        const String& regionName, const String& serviceName);
 
     void hmacSha256Raw(uint8_t* output, const uint8_t* key, size_t keyLen,
                        const uint8_t* data, size_t dataLen);
-    String hmacSha256Hex(const uint8_t* key, size_t keyLen, const String& data);
     String sha256Hash(const String& data);
     String getISOTimestamp();
-    String getDateStamp();
-    String bytesToHex(const uint8_t* bytes, size_t len);
 
     // Internal method that takes pre-computed payload hash
     SigV4Headers createSigV4HeadersInternal(const String& method, const String& uri,
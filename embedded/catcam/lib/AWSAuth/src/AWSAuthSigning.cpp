@@ -0,0 +1,278 @@
+// AWSAuth's SigV4 signing and payload hashing. Kept apart from the
+// credential fetching in AWSAuth.cpp (HTTPClient, MQTT) so it builds on its
+// own, e.g. for the host tests.
+
+#include "AWSAuth.h"
+#include <mbedtls/md.h>
+
+namespace {
+
+// Lowercase hex into out (2 * len characters plus a terminator)
+void hexEncode(const uint8_t* bytes, size_t len, char* out) {
+    const char hexChars[] = "0123456789abcdef";  // AWS SigV4 requires lowercase hex
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = hexChars[(bytes[i] >> 4) & 0x0F];
+        out[i * 2 + 1] = hexChars[bytes[i] & 0x0F];
+    }
+    out[len * 2] = '\0';
+}
+
+}
+
+AWSAuth::AWSAuth(const char* region) : region(region) {
+    credentials.isValid = false;
+    credentials.expiration = 0;
+    caCert = nullptr;
+    clientCert = nullptr;
+    clientKey = nullptr;
+    _mqttService = nullptr;
+}
+
+AWSAuth::~AWSAuth() {
+    if (_mdReady) {
+        mbedtls_md_free(&_md);
+    }
+}
+
+bool AWSAuth::areCredentialsValid() const {
+    if (!credentials.isValid) {
+        return false;
+    }
+    time_t now;
+    time(&now);
+    // Consider credentials invalid if they expire within 5 minutes
+    return now < (credentials.expiration - 300);
+}
+
+SigV4Headers AWSAuth::createSigV4Headers(const String& method, const String& uri,
+                                         const String& host, const String& payload,
+                                         const String& contentType) {
+    // For string payloads, calculate the SHA256 hash
+    String payloadHash = sha256Hash(payload);
+    return createSigV4HeadersInternal(method, uri, host, payloadHash, contentType);
+}
+
+SigV4Headers AWSAuth::createSigV4HeadersForBinary(const String& method, const String& uri,
+                                                   const String& host, const uint8_t* payload,
+                                                   size_t payloadSize,
+                                                   const String& contentType) {
+    // For binary payloads, calculate the SHA256 hash of the binary data
+    SDLogger::getInstance().infof("AWSAuth: Hashing binary payload of %d bytes", payloadSize);
+    String payloadHash = sha256HashBinary(payload, payloadSize);
+    SDLogger::getInstance().infof("AWSAuth: Payload hash: %s", payloadHash.c_str());
+    return createSigV4HeadersInternal(method, uri, host, payloadHash, contentType);
+}
+
+SigV4Headers AWSAuth::createSigV4HeadersForPayloadHash(const String& method, const String& uri,
+                                                        const String& host, const String& payloadHash,
+                                                        const String& contentType) {
+    return createSigV4HeadersInternal(method, uri, host, payloadHash, contentType);
+}
+
+SigV4Headers AWSAuth::createSigV4HeadersInternal(const String& method, const String& uri,
+                                                  const String& host, const String& payloadHash,
+                                                  const String& contentType) {
+    SigV4Headers headers;
+    headers.isValid = false;
+
+    if (!areCredentialsValid()) {
+        SDLogger::getInstance().errorf("AWSAuth: Invalid AWS credentials for SigV4 signing");
+        return headers;
+    }
+
+    if (!_mdReady) {
+        mbedtls_md_init(&_md);
+        _mdReady = mbedtls_md_setup(&_md, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1) == 0;
+        if (!_mdReady) {
+            mbedtls_md_free(&_md);
+            SDLogger::getInstance().errorf("AWSAuth: Failed to set up SHA-256 for SigV4 signing");
+            return headers;
+        }
+    }
+
+    // Get current time (the date stamp from the same reading, so the two cannot straddle midnight)
+    String amzDate = getISOTimestamp();
+    char dateStamp[9];
+    memcpy(dateStamp, amzDate.c_str(), 8);
+    dateStamp[8] = '\0';
+    prepareSigningCache(dateStamp);
+
+    SDLogger::getInstance().debugf("AWSAuth: Creating SigV4 signature for %s %s", method.c_str(), uri.c_str());
+
+    auto hashPart = [this](const char* data, size_t length) {
+        mbedtls_md_update(&_md, (const uint8_t*)data, length);
+    };
+    auto hashText = [&hashPart](const char* text) {
+        hashPart(text, strlen(text));
+    };
+
+    // Canonical request, hashed piece by piece rather than assembled in a String:
+    // method, path, query string, canonical headers (sorted by name), signed headers, payload hash
+    int qPos = uri.indexOf('?');
+    mbedtls_md_starts(&_md);
+    hashPart(method.c_str(), method.length());
+    hashText("\n");
+    hashPart(uri.c_str(), qPos >= 0 ? qPos : uri.length());
+    hashText("\n");
+    hashText(qPos >= 0 ? uri.c_str() + qPos + 1 : "");
+    hashText("\ncontent-type:");
+    hashPart(contentType.c_str(), contentType.length());
+    hashText("\nhost:");
+    hashPart(host.c_str(), host.length());
+    hashText("\nx-amz-date:");
+    hashPart(amzDate.c_str(), amzDate.length());
+    hashPart(_canonicalTail.c_str(), _canonicalTail.length());
+    hashPart(payloadHash.c_str(), payloadHash.length());
+    uint8_t digest[32];
+    mbedtls_md_finish(&_md, digest);
+    char canonicalRequestHash[65];
+    hexEncode(digest, sizeof(digest), canonicalRequestHash);
+
+    SDLogger::getInstance().tracef("AWSAuth: Canonical Request Hash: %s", canonicalRequestHash);
+
+    // String to sign, fed straight into the HMAC with the cached signing key
+    mbedtls_md_hmac_starts(&_md, _signingKey, sizeof(_signingKey));
+    auto signPart = [this](const char* data, size_t length) {
+        mbedtls_md_hmac_update(&_md, (const uint8_t*)data, length);
+    };
+    signPart("AWS4-HMAC-SHA256\n", 17);
+    signPart(amzDate.c_str(), amzDate.length());
+    signPart("\n", 1);
+    signPart(_credentialScope.c_str(), _credentialScope.length());
+    signPart("\n", 1);
+    signPart(canonicalRequestHash, 64);
+    mbedtls_md_hmac_finish(&_md, digest);
+    char signature[65];
+    hexEncode(digest, sizeof(digest), signature);
+
+    SDLogger::getInstance().tracef("AWSAuth: String to Sign: AWS4-HMAC-SHA256 %s %s %s",
+        amzDate.c_str(), _credentialScope.c_str(), canonicalRequestHash);
+
+    // Create authorization header
+    headers.authorization.reserve(_authorizationPrefix.length() + 64);
+    headers.authorization = _authorizationPrefix;
+    headers.authorization.concat(signature, 64);
+
+    headers.date = amzDate;
+    headers.securityToken = credentials.sessionToken;
+    headers.contentType = contentType;
+    headers.host = host;
+    headers.payloadHash = payloadHash;  // Store the payload hash for the HTTP header
+    headers.isValid = true;
+
+    SDLogger::getInstance().debugf("AWSAuth: SigV4 headers created successfully");
+
+    return headers;
+}
+
+void AWSAuth::setCredentials(const AWSCredentials& creds) {
+    credentials = creds;
+    invalidateSigningCache();
+}
+
+void AWSAuth::invalidateSigningCache() {
+    _signingKeyDate[0] = '\0';
+    memset(_signingKey, 0, sizeof(_signingKey));
+}
+
+void AWSAuth::prepareSigningCache(const char* dateStamp) {
+    if (strcmp(dateStamp, _signingKeyDate) == 0) {
+        return;
+    }
+
+    getSigningKey(_signingKey, credentials.secretAccessKey, dateStamp, region, SERVICE);
+    _credentialScope = String(dateStamp) + "/" + region + "/" + SERVICE + "/aws4_request";
+    _authorizationPrefix = String("AWS4-HMAC-SHA256 Credential=") + credentials.accessKeyId + "/" + _credentialScope +
+                           ", SignedHeaders=" + SIGNED_HEADERS + ", Signature=";
+    _canonicalTail = String("\nx-amz-security-token:") + credentials.sessionToken + "\n\n" + SIGNED_HEADERS + "\n";
+    memcpy(_signingKeyDate, dateStamp, sizeof(_signingKeyDate));
+
+    SDLogger::getInstance().debugf("AWSAuth: Derived SigV4 signing key for %s", dateStamp);
+}
+
+void AWSAuth::getSigningKey(uint8_t* output, const String& key, const String& dateStamp,
+                           const String& regionName, const String& serviceName) {
+    // kDate = HMAC("AWS4" + kSecret, Date)
+    String kSecret = "AWS4" + key;
+    uint8_t kDate[32];
+    hmacSha256Raw(kDate, (const uint8_t*)kSecret.c_str(), kSecret.length(),
+                  (const uint8_t*)dateStamp.c_str(), dateStamp.length());
+
+    // kRegion = HMAC(kDate, Region)
+    uint8_t kRegion[32];
+    hmacSha256Raw(kRegion, kDate, 32,
+                  (const uint8_t*)regionName.c_str(), regionName.length());
+
+    // kService = HMAC(kRegion, Service)
+    uint8_t kService[32];
+    hmacSha256Raw(kService, kRegion, 32,
+                  (const uint8_t*)serviceName.c_str(), serviceName.length());
+
+    // kSigning = HMAC(kService, "aws4_request")
+    const char* aws4Request = "aws4_request";
+    hmacSha256Raw(output, kService, 32,
+                  (const uint8_t*)aws4Request, strlen(aws4Request));
+}
+
+void AWSAuth::hmacSha256Raw(uint8_t* output, const uint8_t* key, size_t keyLen,
+                           const uint8_t* data, size_t dataLen) {
+    const mbedtls_md_info_t* md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_md_hmac(md_info, key, keyLen, data, dataLen, output);
+}
+
+String AWSAuth::sha256Hash(const String& data) {
+    uint8_t output[32];
+    const mbedtls_md_info_t* md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_md(md_info, (const uint8_t*)data.c_str(), data.length(), output);
+    return bytesToHex(output, 32);
+}
+
+String AWSAuth::sha256HashBinary(const uint8_t* data, size_t len) {
+    uint8_t output[32];
+    const mbedtls_md_info_t* md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_md(md_info, data, len, output);
+    return bytesToHex(output, 32);
+}
+
+String AWSAuth::sha256HashStream(std::function<size_t(uint8_t* buffer, size_t maxLen)> read,
+                                  uint8_t* buffer, size_t bufferSize) {
+    uint8_t output[32];
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    if (mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) != 0) {
+        mbedtls_md_free(&ctx);
+        return "";
+    }
+
+    mbedtls_md_starts(&ctx);
+    size_t bytesRead;
+    while ((bytesRead = read(buffer, bufferSize)) > 0) {
+        mbedtls_md_update(&ctx, buffer, bytesRead);
+        yield();  // Prevent WDT reset on long payloads
+    }
+    mbedtls_md_finish(&ctx, output);
+    mbedtls_md_free(&ctx);
+
+    return bytesToHex(output, 32);
+}
+
+String AWSAuth::bytesToHex(const uint8_t* bytes, size_t len) {
+    String result = "";
+    result.reserve(len * 2);
+    const char hexChars[] = "0123456789abcdef";  // AWS SigV4 requires lowercase hex
+    for (size_t i = 0; i < len; i++) {
+        result += hexChars[(bytes[i] >> 4) & 0x0F];
+        result += hexChars[bytes[i] & 0x0F];
+    }
+    return result;
+}
+
+String AWSAuth::getISOTimestamp() {
+    time_t now;
+    time(&now);
+    struct tm* timeinfo = gmtime(&now);
+
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%Y%m%dT%H%M%SZ", timeinfo);
+    return String(buffer);
+}
@@ -0,0 +1,48 @@
+#include "PayloadHasher.h"
+#include <mbedtls/md.h>
+
+PayloadHasher::~PayloadHasher() {
+    if (_running) {
+        xSemaphoreTake(_done, portMAX_DELAY);
+    }
+}
+
+bool PayloadHasher::start(const uint8_t* data, size_t size) {
+    if (_running) {
+        return false;
+    }
+    _data = data;
+    _size = size;
+    _ok = false;
+    _done = xSemaphoreCreateBinaryStatic(&_doneBuffer);
+
+    BaseType_t otherCore = 1 - xPortGetCoreID();
+    _running = xTaskCreatePinnedToCore(taskFunction, "PayloadHash", TASK_STACK_SIZE, this,
+                                       TASK_PRIORITY, nullptr, otherCore) == pdPASS;
+    return _running;
+}
+
+bool PayloadHasher::finish(uint8_t* digest, uint32_t* waitedMs) {
+    if (!_running) {
+        return false;
+    }
+    unsigned long startMs = millis();
+    xSemaphoreTake(_done, portMAX_DELAY);
+    _running = false;
+    if (waitedMs) {
+        *waitedMs = millis() - startMs;
+    }
+    if (_ok) {
+        memcpy(digest, _digest, DIGEST_SIZE);
+    }
+    return _ok;
+}
+
+void PayloadHasher::taskFunction(void* parameter) {
+    PayloadHasher* hasher = static_cast<PayloadHasher*>(parameter);
+    hasher->_ok = mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                             hasher->_data, hasher->_size, hasher->_digest) == 0;
+    // The hasher may be gone as soon as this is given
+    xSemaphoreGive(hasher->_done);
+    vTaskDelete(nullptr);
+}
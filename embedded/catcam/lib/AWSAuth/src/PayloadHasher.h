@@ -0,0 +1,54 @@
+#ifndef CATCAM_PAYLOADHASHER_H
+#define CATCAM_PAYLOADHASHER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * PayloadHasher - SHA-256 of an upload payload on the other core
+ *
+ * SigV4 needs the payload hash before the request can be signed. The loop
+ * task connects (DNS, TCP, TLS handshake) on its own core, so hashing the
+ * frame on the other core meanwhile takes it off the path to the first byte
+ * on the wire.
+ *
+ * The payload must stay valid and unchanged until finish() returns; the
+ * destructor waits for the hash too.
+ */
+class PayloadHasher {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+
+    ~PayloadHasher();
+
+    /**
+     * Start hashing on the core the caller is not running on
+     * @return false if the task could not be started (hash inline instead)
+     */
+    bool start(const uint8_t* data, size_t size);
+
+    /**
+     * Wait for the hash started by start()
+     * @param digest DIGEST_SIZE bytes
+     * @param waitedMs Time spent waiting here (0 if it was already done)
+     * @return false if hashing failed
+     */
+    bool finish(uint8_t* digest, uint32_t* waitedMs = nullptr);
+
+private:
+    static constexpr int TASK_STACK_SIZE = 4096;
+    static constexpr int TASK_PRIORITY = 1;
+
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    uint8_t _digest[DIGEST_SIZE];
+    bool _ok = false;
+    bool _running = false;
+    StaticSemaphore_t _doneBuffer;
+    SemaphoreHandle_t _done = nullptr;
+
+    static void taskFunction(void* parameter);
+};
+
+#endif
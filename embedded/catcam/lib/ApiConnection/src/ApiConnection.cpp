@@ -0,0 +1,303 @@
+#include "ApiConnection.h"
+#include <esp_heap_caps.h>
+#include "SDLogger.h"
+#include "SlabAllocator.h"
+
+bool ApiConnection::request(const char* host, const String& head, BodyWriter writeBody, uint32_t timeoutMs,
+                            ApiResponse& response, bool keepBody) {
+    _status.requests++;
+    _transport.setTimeout(timeoutMs);
+
+    // The head goes out as one write from a slab block rather than another
+    // String copy in internal RAM (the body is streamed by the caller)
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    size_t preambleLength = head.length() + strlen(KEEP_ALIVE_LINE);
+    char* preamble = (char*)slab.allocate(preambleLength);
+    if (!preamble) {
+        preamble = (char*)malloc(preambleLength);
+    }
+    if (!preamble) {
+        return fail("No memory for the request head");
+    }
+    memcpy(preamble, head.c_str(), head.length());
+    memcpy(preamble + head.length(), KEEP_ALIVE_LINE, strlen(KEEP_ALIVE_LINE));
+
+    bool answered = exchange(host, (const uint8_t*)preamble, preambleLength, writeBody, timeoutMs, response, keepBody);
+
+    if (slab.owns(preamble)) {
+        slab.release(preamble);
+    } else {
+        free(preamble);
+    }
+    return answered;
+}
+
+bool ApiConnection::exchange(const char* host, const uint8_t* preamble, size_t preambleLength, BodyWriter& writeBody,
+                             uint32_t timeoutMs, ApiResponse& response, bool keepBody) {
+    // A second attempt only if a warm connection turned out to be dead
+    for (int attempt = 0; attempt < 2; attempt++) {
+        _error = nullptr;
+        response = ApiResponse();
+        if (!connect(host, response)) {
+            return false;
+        }
+
+        response.sentAtMs = millis();
+        bool sent = _client.write(preamble, preambleLength) == preambleLength &&
+                    (!writeBody || writeBody(_client));
+
+        bool started = false;
+        bool reusable = false;
+        if (sent && readResponse(timeoutMs, keepBody, response, started, reusable)) {
+            recordConnectTime(response.connectMs);
+            _lastUsedMs = millis();
+            if (!reusable) {
+                close();
+            } else if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < KEEP_ALIVE_MIN_FREE_BYTES) {
+                _status.memoryCloses++;
+                SDLogger::getInstance().debugf("ApiConnection: Internal RAM short - not keeping the connection");
+                close();
+            }
+            _status.warm = _open;
+            return true;
+        }
+
+        bool stale = response.reused && !started && (!sent || !_client.connected());
+        close();
+        if (!stale) {
+            return fail(sent ? (_error ? _error : "Incomplete response") : "Error writing request");
+        }
+        _status.staleRetries++;
+        SDLogger::getInstance().infof("ApiConnection: Warm connection was closed by the server - reconnecting");
+    }
+    return fail("Connection failed");
+}
+
+bool ApiConnection::prepare(const char* host) {
+    if (isUsable(host)) {
+        return true;
+    }
+    ApiResponse response;
+    if (!connect(host, response)) {
+        return false;
+    }
+    _prepared = true;
+    _preparedConnectMs = response.connectMs;
+    _status.warm = true;
+    return true;
+}
+
+void ApiConnection::maintain() {
+    if (!_open) {
+        return;
+    }
+    if (millis() - _lastUsedMs >= IDLE_CLOSE_MS) {
+        SDLogger::getInstance().debugf("ApiConnection: Closing idle connection");
+        close();
+    } else if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < KEEP_ALIVE_MIN_FREE_BYTES) {
+        _status.memoryCloses++;
+        SDLogger::getInstance().debugf("ApiConnection: Internal RAM short - closing the warm connection");
+        close();
+    }
+}
+
+void ApiConnection::close() {
+    if (_open) {
+        _client.stop();
+        _open = false;
+    }
+    _prepared = false;
+    _status.warm = false;
+}
+
+bool ApiConnection::isUsable(const char* host) {
+    return _open && _host == host && _client.connected() && millis() - _lastUsedMs < IDLE_CLOSE_MS;
+}
+
+bool ApiConnection::connect(const char* host, ApiResponse& response) {
+    if (isUsable(host)) {
+        if (_prepared) {
+            // Opened by prepare() for this request
+            _prepared = false;
+            response.connectMs = _preparedConnectMs;
+            return true;
+        }
+        response.reused = true;
+        _status.reused++;
+        return true;
+    }
+    close();
+
+    unsigned long startMs = millis();
+    bool cached = _dnsValid && _dnsHost == host && millis() - _dnsResolvedMs < DNS_CACHE_MS;
+    IPAddress address;
+    if (!resolve(host, address)) {
+        return fail("DNS lookup failed");
+    }
+
+    SDLogger::getInstance().debugf("ApiConnection: Connecting to %s (%s):%d", host, address.toString().c_str(), PORT);
+    bool connected = _transport.connect(address, PORT, host);
+    if (!connected && cached) {
+        // The host may have moved - look it up again before giving up
+        _dnsValid = false;
+        connected = resolve(host, address) && _transport.connect(address, PORT, host);
+    }
+    if (!connected) {
+        _client.stop();
+        return fail("Connection failed");
+    }
+
+    _open = true;
+    _host = host;
+    _lastUsedMs = millis();
+    response.connectMs = millis() - startMs;
+    _status.handshakes++;
+    bool resumed = _transport.resumed();
+    if (resumed) {
+        _status.resumedHandshakes++;
+    }
+    _status.meanHandshakeMs = _status.meanHandshakeMs
+        ? (_status.meanHandshakeMs * 7 + response.connectMs) / 8 : response.connectMs;
+    SDLogger::getInstance().infof("ApiConnection: Connected to %s in %lu ms (handshake #%lu%s)",
+        host, (unsigned long)response.connectMs, _status.handshakes, resumed ? ", session resumed" : "");
+    return true;
+}
+
+bool ApiConnection::resolve(const char* host, IPAddress& address) {
+    if (_dnsValid && _dnsHost == host && millis() - _dnsResolvedMs < DNS_CACHE_MS) {
+        _status.dnsCacheHits++;
+        address = _dnsAddress;
+        return true;
+    }
+    _status.dnsLookups++;
+    if (!_transport.resolve(host, address)) {
+        _dnsValid = false;
+        return false;
+    }
+    _dnsHost = host;
+    _dnsAddress = address;
+    _dnsValid = true;
+    _dnsResolvedMs = millis();
+    return true;
+}
+
+bool ApiConnection::readResponse(uint32_t timeoutMs, bool keepBody, ApiResponse& response,
+                                 bool& started, bool& reusable) {
+    unsigned long waitStartMs = millis();
+    while (!_client.available()) {
+        if (!_client.connected()) {
+            return fail("Connection closed");
+        }
+        if (millis() - waitStartMs > timeoutMs) {
+            return fail("Response timeout");
+        }
+        delay(10);
+    }
+    started = true;
+
+    unsigned long deadlineMs = millis() + BODY_TIMEOUT_MS;
+    String line;
+    if (!readLine(line, deadlineMs)) {
+        return fail("Incomplete response");
+    }
+    SDLogger::getInstance().infof("ApiConnection: %s", line.c_str());
+    int spaceIndex = line.indexOf(' ');
+    if (spaceIndex > 0) {
+        response.statusCode = line.substring(spaceIndex + 1, spaceIndex + 4).toInt();
+    }
+    bool keepAlive = line.startsWith("HTTP/1.1");
+
+    long contentLength = -1;
+    while (true) {
+        if (!readLine(line, deadlineMs)) {
+            return fail("Incomplete response");
+        }
+        line.trim();
+        if (line.length() == 0) {
+            break;
+        }
+        SDLogger::getInstance().tracef("ApiConnection: Header: %s", line.c_str());
+        int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+        if (name.equalsIgnoreCase("Content-Length")) {
+            contentLength = value.toInt();
+        } else if (name.equalsIgnoreCase("Connection") && value.equalsIgnoreCase("close")) {
+            keepAlive = false;
+        } else if (name.equalsIgnoreCase("Transfer-Encoding")) {
+            keepAlive = false;  // Not decoded: read to the end of the connection instead
+        }
+    }
+
+    if (keepBody && contentLength > 0) {
+        response.body.reserve(contentLength + 1);
+    }
+    uint8_t buffer[256];
+    long remaining = contentLength;
+    while (contentLength < 0 || remaining > 0) {
+        int available = _client.available();
+        if (available <= 0) {
+            if (!_client.connected()) {
+                break;  // End of an unsized body, or a truncated sized one
+            }
+            if ((long)(millis() - deadlineMs) > 0) {
+                break;
+            }
+            delay(1);
+            continue;
+        }
+        size_t want = sizeof(buffer);
+        if (contentLength >= 0 && (long)want > remaining) {
+            want = remaining;
+        }
+        int n = _client.read(buffer, min(want, (size_t)available));
+        if (n <= 0) {
+            continue;
+        }
+        if (keepBody) {
+            response.body.concat((const char*)buffer, n);
+        }
+        remaining -= n;
+    }
+
+    if (contentLength >= 0 && remaining > 0) {
+        return fail("Incomplete response");
+    }
+    reusable = keepAlive && contentLength >= 0;
+    return true;
+}
+
+bool ApiConnection::readLine(String& line, unsigned long deadlineMs) {
+    line = "";
+    while ((long)(millis() - deadlineMs) <= 0) {
+        if (!_client.available()) {
+            if (!_client.connected()) {
+                return false;
+            }
+            delay(1);
+            continue;
+        }
+        char c = (char)_client.read();
+        if (c == '\n') {
+            return true;
+        }
+        if (c != '\r') {
+            line += c;
+        }
+    }
+    return false;
+}
+
+void ApiConnection::recordConnectTime(uint32_t connectMs) {
+    _status.lastConnectMs = connectMs;
+    _status.meanConnectMs = _completed++ ? (_status.meanConnectMs * 7 + connectMs) / 8 : connectMs;
+}
+
+bool ApiConnection::fail(const char* error) {
+    _error = error;
+    return false;
+}
@@ -0,0 +1,137 @@
+#ifndef CATCAM_APICONNECTION_H
+#define CATCAM_APICONNECTION_H
+
+#include <Arduino.h>
+#include <functional>
+
+#include "ApiTransport.h"
+#include "SystemState.h"
+
+/**
+ * One HTTP/1.1 response read from the shared connection
+ */
+struct ApiResponse {
+    int statusCode = 0;         // 0 = no response
+    String body;
+    uint32_t connectMs = 0;     // DNS + TCP + TLS spent on this request (0 = warm connection reused)
+    bool reused = false;
+    unsigned long sentAtMs = 0; // millis() when the request's first byte went out
+};
+
+/**
+ * ApiConnection - Shared keep-alive HTTPS connection to the API host
+ *
+ * Detection, archive and video uploads all go to the same API Gateway host.
+ * Rather than a fresh WiFiClientSecure per request (DNS lookup, TCP connect,
+ * full TLS handshake, Connection: close), requests share one connection
+ * that is kept open afterwards as long as:
+ * - the response was read to its Content-Length and the server did not
+ *   ask to close,
+ * - at least KEEP_ALIVE_MIN_FREE_BYTES of internal RAM stays free (the TLS
+ *   session holds ~40 KB of it, which MQTT needs again once it resumes),
+ * - it was used within the last IDLE_CLOSE_MS.
+ * A warm connection the server has dropped in the meantime shows up as a
+ * request that gets no response at all; that request is repeated once on a
+ * new connection. The host's address is cached for DNS_CACHE_MS.
+ *
+ * Once the connection has been closed, WiFiApiTransport reconnects by
+ * resuming the last TLS session, which skips the key exchange whenever the
+ * server still holds it.
+ *
+ * Used from the main loop task only.
+ */
+class ApiConnection {
+public:
+    // Streams the request body; called again if the request is repeated
+    using BodyWriter = std::function<bool(Client& client)>;
+
+    /**
+     * The firmware's connection, over WiFiApiTransport (defined in WiFiApiTransport.cpp)
+     */
+    static ApiConnection& getInstance();
+
+    /**
+     * @param transport Must outlive the connection (tests pass a fake)
+     */
+    explicit ApiConnection(IApiTransport& transport) : _transport(transport), _client(transport.client()) {}
+
+    /**
+     * Send one request and read its response
+     * @param host API host (HTTPS, port 443)
+     * @param head Request line and headers, each ending in CRLF, without
+     *             Connection or the blank line (both added here)
+     * @param writeBody Streams the body (nullptr = no body)
+     * @param timeoutMs Longest wait for the response to start
+     * @param response Status, body and this request's connect cost
+     * @param keepBody false to read and discard the body
+     * @return true if a complete response was read (any status code);
+     *         otherwise error() says why
+     */
+    bool request(const char* host, const String& head, BodyWriter writeBody, uint32_t timeoutMs,
+                 ApiResponse& response, bool keepBody = true);
+
+    /**
+     * Connect ahead of request() (no-op while warm), e.g. while the payload
+     * is still being hashed; the next request() reports the connect time
+     * @return false if it could not connect - request() will try again
+     */
+    bool prepare(const char* host);
+
+    /**
+     * Close the warm connection once it has idled too long or internal RAM
+     * runs short - call from the main loop
+     */
+    void maintain();
+
+    /**
+     * Close the connection now
+     */
+    void close();
+
+    bool isWarm() const { return _open; }
+
+    /**
+     * Why the last request() failed
+     */
+    const char* error() const { return _error; }
+
+    const ApiConnectionStatus& status() const { return _status; }
+
+private:
+    static constexpr uint16_t PORT = 443;
+    static constexpr unsigned long IDLE_CLOSE_MS = 60000;
+    static constexpr unsigned long DNS_CACHE_MS = 10 * 60000;
+    static constexpr size_t KEEP_ALIVE_MIN_FREE_BYTES = 48 * 1024;
+    static constexpr uint32_t BODY_TIMEOUT_MS = 5000;  // Headers and body, once the response has started
+    static constexpr const char* KEEP_ALIVE_LINE = "Connection: keep-alive\r\n\r\n";
+
+    IApiTransport& _transport;
+    Client& _client;
+    bool _open = false;
+    String _host;
+    unsigned long _lastUsedMs = 0;
+    bool _prepared = false;          // Opened by prepare(), not yet used
+    uint32_t _preparedConnectMs = 0;
+
+    // Last resolved address of _dnsHost
+    String _dnsHost;
+    IPAddress _dnsAddress;
+    bool _dnsValid = false;
+    unsigned long _dnsResolvedMs = 0;
+
+    const char* _error = nullptr;
+    ApiConnectionStatus _status;
+    unsigned long _completed = 0;  // Requests answered, for the connect time average
+
+    bool exchange(const char* host, const uint8_t* preamble, size_t preambleLength, BodyWriter& writeBody,
+                  uint32_t timeoutMs, ApiResponse& response, bool keepBody);
+    bool isUsable(const char* host);
+    bool connect(const char* host, ApiResponse& response);
+    bool resolve(const char* host, IPAddress& address);
+    bool readResponse(uint32_t timeoutMs, bool keepBody, ApiResponse& response, bool& started, bool& reusable);
+    bool readLine(String& line, unsigned long deadlineMs);
+    void recordConnectTime(uint32_t connectMs);
+    bool fail(const char* error);
+};
+
+#endif
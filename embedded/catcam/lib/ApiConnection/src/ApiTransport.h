@@ -0,0 +1,45 @@
+#ifndef CATCAM_APITRANSPORT_H
+#define CATCAM_APITRANSPORT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+
+/**
+ * Interface for the socket under ApiConnection: name lookup, the TLS
+ * connect and the stream requests are written to and responses read from.
+ * The firmware uses WiFiApiTransport; host tests put a scripted server, or
+ * a real TLS one, behind it.
+ */
+class IApiTransport {
+public:
+    virtual ~IApiTransport() = default;
+
+    /**
+     * The connection's stream; stop() and connected() are used as-is
+     */
+    virtual Client& client() = 0;
+
+    /**
+     * Look a host up (ApiConnection caches the answer)
+     */
+    virtual bool resolve(const char* host, IPAddress& address) = 0;
+
+    /**
+     * Open a TLS connection to address:port, host used for SNI
+     */
+    virtual bool connect(const IPAddress& address, uint16_t port, const char* host) = 0;
+
+    /**
+     * Socket read/write timeout for the next exchange
+     */
+    virtual void setTimeout(uint32_t timeoutMs) = 0;
+
+    /**
+     * Whether the last connect() resumed a saved TLS session instead of a
+     * full handshake
+     */
+    virtual bool resumed() const = 0;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "TlsClient.h"
+#include <WiFi.h>
+#include <mbedtls/error.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/version.h>
+#include "SDLogger.h"
+
+// mbedtls 3 made the session fields private
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define TLS_SESSION_FIELD(field) MBEDTLS_PRIVATE(field)
+#else
+#define TLS_SESSION_FIELD(field) field
+#endif
+
+TlsClient::TlsClient() {
+    mbedtls_ssl_init(&_ssl);
+    mbedtls_ssl_config_init(&_config);
+    mbedtls_ctr_drbg_init(&_drbg);
+    mbedtls_entropy_init(&_entropy);
+    mbedtls_ssl_session_init(&_session);
+}
+
+TlsClient::~TlsClient() {
+    stop();
+    mbedtls_ssl_free(&_ssl);
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_config_free(&_config);
+    mbedtls_ctr_drbg_free(&_drbg);
+    mbedtls_entropy_free(&_entropy);
+}
+
+bool TlsClient::configure() {
+    if (_configured) {
+        return true;
+    }
+    static const char PERSONALISATION[] = "catcam-tls";
+    int ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                    (const unsigned char*)PERSONALISATION, sizeof(PERSONALISATION) - 1);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&_config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret != 0) {
+        return fail(ret);
+    }
+    mbedtls_ssl_conf_authmode(&_config, MBEDTLS_SSL_VERIFY_NONE);  // As setInsecure() - in production, set proper CA cert
+    mbedtls_ssl_conf_rng(&_config, mbedtls_ctr_drbg_random, &_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&_config, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    _configured = true;
+    return true;
+}
+
+bool TlsClient::connect(const IPAddress& address, uint16_t port, const char* host) {
+    stop();
+    _lastError = 0;
+    _resumed = false;
+    if (!configure()) {
+        return false;
+    }
+    if (!_socket.connect(address, port, _timeoutMs)) {
+        return fail(MBEDTLS_ERR_NET_CONNECT_FAILED);
+    }
+
+    // The record buffers are allocated here and freed again in stop()
+    int ret = mbedtls_ssl_setup(&_ssl, &_config);
+    if (ret == 0 && host) {
+        ret = mbedtls_ssl_set_hostname(&_ssl, host);
+    }
+    bool offered = false;
+    if (ret == 0 && _haveSession && host && _sessionHost == host) {
+        offered = mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+    }
+    if (ret != 0) {
+        _socket.stop();
+        mbedtls_ssl_free(&_ssl);
+        return fail(ret);
+    }
+    mbedtls_ssl_set_bio(&_ssl, this, sendCallback, receiveCallback, nullptr);
+    _open = true;
+
+    unsigned long startMs = millis();
+    while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+        if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            millis() - startMs > _timeoutMs) {
+            stop();
+            if (offered) {
+                // Don't offer a session the server chokes on twice
+                _haveSession = false;
+            }
+            return fail(ret ? ret : MBEDTLS_ERR_SSL_TIMEOUT);
+        }
+        delay(1);
+    }
+
+    // A resumed session carries the offered master secret over; a full
+    // handshake (the server no longer knew the ID or ticket) derives a new one
+    mbedtls_ssl_session current;
+    mbedtls_ssl_session_init(&current);
+    if (mbedtls_ssl_get_session(&_ssl, &current) == 0) {
+        _resumed = offered && memcmp(TLS_SESSION_FIELD(current.master), TLS_SESSION_FIELD(_session.master),
+                                     sizeof(TLS_SESSION_FIELD(current.master))) == 0;
+        mbedtls_ssl_session_free(&_session);
+        _session = current;  // Takes over its allocations
+        _haveSession = true;
+        _sessionHost = host ? host : "";
+    } else {
+        mbedtls_ssl_session_free(&current);
+        _haveSession = false;
+    }
+    return true;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    IPAddress address;
+    return WiFi.hostByName(host, address) && connect(address, port, host);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!_open || _peerClosed) {
+        return 0;
+    }
+    size_t written = 0;
+    unsigned long startMs = millis();
+    while (written < size) {
+        int ret = mbedtls_ssl_write(&_ssl, buf + written, size - written);
+        if (ret > 0) {
+            written += ret;
+            startMs = millis();
+        } else if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+                   millis() - startMs > _timeoutMs) {
+            fail(ret);
+            _peerClosed = true;
+            break;
+        }
+    }
+    return written;
+}
+
+int TlsClient::available() {
+    if (!_open) {
+        return 0;
+    }
+    int pending = _peek >= 0 ? 1 : 0;
+    if (!_peerClosed && mbedtls_ssl_get_bytes_avail(&_ssl) == 0) {
+        // Let mbedtls take in whatever record has arrived
+        int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            _peerClosed = true;
+            if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+                fail(ret);
+            }
+        }
+    }
+    return pending + (int)mbedtls_ssl_get_bytes_avail(&_ssl);
+}
+
+int TlsClient::read() {
+    uint8_t byte;
+    return read(&byte, 1) == 1 ? byte : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0 || available() <= 0) {
+        return -1;
+    }
+    size_t n = 0;
+    if (_peek >= 0) {
+        buf[n++] = (uint8_t)_peek;
+        _peek = -1;
+    }
+    if (n < size && mbedtls_ssl_get_bytes_avail(&_ssl) > 0) {
+        int ret = mbedtls_ssl_read(&_ssl, buf + n, size - n);
+        if (ret > 0) {
+            n += ret;
+        }
+    }
+    return (int)n;
+}
+
+int TlsClient::peek() {
+    if (_peek < 0) {
+        uint8_t byte;
+        if (read(&byte, 1) == 1) {
+            _peek = byte;
+        }
+    }
+    return _peek;
+}
+
+void TlsClient::stop() {
+    if (_open) {
+        if (!_peerClosed) {
+            mbedtls_ssl_close_notify(&_ssl);
+        }
+        _socket.stop();
+        mbedtls_ssl_free(&_ssl);
+        mbedtls_ssl_init(&_ssl);
+    }
+    _open = false;
+    _peerClosed = false;
+    _peek = -1;
+}
+
+uint8_t TlsClient::connected() {
+    if (!_open) {
+        return 0;
+    }
+    if (available() > 0) {
+        return 1;
+    }
+    return !_peerClosed && _socket.connected();
+}
+
+bool TlsClient::fail(int error) {
+    _lastError = error;
+    char text[80];
+    mbedtls_strerror(error, text, sizeof(text));
+    SDLogger::getInstance().debugf("TlsClient: %s (-0x%04x)", text, -error);
+    return false;
+}
+
+int TlsClient::sendCallback(void* context, const unsigned char* buf, size_t len) {
+    TlsClient* self = (TlsClient*)context;
+    if (!self->_socket.connected()) {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    size_t n = self->_socket.write(buf, len);
+    return n > 0 ? (int)n : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int TlsClient::receiveCallback(void* context, unsigned char* buf, size_t len) {
+    TlsClient* self = (TlsClient*)context;
+    if (self->_socket.available() <= 0) {
+        return self->_socket.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int n = self->_socket.read(buf, len);
+    return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
@@ -0,0 +1,90 @@
+#ifndef CATCAM_TLSCLIENT_H
+#define CATCAM_TLSCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+#include <WiFiClient.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl.h>
+
+/**
+ * TlsClient - TLS over a WiFiClient socket that resumes its last session
+ *
+ * WiFiClientSecure cannot resume: its connect() runs start_ssl_client(),
+ * which re-initialises the mbedtls context and handshakes in one call, so
+ * there is no point between mbedtls_ssl_setup() and the handshake to
+ * mbedtls_ssl_set_session(). This client drives mbedtls itself. After each
+ * handshake it keeps the session (ID or ticket); the next connect to the
+ * same host offers it, and a server that still knows it skips the key
+ * exchange and certificate - the expensive part on the ESP32.
+ *
+ * Like WiFiClientSecure with setInsecure(), the server certificate is not
+ * verified. The record buffers (~32 KB of internal RAM) are only held
+ * while connected; the saved session is a few hundred bytes.
+ */
+class TlsClient : public Client {
+public:
+    TlsClient();
+    ~TlsClient() override;
+
+    /**
+     * TCP connect and handshake
+     * @param host SNI name; a saved session is offered only to the same host
+     */
+    bool connect(const IPAddress& address, uint16_t port, const char* host);
+
+    int connect(IPAddress ip, uint16_t port) override { return connect(ip, port, nullptr); }
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t byte) override { return write(&byte, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    /**
+     * Handshake and socket timeout
+     */
+    void setTimeoutMs(uint32_t timeoutMs) { _timeoutMs = timeoutMs; }
+
+    /**
+     * Whether the last connect() resumed the saved session
+     */
+    bool resumed() const { return _resumed; }
+
+    /**
+     * mbedtls error of the last failure (0 = none)
+     */
+    int lastError() const { return _lastError; }
+
+private:
+    WiFiClient _socket;
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _config;
+    mbedtls_ctr_drbg_context _drbg;
+    mbedtls_entropy_context _entropy;
+    bool _configured = false;
+    bool _open = false;        // Handshake done, until stop()
+    bool _peerClosed = false;  // close_notify or reset seen
+    int _peek = -1;
+    uint32_t _timeoutMs = 10000;
+    int _lastError = 0;
+
+    mbedtls_ssl_session _session;
+    bool _haveSession = false;
+    String _sessionHost;
+    bool _resumed = false;
+
+    bool configure();
+    bool fail(int error);
+    static int sendCallback(void* context, const unsigned char* buf, size_t len);
+    static int receiveCallback(void* context, unsigned char* buf, size_t len);
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "WiFiApiTransport.h"
+#include <WiFi.h>
+#include "ApiConnection.h"
+
+// Here rather than in ApiConnection.cpp, so the connection builds without
+// the WiFi and mbedtls stack (host tests)
+ApiConnection& ApiConnection::getInstance() {
+    static WiFiApiTransport transport;
+    static ApiConnection instance(transport);
+    return instance;
+}
+
+bool WiFiApiTransport::resolve(const char* host, IPAddress& address) {
+    return WiFi.hostByName(host, address);
+}
+
+bool WiFiApiTransport::connect(const IPAddress& address, uint16_t port, const char* host) {
+    return _client.connect(address, port, host);
+}
@@ -0,0 +1,23 @@
+#ifndef CATCAM_WIFIAPITRANSPORT_H
+#define CATCAM_WIFIAPITRANSPORT_H
+
+#include "ApiTransport.h"
+#include "TlsClient.h"
+
+/**
+ * TlsClient over the station interface, resuming the API host's session
+ * on reconnect
+ */
+class WiFiApiTransport : public IApiTransport {
+public:
+    Client& client() override { return _client; }
+    bool resolve(const char* host, IPAddress& address) override;
+    bool connect(const IPAddress& address, uint16_t port, const char* host) override;
+    void setTimeout(uint32_t timeoutMs) override { _client.setTimeoutMs(timeoutMs); }
+    bool resumed() const override { return _client.resumed(); }
+
+private:
+    TlsClient _client;
+};
+
+#endif
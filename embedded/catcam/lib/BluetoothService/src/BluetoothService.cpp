@@ -1,5 +1,6 @@
 #include "BluetoothService.h"
 #include <algorithm>
+#include "../../JpegTools/src/JpegMetadata.h"
 
 // External reference to systemState defined in main.cpp
 extern SystemState systemState;
@@ -316,6 +317,22 @@ void BootBootsBluetoothService::processCommand(const String& command) {
             serializeJson(errorDoc, errorJson);
             sendResponse(errorJson);
         }
+    } else if (cmd == "get_thumbnail") {
+        // Reduced copies made by ImageStorage: 1/8 scale, or 1/4 with "preview"
+        String filename = doc["filename"] | "";
+        bool preview = doc["preview"] | false;
+        if (filename.length() > 0) {
+            SDLogger::getInstance().infof("Thumbnail request via command: %s%s", filename.c_str(), preview ? " (preview)" : "");
+            sendImage(String(preview ? "previews/" : "thumbs/") + filename);
+        } else {
+            SDLogger::getInstance().warnf("get_thumbnail command missing filename");
+            DynamicJsonDocument errorDoc(128);
+            errorDoc["type"] = "error";
+            errorDoc["message"] = "Missing filename parameter";
+            String errorJson;
+            serializeJson(errorDoc, errorJson);
+            sendResponse(errorJson);
+        }
     } else if (cmd == "get_image_metadata") {
         String filename = doc["filename"] | "";
         if (filename.length() > 0) {
@@ -347,12 +364,12 @@ void BootBootsBluetoothService::sendResponse(const String& response) {
     }
 }
 
-std::vector<String> BootBootsBluetoothService::listImages() {
+std::vector<String> BootBootsBluetoothService::listImages(const char* dirPath) {
     std::vector<String> imageFiles;
 
-    File dir = SD_MMC.open("/images");
+    File dir = SD_MMC.open(dirPath);
     if (!dir || !dir.isDirectory()) {
-        SDLogger::getInstance().warnf("Failed to open /images directory");
+        SDLogger::getInstance().warnf("Failed to open %s directory", dirPath);
         return imageFiles;
     }
 
@@ -375,6 +392,8 @@ std::vector<String> BootBootsBluetoothService::listImages() {
 void BootBootsBluetoothService::sendImageList() {
     std::vector<String> images = listImages();
     size_t totalImages = images.size();
+    // One scan of the thumbnail directory rather than an exists() lookup per image
+    std::vector<String> thumbnails = listImages("/images/thumbs");
 
     SDLogger::getInstance().infof("Sending image list: %d images", totalImages);
 
@@ -385,6 +404,7 @@ void BootBootsBluetoothService::sendImageList() {
         chunkDoc["chunk"] = i;
         chunkDoc["total"] = totalImages;
         chunkDoc["filename"] = images[i];
+        chunkDoc["thumbnail"] = std::binary_search(thumbnails.begin(), thumbnails.end(), images[i]);
 
         String chunkJson;
         serializeJson(chunkDoc, chunkJson);
@@ -542,6 +562,10 @@ void BootBootsBluetoothService::sendImageMetadata(const String& filename) {
 
     File file = SD_MMC.open(filepath.c_str(), FILE_READ);
     if (!file) {
+        // No sidecar: the result is embedded in the image itself
+        if (sendEmbeddedMetadata(filename)) {
+            return;
+        }
         SDLogger::getInstance().warnf("Metadata file not found: %s", filepath.c_str());
         DynamicJsonDocument errorDoc(256);
         errorDoc["type"] = "metadata_result";
@@ -574,6 +598,47 @@ void BootBootsBluetoothService::sendImageMetadata(const String& filename) {
     SDLogger::getInstance().infof("Metadata transfer complete for: %s", filename.c_str());
 }
 
+bool BootBootsBluetoothService::sendEmbeddedMetadata(const String& filename) {
+    String filepath = "/images/" + filename;
+    File file = SD_MMC.open(filepath.c_str(), FILE_READ);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[512];
+    size_t read = file.read(header, sizeof(header));
+    file.close();
+
+    InferenceMetadata metadata;
+    if (!readJpegMetadata(header, read, metadata)) {
+        return false;
+    }
+
+    // Same shape as the inference response the .txt sidecars hold
+    DynamicJsonDocument contentDoc(384);
+    contentDoc["success"] = true;
+    JsonObject mostLikelyCat = contentDoc.createNestedObject("mostLikelyCat");
+    mostLikelyCat["name"] = metadata.name;
+    mostLikelyCat["index"] = metadata.index;
+    mostLikelyCat["confidence"] = metadata.confidence;
+    contentDoc["latencyMs"] = metadata.latencyMs;
+    contentDoc["firmware"] = metadata.firmware;
+    String content;
+    serializeJson(contentDoc, content);
+
+    DynamicJsonDocument resultDoc(1024);
+    resultDoc["type"] = "metadata_result";
+    resultDoc["filename"] = filename;
+    resultDoc["found"] = true;
+    resultDoc["content"] = content;
+
+    String resultJson;
+    serializeJson(resultDoc, resultJson);
+    sendResponse(resultJson);
+
+    SDLogger::getInstance().infof("Sent embedded metadata for: %s", filename.c_str());
+    return true;
+}
+
 void BootBootsBluetoothService::sendLogList() {
     std::vector<String> logFiles = SDLogger::getInstance().listLogFiles();
     size_t totalLogs = logFiles.size();
@@ -100,10 +100,11 @@ private:
     void sendResponse(const String& response);
 
     // Image transfer methods
-    std::vector<String> listImages();
+    std::vector<String> listImages(const char* dirPath = "/images");  // Sorted .jpg names in dirPath
     void sendImageList();
     void sendImage(const String& filename);
     void sendImageMetadata(const String& filename);
+    bool sendEmbeddedMetadata(const String& filename);
 
     // Log file transfer methods
     void sendLogList();
@@ -1,5 +1,34 @@
 #include "Camera.h"
 #include "../../SDLogger/src/SDLogger.h"
+#include "../../SlabAllocator/src/SlabAllocator.h"
+#include <esp_heap_caps.h>
+#include <mbedtls/md.h>
+
+namespace {
+
+// Software power-down bit per sensor, in set_reg() addressing
+bool standbyRegister(const sensor_t* s, int& reg, int& mask) {
+    switch (s->id.PID) {
+        case OV5640_PID:
+        case OV3660_PID:
+            reg = 0x3008;   // SYSTEM CTRL0, bit 6
+            mask = 0x40;
+            return true;
+        case OV2640_PID:
+            reg = 0x109;    // COM2 (sensor bank), bit 4
+            mask = 0x10;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// SOI at the start and EOI at the end (the driver trims JPEG frames to EOI)
+bool isCompleteJpeg(const uint8_t* buf, size_t len) {
+    return len >= 4 && buf[0] == 0xFF && buf[1] == 0xD8 && buf[len - 2] == 0xFF && buf[len - 1] == 0xD9;
+}
+
+}
 
 Camera::Camera() {
     failureCount = 0;
@@ -8,6 +37,25 @@ Camera::Camera() {
 void Camera::init(const CameraSettings& settings) {
     SDLogger::getInstance().infof("Initializing ESP32-CAM...");
 
+    // Initialize camera (the sensor comes back with driver defaults)
+    _appliedValid = false;
+    _profile = CameraProfile::Photo;
+    if (!startDriver(CameraDriverConfig::forUseCase(settings, CameraUseCase::Stills),
+                     settings.frameSize, settings.jpegQuality)) {
+        failureCount++;
+        _initialized = false;
+        return;
+    }
+
+    // Apply sensor settings (brightness, contrast, etc.)
+    applySettings(settings);
+
+    _initialized = true;
+    SDLogger::getInstance().infof("ESP32-CAM initialized successfully");
+    failureCount = 0;
+}
+
+bool Camera::startDriver(const CameraDriverConfig& driver, int frameSize, int jpegQuality) {
     camera_config_t config;
     config.ledc_channel = LEDC_CHANNEL_0;
     config.ledc_timer = LEDC_TIMER_0;
@@ -27,37 +75,102 @@ void Camera::init(const CameraSettings& settings) {
     config.pin_sccb_scl = SIOC_GPIO_NUM;
     config.pin_pwdn = PWDN_GPIO_NUM;
     config.pin_reset = RESET_GPIO_NUM;
-    config.xclk_freq_hz = 20000000;
+    config.xclk_freq_hz = driver.xclkMHz * 1000000;
     config.pixel_format = PIXFORMAT_JPEG;
 
     // Use settings for frame size, quality, and buffer count
-    config.frame_size = (framesize_t)settings.frameSize;
-    config.jpeg_quality = settings.jpegQuality;
+    config.frame_size = (framesize_t)frameSize;
+    config.jpeg_quality = jpegQuality;
 
+    _driver = driver;
+    _standby = false;  // esp_camera_init() resets the sensor
     if (psramFound()) {
-        config.fb_count = settings.fbCount;
-        SDLogger::getInstance().infof("PSRAM found - frameSize=%d, quality=%d, fbCount=%d",
-            settings.frameSize, settings.jpegQuality, settings.fbCount);
+        SDLogger::getInstance().infof("PSRAM found - frameSize=%d, quality=%d, fbCount=%d, xclk=%d MHz, buffers in %s",
+            frameSize, jpegQuality, driver.fbCount, driver.xclkMHz, driver.fbInPsram ? "PSRAM" : "DRAM");
     } else {
-        config.fb_count = 1;  // Multiple buffers require PSRAM
-        SDLogger::getInstance().warnf("PSRAM not found - forcing fbCount=1");
+        _driver.fbCount = 1;  // Multiple buffers require PSRAM
+        _driver.fbInPsram = false;
+        SDLogger::getInstance().warnf("PSRAM not found - forcing fbCount=1 in DRAM");
     }
+    config.fb_count = _driver.fbCount;
+    config.fb_location = _driver.fbInPsram ? CAMERA_FB_IN_PSRAM : CAMERA_FB_IN_DRAM;
+
+    // Holding the only driver buffer for the length of an upload would stall
+    // the sensor, so single-buffer configurations fall back to copying frames
+    _copyMode = config.fb_count < 2;
+
+    // With spare buffers, let the driver keep overwriting so fb_get always
+    // returns the newest frame rather than one queued before a trigger
+    config.grab_mode = _copyMode ? CAMERA_GRAB_WHEN_EMPTY : CAMERA_GRAB_LATEST;
 
-    // Initialize camera
     esp_err_t err = esp_camera_init(&config);
     if (err != ESP_OK) {
         SDLogger::getInstance().errorf("Camera init failed with error 0x%x", err);
-        failureCount++;
-        _initialized = false;
-        return;
+        return false;
     }
+    return true;
+}
 
-    // Apply sensor settings (brightness, contrast, etc.)
-    applySettings(settings);
+bool Camera::reconfigure(const CameraDriverConfig& driver, CameraDriverHeap* heap) {
+    if (!_initialized) {
+        return false;
+    }
 
-    _initialized = true;
-    SDLogger::getInstance().infof("ESP32-CAM initialized successfully");
-    failureCount = 0;
+    CameraDriverConfig previous = _driver;
+    const CameraSettings& target = _profiles[(size_t)_profile];
+
+    esp_camera_deinit();
+    _appliedValid = false;
+    size_t freeDram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t freePsram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    bool started = startDriver(driver, target.frameSize, target.jpegQuality);
+    if (started && heap) {
+        heap->dramBytes = (int32_t)freeDram - (int32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        heap->psramBytes = (int32_t)freePsram - (int32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    }
+    if (!started) {
+        SDLogger::getInstance().warnf("Camera driver config rejected - restoring fbCount=%d, xclk=%d MHz",
+            previous.fbCount, previous.xclkMHz);
+        esp_camera_deinit();
+        if (!startDriver(previous, target.frameSize, target.jpegQuality)) {
+            failureCount++;
+            _initialized = false;
+            return false;
+        }
+    }
+
+    sensor_t* s = esp_camera_sensor_get();
+    if (s) {
+        writeSensor(s, target, CAMERA_SETTINGS_ALL);
+    }
+    return started;
+}
+
+bool Camera::useDriverFor(CameraUseCase useCase) {
+    CameraDriverConfig driver = CameraDriverConfig::forUseCase(_settings, useCase);
+    if (driver == _driver || !psramFound()) {  // Without PSRAM there is only one configuration
+        return true;
+    }
+    SDLogger::getInstance().infof("Restarting camera driver for %s", useCase == CameraUseCase::Video ? "video" : "stills");
+    return reconfigure(driver);
+}
+
+void Camera::setJpegQuality(CameraProfile profile, int quality) {
+    int& target = _profiles[(size_t)profile].jpegQuality;
+    if (target == quality && (profile != _profile || _applied.jpegQuality == quality)) {
+        return;
+    }
+    target = quality;
+    if (profile != _profile) {
+        return;  // Picked up when the profile is switched in
+    }
+    sensor_t* s = esp_camera_sensor_get();
+    if (s == nullptr) {
+        SDLogger::getInstance().errorf("Cannot set JPEG quality - sensor not available");
+        return;
+    }
+    s->set_quality(s, quality);
+    _applied.jpegQuality = quality;
 }
 
 void Camera::applySettings(const CameraSettings& settings) {
@@ -67,128 +180,305 @@ void Camera::applySettings(const CameraSettings& settings) {
         return;
     }
 
-    s->set_framesize(s, (framesize_t)settings.frameSize);
-    s->set_quality(s, settings.jpegQuality);
+    _settings = settings;
+    compileProfiles(settings);
+    const CameraSettings& target = _profiles[(size_t)_profile];
+
+    // Each register write is an SCCB transaction; skip the ones already in place
+    CameraSettingsMask dirty = _appliedValid ? diffCameraSettings(_applied, target) : CAMERA_SETTINGS_ALL;
+    int written = writeSensor(s, target, dirty);
     // fbCount can only be set during init() - requires camera reinit
-    s->set_brightness(s, settings.brightness);
-    s->set_contrast(s, settings.contrast);
-    s->set_saturation(s, settings.saturation);
-    s->set_special_effect(s, settings.specialEffect);
-    s->set_whitebal(s, settings.whiteBalance ? 1 : 0);
-    s->set_awb_gain(s, settings.awbGain ? 1 : 0);
-    s->set_wb_mode(s, settings.wbMode);
-    s->set_exposure_ctrl(s, settings.exposureCtrl ? 1 : 0);
-    s->set_aec2(s, settings.aec2 ? 1 : 0);
-    s->set_ae_level(s, settings.aeLevel);
-    s->set_aec_value(s, settings.aecValue);
-    s->set_gain_ctrl(s, settings.gainCtrl ? 1 : 0);
-    s->set_agc_gain(s, settings.agcGain);
-    s->set_gainceiling(s, (gainceiling_t)settings.gainCeiling);
-    s->set_bpc(s, settings.bpc ? 1 : 0);
-    s->set_wpc(s, settings.wpc ? 1 : 0);
-    s->set_raw_gma(s, settings.rawGma ? 1 : 0);
-    s->set_lenc(s, settings.lenc ? 1 : 0);
-    s->set_hmirror(s, settings.hmirror ? 1 : 0);
-    s->set_vflip(s, settings.vflip ? 1 : 0);
-    s->set_dcw(s, settings.dcw ? 1 : 0);
-    s->set_colorbar(s, settings.colorbar ? 1 : 0);
     ledDelayMillis = settings.ledDelayMillis;
-    SDLogger::getInstance().infof("Camera settings applied");
+    SDLogger::getInstance().infof("Camera settings applied (%s profile, %d sensor registers written)",
+        cameraProfileName(_profile), written);
 }
 
-NamedImage* Camera::getImage() {
-    // Flush stale frames from the buffer pool
-    // With fb_count=2, old frames may be sitting in the queue
-    // At ~15fps, each frame takes ~66ms, so we need longer delays
-    for (int i = 0; i < 4; i++) {
-        camera_fb_t* stale = esp_camera_fb_get();
-        if (stale) {
-            esp_camera_fb_return(stale);
+uint32_t Camera::setProfile(CameraProfile profile) {
+    if (profile == _profile && _appliedValid) {
+        return 0;
+    }
+    sensor_t* s = esp_camera_sensor_get();
+    if (s == nullptr) {
+        SDLogger::getInstance().errorf("Cannot switch camera profile - sensor not available");
+        return 0;
+    }
+
+    int64_t startUs = esp_timer_get_time();
+    CameraProfile from = _profile;
+    const CameraSettings& target = _profiles[(size_t)profile];
+
+    CameraSettingsMask dirty = _appliedValid ? diffCameraSettings(_applied, target) : CAMERA_SETTINGS_ALL;
+    bool resized = !_appliedValid || _applied.frameSize != target.frameSize;
+    int written = writeSensor(s, target, dirty);
+    _profile = profile;
+
+    // Frames already in flight still have the old size - drop just those
+    // (none arrive in standby; resume() waits for the new size instead)
+    int discarded = 0;
+    if (resized && !_standby) {
+        const resolution_info_t& size = resolution[target.frameSize];
+        int64_t deadlineUs = startUs + (int64_t)PROFILE_SWITCH_TIMEOUT_MS * 1000;
+        int settleFrames = PROFILE_SETTLE_FRAMES;
+        while (esp_timer_get_time() < deadlineUs) {
+            camera_fb_t* fb = esp_camera_fb_get();
+            if (!fb) {
+                break;
+            }
+            bool newSize = fb->width == size.width && fb->height == size.height;
+            esp_camera_fb_return(fb);
+            discarded++;
+            if (newSize && --settleFrames <= 0) {
+                break;
+            }
         }
-        delay(100);  // Wait for fresh frame capture
     }
 
-    // Now capture the actual frame
-    camera_fb_t* fb = esp_camera_fb_get();
-    if (!fb) {
-        SDLogger::getInstance().errorf("Camera capture failed");
-        failureCount++;
-        return nullptr;
+    uint32_t elapsedMs = (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    uint32_t& average = _profileSwitchMs[(size_t)from][(size_t)profile];
+    average = average ? (average * 3 + elapsedMs) / 4 : max(elapsedMs, (uint32_t)1);
+
+    SDLogger::getInstance().infof("Camera profile %s -> %s: %d registers, %d frames dropped, %lu ms",
+        cameraProfileName(from), cameraProfileName(profile), written, discarded, (unsigned long)elapsedMs);
+    return elapsedMs;
+}
+
+void Camera::compileProfiles(const CameraSettings& base) {
+    for (size_t p = 0; p < CAMERA_PROFILE_COUNT; p++) {
+        CameraSettings& compiled = _profiles[p];
+        compiled = base;
+        const CameraProfileDescriptor& profile = CAMERA_PROFILES[p];
+        for (size_t i = 0; i < profile.overrideCount; i++) {
+            int index = findCameraSetting(profile.overrides[i].setting);
+            if (index >= 0) {
+                setCameraSetting(compiled, index, profile.overrides[i].value);
+            }
+        }
     }
+}
 
-    if (fb->len == 0) {
-        SDLogger::getInstance().errorf("Camera captured empty frame");
-        esp_camera_fb_return(fb);
-        failureCount++;
-        return nullptr;
+int Camera::writeSensor(sensor_t* s, const CameraSettings& target, CameraSettingsMask dirty) {
+    int written = 0;
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        const CameraSettingDescriptor& d = CAMERA_SETTINGS[i];
+        if (!(dirty & (1ULL << i)) || !d.apply) {
+            continue;
+        }
+        if (d.apply(s, getCameraSetting(target, i)) != 0) {
+            SDLogger::getInstance().warnf("Sensor rejected %s=%d", d.name, getCameraSetting(target, i));
+        }
+        written++;
     }
-    
-    // Create NamedImage with timestamp
-    NamedImage* namedImage = new NamedImage();
-    if (!namedImage) {
-        SDLogger::getInstance().errorf("Failed to allocate NamedImage");
-        esp_camera_fb_return(fb);
-        return nullptr;
+    _applied = target;
+    _appliedValid = true;
+    return written;
+}
+
+FrameLease Camera::captureFrame() {
+    return captureFrameAfter(esp_timer_get_time());
+}
+
+FrameLease Camera::captureFrameAfter(int64_t sinceUs, uint32_t maxWaitMs, bool hashCopy) {
+    if (_standby) {
+        // fb_get would block for the driver's 4s timeout
+        SDLogger::getInstance().errorf("Camera in standby - cannot capture");
+        return FrameLease();
+    }
+
+    int64_t startUs = esp_timer_get_time();
+    int64_t deadlineUs = startUs + (int64_t)maxWaitMs * 1000;
+    int64_t previousReadoutUs = 0;
+    int discarded = 0;
+
+    while (true) {
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            SDLogger::getInstance().errorf("Camera capture failed");
+            failureCount++;
+            return FrameLease();
+        }
+
+        // The driver stamps a frame when its readout starts; exposure began
+        // roughly one frame period earlier
+        int64_t readoutUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+        if (previousReadoutUs > 0) {
+            int64_t periodUs = readoutUs - previousReadoutUs;
+            if (periodUs >= MIN_FRAME_PERIOD_US && periodUs <= MAX_FRAME_PERIOD_US) {
+                _framePeriodUs = periodUs;
+            }
+        }
+        previousReadoutUs = readoutUs;
+
+        bool fresh = (readoutUs - _framePeriodUs) >= sinceUs;
+        bool timedOut = esp_timer_get_time() >= deadlineUs;
+
+        if (!fresh && !timedOut) {
+            esp_camera_fb_return(fb);
+            discarded++;
+            continue;
+        }
+
+        if (!fresh) {
+            SDLogger::getInstance().warnf("No fresh frame within %u ms - using newest available", maxWaitMs);
+        }
+
+        if (fb->len == 0) {
+            SDLogger::getInstance().errorf("Camera captured empty frame");
+            esp_camera_fb_return(fb);
+            failureCount++;
+            return FrameLease();
+        }
+
+        FrameLease frame = leaseFrame(fb, hashCopy);
+        if (!frame) {
+            failureCount++;
+            return frame;
+        }
+
+        int waitedMs = (int)((esp_timer_get_time() - startUs) / 1000);
+        SDLogger::getInstance().infof("Fresh frame in %d ms (%d stale discarded, saved ~%d ms vs %d ms flush)",
+            waitedMs, discarded, LEGACY_FLUSH_MS - waitedMs, LEGACY_FLUSH_MS);
+        SDLogger::getInstance().debugf("Captured frame (%d bytes, %s)", frame.size(), frame.isCopy() ? "copied" : "zero-copy");
+        failureCount = 0;
+
+        return frame;
     }
-    
-    // Generate filename with timestamp
-    char filename[32];
-    snprintf(filename, sizeof(filename), "img_%lu.jpg", millis());
-    namedImage->filename = String(filename);
-    
-    // Copy image data to PSRAM if available, otherwise regular heap
-    namedImage->image = copyToPSRAM(fb->buf, fb->len);
-    namedImage->size = fb->len;
-    
-    // Return the camera frame buffer
-    esp_camera_fb_return(fb);
-    
-    SDLogger::getInstance().debugf("Captured image: %s (%d bytes)", filename, namedImage->size);
-    failureCount = 0;
-    
-    return namedImage;
 }
 
 void Camera::deInit() {
     esp_camera_deinit();
+    _appliedValid = false;
+    _standby = false;
     SDLogger::getInstance().infof("Camera deinitialized");
 }
 
-void Camera::copyImageToPSRAM(NamedImage* namedImage) {
-    if (!namedImage || !namedImage->image) {
-        return;
+bool Camera::standby() {
+    if (!_initialized || _standby) {
+        return _standby;
     }
-    
-    // Image data is already copied in getImage() method
-    // This method is kept for compatibility
+    sensor_t* s = esp_camera_sensor_get();
+    int reg;
+    int mask;
+    if (s == nullptr || !standbyRegister(s, reg, mask)) {
+        SDLogger::getInstance().warnf("Camera standby not supported on this sensor");
+        return false;
+    }
+    if (s->set_reg(s, reg, mask, mask) < 0) {
+        SDLogger::getInstance().errorf("Camera standby: sensor rejected power-down write");
+        return false;
+    }
+    _standby = true;
+    SDLogger::getInstance().infof("Camera sensor in standby");
+    return true;
 }
 
-void Camera::releaseImageBuffer(NamedImage* namedImage) {
-    if (!namedImage) {
-        return;
+bool Camera::resume(CameraResumeReport* report) {
+    if (!_standby) {
+        return _initialized;
     }
-    
-    if (namedImage->image) {
-        freePSRAM(namedImage->image);
-        namedImage->image = nullptr;
-        namedImage->size = 0;
+
+    CameraResumeReport result;
+    int64_t startUs = esp_timer_get_time();
+    sensor_t* s = esp_camera_sensor_get();
+    int reg;
+    int mask;
+    bool woken = s != nullptr && standbyRegister(s, reg, mask) && s->set_reg(s, reg, mask, 0) >= 0;
+    _standby = false;
+    result.fast = woken && waitForValidFrame(startUs, RESUME_TIMEOUT_MS, result.framesDiscarded);
+
+    if (!result.fast) {
+        // Registers lost or the sensor did not start streaming - full init
+        SDLogger::getInstance().warnf("Camera fast resume failed - restarting driver");
+        if (!reconfigure(_driver)) {
+            return false;
+        }
+        waitForValidFrame(startUs, PROFILE_SWITCH_TIMEOUT_MS, result.framesDiscarded);
     }
-    
-    delete namedImage;
+
+    result.elapsedMs = (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    SDLogger::getInstance().infof("Camera resumed (%s): first valid frame in %lu ms, %d frames dropped",
+        result.fast ? "fast" : "driver restart", (unsigned long)result.elapsedMs, result.framesDiscarded);
+    if (report) {
+        *report = result;
+    }
+    return true;
 }
 
-uint8_t* Camera::copyToPSRAM(const uint8_t* src, size_t size) {
+bool Camera::waitForValidFrame(int64_t sinceUs, uint32_t timeoutMs, int& discarded) {
+    const resolution_info_t& size = resolution[_profiles[(size_t)_profile].frameSize];
+    int64_t deadlineUs = esp_timer_get_time() + (int64_t)timeoutMs * 1000;
+    while (esp_timer_get_time() < deadlineUs) {
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            return false;
+        }
+        // Buffers filled before standby are still queued - judge by readout time
+        int64_t readoutUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+        bool valid = readoutUs >= sinceUs && fb->width == size.width && fb->height == size.height &&
+                     isCompleteJpeg(fb->buf, fb->len);
+        esp_camera_fb_return(fb);
+        if (valid) {
+            return true;
+        }
+        discarded++;
+    }
+    return false;
+}
+
+FrameLease Camera::leaseFrame(camera_fb_t* fb, bool hashCopy) {
+    int64_t timestampUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+
+    if (!_copyMode) {
+        return FrameLease(fb->buf, fb->len, timestampUs, fb, &Camera::returnDriverFrame, this);
+    }
+
+    // Single frame buffer: copy out and give the buffer straight back
+    uint8_t digest[FrameLease::SHA256_SIZE];
+    bool hashed = false;
+    uint8_t* copy = copyToPSRAM(fb->buf, fb->len, hashCopy ? digest : nullptr, &hashed);
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+
+    if (!copy) {
+        return FrameLease();
+    }
+    FrameLease frame(copy, len, timestampUs, copy, &Camera::freeFrameCopy, this, true);
+    if (hashed) {
+        frame.setSha256(digest);
+    }
+    return frame;
+}
+
+void Camera::returnDriverFrame(void* context, void* handle) {
+    esp_camera_fb_return((camera_fb_t*)handle);
+}
+
+void Camera::freeFrameCopy(void* context, void* handle) {
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    if (slab.owns(handle)) {
+        slab.release(handle);
+    } else {
+        free(handle);  // free() works for both PSRAM and regular heap
+    }
+}
+
+uint8_t* Camera::copyToPSRAM(const uint8_t* src, size_t size, uint8_t* sha256, bool* hashed) {
     if (!src || size == 0) {
         return nullptr;
     }
     
-    uint8_t* dest = nullptr;
-    
+    // Fixed slab blocks first so per-capture copies never fragment PSRAM
+    uint8_t* dest = (uint8_t*)SlabAllocator::getInstance().allocate(size);
+    if (dest) {
+        copyFrame(dest, src, size, sha256, hashed);
+        SDLogger::getInstance().debugf("Allocated %d bytes from slab", size);
+        return dest;
+    }
+
     // Try PSRAM first if available
     if (psramFound()) {
         dest = (uint8_t*)ps_malloc(size);
         if (dest) {
-            memcpy(dest, src, size);
+            copyFrame(dest, src, size, sha256, hashed);
             SDLogger::getInstance().debugf("Allocated %d bytes in PSRAM", size);
             return dest;
         }
@@ -197,7 +487,7 @@ uint8_t* Camera::copyToPSRAM(const uint8_t* src, size_t size) {
     // Fallback to regular heap
     dest = (uint8_t*)malloc(size);
     if (dest) {
-        memcpy(dest, src, size);
+        copyFrame(dest, src, size, sha256, hashed);
         SDLogger::getInstance().debugf("Allocated %d bytes in heap", size);
     } else {
         SDLogger::getInstance().errorf("Failed to allocate %d bytes for image buffer", size);
@@ -206,15 +496,26 @@ uint8_t* Camera::copyToPSRAM(const uint8_t* src, size_t size) {
     return dest;
 }
 
-void Camera::freePSRAM(uint8_t* ptr) {
-    if (!ptr) {
+void Camera::copyFrame(uint8_t* dest, const uint8_t* src, size_t size, uint8_t* sha256, bool* hashed) {
+    if (!sha256) {
+        memcpy(dest, src, size);
         return;
     }
-    
-    // Check if pointer is in PSRAM range
-    if (psramFound() && heap_caps_check_integrity(MALLOC_CAP_SPIRAM, true)) {
-        free(ptr); // free() works for both PSRAM and regular heap
-    } else {
-        free(ptr);
+
+    // One pass over the frame: each chunk is hashed straight after it is
+    // copied, so the upload's payload hash is ready with the copy
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    bool ok = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) == 0 &&
+              mbedtls_md_starts(&ctx) == 0;
+    for (size_t offset = 0; offset < size; offset += COPY_HASH_CHUNK) {
+        size_t chunk = min(COPY_HASH_CHUNK, size - offset);
+        memcpy(dest + offset, src + offset, chunk);
+        ok = ok && mbedtls_md_update(&ctx, dest + offset, chunk) == 0;
     }
-}
\ No newline at end of file
+    ok = ok && mbedtls_md_finish(&ctx, sha256) == 0;
+    mbedtls_md_free(&ctx);
+    if (hashed) {
+        *hashed = ok;
+    }
+}
@@ -6,8 +6,11 @@
 #include <driver/rtc_io.h>
 #include <Preferences.h>
 #include <esp32-hal-psram.h>
+#include <esp_timer.h>
 
-#include "NamedImage.h"
+#include "FrameLease.h"
+#include "CameraSettingsRegistry.h"
+#include "CameraProfiles.h"
 #include "../../../include/SystemState.h"
 
 #ifdef ESP32S3_CAM
@@ -48,32 +51,227 @@
 #define PCLK_GPIO_NUM    22
 #endif
 
+/**
+ * What the camera is being used for - each has its own driver configuration
+ */
+enum class CameraUseCase : uint8_t {
+    Stills,
+    Video
+};
+
+/**
+ * Driver-level options that only take effect through esp_camera_init()
+ */
+struct CameraDriverConfig {
+    int fbCount = 2;
+    int xclkMHz = 20;
+    bool fbInPsram = true;
+
+    bool operator==(const CameraDriverConfig& other) const {
+        return fbCount == other.fbCount && xclkMHz == other.xclkMHz && fbInPsram == other.fbInPsram;
+    }
+    bool operator!=(const CameraDriverConfig& other) const { return !(*this == other); }
+
+    static CameraDriverConfig forUseCase(const CameraSettings& settings, CameraUseCase useCase) {
+        CameraDriverConfig driver;
+        if (useCase == CameraUseCase::Video) {
+            driver.fbCount = settings.videoFbCount;
+            driver.xclkMHz = settings.videoXclkMHz;
+            driver.fbInPsram = settings.videoFbInPsram;
+        } else {
+            driver.fbCount = settings.fbCount;
+            driver.xclkMHz = settings.xclkMHz;
+            driver.fbInPsram = settings.fbInPsram;
+        }
+        return driver;
+    }
+};
+
+/**
+ * Heap taken by a running driver (frame buffers, DMA descriptors, task)
+ */
+struct CameraDriverHeap {
+    int32_t dramBytes = 0;
+    int32_t psramBytes = 0;
+};
+
+/**
+ * How the sensor came back from standby
+ */
+struct CameraResumeReport {
+    bool fast = false;          // Power-down bit cleared; no driver restart was needed
+    uint32_t elapsedMs = 0;     // resume() call to the first valid frame
+    int framesDiscarded = 0;    // Stale (pre-standby), wrong-size or incomplete frames before it
+};
+
 class Camera
 {
 public:
     Camera();
     void init(const CameraSettings& settings = CameraSettings());
+
+    /**
+     * Take new user settings and push the current profile's version of them
+     * to the sensor - only the registers whose values changed since the last
+     * write (everything after init())
+     */
     void applySettings(const CameraSettings& settings);
-    NamedImage* getImage();
+
+    /**
+     * Switch the sensor to a profile in one batch
+     * Only registers that differ are written. After a frame size change,
+     * frames are discarded until the new size comes through, plus the first
+     * one at the new size (OV sensors can corrupt it); otherwise nothing is
+     * waited for.
+     * @return Time the switch took (ms), also kept per profile pair
+     */
+    uint32_t setProfile(CameraProfile profile);
+
+    CameraProfile getProfile() const { return _profile; }
+
+    /**
+     * The user settings with a profile's overrides applied
+     */
+    const CameraSettings& getProfileSettings(CameraProfile profile) const { return _profiles[(size_t)profile]; }
+
+    /**
+     * Average switch time from one profile to another (0 = never switched)
+     */
+    uint32_t getProfileSwitchMs(CameraProfile from, CameraProfile to) const {
+        return _profileSwitchMs[(size_t)from][(size_t)to];
+    }
+
+    /**
+     * Change one profile's JPEG quality (0-63, lower = better), e.g. from a
+     * rate controller; written now if that profile is active. Kept until the
+     * profiles are next compiled from the base settings.
+     */
+    void setJpegQuality(CameraProfile profile, int quality);
+
+    /**
+     * Restart the driver with different buffer count, XCLK or buffer placement
+     * The current profile is written back to the sensor afterwards. If the
+     * new configuration fails to start, the previous one is restored.
+     * @param heap If given, filled with what the new driver allocated
+     * @return true if the requested configuration is running
+     */
+    bool reconfigure(const CameraDriverConfig& driver, CameraDriverHeap* heap = nullptr);
+
+    /**
+     * Switch to the driver configuration stored for a use case (no-op if
+     * it is already running)
+     */
+    bool useDriverFor(CameraUseCase useCase);
+
+    const CameraDriverConfig& getDriverConfig() const { return _driver; }
     void deInit();
     bool isReady() const { return _initialized; }
-    
-    // PSRAM buffer management
-    void copyImageToPSRAM(NamedImage* namedImage);
-    void releaseImageBuffer(NamedImage* namedImage);
+
+    /**
+     * Put the sensor in software standby (power-down bit over SCCB)
+     * The sensor keeps its registers and the driver stays installed, but
+     * no frames arrive: nothing may capture until resume(). Supported on
+     * the OV2640, OV3660 and OV5640.
+     * @return true if the sensor is now in standby
+     */
+    bool standby();
+
+    /**
+     * Bring the sensor out of standby and wait for its first valid frame
+     * Fast path: clear the power-down bit and reuse the register state the
+     * sensor kept. If no complete frame of the current profile's size comes
+     * within RESUME_TIMEOUT_MS, the driver is restarted as reconfigure()
+     * does and the profile written back.
+     * @param report If given, filled with which path ran and how long it took
+     * @return true if the camera is capturing again
+     */
+    bool resume(CameraResumeReport* report = nullptr);
+
+    bool isStandby() const { return _standby; }
+
+    /**
+     * Capture a frame and lease it to the caller
+     * With fbCount >= 2 the lease points straight at the driver buffer and
+     * returns it on destruction. With a single frame buffer the JPEG is copied
+     * out (PSRAM preferred) so the sensor can keep capturing.
+     * Equivalent to captureFrameAfter(now).
+     * @return Frame lease, or an invalid lease on failure
+     */
+    FrameLease captureFrame();
+
+    /**
+     * Capture the first frame whose exposure started at or after sinceUs
+     * Frames queued before that instant are handed straight back to the
+     * driver, replacing the old fixed 4 x 100ms stale-frame flush.
+     * @param sinceUs esp_timer_get_time() instant, e.g. when the flash turned on
+     * @param maxWaitMs Upper bound on the wait; the newest frame is used after this
+     * @param hashCopy In copy mode, SHA-256 the frame in the same pass as the
+     *                 copy (FrameLease::sha256()) - only for a frame that will be
+     *                 uploaded unchanged, since the hash is wasted otherwise
+     * @return Frame lease, or an invalid lease on failure
+     */
+    FrameLease captureFrameAfter(int64_t sinceUs, uint32_t maxWaitMs = 1000, bool hashCopy = false);
+
+    /**
+     * Whether captureFrame() copies frames instead of leasing driver buffers
+     */
+    bool isCopyMode() const { return _copyMode; }
 
     // Settings getters
     int getLedDelayMillis() const { return ledDelayMillis; }
 
+    /**
+     * Measured time between frames; a frame's exposure began about this long
+     * before its timestamp
+     */
+    int64_t getFramePeriodUs() const { return _framePeriodUs; }
+
 private:
     bool _initialized = false;
+    bool _standby = false;
     int failureCount = 0;
     int ledDelayMillis = 100;
+    bool _copyMode = false;
+
+    // Driver configuration in use, and the settings it came from
+    CameraDriverConfig _driver;
+    CameraSettings _settings;
+    bool startDriver(const CameraDriverConfig& driver, int frameSize, int jpegQuality);
+
+    // What the sensor currently holds, for dirty-only writes
+    CameraSettings _applied;
+    bool _appliedValid = false;
+
+    // User settings compiled into each profile
+    CameraProfile _profile = CameraProfile::Photo;
+    CameraSettings _profiles[CAMERA_PROFILE_COUNT];
+    uint32_t _profileSwitchMs[CAMERA_PROFILE_COUNT][CAMERA_PROFILE_COUNT] = {};
+    static constexpr uint32_t PROFILE_SWITCH_TIMEOUT_MS = 1500;
+    static constexpr int PROFILE_SETTLE_FRAMES = 1;  // Frames dropped once the new size shows up
+
+    // Standby: longest wait for a valid frame before falling back to a driver restart
+    static constexpr uint32_t RESUME_TIMEOUT_MS = 1000;
+    bool waitForValidFrame(int64_t sinceUs, uint32_t timeoutMs, int& discarded);
+
+    void compileProfiles(const CameraSettings& base);
+    int writeSensor(sensor_t* s, const CameraSettings& target, CameraSettingsMask dirty);
     Preferences preferences;
-    
-    // PSRAM helper methods
-    uint8_t* copyToPSRAM(const uint8_t* src, size_t size);
-    void freePSRAM(uint8_t* ptr);
+
+    // Frame timing - used to judge when a frame's exposure started
+    static constexpr int64_t MIN_FRAME_PERIOD_US = 20000;
+    static constexpr int64_t MAX_FRAME_PERIOD_US = 250000;
+    static constexpr int LEGACY_FLUSH_MS = 400;  // Old 4 x delay(100) flush, for latency reporting
+    int64_t _framePeriodUs = 66000;              // ~15fps until measured
+
+    // Lease helpers
+    static constexpr size_t COPY_HASH_CHUNK = 4096;  // Copied then hashed while still in cache
+    FrameLease leaseFrame(camera_fb_t* fb, bool hashCopy);
+    uint8_t* copyToPSRAM(const uint8_t* src, size_t size, uint8_t* sha256 = nullptr, bool* hashed = nullptr);
+    static void copyFrame(uint8_t* dest, const uint8_t* src, size_t size, uint8_t* sha256, bool* hashed);
+
+    // FrameLease release callbacks
+    static void returnDriverFrame(void* context, void* handle);
+    static void freeFrameCopy(void* context, void* handle);
 };
 
 
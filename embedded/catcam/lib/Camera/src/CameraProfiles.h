@@ -0,0 +1,83 @@
+#ifndef CATCAM_CAMERAPROFILES_H
+#define CATCAM_CAMERAPROFILES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_camera.h>
+
+/**
+ * Named camera configurations the firmware switches between
+ */
+enum class CameraProfile : uint8_t {
+    Photo,      // The user's camera settings as-is (UXGA by default)
+    Video,      // VGA at quality 12 for AVI recording
+    Night,      // Photo settings pushed for low light: longer AE, more gain
+    Inference,  // SVGA for quick inference-only shots
+    Count
+};
+
+constexpr size_t CAMERA_PROFILE_COUNT = (size_t)CameraProfile::Count;
+static_assert(CAMERA_PROFILE_COUNT == 4, "SystemState::profileSwitchMs and the *_profile setting ranges assume 4 profiles");
+
+/**
+ * One value a profile changes relative to the user's camera settings
+ */
+struct CameraProfileOverride {
+    const char* setting;    // CAMERA_SETTINGS name
+    int value;
+};
+
+struct CameraProfileDescriptor {
+    const char* name;
+    const CameraProfileOverride* overrides;
+    size_t overrideCount;
+};
+
+namespace camera_profiles {
+inline constexpr CameraProfileOverride VIDEO[] = {
+    { "frame_size", FRAMESIZE_VGA },
+    { "jpeg_quality", 12 },
+};
+inline constexpr CameraProfileOverride NIGHT[] = {
+    { "aec2", 1 },
+    { "ae_level", 2 },
+    { "gain_ceiling", 4 },
+};
+inline constexpr CameraProfileOverride INFERENCE[] = {
+    { "frame_size", FRAMESIZE_SVGA },
+    { "jpeg_quality", 12 },
+};
+}
+
+/**
+ * CAMERA_PROFILES - Indexed by CameraProfile
+ *
+ * Profiles are overlays on the user's settings, so e.g. mirror/flip and
+ * white balance carry over into video. Camera compiles each overlay into a
+ * full settings set whenever the base settings change, and a switch writes
+ * only the registers that differ between what the sensor holds and the
+ * target profile.
+ */
+inline constexpr CameraProfileDescriptor CAMERA_PROFILES[CAMERA_PROFILE_COUNT] = {
+    { "photo", nullptr, 0 },
+    { "video", camera_profiles::VIDEO, sizeof(camera_profiles::VIDEO) / sizeof(CameraProfileOverride) },
+    { "night", camera_profiles::NIGHT, sizeof(camera_profiles::NIGHT) / sizeof(CameraProfileOverride) },
+    { "inference", camera_profiles::INFERENCE, sizeof(camera_profiles::INFERENCE) / sizeof(CameraProfileOverride) },
+};
+
+inline const char* cameraProfileName(CameraProfile profile) {
+    return (size_t)profile < CAMERA_PROFILE_COUNT ? CAMERA_PROFILES[(size_t)profile].name : "unknown";
+}
+
+/**
+ * "from>to" names for profile switch timings, indexed [from][to]; static so
+ * JSON documents can key on them without copying
+ */
+inline constexpr const char* CAMERA_PROFILE_SWITCH_NAMES[CAMERA_PROFILE_COUNT][CAMERA_PROFILE_COUNT] = {
+    { "photo>photo", "photo>video", "photo>night", "photo>inference" },
+    { "video>photo", "video>video", "video>night", "video>inference" },
+    { "night>photo", "night>video", "night>night", "night>inference" },
+    { "inference>photo", "inference>video", "inference>night", "inference>inference" },
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "CameraSettingsRegistry.h"
+#include <string.h>
+#include "../../SDLogger/src/SDLogger.h"
+
+namespace {
+
+const char* BLOB_KEY = "camSettings";
+
+// Values are stored by table index; count lets an older blob (fewer
+// settings) load with defaults for the ones appended since
+struct CameraSettingsBlob {
+    uint8_t version;
+    uint8_t count;
+    uint8_t reserved[2];
+    int32_t values[CAMERA_SETTING_COUNT];
+};
+
+}
+
+int findCameraSetting(const char* name) {
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        if (strcmp(CAMERA_SETTINGS[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int getCameraSetting(const CameraSettings& settings, size_t index) {
+    const CameraSettingDescriptor& d = CAMERA_SETTINGS[index];
+    return d.isBool() ? (settings.*d.boolField ? 1 : 0) : settings.*d.intField;
+}
+
+int setCameraSetting(CameraSettings& settings, size_t index, int value) {
+    const CameraSettingDescriptor& d = CAMERA_SETTINGS[index];
+    value = value < d.minValue ? d.minValue : (value > d.maxValue ? d.maxValue : value);
+    if (d.isBool()) {
+        settings.*d.boolField = value != 0;
+    } else {
+        settings.*d.intField = value;
+    }
+    return value;
+}
+
+CameraSettingsMask diffCameraSettings(const CameraSettings& a, const CameraSettings& b) {
+    CameraSettingsMask mask = 0;
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        if (getCameraSetting(a, i) != getCameraSetting(b, i)) {
+            mask |= 1ULL << i;
+        }
+    }
+    return mask;
+}
+
+bool loadCameraSettingsBlob(Preferences& prefs, CameraSettings& settings) {
+    CameraSettingsBlob blob;
+    size_t length = prefs.getBytesLength(BLOB_KEY);
+    if (length >= offsetof(CameraSettingsBlob, values) && length <= sizeof(blob) &&
+        prefs.getBytes(BLOB_KEY, &blob, length) == length) {
+        size_t stored = (length - offsetof(CameraSettingsBlob, values)) / sizeof(int32_t);
+        if (blob.version != CAMERA_SETTINGS_BLOB_VERSION || blob.count != stored) {
+            SDLogger::getInstance().warnf("Camera settings blob v%d (%d values) not understood - using defaults",
+                blob.version, blob.count);
+            return false;
+        }
+        for (size_t i = 0; i < stored; i++) {
+            setCameraSetting(settings, i, blob.values[i]);
+        }
+        return true;
+    }
+
+    // First boot after the upgrade: one-off read of the old per-field keys
+    // (left in place so older firmware still finds them after a rollback)
+    bool migrated = false;
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        const CameraSettingDescriptor& d = CAMERA_SETTINGS[i];
+        if (!d.legacyKey || !prefs.isKey(d.legacyKey)) {
+            continue;
+        }
+        int value = d.isBool() ? (prefs.getBool(d.legacyKey, false) ? 1 : 0) : prefs.getInt(d.legacyKey, 0);
+        setCameraSetting(settings, i, value);
+        migrated = true;
+    }
+    if (migrated) {
+        SDLogger::getInstance().infof("Migrated camera settings from per-field NVS keys to one blob");
+        saveCameraSettingsBlob(prefs, settings);
+    }
+    return migrated;
+}
+
+bool saveCameraSettingsBlob(Preferences& prefs, const CameraSettings& settings) {
+    CameraSettingsBlob blob;
+    blob.version = CAMERA_SETTINGS_BLOB_VERSION;
+    blob.count = (uint8_t)CAMERA_SETTING_COUNT;
+    blob.reserved[0] = blob.reserved[1] = 0;
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        blob.values[i] = getCameraSetting(settings, i);
+    }
+    if (prefs.putBytes(BLOB_KEY, &blob, sizeof(blob)) != sizeof(blob)) {
+        SDLogger::getInstance().errorf("Failed to write camera settings blob to NVS");
+        return false;
+    }
+    return true;
+}
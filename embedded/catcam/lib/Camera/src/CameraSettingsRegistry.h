@@ -0,0 +1,148 @@
+#ifndef CATCAM_CAMERASETTINGSREGISTRY_H
+#define CATCAM_CAMERASETTINGSREGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_camera.h>
+#include <Preferences.h>
+
+#include "../../../include/SystemState.h"
+
+/**
+ * Pushes one setting to the sensor (nullptr = not a sensor register)
+ */
+using CameraSensorSetter = int (*)(sensor_t* sensor, int value);
+
+/**
+ * One CameraSettings field: wire name, storage, valid range and sensor register
+ */
+struct CameraSettingDescriptor {
+    const char* name;                      // set_setting "camera_<name>" / get_camera_settings key
+    int CameraSettings::* intField;        // Exactly one of intField/boolField is set
+    bool CameraSettings::* boolField;
+    int32_t minValue;
+    int32_t maxValue;
+    CameraSensorSetter apply;
+    const char* legacyKey;                 // Per-field NVS key the pre-blob firmware wrote (migration only, null for newer settings)
+
+    bool isBool() const { return boolField != nullptr; }
+};
+
+/**
+ * CAMERA_SETTINGS - The single table behind camera settings load, save, apply and report
+ *
+ * Only the sensor, its driver configuration and the profile choice live here;
+ * capture/upload pipeline settings have their own table and blob
+ * (PipelineSettingsRegistry).
+ *
+ * Entries are applied to the sensor in table order (frame size first, as the
+ * old hand-written applySettings() did). The NVS blob stores values by table
+ * index, so new settings must be appended; reordering or removing entries
+ * needs CAMERA_SETTINGS_BLOB_VERSION bumped.
+ */
+inline constexpr CameraSettingDescriptor CAMERA_SETTINGS[] = {
+    { "frame_size", &CameraSettings::frameSize, nullptr, 0, FRAMESIZE_INVALID - 1,
+      [](sensor_t* s, int v) { return s->set_framesize(s, (framesize_t)v); }, "camFrmSize" },
+    { "jpeg_quality", &CameraSettings::jpegQuality, nullptr, 0, 63,
+      [](sensor_t* s, int v) { return s->set_quality(s, v); }, "camJpgQual" },
+    { "fb_count", &CameraSettings::fbCount, nullptr, 1, 3, nullptr, "camFbCount" },  // Needs camera re-init
+    { "brightness", &CameraSettings::brightness, nullptr, -2, 2,
+      [](sensor_t* s, int v) { return s->set_brightness(s, v); }, "camBright" },
+    { "contrast", &CameraSettings::contrast, nullptr, -2, 2,
+      [](sensor_t* s, int v) { return s->set_contrast(s, v); }, "camContrast" },
+    { "saturation", &CameraSettings::saturation, nullptr, -2, 2,
+      [](sensor_t* s, int v) { return s->set_saturation(s, v); }, "camSat" },
+    { "special_effect", &CameraSettings::specialEffect, nullptr, 0, 6,
+      [](sensor_t* s, int v) { return s->set_special_effect(s, v); }, "camEffect" },
+    { "white_balance", nullptr, &CameraSettings::whiteBalance, 0, 1,
+      [](sensor_t* s, int v) { return s->set_whitebal(s, v); }, "camWB" },
+    { "awb_gain", nullptr, &CameraSettings::awbGain, 0, 1,
+      [](sensor_t* s, int v) { return s->set_awb_gain(s, v); }, "camAWBGain" },
+    { "wb_mode", &CameraSettings::wbMode, nullptr, 0, 4,
+      [](sensor_t* s, int v) { return s->set_wb_mode(s, v); }, "camWBMode" },
+    { "exposure_ctrl", nullptr, &CameraSettings::exposureCtrl, 0, 1,
+      [](sensor_t* s, int v) { return s->set_exposure_ctrl(s, v); }, "camExpCtrl" },
+    { "aec2", nullptr, &CameraSettings::aec2, 0, 1,
+      [](sensor_t* s, int v) { return s->set_aec2(s, v); }, "camAEC2" },
+    { "ae_level", &CameraSettings::aeLevel, nullptr, -2, 2,
+      [](sensor_t* s, int v) { return s->set_ae_level(s, v); }, "camAELevel" },
+    { "aec_value", &CameraSettings::aecValue, nullptr, 0, 1200,
+      [](sensor_t* s, int v) { return s->set_aec_value(s, v); }, "camAECVal" },
+    { "gain_ctrl", nullptr, &CameraSettings::gainCtrl, 0, 1,
+      [](sensor_t* s, int v) { return s->set_gain_ctrl(s, v); }, "camGainCtrl" },
+    { "agc_gain", &CameraSettings::agcGain, nullptr, 0, 30,
+      [](sensor_t* s, int v) { return s->set_agc_gain(s, v); }, "camAGCGain" },
+    { "gain_ceiling", &CameraSettings::gainCeiling, nullptr, 0, 6,
+      [](sensor_t* s, int v) { return s->set_gainceiling(s, (gainceiling_t)v); }, "camGainCeil" },
+    { "bpc", nullptr, &CameraSettings::bpc, 0, 1,
+      [](sensor_t* s, int v) { return s->set_bpc(s, v); }, "camBPC" },
+    { "wpc", nullptr, &CameraSettings::wpc, 0, 1,
+      [](sensor_t* s, int v) { return s->set_wpc(s, v); }, "camWPC" },
+    { "raw_gma", nullptr, &CameraSettings::rawGma, 0, 1,
+      [](sensor_t* s, int v) { return s->set_raw_gma(s, v); }, "camGamma" },
+    { "lenc", nullptr, &CameraSettings::lenc, 0, 1,
+      [](sensor_t* s, int v) { return s->set_lenc(s, v); }, "camLenc" },
+    { "hmirror", nullptr, &CameraSettings::hmirror, 0, 1,
+      [](sensor_t* s, int v) { return s->set_hmirror(s, v); }, "camHMirror" },
+    { "vflip", nullptr, &CameraSettings::vflip, 0, 1,
+      [](sensor_t* s, int v) { return s->set_vflip(s, v); }, "camVFlip" },
+    { "dcw", nullptr, &CameraSettings::dcw, 0, 1,
+      [](sensor_t* s, int v) { return s->set_dcw(s, v); }, "camDCW" },
+    { "colorbar", nullptr, &CameraSettings::colorbar, 0, 1,
+      [](sensor_t* s, int v) { return s->set_colorbar(s, v); }, "camColorbar" },
+    { "led_delay_millis", &CameraSettings::ledDelayMillis, nullptr, 0, 5000, nullptr, "ledDelayMillis" },
+    { "photo_profile", &CameraSettings::photoProfile, nullptr, 0, 3, nullptr, nullptr },
+    { "video_profile", &CameraSettings::videoProfile, nullptr, 0, 3, nullptr, nullptr },
+    { "xclk_mhz", &CameraSettings::xclkMHz, nullptr, 8, 24, nullptr, nullptr },              // Needs camera re-init
+    { "fb_in_psram", nullptr, &CameraSettings::fbInPsram, 0, 1, nullptr, nullptr },          // Needs camera re-init
+    { "video_fb_count", &CameraSettings::videoFbCount, nullptr, 1, 3, nullptr, nullptr },
+    { "video_xclk_mhz", &CameraSettings::videoXclkMHz, nullptr, 8, 24, nullptr, nullptr },
+    { "video_fb_in_psram", nullptr, &CameraSettings::videoFbInPsram, 0, 1, nullptr, nullptr },
+};
+
+constexpr size_t CAMERA_SETTING_COUNT = sizeof(CAMERA_SETTINGS) / sizeof(CAMERA_SETTINGS[0]);
+static_assert(CAMERA_SETTING_COUNT <= 64, "Dirty mask is a uint64_t");
+
+/**
+ * Bit i set = CAMERA_SETTINGS[i] differs / needs applying
+ */
+using CameraSettingsMask = uint64_t;
+constexpr CameraSettingsMask CAMERA_SETTINGS_ALL =
+    CAMERA_SETTING_COUNT == 64 ? ~0ULL : ((1ULL << CAMERA_SETTING_COUNT) - 1);
+
+constexpr uint8_t CAMERA_SETTINGS_BLOB_VERSION = 1;
+
+/**
+ * Look a setting up by wire name
+ * @return Table index, or -1 if unknown
+ */
+int findCameraSetting(const char* name);
+
+int getCameraSetting(const CameraSettings& settings, size_t index);
+
+/**
+ * Store a value, clamped to the setting's range
+ * @return The value actually stored
+ */
+int setCameraSetting(CameraSettings& settings, size_t index, int value);
+
+/**
+ * Settings whose values differ between a and b
+ */
+CameraSettingsMask diffCameraSettings(const CameraSettings& a, const CameraSettings& b);
+
+/**
+ * Read settings from the NVS blob; on first boot after the upgrade the old
+ * per-field keys are read once and written back as a blob
+ * @param prefs Namespace already opened read-write
+ * @return false if nothing was stored (settings keep their defaults)
+ */
+bool loadCameraSettingsBlob(Preferences& prefs, CameraSettings& settings);
+
+/**
+ * Write all settings as one versioned blob
+ * @param prefs Namespace already opened read-write
+ */
+bool saveCameraSettingsBlob(Preferences& prefs, const CameraSettings& settings);
+
+#endif
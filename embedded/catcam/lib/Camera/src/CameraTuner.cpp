@@ -0,0 +1,150 @@
+#include "CameraTuner.h"
+#include <esp_heap_caps.h>
+#include "../../SDLogger/src/SDLogger.h"
+
+bool CameraTuner::tune(CameraUseCase useCase, CameraProfile profile, CameraTuneReport& report, uint32_t measureMs) {
+    if (!_camera || !_camera->isReady()) {
+        SDLogger::getInstance().errorf("Camera tune: camera not ready");
+        return false;
+    }
+
+    report = CameraTuneReport();
+    report.useCase = useCase;
+    report.profile = profile;
+
+    CameraDriverConfig original = _camera->getDriverConfig();
+    CameraProfile originalProfile = _camera->getProfile();
+    _camera->setProfile(profile);
+
+    // The driver sizes each JPEG frame buffer at a fifth of the raw frame
+    report.frameSize = _camera->getProfileSettings(profile).frameSize;
+    const resolution_info_t& size = resolution[report.frameSize];
+    size_t frameBytes = (size_t)size.width * size.height / 5;
+
+    SDLogger::getInstance().infof("Camera tune (%s, %s profile, %dx%d): %lu ms per candidate",
+        useCase == CameraUseCase::Video ? "video" : "stills", cameraProfileName(profile),
+        size.width, size.height, (unsigned long)measureMs);
+
+    for (int fbCount : FB_COUNTS) {
+        for (int xclkMHz : XCLK_MHZ) {
+            for (int inPsram = 1; inPsram >= 0; inPsram--) {
+                CameraTuneCandidate& candidate = report.candidates[report.candidateCount++];
+                candidate.driver.fbCount = fbCount;
+                candidate.driver.xclkMHz = xclkMHz;
+                candidate.driver.fbInPsram = inPsram != 0;
+                measure(candidate, frameBytes, measureMs);
+
+                if (candidate.ok() && (report.best < 0 || better(candidate, report.candidates[report.best], useCase))) {
+                    report.best = (int)report.candidateCount - 1;
+                }
+            }
+        }
+    }
+
+    _camera->reconfigure(original);
+    _camera->setProfile(originalProfile);
+
+    if (report.best >= 0) {
+        const CameraTuneCandidate& best = report.candidates[report.best];
+        SDLogger::getInstance().infof("Camera tune best: fbCount=%d, xclk=%d MHz, %s - %.1f fps, %.1f ms to frame",
+            best.driver.fbCount, best.driver.xclkMHz, best.driver.fbInPsram ? "PSRAM" : "DRAM",
+            best.fps, best.meanLatencyUs / 1000.0f);
+    } else {
+        SDLogger::getInstance().warnf("Camera tune: no configuration produced frames");
+    }
+    return true;
+}
+
+void CameraTuner::measure(CameraTuneCandidate& candidate, size_t frameBytes, uint32_t measureMs) {
+    const CameraDriverConfig& driver = candidate.driver;
+
+    if (!_camera->isReady()) {
+        candidate.status = "init_failed";  // An earlier restart left no driver running
+        return;
+    }
+    if (driver.fbInPsram && !psramFound()) {
+        candidate.status = "no_psram";
+        return;
+    }
+    if (!driver.fbInPsram) {
+        // Count what the current driver holds in DRAM as available: it is
+        // released before the candidate starts
+        CameraDriverConfig current = _camera->getDriverConfig();
+        size_t released = current.fbInPsram ? 0 : current.fbCount * frameBytes;
+        size_t freeDram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + released;
+        if (driver.fbCount * frameBytes + DRAM_RESERVE_BYTES > freeDram) {
+            candidate.status = "no_dram";
+            return;
+        }
+    }
+
+    CameraDriverHeap heap;
+    int64_t startUs = esp_timer_get_time();
+    if (!_camera->reconfigure(driver, &heap)) {
+        candidate.status = "init_failed";
+        return;
+    }
+    candidate.initMs = (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    candidate.dramBytes = heap.dramBytes;
+    candidate.psramBytes = heap.psramBytes;
+
+    for (int i = 0; i < WARMUP_FRAMES; i++) {
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            candidate.status = "no_frames";
+            return;
+        }
+        esp_camera_fb_return(fb);
+    }
+
+    int frames = 0;
+    uint64_t totalLatencyUs = 0;
+    int64_t windowStartUs = esp_timer_get_time();
+    int64_t windowEndUs = windowStartUs + (int64_t)measureMs * 1000;
+    while (esp_timer_get_time() < windowEndUs) {
+        int64_t requestUs = esp_timer_get_time();
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            break;
+        }
+        uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - requestUs);
+        esp_camera_fb_return(fb);
+
+        frames++;
+        totalLatencyUs += latencyUs;
+        candidate.maxLatencyUs = max(candidate.maxLatencyUs, latencyUs);
+    }
+    int64_t elapsedUs = esp_timer_get_time() - windowStartUs;
+
+    if (frames == 0) {
+        candidate.status = "no_frames";
+        return;
+    }
+    candidate.status = "ok";
+    candidate.fps = frames * 1000000.0f / (float)elapsedUs;
+    candidate.meanLatencyUs = (uint32_t)(totalLatencyUs / frames);
+
+    SDLogger::getInstance().debugf("Camera tune fbCount=%d xclk=%d %s: %.1f fps, %lu us mean / %lu us max, DRAM %ld, PSRAM %ld",
+        driver.fbCount, driver.xclkMHz, driver.fbInPsram ? "PSRAM" : "DRAM", candidate.fps,
+        (unsigned long)candidate.meanLatencyUs, (unsigned long)candidate.maxLatencyUs,
+        (long)candidate.dramBytes, (long)candidate.psramBytes);
+}
+
+bool CameraTuner::better(const CameraTuneCandidate& a, const CameraTuneCandidate& b, CameraUseCase useCase) {
+    // Primary metric, as "a beats b by more than the tie margin" either way round
+    float aMetric = useCase == CameraUseCase::Video ? a.fps : -(float)a.meanLatencyUs;
+    float bMetric = useCase == CameraUseCase::Video ? b.fps : -(float)b.meanLatencyUs;
+    float margin = TIE_FRACTION * max(fabsf(aMetric), fabsf(bMetric));
+    if (aMetric > bMetric + margin) {
+        return true;
+    }
+    if (bMetric > aMetric + margin) {
+        return false;
+    }
+
+    // Near-tie: keep internal DRAM for the network stacks, then fewer buffers
+    if (a.dramBytes != b.dramBytes) {
+        return a.dramBytes < b.dramBytes;
+    }
+    return a.driver.fbCount < b.driver.fbCount;
+}
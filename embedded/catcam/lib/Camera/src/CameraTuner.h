@@ -0,0 +1,77 @@
+#ifndef CATCAM_CAMERATUNER_H
+#define CATCAM_CAMERATUNER_H
+
+#include <Arduino.h>
+
+#include "Camera.h"
+
+/**
+ * One driver configuration tried by CameraTuner
+ */
+struct CameraTuneCandidate {
+    CameraDriverConfig driver;
+    const char* status = "untested";  // "ok", "init_failed", "no_frames", "no_dram", "no_psram"
+    uint32_t initMs = 0;              // Driver restart time
+    float fps = 0.0f;                 // Sustained frame rate over the measuring window
+    uint32_t meanLatencyUs = 0;       // esp_camera_fb_get() call to frame in hand
+    uint32_t maxLatencyUs = 0;
+    int32_t dramBytes = 0;            // Heap taken by the driver
+    int32_t psramBytes = 0;
+
+    bool ok() const { return strcmp(status, "ok") == 0; }
+};
+
+/**
+ * Sweep results for one use case
+ */
+struct CameraTuneReport {
+    static constexpr size_t MAX_CANDIDATES = 18;
+
+    CameraUseCase useCase = CameraUseCase::Stills;
+    CameraProfile profile = CameraProfile::Photo;
+    int frameSize = 0;
+    CameraTuneCandidate candidates[MAX_CANDIDATES];
+    size_t candidateCount = 0;
+    int best = -1;                    // Index into candidates, -1 if nothing worked
+};
+
+/**
+ * CameraTuner - Measures driver configurations and picks the best per use case
+ *
+ * Each candidate (frame buffer count x XCLK x buffer placement) is started
+ * with Camera::reconfigure() at the use case's profile frame size, warmed up,
+ * then sampled for a fixed window. Stills favour the shortest wait for a
+ * frame, video the highest sustained frame rate; near-ties (within 5%) go to
+ * the configuration using less internal DRAM. DRAM placements that cannot fit
+ * are skipped rather than tried.
+ *
+ * The camera is put back in its original configuration and profile afterwards;
+ * persisting the winner is up to the caller.
+ */
+class CameraTuner {
+public:
+    static constexpr uint32_t DEFAULT_MEASURE_MS = 1000;
+
+    explicit CameraTuner(Camera* camera) : _camera(camera) {}
+
+    /**
+     * Run the sweep (blocking: about 1.5 x measureMs per candidate)
+     * @return false if the camera is not ready
+     */
+    bool tune(CameraUseCase useCase, CameraProfile profile, CameraTuneReport& report,
+              uint32_t measureMs = DEFAULT_MEASURE_MS);
+
+private:
+    static constexpr int FB_COUNTS[] = { 1, 2, 3 };
+    static constexpr int XCLK_MHZ[] = { 10, 20, 24 };
+    static constexpr int WARMUP_FRAMES = 2;                  // First frames after init are often short or dark
+    static constexpr size_t DRAM_RESERVE_BYTES = 64 * 1024;  // Left free for WiFi/BLE/TLS
+    static constexpr float TIE_FRACTION = 0.05f;
+
+    Camera* _camera;
+
+    void measure(CameraTuneCandidate& candidate, size_t frameBytes, uint32_t measureMs);
+    static bool better(const CameraTuneCandidate& a, const CameraTuneCandidate& b, CameraUseCase useCase);
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef CATCAM_FRAMELEASE_H
+#define CATCAM_FRAMELEASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+
+/**
+ * FrameLease - Move-only owner of a captured JPEG frame
+ *
+ * Normally wraps the camera driver's frame buffer directly (zero-copy) and
+ * hands it back to the driver when the lease is destroyed or reset. When the
+ * driver only has a single frame buffer, Camera hands out a heap copy instead
+ * so the sensor can keep capturing; the release function then frees the copy.
+ *
+ * Deliberately free of any camera driver or Arduino dependency so it can be
+ * built on the host against a fake frame source.
+ */
+class FrameLease {
+public:
+    /**
+     * Called exactly once when the lease gives up its frame
+     * @param context Opaque pointer supplied by the frame source
+     * @param handle Source-specific frame handle (e.g. camera_fb_t*)
+     */
+    using ReleaseFn = void (*)(void* context, void* handle);
+
+    static constexpr size_t SHA256_SIZE = 32;
+
+    FrameLease() = default;
+
+    FrameLease(const uint8_t* data, size_t size, int64_t timestampUs,
+               void* handle, ReleaseFn release, void* context, bool isCopy = false)
+        : _data(data), _size(size), _timestampUs(timestampUs),
+          _handle(handle), _release(release), _context(context), _isCopy(isCopy) {}
+
+    ~FrameLease() { reset(); }
+
+    FrameLease(FrameLease&& other) noexcept { moveFrom(other); }
+
+    FrameLease& operator=(FrameLease&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    /**
+     * Return the frame to its source now rather than at destruction
+     */
+    void reset() {
+        if (_release && _handle) {
+            _release(_context, _handle);
+        }
+        _data = nullptr;
+        _size = 0;
+        _timestampUs = 0;
+        _handle = nullptr;
+        _release = nullptr;
+        _context = nullptr;
+        _isCopy = false;
+        _hasSha256 = false;
+    }
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    /**
+     * Capture time in microseconds on the esp_timer clock (0 if unknown)
+     */
+    int64_t timestampUs() const { return _timestampUs; }
+
+    /**
+     * True if the frame was copied out of the driver buffer (fbCount=1 fallback)
+     */
+    bool isCopy() const { return _isCopy; }
+
+    /**
+     * SHA-256 of the frame when the source hashed it on the way in (the
+     * copy path does it in the same pass as the copy), otherwise nullptr
+     */
+    const uint8_t* sha256() const { return _hasSha256 ? _sha256 : nullptr; }
+
+    void setSha256(const uint8_t* digest) {
+        memcpy(_sha256, digest, SHA256_SIZE);
+        _hasSha256 = true;
+    }
+
+    bool isValid() const { return _data != nullptr && _size > 0; }
+    explicit operator bool() const { return isValid(); }
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    int64_t _timestampUs = 0;
+    void* _handle = nullptr;
+    ReleaseFn _release = nullptr;
+    void* _context = nullptr;
+    bool _isCopy = false;
+    bool _hasSha256 = false;
+    uint8_t _sha256[SHA256_SIZE];
+
+    void moveFrom(FrameLease& other) {
+        _data = other._data;
+        _size = other._size;
+        _timestampUs = other._timestampUs;
+        _handle = other._handle;
+        _release = other._release;
+        _context = other._context;
+        _isCopy = other._isCopy;
+        _hasSha256 = other._hasSha256;
+        if (_hasSha256) {
+            memcpy(_sha256, other._sha256, SHA256_SIZE);
+        }
+
+        other._data = nullptr;
+        other._size = 0;
+        other._timestampUs = 0;
+        other._handle = nullptr;
+        other._release = nullptr;
+        other._context = nullptr;
+        other._isCopy = false;
+        other._hasSha256 = false;
+    }
+};
+
+#endif
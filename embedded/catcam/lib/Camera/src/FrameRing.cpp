@@ -0,0 +1,268 @@
+#include "FrameRing.h"
+#include <esp32-hal-psram.h>
+#include "../../SDLogger/src/SDLogger.h"
+
+FrameRing::FrameRing() {
+    memset(_slots, 0, sizeof(_slots));
+}
+
+FrameRing::~FrameRing() {
+    stop();
+    if (_task) {
+        return;  // Leak the semaphores rather than delete them under a live task
+    }
+    if (_exited) {
+        vSemaphoreDelete(_exited);
+        _exited = nullptr;
+    }
+    if (_mutex) {
+        vSemaphoreDelete(_mutex);
+        _mutex = nullptr;
+    }
+}
+
+bool FrameRing::configure(const PipelineSettings& settings) {
+    stop();
+    if (_task) {
+        SDLogger::getInstance().errorf("FrameRing: Previous capture task still running - not reconfiguring");
+        return false;
+    }
+
+    if (settings.preTriggerFrames <= 0) {
+        SDLogger::getInstance().infof("FrameRing: Pre-trigger capture disabled");
+        return true;
+    }
+
+    if (!psramFound()) {
+        SDLogger::getInstance().warnf("FrameRing: PSRAM not found - pre-trigger capture unavailable");
+        return false;
+    }
+
+    size_t slotCount = min((size_t)settings.preTriggerFrames, MAX_SLOTS);
+    size_t slotBytes = (size_t)constrain(settings.preTriggerSlotKB, 32, 1024) * 1024;
+    int fps = constrain(settings.preTriggerFps, 1, 10);
+
+    if (!_mutex) {
+        _mutex = xSemaphoreCreateMutex();
+        if (!_mutex) {
+            SDLogger::getInstance().errorf("FrameRing: Failed to create mutex");
+            return false;
+        }
+    }
+    if (!_exited) {
+        _exited = xSemaphoreCreateBinary();
+        if (!_exited) {
+            SDLogger::getInstance().errorf("FrameRing: Failed to create exit semaphore");
+            return false;
+        }
+    }
+
+    _memory = (uint8_t*)ps_malloc(slotCount * slotBytes);
+    if (!_memory) {
+        SDLogger::getInstance().errorf("FrameRing: Failed to allocate %d bytes for %d slots",
+            slotCount * slotBytes, slotCount);
+        return false;
+    }
+
+    memset(_slots, 0, sizeof(_slots));
+    for (size_t i = 0; i < slotCount; i++) {
+        _slots[i].data = _memory + i * slotBytes;
+    }
+    _slotCount = slotCount;
+    _slotBytes = slotBytes;
+    _next = 0;
+    _intervalMs = 1000 / fps;
+    _stopRequested = false;
+
+    BaseType_t taskResult = xTaskCreate(taskFunction, "FrameRing", TASK_STACK_SIZE, this, TASK_PRIORITY, &_task);
+    if (taskResult != pdPASS) {
+        SDLogger::getInstance().errorf("FrameRing: Failed to create capture task");
+        _task = nullptr;
+        free(_memory);
+        _memory = nullptr;
+        _slotCount = 0;
+        return false;
+    }
+
+    SDLogger::getInstance().infof("FrameRing: Capturing %d frames at %d fps (%d KB per slot, %d KB total)",
+        slotCount, fps, slotBytes / 1024, memoryBytes() / 1024);
+    return true;
+}
+
+void FrameRing::stop() {
+    if (_task) {
+        // The task reads _slots and writes slot memory until it exits, so
+        // nothing is torn down before it says it has
+        _stopRequested = true;
+        if (xSemaphoreTake(_exited, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) != pdTRUE) {
+            SDLogger::getInstance().errorf("FrameRing: Capture task did not exit - leaving %d bytes allocated", memoryBytes());
+            return;
+        }
+        _task = nullptr;
+    }
+
+    if (!_memory) {
+        return;
+    }
+
+    // Never free memory a caller is still reading through a lease
+    bool pinned = false;
+    for (int attempt = 0; attempt < 200; attempt++) {
+        pinned = false;
+        for (size_t i = 0; i < _slotCount; i++) {
+            pinned |= _slots[i].pinned;
+        }
+        if (!pinned) break;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    if (pinned) {
+        SDLogger::getInstance().errorf("FrameRing: Slot still leased at stop - leaking %d bytes", memoryBytes());
+    } else {
+        free(_memory);
+    }
+
+    _memory = nullptr;
+    memset(_slots, 0, sizeof(_slots));
+    _slotCount = 0;
+    _slotBytes = 0;
+    SDLogger::getInstance().infof("FrameRing: Stopped");
+}
+
+void FrameRing::pause() {
+    _pauseDepth++;
+    // Wait for any in-flight capture to finish before the caller touches the camera
+    if (_mutex) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        xSemaphoreGive(_mutex);
+    }
+}
+
+void FrameRing::resume() {
+    if (_pauseDepth > 0) {
+        _pauseDepth--;
+    }
+}
+
+size_t FrameRing::frameCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < _slotCount; i++) {
+        if (_slots[i].size > 0) count++;
+    }
+    return count;
+}
+
+FrameLease FrameRing::leaseNearest(int64_t instantUs, int64_t maxDistanceUs) {
+    if (!_mutex || _slotCount == 0) {
+        return FrameLease();
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    Slot* best = nullptr;
+    int64_t bestDistance = maxDistanceUs;
+    for (size_t i = 0; i < _slotCount; i++) {
+        Slot& slot = _slots[i];
+        if (slot.size == 0) continue;
+        int64_t distance = llabs(slot.timestampUs - instantUs);
+        if (distance <= bestDistance) {
+            best = &slot;
+            bestDistance = distance;
+        }
+    }
+
+    FrameLease lease;
+    if (best) {
+        best->pinned = true;
+        lease = FrameLease(best->data, best->size, best->timestampUs, best, &FrameRing::unpinSlot, this, true);
+    }
+
+    xSemaphoreGive(_mutex);
+    return lease;
+}
+
+size_t FrameRing::forEachSince(int64_t sinceUs, FrameVisitor visitor) {
+    if (!_mutex || _slotCount == 0 || !visitor) {
+        return 0;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // Order the occupied slots by capture time (at most MAX_SLOTS entries)
+    size_t order[MAX_SLOTS];
+    size_t count = 0;
+    for (size_t i = 0; i < _slotCount; i++) {
+        if (_slots[i].size == 0 || _slots[i].timestampUs < sinceUs) continue;
+        size_t pos = count++;
+        while (pos > 0 && _slots[order[pos - 1]].timestampUs > _slots[i].timestampUs) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const Slot& slot = _slots[order[i]];
+        visitor(slot.data, slot.size, slot.timestampUs);
+    }
+
+    xSemaphoreGive(_mutex);
+    return count;
+}
+
+void FrameRing::captureOne() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    if (_pauseDepth > 0 || _stopRequested) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (!fb) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    if (fb->len > _slotBytes) {
+        SDLogger::getInstance().tracef("FrameRing: Frame of %d bytes exceeds %d byte slot - skipped", fb->len, _slotBytes);
+    } else {
+        // Oldest unpinned slot gets the new frame
+        for (size_t tries = 0; tries < _slotCount; tries++) {
+            Slot& slot = _slots[_next];
+            _next = (_next + 1) % _slotCount;
+            if (slot.pinned) continue;
+
+            memcpy(slot.data, fb->buf, fb->len);
+            slot.size = fb->len;
+            slot.timestampUs = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+            break;
+        }
+    }
+
+    esp_camera_fb_return(fb);
+    xSemaphoreGive(_mutex);
+}
+
+void FrameRing::taskFunction(void* parameter) {
+    FrameRing* ring = static_cast<FrameRing*>(parameter);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (!ring->_stopRequested) {
+        if (ring->_pauseDepth == 0) {
+            ring->captureOne();
+        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(ring->_intervalMs));
+    }
+
+    xSemaphoreGive(ring->_exited);
+    vTaskDelete(nullptr);
+}
+
+void FrameRing::unpinSlot(void* context, void* handle) {
+    FrameRing* ring = static_cast<FrameRing*>(context);
+    Slot* slot = static_cast<Slot*>(handle);
+    xSemaphoreTake(ring->_mutex, portMAX_DELAY);
+    slot->pinned = false;
+    xSemaphoreGive(ring->_mutex);
+}
@@ -0,0 +1,115 @@
+#ifndef CATCAM_FRAMERING_H
+#define CATCAM_FRAMERING_H
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <functional>
+
+#include "FrameLease.h"
+#include "../../../include/SystemState.h"
+
+/**
+ * FrameRing - Pre-trigger ring of recent JPEG frames
+ *
+ * A low-priority task grabs frames at a low rate and copies them into a fixed
+ * set of PSRAM slots, so a PIR trigger already has frames from around the
+ * motion edge instead of waiting for flash warm-up. Memory use is bounded to
+ * preTriggerFrames x preTriggerSlotKB and is allocated once in configure().
+ *
+ * Frames larger than a slot are skipped. Leased slots are pinned and never
+ * overwritten until the lease is released.
+ */
+class FrameRing {
+public:
+    using FrameVisitor = std::function<void(const uint8_t* data, size_t size, int64_t timestampUs)>;
+
+    FrameRing();
+    ~FrameRing();
+
+    /**
+     * (Re)configure from pipeline settings and start or stop the capture task
+     * preTriggerFrames = 0 disables the ring and frees its memory.
+     * @return true if the ring is running (or was deliberately disabled)
+     */
+    bool configure(const PipelineSettings& settings);
+
+    /**
+     * Stop capturing and free all slots
+     * If the capture task does not exit in time, nothing is freed (the task
+     * may still be writing to the slots) and a later stop() tries again.
+     */
+    void stop();
+
+    /**
+     * Suspend/resume capture (nestable) - e.g. while the camera is reconfigured
+     * for video or a trigger is being handled. pause() returns once any
+     * in-flight capture has finished.
+     */
+    void pause();
+    void resume();
+
+    bool isRunning() const { return _task != nullptr; }
+    bool isPaused() const { return _pauseDepth > 0; }
+
+    /**
+     * Number of slots currently holding a frame
+     */
+    size_t frameCount() const;
+
+    /**
+     * Total PSRAM reserved for slots
+     */
+    size_t memoryBytes() const { return _slotCount * _slotBytes; }
+
+    /**
+     * Lease the stored frame captured closest to instantUs
+     * The slot stays pinned until the lease is released.
+     * @param instantUs esp_timer_get_time() instant, e.g. the PIR rising edge
+     * @param maxDistanceUs Reject frames further than this from instantUs
+     * @return Frame lease, or an invalid lease if no frame is close enough
+     */
+    FrameLease leaseNearest(int64_t instantUs, int64_t maxDistanceUs);
+
+    /**
+     * Visit stored frames oldest-first (used for video pre-roll)
+     * @param sinceUs Only frames captured at or after this instant
+     * @param visitor Called for each frame while the ring lock is held
+     * @return Number of frames visited
+     */
+    size_t forEachSince(int64_t sinceUs, FrameVisitor visitor);
+
+private:
+    struct Slot {
+        uint8_t* data;
+        size_t size;
+        int64_t timestampUs;
+        bool pinned;
+    };
+
+    static constexpr size_t MAX_SLOTS = 16;
+    static constexpr int TASK_STACK_SIZE = 4096;
+    static constexpr int TASK_PRIORITY = 1;
+    static constexpr uint32_t STOP_TIMEOUT_MS = 2000;
+
+    Slot _slots[MAX_SLOTS];
+    size_t _slotCount = 0;
+    size_t _slotBytes = 0;
+    size_t _next = 0;
+    uint32_t _intervalMs = 500;
+    uint8_t* _memory = nullptr;
+
+    TaskHandle_t _task = nullptr;
+    SemaphoreHandle_t _mutex = nullptr;
+    SemaphoreHandle_t _exited = nullptr;  // Given by the task as its last access to the ring
+    volatile bool _stopRequested = false;
+    volatile int _pauseDepth = 0;
+
+    void captureOne();
+    static void taskFunction(void* parameter);
+    static void unpinSlot(void* context, void* handle);
+};
+
+#endif
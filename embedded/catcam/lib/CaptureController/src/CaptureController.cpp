@@ -1,7 +1,12 @@
 #include "CaptureController.h"
 #include <SDLogger.h>
 #include <ArduinoJson.h>
+#include <SD_MMC.h>
+#include <vector>
 #include "CatCamHttpClient.h"
+#include "SlabAllocator.h"
+#include "PerceptualHash.h"
+#include "../../../include/version.h"
 
 CaptureController::CaptureController(Camera* camera, VideoRecorder* videoRecorder,
                                      LedController* ledController, ImageStorage* imageStorage,
@@ -10,7 +15,7 @@ CaptureController::CaptureController(Camera* camera, VideoRecorder* videoRecorde
       _imageStorage(imageStorage), _awsAuth(awsAuth) {
 }
 
-bool CaptureController::init(const CameraSettings& settings) {
+bool CaptureController::init(const CameraSettings& settings, const PipelineSettings& pipeline) {
     SDLogger::getInstance().infof("=== Initializing CaptureController ===");
 
     // Initialize LED controller and run test sequence
@@ -19,12 +24,27 @@ bool CaptureController::init(const CameraSettings& settings) {
         _ledController->runTestSequence(3, 100);
     }
 
+    setCameraProfiles((CameraProfile)settings.photoProfile, (CameraProfile)settings.videoProfile);
+    setUploadCrop(pipeline.cropX, pipeline.cropY, pipeline.cropWidth, pipeline.cropHeight);
+    setBurst(pipeline.burstFrames, pipeline.burstBudgetMs);
+    setDualCapture(pipeline.dualCapture, pipeline.archiveUpload);
+    setQualityGate(pipeline.qualityGate, pipeline.gateRecaptures);
+    setUploadTranscode(pipeline.uploadTranscodeQuality);
+    setInferenceCache(pipeline.inferenceCacheTtlS, pipeline.inferenceCacheDistance);
+    setLocalInference(pipeline.localInference);
+    setDaylightCapture(pipeline.daylightCapture, pipeline.daylightMinLuma);
+    setIdleStandby(pipeline.idleStandbyS);
+    setUploadHashOverlap(pipeline.uploadHashOverlap);
+    setChangeGate(pipeline.changeGate, pipeline.changeGateThreshold);
+
     // Initialize camera with settings (frame size, quality, buffer count)
     if (_camera) {
         _camera->init(settings);
         delay(500);  // Give camera time to stabilize
         if (!_camera->isReady()) {
             SDLogger::getInstance().errorf("Camera initialization failed - photo capture will be unavailable");
+        } else {
+            setQualityTarget(settings, pipeline);
         }
     } else {
         SDLogger::getInstance().errorf("Camera not provided");
@@ -60,6 +80,290 @@ void CaptureController::setAWSConfig(const char* roleAlias, const char* apiHost,
     _apiPath = apiPath;
 }
 
+FrameLease CaptureController::captureStill(const char* caller, bool burst, bool dual) {
+    // Keep the pre-trigger ring from competing for frames
+    if (_frameRing) _frameRing->pause();
+    int64_t startUs = esp_timer_get_time();
+    CameraProfile profile = dual ? CameraProfile::Inference : _photoProfile;
+
+    // Uploads come from whichever profile took the still, so that is the one
+    // the adaptive quality loop steers
+    _uploadProfile = profile;
+    if (_quality.isActive()) {
+        _camera->setJpegQuality(profile, _quality.quality());
+    }
+
+    // Bright enough already - no LEDs and no warm-up to wait for
+    FrameLease image = captureDaylightFrame(caller, profile);
+    bool daylight = (bool)image;
+    _stillDaylight = daylight;
+
+    if (daylight) {
+        recordTimeToFrame(true, startUs);
+    } else {
+        // Turn on external flash for capture
+        if (_flashCallback) _flashCallback(true);
+        int64_t flashOnUs = esp_timer_get_time();
+
+        // A no-op unless the profile changed since the last capture (in dual
+        // mode, the archive frame left the photo profile in place); the resize
+        // then overlaps the LED warm-up instead of adding to it.
+        _camera->setProfile(profile);
+
+        // The LEDs need a short while to warm up and auto-exposure a frame or two
+        // to follow; take the first frame whose brightness has stopped moving
+        image = captureSettledFrame(caller, flashOnUs, _camera->getLedDelayMillis());
+        if (image) {
+            recordTimeToFrame(false, startUs);
+        }
+    }
+
+    // A moving cat blurs some frames more than others - keep the sharpest
+    if (burst && image && _burstFrames > 1) {
+        image = keepSharpest(std::move(image));
+    }
+
+    // Dark, blown-out or damaged frames are retaken under the same light
+    image = passQualityGate(std::move(image), caller);
+
+    // Turn off external flash after capture
+    if (!daylight && _flashCallback) _flashCallback(false);
+
+    if (_frameRing) _frameRing->resume();
+
+    return image;
+}
+
+FrameLease CaptureController::captureArchive(const char* caller) {
+    if (_frameRing) _frameRing->pause();
+    int64_t startUs = esp_timer_get_time();
+
+    // Same light as the decision frame: the flash goes back on only if that one needed it
+    int64_t sinceUs = 0;
+    if (!_stillDaylight) {
+        if (_flashCallback) _flashCallback(true);
+        // The LED delay bounds the settle time, so a frame exposed after it needs no settle check
+        sinceUs = esp_timer_get_time() + (int64_t)_camera->getLedDelayMillis() * 1000;
+    }
+
+    // The resize overlaps the LED warm-up. Only the archive goes up byte for
+    // byte; settle, burst and gate frames may be dropped, cropped or
+    // transcoded, so PayloadHasher hashes those.
+    _camera->setProfile(_photoProfile);
+    FrameLease archive = _camera->captureFrameAfter(sinceUs, FRESH_FRAME_TIMEOUT_MS, _archiveUpload);
+
+    if (!_stillDaylight && _flashCallback) _flashCallback(false);
+    if (_frameRing) _frameRing->resume();
+
+    if (archive) {
+        SDLogger::getInstance().infof("%s: archive frame after the decision: %lu ms (%d bytes)", caller,
+            (unsigned long)((esp_timer_get_time() - startUs) / 1000), archive.size());
+    } else {
+        SDLogger::getInstance().warnf("%s: no archive frame - keeping the inference frame only", caller);
+    }
+    return archive;
+}
+
+FrameLease CaptureController::captureDaylightFrame(const char* caller, CameraProfile profile) {
+    if (_daylightMode == DaylightMode::Off) {
+        return FrameLease();
+    }
+    if (_daylightMode == DaylightMode::LightSensor) {
+        _policyStatus.lightSensorBright = _lightCallback && _lightCallback();
+        if (!_policyStatus.lightSensorBright) {
+            return FrameLease();
+        }
+    }
+
+    // The sensor has been streaming, so auto-exposure has already settled on the ambient light
+    _camera->setProfile(profile);
+    FrameLease frame = _camera->captureFrameAfter(0, FRESH_FRAME_TIMEOUT_MS);
+    float luma = 0.0f;
+    if (!frame || !meanLuma(frame, luma)) {
+        return FrameLease();
+    }
+    _policyStatus.lastLuma = (int)luma;
+
+    if (luma < _daylightMinLuma) {
+        _policyStatus.daylightRejected++;
+        SDLogger::getInstance().infof("%s: too dark without flash (mean luma %.0f < %d) - using flash",
+            caller, luma, _daylightMinLuma);
+        return FrameLease();
+    }
+    SDLogger::getInstance().infof("%s: daylight capture, no flash (mean luma %.0f)", caller, luma);
+    return frame;
+}
+
+void CaptureController::recordTimeToFrame(bool daylight, int64_t startUs) {
+    unsigned long elapsedMs = (unsigned long)((esp_timer_get_time() - startUs) / 1000);
+    unsigned long& frames = daylight ? _policyStatus.daylightFrames : _policyStatus.flashFrames;
+    unsigned long& mean = daylight ? _policyStatus.meanDaylightMs : _policyStatus.meanFlashMs;
+    frames++;
+    mean = mean ? (mean * 7 + elapsedMs) / 8 : max(elapsedMs, 1UL);
+    SDLogger::getInstance().infof("Time to frame (%s): %lu ms - average daylight %lu ms, flash %lu ms",
+        daylight ? "daylight" : "flash", elapsedMs, _policyStatus.meanDaylightMs, _policyStatus.meanFlashMs);
+}
+
+FrameLease CaptureController::captureSettledFrame(const char* caller, int64_t flashOnUs, int ledDelayMillis) {
+    // ledDelayMillis is now only the upper bound: a frame exposed after it is used as-is
+    int64_t boundUs = flashOnUs + (int64_t)ledDelayMillis * 1000;
+    int64_t giveUpUs = boundUs + (int64_t)FRESH_FRAME_TIMEOUT_MS * 1000;
+    float previousLuma = -1.0f;
+    int frames = 0;
+
+    while (true) {
+        int64_t nowUs = esp_timer_get_time();
+        uint32_t maxWaitMs = nowUs < giveUpUs ? (uint32_t)((giveUpUs - nowUs) / 1000) : 0;
+        // Only the first frame needs the freshness check; later ones are newer by construction
+        FrameLease frame = _camera->captureFrameAfter(frames == 0 ? flashOnUs : 0, maxWaitMs);
+        if (!frame) {
+            return frame;
+        }
+        frames++;
+
+        int64_t exposureStartUs = frame.timestampUs() - _camera->getFramePeriodUs();
+        float luma = -1.0f;
+        bool atBound = exposureStartUs >= boundUs || esp_timer_get_time() >= giveUpUs;
+        bool settled = !atBound && meanLuma(frame, luma) && previousLuma >= 0.0f &&
+                       fabsf(luma - previousLuma) <= max(AE_SETTLE_TOLERANCE, previousLuma * AE_SETTLE_FRACTION);
+
+        if (atBound || settled) {
+            int64_t settleUs = max((int64_t)0, exposureStartUs - flashOnUs);
+            _lastSettleMs = (uint32_t)(settleUs / 1000);
+            if (settled) {
+                _settleSavedMs += (uint32_t)((boundUs - exposureStartUs) / 1000);
+                SDLogger::getInstance().infof("%s: exposure settled after %d frames, %lu ms after flash-on (bound %d ms, mean luma %.0f)",
+                    caller, frames, (unsigned long)_lastSettleMs, ledDelayMillis, luma);
+            } else {
+                SDLogger::getInstance().infof("%s: exposure not settled after %d frames - using frame at %lu ms (bound %d ms)",
+                    caller, frames, (unsigned long)_lastSettleMs, ledDelayMillis);
+            }
+            return frame;
+        }
+        previousLuma = luma;
+    }
+}
+
+bool CaptureController::meanLuma(const FrameLease& frame, float& luma) {
+    _lumaMapFrameUs = 0;
+    if (!_lumaMap.build(frame.data(), frame.size())) {
+        return false;
+    }
+    const uint8_t* pixels = _lumaMap.data();
+    uint32_t sum = 0;
+    for (size_t i = 0; i < _lumaMap.cellCount(); i++) {
+        sum += pixels[i];
+    }
+    luma = _lumaMap.cellCount() ? (float)sum / _lumaMap.cellCount() : 0.0f;
+    return true;
+}
+
+static_assert((int)FrameVerdict::Count == FrameGateStatus::VERDICT_COUNT, "FrameGateStatus::verdicts is indexed by FrameVerdict");
+
+FrameVerdict CaptureController::checkFrame(const FrameLease& frame, const char* caller) {
+    int64_t startUs = esp_timer_get_time();
+    FrameQualityGate::Result check = _qualityGate.check(frame.data(), frame.size(), _lumaMap);
+    uint32_t costUs = (uint32_t)(esp_timer_get_time() - startUs);
+    _lumaMapFrameUs = check.verdict == FrameVerdict::Ok ? frame.timestampUs() : 0;
+
+    _gateStatus.checked++;
+    _gateStatus.verdicts[(size_t)check.verdict]++;
+    _gateStatus.meanCostUs = _gateStatus.meanCostUs ? (_gateStatus.meanCostUs * 7 + costUs) / 8 : costUs;
+    _gateStatus.maxCostUs = max(_gateStatus.maxCostUs, (unsigned long)costUs);
+
+    if (check.verdict != FrameVerdict::Ok) {
+        SDLogger::getInstance().warnf("%s: frame failed quality gate - %s (%d bytes, mean luma %.0f, %.0f%% dark, %.0f%% saturated, %lu us)",
+            caller, frameVerdictName(check.verdict), frame.size(), check.meanLuma,
+            check.darkFraction * 100.0f, check.brightFraction * 100.0f, (unsigned long)costUs);
+    }
+    return check.verdict;
+}
+
+FrameLease CaptureController::passQualityGate(FrameLease image, const char* caller) {
+    if (!_qualityGateEnabled || !image) {
+        return image;
+    }
+
+    for (int attempt = 0; ; attempt++) {
+        FrameVerdict verdict = checkFrame(image, caller);
+        if (verdict == FrameVerdict::Ok) {
+            if (attempt > 0) {
+                _gateStatus.recovered++;
+                SDLogger::getInstance().infof("%s: recapture %d passed the quality gate", caller, attempt);
+            }
+            return image;
+        }
+
+        if (attempt >= _gateRecaptures) {
+            _gateStatus.gaveUp++;
+            // A badly exposed frame may still show a cat; a damaged one is no use
+            if (verdict == FrameVerdict::Dark || verdict == FrameVerdict::BlownOut) {
+                SDLogger::getInstance().warnf("%s: no better frame after %d recaptures - using it anyway", caller, attempt);
+                return image;
+            }
+            SDLogger::getInstance().errorf("%s: no intact frame after %d recaptures", caller, attempt);
+            return FrameLease();
+        }
+
+        // Give the buffer back first so a single-buffer driver can fill it again
+        image.reset();
+        _gateStatus.recaptures++;
+        image = _camera->captureFrameAfter(0, FRESH_FRAME_TIMEOUT_MS);
+        if (!image) {
+            _gateStatus.gaveUp++;
+            return image;
+        }
+    }
+}
+
+FrameLease CaptureController::keepSharpest(FrameLease first) {
+    int64_t startUs = esp_timer_get_time();
+    int64_t deadlineUs = startUs + (int64_t)_burstBudgetMs * 1000;
+    int64_t scoringUs = 0;
+
+    float bestScore = -1.0f;
+    float worstScore = -1.0f;
+    int bestIndex = 0;
+    int frames = 0;
+    FrameLease best;
+    FrameLease frame = std::move(first);
+
+    while (true) {
+        int64_t scoreStartUs = esp_timer_get_time();
+        float score;
+        if (!_sharpness.score(frame.data(), frame.size(), score)) {
+            SDLogger::getInstance().warnf("Burst: cannot score frame %d (%s)", frames, _sharpness.error());
+            score = -1.0f;
+        }
+        scoringUs += esp_timer_get_time() - scoreStartUs;
+
+        if (!best || score > bestScore) {
+            best = std::move(frame);  // Previous best goes back to the driver here
+            bestScore = score;
+            bestIndex = frames;
+        }
+        if (worstScore < 0.0f || (score >= 0.0f && score < worstScore)) {
+            worstScore = score;
+        }
+        frame.reset();
+        frames++;
+
+        int64_t nowUs = esp_timer_get_time();
+        if (frames >= _burstFrames || nowUs >= deadlineUs) {
+            break;
+        }
+        // The next frame in the queue is necessarily newer than the ones already taken
+        frame = _camera->captureFrameAfter(0, (uint32_t)((deadlineUs - nowUs) / 1000));
+        if (!frame) {
+            break;
+        }
+    }
+
+    SDLogger::getInstance().infof("Burst: kept frame %d of %d (sharpness %.2f, worst %.2f) in %lld ms, scoring %lld us/frame",
+        bestIndex + 1, frames, bestScore, worstScore, (esp_timer_get_time() - startUs) / 1000, scoringUs / frames);
+    return best;
+}
+
 void CaptureController::runCountdown() {
     if (!_ledController) return;
 
@@ -73,6 +377,7 @@ void CaptureController::runCountdown() {
 }
 
 String CaptureController::capturePhoto() {
+    wakeCamera();
     if (!_camera || !_camera->isReady()) {
         SDLogger::getInstance().errorf("Camera not available - cannot capture photo");
         return "";
@@ -89,20 +394,10 @@ String CaptureController::capturePhoto() {
         _ledController->setColor(255, 255, 255);
     }
 
-    // Turn on external flash for capture
-    if (_flashCallback) _flashCallback(true);
-    
-    // Wait a short while for the LEDs to warm up
-    SDLogger::getInstance().infof("capturePhoto waiting for %d millis to allow LEDs to warm", _camera->getLedDelayMillis());
-    delay(_camera->getLedDelayMillis());
-
-    // Capture image
-    NamedImage* image = _camera->getImage();
-
-    // Turn off external flash after capture
-    if (_flashCallback) _flashCallback(false);
+    // Capture image (with the external flash unless the scene is bright)
+    FrameLease image = captureStill("capturePhoto");
 
-    if (!image || !image->image || image->size == 0) {
+    if (!image) {
         SDLogger::getInstance().errorf("Failed to capture image");
         if (_ledController) _ledController->off();
         return "";
@@ -117,15 +412,12 @@ String CaptureController::capturePhoto() {
         _ledController->setColor(0, 255, 0);
     }
 
-    SDLogger::getInstance().infof("Captured image: %s (%d bytes)", basename.c_str(), image->size);
-
-    // Save image to SD card
-    if (_imageStorage) {
-        _imageStorage->saveImage(basename, image);
-    }
+    SDLogger::getInstance().infof("Captured image: %s (%d bytes)", basename.c_str(), image.size());
 
     // Upload to AWS if configured
     String response;
+    InferenceMetadata metadata;
+    bool haveMetadata = false;
     if (_awsAuth && _roleAlias && _apiHost && _apiPath) {
         // Pause MQTT to free SSL memory before making HTTPS request
         _awsAuth->pauseMqtt();
@@ -136,29 +428,38 @@ String CaptureController::capturePhoto() {
             if (!_awsAuth->getCredentialsWithRoleAlias(_roleAlias)) {
                 SDLogger::getInstance().errorf("Failed to get AWS credentials");
                 _awsAuth->resumeMqtt();
-                _camera->releaseImageBuffer(image);
+                if (_imageStorage) {
+                    _imageStorage->saveImage(basename, image);
+                }
                 if (_ledController) _ledController->off();
                 return "";
             }
         }
 
         // Post image to inference endpoint
-        CatCamHttpClient httpClient;
-        response = httpClient.postImage(image, _apiHost, _apiPath, _awsAuth);
+        unsigned long inferStartMs = millis();
+        response = uploadImage(image, false, false);
+        uint32_t latencyMs = millis() - inferStartMs;
 
         _awsAuth->resumeMqtt();
 
-        // Save server response to SD card
+        // Save server response to SD card (only with .txt sidecars enabled)
         if (_imageStorage) {
             _imageStorage->saveResponse(basename, response);
         }
 
         // Parse and log inference results
+        haveMetadata = makeMetadata(parseInferenceResponse(response, basename + ".jpg"), latencyMs, metadata);
         parseAndLogInferenceResponse(response);
     }
 
-    // Release image buffer
-    _camera->releaseImageBuffer(image);
+    // Save image to SD card, with the result embedded
+    if (_imageStorage) {
+        _imageStorage->saveImage(basename, image, haveMetadata ? &metadata : nullptr);
+    }
+
+    // Hand the frame buffer back to the camera driver
+    image.reset();
 
     // Clean up old images
     if (_imageStorage) {
@@ -187,6 +488,7 @@ bool CaptureController::recordVideo(int durationSeconds, int fps) {
     }
 
     SDLogger::getInstance().infof("=== Starting Video Recording ===");
+    wakeCamera();
 
     // Run LED countdown
     runCountdown();
@@ -199,8 +501,7 @@ bool CaptureController::recordVideo(int durationSeconds, int fps) {
 
     // Configure recording
     VideoConfig config = VideoRecorder::getDefaultConfig();
-    config.frameSize = FRAMESIZE_VGA;
-    config.quality = 12;
+    config.profile = _videoProfile;
     config.fps = fps;
     config.durationSeconds = durationSeconds;
     config.outputDir = "/videos";
@@ -284,6 +585,18 @@ void CaptureController::parseAndLogInferenceResponse(const String& response) {
     }
 }
 
+bool CaptureController::makeMetadata(const DetectionResult& result, uint32_t latencyMs, InferenceMetadata& metadata) {
+    if (!result.success) {
+        return false;
+    }
+    strlcpy(metadata.name, result.detectedName.c_str(), sizeof(metadata.name));
+    metadata.index = result.detectedIndex;
+    metadata.confidence = result.confidence;
+    metadata.latencyMs = latencyMs;
+    strlcpy(metadata.firmware, FIRMWARE_VERSION, sizeof(metadata.firmware));
+    return true;
+}
+
 DetectionResult CaptureController::parseInferenceResponse(const String& response, const String& filename) {
     DetectionResult result;
     result.filename = filename;
@@ -318,6 +631,7 @@ DetectionResult CaptureController::parseInferenceResponse(const String& response
 }
 
 String CaptureController::captureTrainingPhoto() {
+    wakeCamera();
     if (!_camera || !_camera->isReady()) {
         SDLogger::getInstance().errorf("Camera not available - cannot capture photo");
         return "";
@@ -327,20 +641,10 @@ String CaptureController::captureTrainingPhoto() {
 
     // No LED countdown for training captures (similar to quick PIR captures)
 
-    // Turn on external flash for capture
-    if (_flashCallback) _flashCallback(true);
-    
-    // Wait a short while for the LEDs to warm up
-    SDLogger::getInstance().infof("captureTrainingPhoto Waiting for %d millis to allow LEDs to warm", _camera->getLedDelayMillis());
-    delay(_camera->getLedDelayMillis());
-
-    // Capture image
-    NamedImage* image = _camera->getImage();
-
-    // Turn off external flash after capture
-    if (_flashCallback) _flashCallback(false);
+    // Capture image (with the external flash unless the scene is bright)
+    FrameLease image = captureStill("captureTrainingPhoto");
 
-    if (!image || !image->image || image->size == 0) {
+    if (!image) {
         SDLogger::getInstance().errorf("Failed to capture image");
         return "";
     }
@@ -348,7 +652,7 @@ String CaptureController::captureTrainingPhoto() {
     // Generate timestamp-based filename
     String basename = _imageStorage ? _imageStorage->generateFilename() : String(millis());
 
-    SDLogger::getInstance().infof("Captured training image: %s (%d bytes)", basename.c_str(), image->size);
+    SDLogger::getInstance().infof("Captured training image: %s (%d bytes)", basename.c_str(), image.size());
 
     // Save image to SD card
     if (_imageStorage) {
@@ -367,14 +671,12 @@ String CaptureController::captureTrainingPhoto() {
             if (!_awsAuth->getCredentialsWithRoleAlias(_roleAlias)) {
                 SDLogger::getInstance().errorf("Failed to get AWS credentials");
                 _awsAuth->resumeMqtt();
-                _camera->releaseImageBuffer(image);
                 return "";
             }
         }
 
         // Post image to inference endpoint with training mode flag
-        CatCamHttpClient httpClient;
-        response = httpClient.postImage(image, _apiHost, _apiPath, _awsAuth, true);  // trainingMode=true
+        response = uploadImage(image, true, false);
 
         _awsAuth->resumeMqtt();
 
@@ -389,8 +691,8 @@ String CaptureController::captureTrainingPhoto() {
         SDLogger::getInstance().warnf("AWS not configured - cannot upload training photo");
     }
 
-    // Release image buffer
-    _camera->releaseImageBuffer(image);
+    // Hand the frame buffer back to the camera driver
+    image.reset();
 
     // Clean up old images
     if (_imageStorage) {
@@ -402,8 +704,689 @@ String CaptureController::captureTrainingPhoto() {
     return basename + ".jpg";
 }
 
-DetectionResult CaptureController::captureAndDetect(bool claudeInfer) {
+void CaptureController::setChangeGate(bool enabled, float threshold) {
+    _changeGateEnabled = enabled;
+    _changeGateThreshold = constrain(threshold, 0.0f, 1.0f);
+    _consecutiveGateSkips = 0;
+    if (!enabled) {
+        _sceneChange.reset();
+    }
+    SDLogger::getInstance().infof("Scene-change gate %s (threshold %.1f%% of cells)",
+        enabled ? "ON" : "OFF", _changeGateThreshold * 100.0f);
+}
+
+bool CaptureController::isSceneUnchanged(const FrameLease& image, float& changeRatio) {
+    int64_t startUs = esp_timer_get_time();
+
+    // The quality gate usually built this frame's map already
+    bool mapReady = image.timestampUs() != 0 && image.timestampUs() == _lumaMapFrameUs;
+    if (!mapReady) {
+        if (!_lumaMap.build(image.data(), image.size())) {
+            SDLogger::getInstance().warnf("Change gate: cannot read frame (%s) - uploading", _lumaMap.error());
+            _lumaMapFrameUs = 0;
+            return false;
+        }
+        _lumaMapFrameUs = image.timestampUs();
+    }
+    SceneChangeDetector::Result change = _sceneChange.update(_lumaMap);
+    changeRatio = change.changeRatio;
+
+    SDLogger::getInstance().infof("Change gate: %.1f%% of %dx%d cells changed (shift %.1f, threshold %.1f%%) in %lld us",
+        change.changeRatio * 100.0f, _lumaMap.width(), _lumaMap.height(), change.meanShift,
+        _changeGateThreshold * 100.0f, esp_timer_get_time() - startUs);
+
+    if (change.backgroundReset || change.changeRatio >= _changeGateThreshold) {
+        _consecutiveGateSkips = 0;
+        return false;
+    }
+
+    if (_consecutiveGateSkips >= CHANGE_GATE_MAX_CONSECUTIVE_SKIPS) {
+        SDLogger::getInstance().infof("Change gate: uploading after %d skipped triggers", _consecutiveGateSkips);
+        _consecutiveGateSkips = 0;
+        return false;
+    }
+
+    _consecutiveGateSkips++;
+    return true;
+}
+
+void CaptureController::setInferenceCache(int ttlSeconds, int maxDistance) {
+    ttlSeconds = constrain(ttlSeconds, 0, 3600);
+    _inferenceCache.configure((uint32_t)ttlSeconds * 1000, maxDistance);
+    _cacheStatus.entries = _inferenceCache.liveEntries(millis());
+    if (ttlSeconds) {
+        SDLogger::getInstance().infof("Inference cache ON (%d s, up to %d bits apart)", ttlSeconds, maxDistance);
+    } else {
+        SDLogger::getInstance().infof("Inference cache OFF");
+    }
+}
+
+bool CaptureController::hashFrame(const FrameLease& image, uint64_t& hash) {
+    int64_t startUs = esp_timer_get_time();
+
+    // The quality gate or change gate usually built this frame's map already
+    bool mapReady = image.timestampUs() != 0 && image.timestampUs() == _lumaMapFrameUs;
+    if (!mapReady) {
+        if (!_lumaMap.build(image.data(), image.size())) {
+            SDLogger::getInstance().warnf("Inference cache: cannot read frame (%s)", _lumaMap.error());
+            _lumaMapFrameUs = 0;
+            return false;
+        }
+        _lumaMapFrameUs = image.timestampUs();
+    }
+
+    // Hash what inference sees: the upload crop
+    int width = _lumaMap.width();
+    int height = _lumaMap.height();
+    if (!perceptualHash(_lumaMap, width * _cropX / 100, height * _cropY / 100,
+                        max(1, width * _cropWidth / 100), max(1, height * _cropHeight / 100), hash)) {
+        return false;
+    }
+    SDLogger::getInstance().debugf("Inference cache: hash %08lx%08lx in %lld us",
+        (unsigned long)(hash >> 32), (unsigned long)hash, esp_timer_get_time() - startUs);
+    return true;
+}
+
+bool CaptureController::lookupCachedResult(uint64_t hash, const String& filename, DetectionResult& result) {
+    uint32_t nowMs = millis();
+    InferenceMetadata cached;
+    int distance = 0;
+    bool hit = _inferenceCache.lookup(hash, nowMs, cached, distance);
+    _cacheStatus.entries = _inferenceCache.liveEntries(nowMs);
+    if (!hit) {
+        _cacheStatus.misses++;
+        return false;
+    }
+
+    _cacheStatus.hits++;
+    _cacheStatus.latencySavedMs += cached.latencyMs;
+    _cacheStatus.lastDistance = distance;
+
+    result.success = true;
+    result.detectedName = cached.name;
+    result.detectedIndex = cached.index;
+    result.confidence = cached.confidence;
+    result.filename = filename;
+    result.cached = true;
+
+    SDLogger::getInstance().infof("Inference cache hit (%d bits apart): %s (%.1f%%) - no upload, ~%lu ms saved",
+        distance, cached.name, cached.confidence * 100.0f, (unsigned long)cached.latencyMs);
+    return true;
+}
+
+void CaptureController::setLocalInference(int mode) {
+    static const char* const MODE_NAMES[] = { "OFF", "fallback", "primary", "shadow" };
+    _localMode = (LocalInferenceMode)constrain(mode, 0, 3);
+    if (_localMode == LocalInferenceMode::Off) {
+        _localClassifier.end();
+    } else {
+        _localClassifier.begin();
+    }
+    _localStatus.mode = (int)_localMode;
+    _localStatus.modelLoaded = _localClassifier.isReady();
+    SDLogger::getInstance().infof("Local inference %s%s", MODE_NAMES[(int)_localMode],
+        _localMode != LocalInferenceMode::Off && !_localStatus.modelLoaded ? " (no model - inactive)" : "");
+}
+
+bool CaptureController::runLocalClassifier(const FrameLease& image, LocalResult& local) {
+    if (!_localClassifier.isReady() ||
+        !_localClassifier.classify(image.data(), image.size(), _cropX, _cropY, _cropWidth, _cropHeight, local)) {
+        return false;
+    }
+    _localStatus.runs++;
+    _localStatus.meanLatencyMs = _localStatus.meanLatencyMs
+        ? (_localStatus.meanLatencyMs * 7 + local.latencyMs) / 8 : local.latencyMs;
+    _localStatus.maxLatencyMs = max(_localStatus.maxLatencyMs, (unsigned long)local.latencyMs);
+    return true;
+}
+
+bool CaptureController::decideLocally(const FrameLease& image, const String& filename, DetectionResult& result,
+                                      uint32_t& latencyMs) {
+    LocalResult local;
+    if (!runLocalClassifier(image, local)) {
+        return false;
+    }
+    _localStatus.decisions++;
+
+    result.success = true;
+    result.detectedName = local.name;
+    result.detectedIndex = local.index;
+    result.confidence = local.confidence;
+    result.filename = filename;
+    result.local = true;
+    latencyMs = local.latencyMs;
+
+    SDLogger::getInstance().infof("Local inference: %s (%.1f%%) in %lu ms (preprocess %lu ms, model %lu ms)",
+        local.name, local.confidence * 100.0f, (unsigned long)local.latencyMs,
+        (unsigned long)local.preprocessMs, (unsigned long)local.inferenceMs);
+    return true;
+}
+
+void CaptureController::compareWithCloud(const FrameLease& image, const DetectionResult& cloud, uint32_t cloudMs) {
+    LocalResult local;
+    if (!runLocalClassifier(image, local)) {
+        return;
+    }
+
+    // Index 0 is Boots for both the cloud and the on-device model
+    bool cloudBoots = cloud.detectedIndex == 0;
+    bool localBoots = local.index == 0;
+    _localStatus.compared++;
+    if (cloudBoots == localBoots) {
+        _localStatus.agreed++;
+    } else if (cloudBoots) {
+        _localStatus.bootsMissed++;
+    } else {
+        _localStatus.bootsFalse++;
+    }
+    _localStatus.meanCloudMs = _localStatus.meanCloudMs ? (_localStatus.meanCloudMs * 7 + cloudMs) / 8 : cloudMs;
+
+    SDLogger::getInstance().infof("Local inference (shadow): %s %.1f%% in %lu ms vs cloud %s %.1f%% in %lu ms - %s (%lu/%lu agree)",
+        local.name, local.confidence * 100.0f, (unsigned long)local.latencyMs,
+        cloud.detectedName.c_str(), cloud.confidence * 100.0f, (unsigned long)cloudMs,
+        cloudBoots == localBoots ? "agree" : "DISAGREE", _localStatus.agreed, _localStatus.compared);
+}
+
+void CaptureController::setDaylightCapture(int mode, int minLuma) {
+    static const char* const MODE_NAMES[] = { "OFF", "light sensor", "frame luma" };
+    _daylightMode = (DaylightMode)constrain(mode, 0, 2);
+    _daylightMinLuma = constrain(minLuma, 0, 255);
+    SDLogger::getInstance().infof("Daylight capture %s (min luma %d)", MODE_NAMES[(int)_daylightMode], _daylightMinLuma);
+}
+
+void CaptureController::setIdleStandby(int idleSeconds) {
+    _idleStandbyMs = (unsigned long)max(idleSeconds, 0) * 1000UL;
+    _lastActivityMs = millis();
+    if (_idleStandbyMs) {
+        SDLogger::getInstance().infof("Camera standby after %d s idle", idleSeconds);
+    } else {
+        SDLogger::getInstance().infof("Camera standby OFF");
+    }
+}
+
+void CaptureController::updateStandby(bool allowed) {
+    if (!_camera || !_camera->isReady()) {
+        return;
+    }
+    if (_camera->isStandby() || _ringPausedForStandby) {
+        // A driver restart elsewhere also wakes the sensor - catch up with it
+        if (!allowed || _idleStandbyMs == 0 || !_camera->isStandby()) {
+            wakeCamera();
+        }
+        return;
+    }
+    if (!allowed || _idleStandbyMs == 0 || millis() - _lastActivityMs < _idleStandbyMs ||
+        (_videoRecorder && _videoRecorder->isRecording())) {
+        return;
+    }
+
+    // The ring must not be inside fb_get when the frames stop
+    if (_frameRing) _frameRing->pause();
+    if (!_camera->standby()) {
+        if (_frameRing) _frameRing->resume();
+        _lastActivityMs = millis();  // Try again after another idle period, not every loop
+        return;
+    }
+    _ringPausedForStandby = _frameRing != nullptr;
+    _standbySinceMs = millis();
+    _standbyStatus.asleep = true;
+    _standbyStatus.standbys++;
+}
+
+bool CaptureController::wakeCamera() {
+    _lastActivityMs = millis();
+    if (!_camera) {
+        return false;
+    }
+
+    // Also clears up after a driver restart (e.g. tune_camera) that woke the sensor
+    if (_camera->isStandby()) {
+        CameraResumeReport report;
+        if (_camera->resume(&report)) {
+            CameraStandbyStatus& status = _standbyStatus;
+            (report.fast ? status.fastResumes : status.fullResumes)++;
+            status.lastResumeMs = report.elapsedMs;
+            if (report.fast) {
+                status.meanResumeMs = status.meanResumeMs
+                    ? (status.meanResumeMs * 7 + report.elapsedMs) / 8 : report.elapsedMs;
+            }
+            status.maxResumeMs = max(status.maxResumeMs, (unsigned long)report.elapsedMs);
+        } else {
+            SDLogger::getInstance().errorf("Camera did not come back from standby");
+        }
+    }
+    if (_ringPausedForStandby) {
+        _frameRing->resume();
+        _ringPausedForStandby = false;
+    }
+    if (_standbyStatus.asleep) {
+        _standbyStatus.asleepSeconds += (millis() - _standbySinceMs) / 1000;
+        _standbyStatus.asleep = false;
+    }
+    return _camera->isReady();
+}
+
+void CaptureController::setUploadCrop(int x, int y, int width, int height) {
+    _cropX = constrain(x, 0, 99);
+    _cropY = constrain(y, 0, 99);
+    _cropWidth = constrain(width, 1, 100 - _cropX);
+    _cropHeight = constrain(height, 1, 100 - _cropY);
+    SDLogger::getInstance().infof("Upload crop: %d,%d %dx%d%%", _cropX, _cropY, _cropWidth, _cropHeight);
+}
+
+void CaptureController::setCameraProfiles(CameraProfile photo, CameraProfile video) {
+    _photoProfile = photo;
+    _videoProfile = video;
+    SDLogger::getInstance().infof("Camera profiles: %s for stills, %s for video",
+        cameraProfileName(photo), cameraProfileName(video));
+}
+
+void CaptureController::setDualCapture(bool enabled, bool uploadArchive) {
+    _dualCapture = enabled;
+    _archiveUpload = uploadArchive;
+    SDLogger::getInstance().infof("Dual capture %s (archive upload %s)",
+        enabled ? "ON" : "OFF", uploadArchive ? "ON" : "OFF");
+}
+
+void CaptureController::setQualityGate(bool enabled, int recaptures) {
+    _qualityGateEnabled = enabled;
+    _gateRecaptures = constrain(recaptures, 0, MAX_GATE_RECAPTURES);
+    SDLogger::getInstance().infof("Frame quality gate %s (up to %d recaptures)",
+        enabled ? "ON" : "OFF", _gateRecaptures);
+}
+
+void CaptureController::setUploadTranscode(int quality) {
+    _transcodeQuality = constrain(quality, 0, 100);
+    if (_transcodeQuality) {
+        SDLogger::getInstance().infof("Upload transcode ON (quality %d)", _transcodeQuality);
+    } else {
+        SDLogger::getInstance().infof("Upload transcode OFF");
+    }
+}
+
+void CaptureController::logDecisionTime(bool dual, int64_t startUs) {
+    uint32_t elapsedMs = (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    uint32_t& average = _decisionMs[dual ? 1 : 0];
+    average = average ? (average * 3 + elapsedMs) / 4 : max(elapsedMs, (uint32_t)1);
+    SDLogger::getInstance().infof("Time to decision (%s): %lu ms - average single %lu ms, dual %lu ms",
+        dual ? "dual" : "single", (unsigned long)elapsedMs,
+        (unsigned long)_decisionMs[0], (unsigned long)_decisionMs[1]);
+}
+
+bool CaptureController::uploadPendingArchive() {
+    if (_pendingArchive.isEmpty()) {
+        return false;
+    }
+    String basename = _pendingArchive;
+    _pendingArchive = "";
+
+    if (!_imageStorage || !_awsAuth || !_roleAlias || !_apiHost || !_apiPath) {
+        return false;
+    }
+    FrameLease archive = _imageStorage->loadImage(basename);
+    if (!archive) {
+        return false;
+    }
+
+    _awsAuth->pauseMqtt();
+    if (!_awsAuth->areCredentialsValid() && !_awsAuth->getCredentialsWithRoleAlias(_roleAlias)) {
+        SDLogger::getInstance().errorf("Archive upload: failed to get AWS credentials");
+        _awsAuth->resumeMqtt();
+        return false;
+    }
+
+    // Full frame, not cropped, and kept out of the adaptive quality loop
+    unsigned long startMs = millis();
+    CatCamHttpClient httpClient;
+    UploadTiming timing;
+    String response = httpClient.postImage(archive, _apiHost, _apiPath, _awsAuth, UploadMode::Archive,
+        false, _uploadHashOverlap, &timing);
+    _awsAuth->resumeMqtt();
+    recordUploadTiming(timing);
+
+    bool succeeded = !response.startsWith("{\"error\"");
+    SDLogger::getInstance().infof("Archive upload %s: %s (%d bytes, %lu ms)",
+        succeeded ? "done" : "failed", basename.c_str(), archive.size(), millis() - startMs);
+    return succeeded;
+}
+
+void CaptureController::setBurst(int frames, int budgetMs) {
+    _burstFrames = constrain(frames, 1, MAX_BURST_FRAMES);
+    _burstBudgetMs = (uint32_t)constrain(budgetMs, 100, 5000);
+    if (_burstFrames > 1) {
+        SDLogger::getInstance().infof("Burst capture: up to %d frames in %lu ms", _burstFrames, (unsigned long)_burstBudgetMs);
+    }
+}
+
+void CaptureController::setQualityTarget(const CameraSettings& settings, const PipelineSettings& pipeline) {
+    _quality.configure(settings, pipeline);
+    // Inactive means every profile keeps its compiled quality
+    if (_quality.isActive() && _camera && _camera->isReady()) {
+        _camera->setJpegQuality(_uploadProfile, _quality.quality());
+    }
+    if (_quality.isActive()) {
+        SDLogger::getInstance().infof("Adaptive JPEG quality ON (target %d KB / %d ms, quality %d)",
+            pipeline.uploadTargetKB, pipeline.uploadTargetMs, _quality.quality());
+    }
+}
+
+String CaptureController::uploadImage(const FrameLease& image, bool trainingMode, bool claudeInfer) {
+    // Only the region of interest goes up (cropped like detection uploads for
+    // training too, so training data matches what the model sees)
+    FrameLease cropped = cropForUpload(image);
+    const FrameLease& source = cropped ? cropped : image;
+    FrameLease transcoded = transcodeForUpload(source);
+    const FrameLease& upload = transcoded ? transcoded : source;
+
+    unsigned long startMs = millis();
+    CatCamHttpClient httpClient;
+    UploadTiming timing;
+    String response = httpClient.postImage(upload, _apiHost, _apiPath, _awsAuth,
+        trainingMode ? UploadMode::Training : UploadMode::Inference, claudeInfer, _uploadHashOverlap, &timing);
+    unsigned long elapsedMs = millis() - startMs;
+    recordUploadTiming(timing);
+
+    bool succeeded = !response.startsWith("{\"error\"");
+    int previousQuality = _quality.quality();
+    // The loop steers the sensor's quality, so it sees the sensor's bytes -
+    // a transcode on top would otherwise look like the camera undershooting
+    if (_quality.onUpload(source.size(), elapsedMs, succeeded)) {
+        _camera->setJpegQuality(_uploadProfile, _quality.quality());
+    }
+
+    const JpegQualityStatus& q = _quality.status();
+    SDLogger::getInstance().infof("Upload: %d bytes in %lu ms (quality %d -> %d, target %lu bytes, %lu B/s)",
+        upload.size(), elapsedMs, previousQuality, q.quality, q.targetBytes, q.throughputBps);
+    if (q.uploads % QUALITY_HISTOGRAM_LOG_INTERVAL == 0) {
+        logQualityHistograms();
+    }
+    return response;
+}
+
+void CaptureController::setUploadHashOverlap(bool enabled) {
+    _uploadHashOverlap = enabled;
+    SDLogger::getInstance().infof("Upload hash %s", enabled ? "overlapped with connecting" : "before connecting");
+}
+
+void CaptureController::recordUploadTiming(const UploadTiming& timing) {
+    if (!timing.sent) {
+        return;
+    }
+    UploadHashStatus& s = _uploadHashStatus;
+    unsigned long* mean = &s.meanFirstByteSerialMs;
+    if (timing.hashSource == PayloadHashSource::Capture) {
+        s.fromCapture++;
+        mean = &s.meanFirstByteCaptureMs;
+    } else if (timing.hashSource == PayloadHashSource::Overlapped) {
+        s.overlapped++;
+        mean = &s.meanFirstByteOverlapMs;
+    } else {
+        s.serial++;
+    }
+    s.lastHashWaitMs = timing.hashWaitMs;
+    s.lastFirstByteMs = timing.firstByteMs;
+    *mean = *mean ? (*mean * 7 + timing.firstByteMs) / 8 : max((unsigned long)timing.firstByteMs, 1UL);
+}
+
+void CaptureController::logQualityHistograms() {
+    const JpegQualityStatus& q = _quality.status();
+    SDLogger::getInstance().infof("Upload sizes after %lu uploads: <32K %u, <64K %u, <128K %u, <256K %u, <512K %u, more %u",
+        q.uploads, q.sizeHistogram[0], q.sizeHistogram[1], q.sizeHistogram[2],
+        q.sizeHistogram[3], q.sizeHistogram[4], q.sizeHistogram[5]);
+    SDLogger::getInstance().infof("Upload latency: <0.5s %u, <1s %u, <2s %u, <4s %u, <8s %u, more %u",
+        q.latencyHistogram[0], q.latencyHistogram[1], q.latencyHistogram[2],
+        q.latencyHistogram[3], q.latencyHistogram[4], q.latencyHistogram[5]);
+}
+
+FrameLease CaptureController::cropForUpload(const FrameLease& image) {
+    if (_cropX == 0 && _cropY == 0 && _cropWidth == 100 && _cropHeight == 100) {
+        return FrameLease();
+    }
+
+    int64_t startUs = esp_timer_get_time();
+
+    if (!_cropper.load(image.data(), image.size())) {
+        SDLogger::getInstance().warnf("Upload crop: cannot read frame (%s) - uploading full frame", _cropper.error());
+        return FrameLease();
+    }
+
+    const JpegInfo& info = _cropper.info();
+    JpegCropRect rect;
+    rect.x = (uint16_t)((uint32_t)info.width * _cropX / 100);
+    rect.y = (uint16_t)((uint32_t)info.height * _cropY / 100);
+    rect.width = (uint16_t)max(1UL, (unsigned long)info.width * _cropWidth / 100);
+    rect.height = (uint16_t)max(1UL, (unsigned long)info.height * _cropHeight / 100);
+
+    size_t capacity = image.size() + CROP_HEADROOM_BYTES;
+    uint8_t* buffer = (uint8_t*)SlabAllocator::getInstance().allocate(capacity);
+    if (!buffer) {
+        buffer = (uint8_t*)(psramFound() ? ps_malloc(capacity) : malloc(capacity));
+    }
+    if (!buffer) {
+        SDLogger::getInstance().warnf("Upload crop: no memory for %d bytes - uploading full frame", capacity);
+        return FrameLease();
+    }
+
+    size_t croppedSize = 0;
+    JpegCropRect actual;
+    if (!_cropper.crop(rect, buffer, capacity, croppedSize, &actual)) {
+        SDLogger::getInstance().warnf("Upload crop failed (%s) - uploading full frame", _cropper.error());
+        freeUploadBuffer(nullptr, buffer);
+        return FrameLease();
+    }
+
+    SDLogger::getInstance().infof("Upload crop: %dx%d at %d,%d of %dx%d, %d -> %d bytes in %lld us",
+        actual.width, actual.height, actual.x, actual.y, info.width, info.height,
+        image.size(), croppedSize, esp_timer_get_time() - startUs);
+
+    return FrameLease(buffer, croppedSize, image.timestampUs(), buffer, &CaptureController::freeUploadBuffer, nullptr, true);
+}
+
+FrameLease CaptureController::transcodeForUpload(const FrameLease& image) {
+    if (!_transcodeQuality) {
+        return FrameLease();
+    }
+
+    int64_t startUs = esp_timer_get_time();
+
+    size_t capacity = image.size() + TRANSCODE_HEADROOM_BYTES;
+    uint8_t* buffer = (uint8_t*)SlabAllocator::getInstance().allocate(capacity);
+    if (!buffer) {
+        buffer = (uint8_t*)(psramFound() ? ps_malloc(capacity) : malloc(capacity));
+    }
+    if (!buffer) {
+        SDLogger::getInstance().warnf("Upload transcode: no memory for %d bytes - uploading as captured", capacity);
+        _transcodeStatus.failures++;
+        return FrameLease();
+    }
+
+    size_t transcodedSize = 0;
+    if (!_transcoder.load(image.data(), image.size()) ||
+        !_transcoder.transcode(_transcodeQuality, buffer, capacity, transcodedSize)) {
+        SDLogger::getInstance().warnf("Upload transcode failed (%s) - uploading as captured", _transcoder.error());
+        freeUploadBuffer(nullptr, buffer);
+        _transcodeStatus.failures++;
+        return FrameLease();
+    }
+
+    unsigned long costUs = (unsigned long)(esp_timer_get_time() - startUs);
+    recordTranscode(image.size(), transcodedSize, costUs);
+
+    SDLogger::getInstance().infof("Upload transcode: %d -> %d bytes (%d%% smaller) at quality %d in %lu us",
+        image.size(), transcodedSize, (int)(100 - (long)transcodedSize * 100 / (long)image.size()), _transcodeQuality, costUs);
+
+    // Already at or above the target quality with near-optimal tables
+    if (transcodedSize >= image.size()) {
+        freeUploadBuffer(nullptr, buffer);
+        return FrameLease();
+    }
+    return FrameLease(buffer, transcodedSize, image.timestampUs(), buffer, &CaptureController::freeUploadBuffer, nullptr, true);
+}
+
+void CaptureController::recordTranscode(size_t bytesIn, size_t bytesOut, unsigned long costUs) {
+    _transcodeStatus.frames++;
+    _transcodeStatus.bytesIn += bytesIn;
+    _transcodeStatus.bytesOut += bytesOut;
+    _transcodeStatus.meanCostUs = _transcodeStatus.meanCostUs ? (_transcodeStatus.meanCostUs * 7 + costUs) / 8 : costUs;
+    _transcodeStatus.maxCostUs = max(_transcodeStatus.maxCostUs, costUs);
+}
+
+namespace {
+
+bool readAviU32(File& file, uint32_t& value) {
+    uint8_t buf[4];
+    if (file.read(buf, 4) != 4) {
+        return false;
+    }
+    value = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+    return true;
+}
+
+bool writeAviU32(File& file, uint32_t value) {
+    uint8_t buf[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    return file.write(buf, 4) == 4;
+}
+
+// FourCCs are compared as little-endian words
+constexpr uint32_t aviFourCC(const char* code) {
+    return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+}
+
+bool CaptureController::transcodeVideoForUpload(const String& sourcePath, const String& uploadPath) {
+    if (!_transcodeQuality) {
+        return false;
+    }
+    File source = SD_MMC.open(sourcePath.c_str(), FILE_READ);
+    if (!source) {
+        return false;
+    }
+    int64_t startUs = esp_timer_get_time();
+    size_t sourceSize = source.size();
+
+    // Find the movi LIST after the RIFF header and hdrl
+    uint32_t tag = 0, length = 0, listType = 0;
+    size_t moviListPos = 0, moviEnd = 0;
+    size_t position = 12;
+    while (position + 12 <= sourceSize && source.seek(position) && readAviU32(source, tag) && readAviU32(source, length)) {
+        if (tag == aviFourCC("LIST") && readAviU32(source, listType) && listType == aviFourCC("movi")) {
+            moviListPos = position;
+            moviEnd = min(sourceSize, position + 8 + (size_t)length);
+            break;
+        }
+        position += 8 + length + (length & 1);
+    }
+    size_t moviDataStart = moviListPos + 12;
+
+    // The largest frame sizes both buffers
+    size_t largest = 0;
+    for (position = moviDataStart; moviListPos && position + 8 <= moviEnd; position += 8 + length + (length & 1)) {
+        if (!source.seek(position) || !readAviU32(source, tag) || !readAviU32(source, length)) {
+            break;
+        }
+        largest = max(largest, (size_t)length);
+    }
+    if (!moviListPos || !largest) {
+        SDLogger::getInstance().warnf("Video transcode: no frames found in %s", sourcePath.c_str());
+        source.close();
+        return false;
+    }
+
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    size_t capacity = largest + TRANSCODE_HEADROOM_BYTES;
+    uint8_t* frame = (uint8_t*)slab.allocate(largest);
+    if (!frame) frame = (uint8_t*)(psramFound() ? ps_malloc(largest) : malloc(largest));
+    uint8_t* transcoded = (uint8_t*)slab.allocate(capacity);
+    if (!transcoded) transcoded = (uint8_t*)(psramFound() ? ps_malloc(capacity) : malloc(capacity));
+    File output = (frame && transcoded) ? SD_MMC.open(uploadPath.c_str(), FILE_WRITE) : File();
+
+    // RIFF header, hdrl and the movi LIST header are copied as-is; the sizes are patched at the end
+    bool ok = output && source.seek(0);
+    for (position = 0; ok && position < moviDataStart; ) {
+        size_t n = min(largest, moviDataStart - position);
+        ok = source.read(frame, n) == n && output.write(frame, n) == n;
+        position += n;
+    }
+
+    // Requantise every 00dc chunk; a frame that fails or does not shrink is copied
+    struct IndexEntry {
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::vector<IndexEntry> index;
+    size_t framesIn = 0, framesOut = 0;
+    int fallbacks = 0;
+    for (position = moviDataStart; ok && position + 8 <= moviEnd; position += 8 + length + (length & 1)) {
+        ok = source.seek(position) && readAviU32(source, tag) && readAviU32(source, length) &&
+             length <= largest && source.read(frame, length) == length;
+        if (!ok) {
+            break;
+        }
+        const uint8_t* data = frame;
+        size_t size = length;
+        if (tag == aviFourCC("00dc")) {
+            int64_t frameStartUs = esp_timer_get_time();
+            size_t transcodedSize = 0;
+            if (_transcoder.load(frame, length) &&
+                _transcoder.transcode(_transcodeQuality, transcoded, capacity, transcodedSize) &&
+                transcodedSize < length) {
+                recordTranscode(length, transcodedSize, (unsigned long)(esp_timer_get_time() - frameStartUs));
+                data = transcoded;
+                size = transcodedSize;
+            } else {
+                fallbacks++;
+            }
+            index.push_back({ (uint32_t)(output.position() - moviDataStart), (uint32_t)size });
+            framesIn += length;
+            framesOut += size;
+        }
+        uint8_t pad = 0;
+        ok = writeAviU32(output, tag) && writeAviU32(output, size) && output.write(data, size) == size &&
+             (!(size & 1) || output.write(&pad, 1) == 1);
+        yield();  // Prevent WDT reset
+    }
+
+    // New idx1 (offsets from the movi data, as VideoRecorder writes them), then the sizes
+    size_t newMoviEnd = output ? output.position() : 0;
+    ok = ok && writeAviU32(output, aviFourCC("idx1")) && writeAviU32(output, index.size() * 16);
+    for (size_t i = 0; ok && i < index.size(); i++) {
+        ok = writeAviU32(output, aviFourCC("00dc")) && writeAviU32(output, 0x10) &&  // AVIIF_KEYFRAME
+             writeAviU32(output, index[i].offset) && writeAviU32(output, index[i].size);
+    }
+    size_t outputSize = output ? output.position() : 0;
+    ok = ok && output.seek(4) && writeAviU32(output, outputSize - 8) &&
+         output.seek(moviListPos + 4) && writeAviU32(output, newMoviEnd - moviDataStart + 4);
+
+    source.close();
+    if (output) output.close();
+    freeUploadBuffer(nullptr, frame);
+    freeUploadBuffer(nullptr, transcoded);
+
+    if (!ok || outputSize >= sourceSize) {
+        SDLogger::getInstance().warnf("Video transcode %s - uploading as recorded", ok ? "saved nothing" : "failed");
+        SD_MMC.remove(uploadPath.c_str());
+        if (!ok) _transcodeStatus.failures++;
+        return false;
+    }
+    SDLogger::getInstance().infof("Video transcode: %d frames, %d -> %d bytes of JPEG (%d%% smaller, %d kept as recorded) at quality %d in %lu ms",
+        index.size(), framesIn, framesOut, (int)(100 - (long long)framesOut * 100 / (long long)framesIn), fallbacks,
+        _transcodeQuality, (unsigned long)((esp_timer_get_time() - startUs) / 1000));
+    return true;
+}
+
+void CaptureController::freeUploadBuffer(void* context, void* handle) {
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    if (slab.owns(handle)) {
+        slab.release(handle);
+    } else {
+        free(handle);
+    }
+}
+
+DetectionResult CaptureController::captureAndDetect(bool claudeInfer, int64_t triggerUs) {
     DetectionResult result;
+    wakeCamera();  // Resume latency counts towards the decision time
 
     if (!_camera || !_camera->isReady()) {
         SDLogger::getInstance().errorf("Camera not available - cannot capture photo");
@@ -411,23 +1394,33 @@ DetectionResult CaptureController::captureAndDetect(bool claudeInfer) {
     }
 
     SDLogger::getInstance().infof("=== Quick Capture for Detection ===");
+    int64_t decisionStartUs = triggerUs > 0 ? triggerUs : esp_timer_get_time();
 
     // No LED countdown for quick PIR-triggered capture
 
-    // Turn on external flash for capture
-    if (_flashCallback) _flashCallback(true);
-
-    // Wait a short while for the LEDs to warm up
-    SDLogger::getInstance().infof("captureAndDetect Waiting for %d millis to allow LEDs to warm", _camera->getLedDelayMillis());
-    delay(_camera->getLedDelayMillis());
-
-    // Capture image
-    NamedImage* image = _camera->getImage();
+    // Prefer a frame the pre-trigger ring already holds from around the PIR edge
+    FrameLease image;
+    if (_frameRing && _frameRing->isRunning() && triggerUs > 0) {
+        image = _frameRing->leaseNearest(triggerUs, PRE_TRIGGER_MAX_DISTANCE_US);
+        if (image && _qualityGateEnabled && checkFrame(image, "pre-trigger") != FrameVerdict::Ok) {
+            image.reset();  // Take a fresh capture instead
+        }
+        if (image) {
+            SDLogger::getInstance().infof("Using pre-trigger frame captured %lld ms from PIR edge",
+                (image.timestampUs() - triggerUs) / 1000);
+        }
+    }
 
-    // Turn off external flash after capture
-    if (_flashCallback) _flashCallback(false);
+    // Otherwise capture a still (flash unless it is bright); in dual mode a
+    // small frame decides and a full-resolution one is taken for the archive
+    // once the decision is made
+    bool dual = false;
+    if (!image) {
+        dual = _dualCapture;
+        image = captureStill("captureAndDetect", true, dual);
+    }
 
-    if (!image || !image->image || image->size == 0) {
+    if (!image) {
         SDLogger::getInstance().errorf("Failed to capture image");
         return result;
     }
@@ -435,52 +1428,104 @@ DetectionResult CaptureController::captureAndDetect(bool claudeInfer) {
     // Generate timestamp-based filename
     String basename = _imageStorage ? _imageStorage->generateFilename() : String(millis());
 
-    SDLogger::getInstance().infof("Captured image: %s (%d bytes)", basename.c_str(), image->size);
+    SDLogger::getInstance().infof("Captured image: %s (%d bytes)", basename.c_str(), image.size());
 
-    // Save image to SD card
-    if (_imageStorage) {
-        _imageStorage->saveImage(basename, image);
+    // Nothing new in view (curtains, sunlight, a sleeping cat) - skip the upload
+    if (_changeGateEnabled && isSceneUnchanged(image, result.sceneChange)) {
+        result.skippedUnchanged = true;
+        image.reset();
+        SDLogger::getInstance().infof("=== Detection Skipped (scene unchanged) ===");
+        return result;
     }
 
+    // The same view as a recent upload - reuse that answer
+    uint64_t hash = 0;
+    bool haveHash = _inferenceCache.enabled() && hashFrame(image, hash);
+
     // Upload to AWS and get inference result
     String response;
-    if (_awsAuth && _roleAlias && _apiHost && _apiPath) {
+    uint32_t latencyMs = 0;
+    if (haveHash && lookupCachedResult(hash, basename + ".jpg", result)) {
+        // Answered from the cache
+    } else if (_localMode == LocalInferenceMode::Primary && decideLocally(image, basename + ".jpg", result, latencyMs)) {
+        // Answered on the device
+    } else if (_awsAuth && _roleAlias && _apiHost && _apiPath) {
         // Pause MQTT to free SSL memory before making HTTPS request
         _awsAuth->pauseMqtt();
 
         // Get AWS credentials (refresh if needed)
-        if (!_awsAuth->areCredentialsValid()) {
+        bool haveCredentials = _awsAuth->areCredentialsValid();
+        if (!haveCredentials) {
             SDLogger::getInstance().infof("Refreshing AWS credentials...");
-            if (!_awsAuth->getCredentialsWithRoleAlias(_roleAlias)) {
+            haveCredentials = _awsAuth->getCredentialsWithRoleAlias(_roleAlias);
+            if (!haveCredentials) {
                 SDLogger::getInstance().errorf("Failed to get AWS credentials");
-                _awsAuth->resumeMqtt();
-                _camera->releaseImageBuffer(image);
-                return result;
             }
         }
 
-        // Post image to inference endpoint
-        CatCamHttpClient httpClient;
-        response = httpClient.postImage(image, _apiHost, _apiPath, _awsAuth, false, claudeInfer);
+        if (haveCredentials) {
+            // Post image to inference endpoint
+            unsigned long inferStartMs = millis();
+            response = uploadImage(image, false, claudeInfer);
+            latencyMs = millis() - inferStartMs;
+        }
 
         _awsAuth->resumeMqtt();
 
-        // Save server response to SD card
-        if (_imageStorage) {
-            _imageStorage->saveResponse(basename, response);
-        }
+        if (haveCredentials) {
+            // Save server response to SD card (only with .txt sidecars enabled)
+            if (_imageStorage) {
+                _imageStorage->saveResponse(basename, response);
+            }
 
-        // Parse response into DetectionResult
-        result = parseInferenceResponse(response, basename + ".jpg");
+            // Parse response into DetectionResult
+            result = parseInferenceResponse(response, basename + ".jpg");
 
-        // Also log the inference results
-        parseAndLogInferenceResponse(response);
+            // Also log the inference results
+            parseAndLogInferenceResponse(response);
+
+            InferenceMetadata answer;
+            if (haveHash && makeMetadata(result, latencyMs, answer)) {
+                _inferenceCache.insert(hash, answer, millis());
+                _cacheStatus.entries = _inferenceCache.liveEntries(millis());
+            }
+        }
     } else {
         SDLogger::getInstance().warnf("AWS not configured - cannot run inference");
     }
 
-    // Release image buffer
-    _camera->releaseImageBuffer(image);
+    // No answer from the cloud (offline, no credentials, server error)
+    if (!result.success && _localMode == LocalInferenceMode::Fallback) {
+        decideLocally(image, basename + ".jpg", result, latencyMs);
+    }
+
+    logDecisionTime(dual, decisionStartUs);
+
+    // Score the on-device model against the cloud's answer
+    if (_localMode == LocalInferenceMode::Shadow && result.success && !result.cached) {
+        compareWithCloud(image, result, latencyMs);
+    }
+
+    // Off the decision path: take the full frame in dual mode, keep it (or
+    // the decision frame) with the result embedded, and queue an archive
+    // upload for when the main loop is idle again
+    FrameLease archive;
+    if (dual) {
+        archive = captureArchive("captureAndDetect");
+        dual = (bool)archive;
+    }
+    InferenceMetadata metadata;
+    bool haveMetadata = makeMetadata(result, latencyMs, metadata);
+    if (_imageStorage) {
+        bool saved = _imageStorage->saveImage(basename, dual ? archive : image, haveMetadata ? &metadata : nullptr);
+        if (saved && dual && _archiveUpload && !result.cached) {
+            _pendingArchive = basename;
+        }
+    }
+
+    // Hand the frame buffers back to the camera driver
+    image.reset();
+    archive.reset();
 
     // Clean up old images
     if (_imageStorage) {
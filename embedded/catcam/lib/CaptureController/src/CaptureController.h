@@ -3,10 +3,22 @@
 #include <Arduino.h>
 #include <functional>
 #include "Camera.h"
+#include "FrameRing.h"
 #include "VideoRecorder.h"
 #include "LedController.h"
 #include "ImageStorage.h"
 #include "AWSAuth.h"
+#include "DcLumaMap.h"
+#include "SceneChangeDetector.h"
+#include "JpegCropper.h"
+#include "JpegTranscoder.h"
+#include "JpegQualityController.h"
+#include "JpegSharpness.h"
+#include "FrameQualityGate.h"
+#include "InferenceCache.h"
+#include "LocalClassifier.h"
+
+struct UploadTiming;
 
 /**
  * DetectionResult - Result from capture and inference
@@ -18,6 +30,29 @@ struct DetectionResult {
     float confidence = 0.0f;        // Confidence score (0.0 to 1.0)
     String filename;                // Filename of captured image
     String rawResponse;             // Raw JSON response from inference API
+    bool skippedUnchanged = false;  // Upload skipped - scene matched the background model
+    float sceneChange = -1.0f;      // Fraction of DC cells that changed (-1 = gate not run)
+    bool cached = false;            // Result reused from the inference cache - nothing was uploaded
+    bool local = false;             // Decided by the on-device model
+};
+
+/**
+ * How captureAndDetect() uses the on-device model (PipelineSettings::localInference)
+ */
+enum class LocalInferenceMode : int {
+    Off = 0,
+    Fallback = 1,   // Only when the cloud gives no answer
+    Primary = 2,    // Instead of the cloud; the cloud is used if the model cannot run
+    Shadow = 3      // Cloud decides; the model runs afterwards and is scored against it
+};
+
+/**
+ * How stills decide whether they need the flash (PipelineSettings::daylightCapture)
+ */
+enum class DaylightMode : int {
+    Off = 0,            // Always flash
+    LightSensor = 1,    // Try without flash when the light sensor reads bright
+    FrameLuma = 2       // Always try without flash first
 };
 
 /**
@@ -32,6 +67,7 @@ public:
     using CancelCheckCallback = std::function<bool()>;
     using LoopCallback = std::function<void()>;
     using FlashCallback = std::function<void(bool on)>;
+    using LightCallback = std::function<bool()>;
 
     /**
      * Constructor - takes pointers to required components
@@ -44,9 +80,10 @@ public:
      * Initialize the capture controller
      * Runs LED test sequence and initializes camera/video recorder
      * @param settings Camera settings for init (frame size, quality, buffers)
+     * @param pipeline Crop, burst, gate, cache and the other capture/upload settings
      * @return true if initialization successful
      */
-    bool init(const CameraSettings& settings = CameraSettings());
+    bool init(const CameraSettings& settings = CameraSettings(), const PipelineSettings& pipeline = PipelineSettings());
 
     /**
      * Check if the controller is initialized and ready
@@ -65,6 +102,12 @@ public:
      */
     void setFlashCallback(FlashCallback flashCallback);
 
+    /**
+     * Set ambient light callback (true = bright), read before each still
+     * when setDaylightCapture() uses the light sensor
+     */
+    void setLightCallback(LightCallback lightCallback) { _lightCallback = lightCallback; }
+
     /**
      * Configure AWS endpoint for photo uploads
      */
@@ -76,12 +119,219 @@ public:
      */
     String capturePhoto();
 
+    /**
+     * Set the pre-trigger frame ring (optional)
+     * When it holds a frame close to the trigger, captureAndDetect() uses that
+     * frame instead of waiting for the flash.
+     */
+    void setFrameRing(FrameRing* frameRing) { _frameRing = frameRing; }
+
     /**
      * Capture photo and run inference without LED countdown (for PIR-triggered detection)
      * Quick response path - captures photo, uploads to AWS, returns structured result
+     * @param claudeInfer Request parallel Claude vision inference
+     * @param triggerUs esp_timer time of the PIR edge (0 = unknown); used to pick
+     *                  a pre-trigger frame when the ring is running
      * @return DetectionResult with inference results
      */
-    DetectionResult captureAndDetect(bool claudeInfer = false);
+    DetectionResult captureAndDetect(bool claudeInfer = false, int64_t triggerUs = 0);
+
+    /**
+     * Configure the scene-change gate for captureAndDetect()
+     * When enabled, frames whose DC luma map differs from the rolling background
+     * in less than threshold of its cells are not uploaded for inference.
+     * @param enabled Gate on/off (off also forgets the background)
+     * @param threshold Fraction of changed cells (0-1) required to upload
+     */
+    void setChangeGate(bool enabled, float threshold);
+
+    /**
+     * Set the region of interest sent for inference (percent of the frame)
+     * The full frame is still saved to SD; only the upload is cropped,
+     * losslessly and snapped outward to 16-pixel MCU boundaries.
+     * 0,0 100x100 uploads the whole frame.
+     */
+    void setUploadCrop(int x, int y, int width, int height);
+
+    /**
+     * Choose the camera profiles used for stills and for recordVideo()
+     * The photo profile is switched in before each flash capture and left
+     * in place afterwards, so back-to-back captures pay for it once.
+     */
+    void setCameraProfiles(CameraProfile photo, CameraProfile video);
+
+    CameraProfile getVideoProfile() const { return _videoProfile; }
+
+    /**
+     * Configure burst capture for captureAndDetect()
+     * With frames > 1 the flash stays on while up to that many frames are
+     * grabbed back to back; each is scored for sharpness (AC energy) and only
+     * the sharpest is kept. Stops early when budgetMs runs out.
+     */
+    void setBurst(int frames, int budgetMs);
+
+    /**
+     * Dual-resolution detection captures
+     * When enabled, captureAndDetect() decides on a frame taken in the
+     * inference profile. Once the decision is made it switches to the photo
+     * profile and takes a full-resolution frame under the same light (flash
+     * again if the decision frame needed it). The full frame is saved and,
+     * with uploadArchive, queued for uploadPendingArchive().
+     */
+    void setDualCapture(bool enabled, bool uploadArchive);
+
+    /**
+     * Frame quality gate
+     * Flash captures are checked (SOI/EOI framing, DC decode, exposure from
+     * the DC luma histogram) before they are used. A failing frame is
+     * replaced by up to `recaptures` fresh ones under the same flash. If all
+     * fail, a badly exposed frame is still used; a truncated or corrupt one
+     * is not. Pre-trigger frames that fail fall back to a flash capture.
+     */
+    void setQualityGate(bool enabled, int recaptures);
+
+    /**
+     * Shrink inference and training uploads in the DCT domain
+     * After the crop, coefficients are requantised to the standard tables at
+     * this IJG quality (never finer than the sensor's) and re-encoded with
+     * Huffman tables built for the frame. The copy on SD is untouched.
+     * @param quality 1-100, 0 = upload the camera's bytes
+     */
+    void setUploadTranscode(int quality);
+
+    /**
+     * Write a copy of a recorded AVI for upload with every MJPEG frame
+     * transcoded as setUploadTranscode() does for stills. Chunk sizes, idx1
+     * and the RIFF/movi sizes are rewritten; the recording itself is untouched.
+     * @return true if uploadPath was written and is smaller; otherwise
+     *         upload the recording as-is (transcoding off, or nothing gained)
+     */
+    bool transcodeVideoForUpload(const String& sourcePath, const String& uploadPath);
+
+    /**
+     * Inference result cache for captureAndDetect()
+     * Each uploaded frame's answer is stored under a perceptual hash of the
+     * upload crop (from the DC luma map). A later frame within maxDistance
+     * bits, less than ttlSeconds after that answer, gets the same result
+     * without an upload. Frames are still saved to SD; no archive upload is
+     * queued for a hit.
+     * @param ttlSeconds 0 = off (also empties the cache)
+     */
+    void setInferenceCache(int ttlSeconds, int maxDistance);
+
+    /**
+     * On-device Boots/NotBoots model for captureAndDetect()
+     * Loads LocalClassifier::MODEL_PATH from SPIFFS on first use; Off frees
+     * it again. Shadow runs add the model's latency after the decision is
+     * logged, before captureAndDetect() returns.
+     * @param mode LocalInferenceMode (0-3)
+     */
+    void setLocalInference(int mode);
+
+    /**
+     * Skip the flash and its warm-up when the scene is already bright
+     * A still is first taken without the flash - always (FrameLuma), or only
+     * when the light callback reports bright (LightSensor) - and used if its
+     * mean luma reaches minLuma; otherwise the flash path runs as before.
+     * @param mode DaylightMode (0-2)
+     * @param minLuma 0-255
+     */
+    void setDaylightCapture(int mode, int minLuma);
+
+    /**
+     * Put the camera in standby after this long without a capture
+     * The pre-trigger ring is paused while the sensor sleeps. The next
+     * capture (PIR edge, command or button) brings it back through
+     * Camera::resume(), whose time to first valid frame is recorded.
+     * @param idleSeconds 0 = never
+     */
+    void setIdleStandby(int idleSeconds);
+
+    /**
+     * Hash uploads on the other core while the connection is set up
+     * Frames copied out of a single-buffer driver are hashed during the copy
+     * either way. Off hashes first and connects after, as before, so
+     * get_status can compare time to first byte for both.
+     */
+    void setUploadHashOverlap(bool enabled);
+
+    /**
+     * Enter standby once the camera has been idle long enough - call from the main loop
+     * @param allowed false while something else needs frames (e.g. camera
+     *                motion detection); a sleeping camera is woken
+     */
+    void updateStandby(bool allowed);
+
+    /**
+     * Resume the camera if it is in standby and restart the idle timer
+     * Every capture calls this; call it before using the Camera directly.
+     * @return true if the camera is ready to capture
+     */
+    bool wakeCamera();
+
+    /**
+     * Upload the last queued archive frame (?mode=archive), if any
+     * Call from the main loop when nothing time-critical is running.
+     * @return true if a frame was uploaded
+     */
+    bool uploadPendingArchive();
+
+    /**
+     * Configure the adaptive JPEG quality controller (camera jpegQuality,
+     * pipeline uploadTargetKB/uploadTargetMs) and push its quality to the
+     * sensor. Call after Camera::applySettings(), which may reset the quality.
+     */
+    void setQualityTarget(const CameraSettings& settings, const PipelineSettings& pipeline);
+
+    /**
+     * Flash-on to exposure start of the frame used by the last flash capture
+     */
+    uint32_t getLastSettleMs() const { return _lastSettleMs; }
+
+    /**
+     * Total wait saved by exposure settling vs always waiting ledDelayMillis
+     */
+    uint32_t getSettleSavedMs() const { return _settleSavedMs; }
+
+    /**
+     * Adaptive quality state and upload size/latency histograms
+     */
+    const JpegQualityStatus& getQualityStatus() const { return _quality.status(); }
+
+    /**
+     * Quality gate decisions, recaptures and cost
+     */
+    const FrameGateStatus& getFrameGateStatus() const { return _gateStatus; }
+
+    /**
+     * Upload transcoder byte savings and cost
+     */
+    const UploadTranscodeStatus& getTranscodeStatus() const { return _transcodeStatus; }
+
+    /**
+     * Inference cache hits, misses and server time saved
+     */
+    const InferenceCacheStatus& getInferenceCacheStatus() const { return _cacheStatus; }
+
+    /**
+     * On-device model runs, latency and agreement with the cloud
+     */
+    const LocalInferenceStatus& getLocalInferenceStatus() const { return _localStatus; }
+
+    /**
+     * Daylight vs flash captures and time-to-frame for each
+     */
+    const CapturePolicyStatus& getCapturePolicyStatus() const { return _policyStatus; }
+
+    /**
+     * Standby periods and resume-to-first-frame latency
+     */
+    const CameraStandbyStatus& getStandbyStatus() const { return _standbyStatus; }
+
+    /**
+     * Where upload hashes came from and time to first byte for each
+     */
+    const UploadHashStatus& getUploadHashStatus() const { return _uploadHashStatus; }
 
     /**
      * Record a video with LED countdown
@@ -124,6 +374,7 @@ private:
     LedController* _ledController;
     ImageStorage* _imageStorage;
     AWSAuth* _awsAuth;
+    FrameRing* _frameRing = nullptr;
 
     bool _initialized = false;
     bool _trainingMode = false;
@@ -132,14 +383,135 @@ private:
     CancelCheckCallback _cancelCheck = nullptr;
     LoopCallback _loopCallback = nullptr;
     FlashCallback _flashCallback = nullptr;
+    LightCallback _lightCallback = nullptr;
+
+    // Daylight capture (no flash, no warm-up) and time-to-frame per policy
+    DaylightMode _daylightMode = DaylightMode::Off;
+    int _daylightMinLuma = 70;
+    CapturePolicyStatus _policyStatus;
+
+    // Idle standby (0 = off); the ring stays paused while the sensor sleeps
+    unsigned long _idleStandbyMs = 0;
+    unsigned long _lastActivityMs = 0;
+    unsigned long _standbySinceMs = 0;
+    bool _ringPausedForStandby = false;
+    CameraStandbyStatus _standbyStatus;
+
+    // Upload payload hash overlapped with connecting
+    bool _uploadHashOverlap = true;
+    UploadHashStatus _uploadHashStatus;
 
     // AWS configuration
     const char* _roleAlias = nullptr;
     const char* _apiHost = nullptr;
     const char* _apiPath = nullptr;
 
+    // Extra time allowed beyond the LED warm-up for a fresh frame to arrive
+    static constexpr uint32_t FRESH_FRAME_TIMEOUT_MS = 1000;
+
+    // Exposure counts as settled when mean luma moves less than this between
+    // frames (levels, or fraction of the level, whichever is larger)
+    static constexpr float AE_SETTLE_TOLERANCE = 2.0f;
+    static constexpr float AE_SETTLE_FRACTION = 0.02f;
+    uint32_t _lastSettleMs = 0;
+    uint32_t _settleSavedMs = 0;
+
+    // Furthest a pre-trigger frame may be from the PIR edge to stand in for a capture
+    static constexpr int64_t PRE_TRIGGER_MAX_DISTANCE_US = 1000000;
+
+    // Scene-change gate (DC-coefficient luma map vs rolling background)
+    bool _changeGateEnabled = false;
+    float _changeGateThreshold = 0.02f;
+    int _consecutiveGateSkips = 0;
+    DcLumaMap _lumaMap;
+    int64_t _lumaMapFrameUs = 0;   // Timestamp of the frame _lumaMap was built from by the quality gate
+    SceneChangeDetector _sceneChange;
+
+    // Upload anyway after this many skipped triggers in a row, in case the
+    // background has absorbed something that is really there
+    static constexpr int CHANGE_GATE_MAX_CONSECUTIVE_SKIPS = 10;
+
+    // Upload crop (percent of the frame; whole frame = no crop)
+    int _cropX = 0;
+    int _cropY = 0;
+    int _cropWidth = 100;
+    int _cropHeight = 100;
+    JpegCropper _cropper;
+
+    CameraProfile _photoProfile = CameraProfile::Photo;
+    CameraProfile _videoProfile = CameraProfile::Video;
+    CameraProfile _uploadProfile = CameraProfile::Photo;  // Profile of the last still
+
+    // Dual-resolution capture; decision times are averaged per mode (0 = single, 1 = dual)
+    bool _dualCapture = false;
+    bool _archiveUpload = false;
+    bool _stillDaylight = false;  // The last still was taken without flash
+    String _pendingArchive;
+    uint32_t _decisionMs[2] = {};
+
+    // Frame quality gate
+    bool _qualityGateEnabled = false;
+    int _gateRecaptures = 2;
+    FrameQualityGate _qualityGate;
+    FrameGateStatus _gateStatus;
+    static constexpr int MAX_GATE_RECAPTURES = 3;
+
+    // Upload transcoder (0 = off)
+    int _transcodeQuality = 0;
+    JpegTranscoder _transcoder;
+    UploadTranscodeStatus _transcodeStatus;
+
+    // Inference result cache
+    InferenceCache _inferenceCache;
+    InferenceCacheStatus _cacheStatus;
+
+    // On-device classifier
+    LocalInferenceMode _localMode = LocalInferenceMode::Off;
+    LocalClassifier _localClassifier;
+    LocalInferenceStatus _localStatus;
+
+    // Burst capture (1 frame = off)
+    int _burstFrames = 1;
+    uint32_t _burstBudgetMs = 1000;
+    JpegSharpness _sharpness;
+    static constexpr int MAX_BURST_FRAMES = 5;
+
+    // Adaptive JPEG quality; histograms are logged every this many uploads
+    JpegQualityController _quality;
+    static constexpr unsigned long QUALITY_HISTOGRAM_LOG_INTERVAL = 10;
+
+    // Re-encoding can grow a block by a few bits when DC predictors change
+    static constexpr size_t CROP_HEADROOM_BYTES = 1024;
+
+    // New DQT/DHT segments can be a little longer than the sensor's
+    static constexpr size_t TRANSCODE_HEADROOM_BYTES = 2048;
+
     // Helper methods
+    FrameLease captureStill(const char* caller, bool burst = false, bool dual = false);
+    FrameLease captureArchive(const char* caller);
+    FrameLease captureDaylightFrame(const char* caller, CameraProfile profile);
+    void recordTimeToFrame(bool daylight, int64_t startUs);
+    FrameLease keepSharpest(FrameLease first);
+    FrameLease captureSettledFrame(const char* caller, int64_t flashOnUs, int ledDelayMillis);
+    bool meanLuma(const FrameLease& frame, float& luma);
+    FrameVerdict checkFrame(const FrameLease& frame, const char* caller);
+    FrameLease passQualityGate(FrameLease image, const char* caller);
+    bool isSceneUnchanged(const FrameLease& image, float& changeRatio);
+    bool hashFrame(const FrameLease& image, uint64_t& hash);
+    bool lookupCachedResult(uint64_t hash, const String& filename, DetectionResult& result);
+    bool runLocalClassifier(const FrameLease& image, LocalResult& local);
+    bool decideLocally(const FrameLease& image, const String& filename, DetectionResult& result, uint32_t& latencyMs);
+    void compareWithCloud(const FrameLease& image, const DetectionResult& cloud, uint32_t cloudMs);
+    FrameLease cropForUpload(const FrameLease& image);
+    FrameLease transcodeForUpload(const FrameLease& image);
+    void recordTranscode(size_t bytesIn, size_t bytesOut, unsigned long costUs);
+    String uploadImage(const FrameLease& image, bool trainingMode, bool claudeInfer);
+    void recordUploadTiming(const UploadTiming& timing);
+    void logQualityHistograms();
+    void logDecisionTime(bool dual, int64_t startUs);
+    static void freeUploadBuffer(void* context, void* handle);
     void runCountdown();
     void parseAndLogInferenceResponse(const String& response);
     DetectionResult parseInferenceResponse(const String& response, const String& filename);
+    bool makeMetadata(const DetectionResult& result, uint32_t latencyMs, InferenceMetadata& metadata);
 };
@@ -0,0 +1,80 @@
+#include "JpegQualityController.h"
+#include <math.h>
+
+static int histogramBucket(uint32_t value, uint32_t firstLimit) {
+    int bucket = 0;
+    uint32_t limit = firstLimit;
+    while (bucket < JpegQualityStatus::HISTOGRAM_BUCKETS - 1 && value >= limit) {
+        bucket++;
+        limit <<= 1;
+    }
+    return bucket;
+}
+
+void JpegQualityController::configure(const CameraSettings& settings, const PipelineSettings& pipeline) {
+    int targetKB = pipeline.uploadTargetKB > 0 ? pipeline.uploadTargetKB : 0;
+    int targetMs = pipeline.uploadTargetMs > 0 ? pipeline.uploadTargetMs : 0;
+
+    if (settings.jpegQuality != _baseQuality || targetKB != _targetKB || targetMs != _targetMs) {
+        _baseQuality = settings.jpegQuality;
+        _targetKB = targetKB;
+        _targetMs = targetMs;
+        _status.quality = settings.jpegQuality;
+    }
+
+    _status.active = _targetKB > 0 || _targetMs > 0;
+    if (!_status.active) {
+        _status.quality = settings.jpegQuality;
+    }
+    updateTarget();
+}
+
+bool JpegQualityController::onUpload(size_t bytes, uint32_t elapsedMs, bool succeeded) {
+    _status.lastBytes = bytes;
+    _status.lastUploadMs = elapsedMs;
+    _status.uploads++;
+    _status.sizeHistogram[histogramBucket((uint32_t)bytes, 32 * 1024)]++;
+    _status.latencyHistogram[histogramBucket(elapsedMs, 500)]++;
+
+    if (succeeded && elapsedMs > 0) {
+        uint32_t bps = (uint32_t)((uint64_t)bytes * 1000 / elapsedMs);
+        _status.throughputBps = _status.throughputBps ? (_status.throughputBps * 3 + bps) / 4 : bps;
+        updateTarget();
+    }
+
+    if (!_status.active || _status.targetBytes == 0 || bytes == 0) {
+        return false;
+    }
+
+    // Size falls roughly geometrically as the quality number rises
+    float error = log2f((float)bytes / (float)_status.targetBytes);
+    if (fabsf(error) < DEAD_BAND) {
+        return false;
+    }
+    int step = (int)lroundf(error * GAIN);
+    if (step == 0) {
+        step = error > 0 ? 1 : -1;
+    }
+    step = step > MAX_STEP ? MAX_STEP : (step < -MAX_STEP ? -MAX_STEP : step);
+
+    int quality = _status.quality + step;
+    quality = quality < QUALITY_BEST ? QUALITY_BEST : (quality > QUALITY_WORST ? QUALITY_WORST : quality);
+    if (quality == _status.quality) {
+        return false;
+    }
+    _status.quality = quality;
+    return true;
+}
+
+void JpegQualityController::updateTarget() {
+    if (_targetKB > 0) {
+        _status.targetBytes = (unsigned long)_targetKB * 1024;
+    } else if (_targetMs > 0 && _status.throughputBps > 0) {
+        uint64_t bytes = (uint64_t)_status.throughputBps * _targetMs / 1000;
+        if (bytes < MIN_DERIVED_BYTES) bytes = MIN_DERIVED_BYTES;
+        if (bytes > MAX_DERIVED_BYTES) bytes = MAX_DERIVED_BYTES;
+        _status.targetBytes = (unsigned long)bytes;
+    } else {
+        _status.targetBytes = 0;  // Nothing measured yet - hold the current quality
+    }
+}
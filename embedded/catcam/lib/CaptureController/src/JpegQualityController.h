@@ -0,0 +1,70 @@
+#ifndef CATCAM_JPEGQUALITYCONTROLLER_H
+#define CATCAM_JPEGQUALITYCONTROLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SystemState.h"
+
+/**
+ * JpegQualityController - Closed-loop JPEG quality for a per-upload byte budget
+ *
+ * Compressed size swings with lighting and scene detail, so a fixed
+ * jpegQuality gives wildly different upload times. After each uploaded frame
+ * the controller nudges the sensor quality (0-63, lower = better) in
+ * proportion to log2(size / budget), with a dead band so it settles.
+ *
+ * The budget is either fixed (uploadTargetKB) or derived from measured upload
+ * throughput (uploadTargetMs x bytes/s); a fixed budget wins if both are set.
+ * With neither set the controller is inactive and jpegQuality is used as-is.
+ *
+ * Size and latency histograms are kept either way.
+ */
+class JpegQualityController {
+public:
+    static constexpr int QUALITY_BEST = 4;    // Lower overflows the driver's JPEG buffer at UXGA
+    static constexpr int QUALITY_WORST = 40;  // Higher is too blocky for inference
+
+    /**
+     * (Re)configure from the camera's jpegQuality and the pipeline's upload
+     * targets; the quality restarts from jpegQuality only if it or the
+     * targets changed
+     */
+    void configure(const CameraSettings& settings, const PipelineSettings& pipeline);
+
+    bool isActive() const { return _status.active; }
+
+    /**
+     * Quality the sensor should be using
+     */
+    int quality() const { return _status.quality; }
+
+    /**
+     * Record an upload and adjust the quality for the next frame
+     * @param bytes Size of the uploaded JPEG
+     * @param elapsedMs Time the upload took
+     * @param succeeded False if the upload failed (size is still counted, throughput is not)
+     * @return true if the quality changed
+     */
+    bool onUpload(size_t bytes, uint32_t elapsedMs, bool succeeded);
+
+    const JpegQualityStatus& status() const { return _status; }
+
+private:
+    JpegQualityStatus _status;
+    int _baseQuality = -1;
+    int _targetKB = 0;
+    int _targetMs = 0;
+
+    // Quality steps per doubling of size over budget, and the dead band around it
+    static constexpr float GAIN = 6.0f;
+    static constexpr float DEAD_BAND = 0.15f;
+    static constexpr int MAX_STEP = 6;
+
+    // Limits on a budget derived from throughput
+    static constexpr uint32_t MIN_DERIVED_BYTES = 16 * 1024;
+    static constexpr uint32_t MAX_DERIVED_BYTES = 512 * 1024;
+
+    void updateTarget();
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "PipelineSettingsRegistry.h"
+#include <string.h>
+#include <type_traits>
+#include "../../SDLogger/src/SDLogger.h"
+
+namespace {
+
+const char* BLOB_KEY = "pipeSettings";
+
+static_assert(std::is_trivially_copyable<VisualMotionSettings>::value, "Stored in the blob as-is");
+
+// Command-set settings come first with a fixed layout; the table values are
+// stored by index and count lets an older blob (fewer settings) load with
+// defaults for the ones appended since
+struct PipelineSettingsBlob {
+    uint8_t version;
+    uint8_t count;
+    uint8_t changeGate;
+    uint8_t reserved;
+    float changeGateThreshold;
+    VisualMotionSettings visualMotion;  // Changing this struct needs PIPELINE_SETTINGS_BLOB_VERSION bumped
+    int32_t values[PIPELINE_SETTING_COUNT];
+};
+
+}
+
+int findPipelineSetting(const char* name) {
+    for (size_t i = 0; i < PIPELINE_SETTING_COUNT; i++) {
+        if (strcmp(PIPELINE_SETTINGS[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int getPipelineSetting(const PipelineSettings& settings, size_t index) {
+    const PipelineSettingDescriptor& d = PIPELINE_SETTINGS[index];
+    return d.isBool() ? (settings.*d.boolField ? 1 : 0) : settings.*d.intField;
+}
+
+int setPipelineSetting(PipelineSettings& settings, size_t index, int value) {
+    const PipelineSettingDescriptor& d = PIPELINE_SETTINGS[index];
+    value = value < d.minValue ? d.minValue : (value > d.maxValue ? d.maxValue : value);
+    if (d.isBool()) {
+        settings.*d.boolField = value != 0;
+    } else {
+        settings.*d.intField = value;
+    }
+    return value;
+}
+
+bool loadPipelineSettingsBlob(Preferences& prefs, PipelineSettings& settings) {
+    PipelineSettingsBlob blob;
+    size_t length = prefs.getBytesLength(BLOB_KEY);
+    if (length < offsetof(PipelineSettingsBlob, values) || length > sizeof(blob) ||
+        prefs.getBytes(BLOB_KEY, &blob, length) != length) {
+        return false;
+    }
+
+    size_t stored = (length - offsetof(PipelineSettingsBlob, values)) / sizeof(int32_t);
+    if (blob.version != PIPELINE_SETTINGS_BLOB_VERSION || blob.count != stored) {
+        SDLogger::getInstance().warnf("Pipeline settings blob v%d (%d values) not understood - using defaults",
+            blob.version, blob.count);
+        return false;
+    }
+
+    settings.changeGate = blob.changeGate != 0;
+    settings.changeGateThreshold = blob.changeGateThreshold;
+    settings.visualMotion = blob.visualMotion;
+    for (size_t i = 0; i < stored; i++) {
+        setPipelineSetting(settings, i, blob.values[i]);
+    }
+    return true;
+}
+
+bool savePipelineSettingsBlob(Preferences& prefs, const PipelineSettings& settings) {
+    PipelineSettingsBlob blob;
+    memset(&blob, 0, sizeof(blob));  // Padding included, so an unchanged blob is byte-identical
+    blob.version = PIPELINE_SETTINGS_BLOB_VERSION;
+    blob.count = (uint8_t)PIPELINE_SETTING_COUNT;
+    blob.changeGate = settings.changeGate ? 1 : 0;
+    blob.changeGateThreshold = settings.changeGateThreshold;
+    blob.visualMotion = settings.visualMotion;
+    for (size_t i = 0; i < PIPELINE_SETTING_COUNT; i++) {
+        blob.values[i] = getPipelineSetting(settings, i);
+    }
+    if (prefs.putBytes(BLOB_KEY, &blob, sizeof(blob)) != sizeof(blob)) {
+        SDLogger::getInstance().errorf("Failed to write pipeline settings blob to NVS");
+        return false;
+    }
+    return true;
+}
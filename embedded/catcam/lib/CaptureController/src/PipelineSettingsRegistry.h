@@ -0,0 +1,91 @@
+#ifndef CATCAM_PIPELINESETTINGSREGISTRY_H
+#define CATCAM_PIPELINESETTINGSREGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Preferences.h>
+
+#include "../../../include/SystemState.h"
+
+/**
+ * One PipelineSettings field settable with set_setting: wire name, storage and valid range
+ */
+struct PipelineSettingDescriptor {
+    const char* name;                      // set_setting "pipeline_<name>" / get_camera_settings "pipeline" key
+    int PipelineSettings::* intField;      // Exactly one of intField/boolField is set
+    bool PipelineSettings::* boolField;
+    int32_t minValue;
+    int32_t maxValue;
+
+    bool isBool() const { return boolField != nullptr; }
+};
+
+/**
+ * PIPELINE_SETTINGS - Capture and upload pipeline settings behind set_setting and get_camera_settings
+ *
+ * None of these touch the sensor, so they are kept apart from CAMERA_SETTINGS
+ * and its register dirty mask. The change gate and visual motion settings
+ * have their own commands and are not in the table, but are saved in the
+ * same blob. The blob stores table values by index, so new settings must be
+ * appended; reordering or removing entries needs
+ * PIPELINE_SETTINGS_BLOB_VERSION bumped.
+ */
+inline constexpr PipelineSettingDescriptor PIPELINE_SETTINGS[] = {
+    { "pre_trigger_frames", &PipelineSettings::preTriggerFrames, nullptr, 0, 16 },
+    { "pre_trigger_fps", &PipelineSettings::preTriggerFps, nullptr, 1, 10 },
+    { "pre_trigger_slot_kb", &PipelineSettings::preTriggerSlotKB, nullptr, 16, 1024 },
+    { "crop_x", &PipelineSettings::cropX, nullptr, 0, 99 },
+    { "crop_y", &PipelineSettings::cropY, nullptr, 0, 99 },
+    { "crop_width", &PipelineSettings::cropWidth, nullptr, 1, 100 },
+    { "crop_height", &PipelineSettings::cropHeight, nullptr, 1, 100 },
+    { "upload_target_kb", &PipelineSettings::uploadTargetKB, nullptr, 0, 1024 },
+    { "upload_target_ms", &PipelineSettings::uploadTargetMs, nullptr, 0, 30000 },
+    { "burst_frames", &PipelineSettings::burstFrames, nullptr, 1, 5 },
+    { "burst_budget_ms", &PipelineSettings::burstBudgetMs, nullptr, 100, 5000 },
+    { "dual_capture", nullptr, &PipelineSettings::dualCapture, 0, 1 },
+    { "archive_upload", nullptr, &PipelineSettings::archiveUpload, 0, 1 },
+    { "response_sidecar", nullptr, &PipelineSettings::responseSidecar, 0, 1 },
+    { "quality_gate", nullptr, &PipelineSettings::qualityGate, 0, 1 },
+    { "gate_recaptures", &PipelineSettings::gateRecaptures, nullptr, 0, 3 },
+    { "upload_transcode_quality", &PipelineSettings::uploadTranscodeQuality, nullptr, 0, 100 },
+    { "inference_cache_ttl_s", &PipelineSettings::inferenceCacheTtlS, nullptr, 0, 3600 },
+    { "inference_cache_distance", &PipelineSettings::inferenceCacheDistance, nullptr, 0, 32 },
+    { "daylight_capture", &PipelineSettings::daylightCapture, nullptr, 0, 2 },
+    { "daylight_min_luma", &PipelineSettings::daylightMinLuma, nullptr, 0, 255 },
+    { "local_inference", &PipelineSettings::localInference, nullptr, 0, 3 },
+    { "idle_standby_s", &PipelineSettings::idleStandbyS, nullptr, 0, 86400 },
+    { "upload_hash_overlap", nullptr, &PipelineSettings::uploadHashOverlap, 0, 1 },
+};
+
+constexpr size_t PIPELINE_SETTING_COUNT = sizeof(PIPELINE_SETTINGS) / sizeof(PIPELINE_SETTINGS[0]);
+
+constexpr uint8_t PIPELINE_SETTINGS_BLOB_VERSION = 1;
+
+/**
+ * Look a setting up by wire name
+ * @return Table index, or -1 if unknown
+ */
+int findPipelineSetting(const char* name);
+
+int getPipelineSetting(const PipelineSettings& settings, size_t index);
+
+/**
+ * Store a value, clamped to the setting's range
+ * @return The value actually stored
+ */
+int setPipelineSetting(PipelineSettings& settings, size_t index, int value);
+
+/**
+ * Read settings, change gate and visual motion included, from the NVS blob
+ * @param prefs Namespace already opened
+ * @return false if nothing usable was stored (settings keep their defaults)
+ */
+bool loadPipelineSettingsBlob(Preferences& prefs, PipelineSettings& settings);
+
+/**
+ * Write all pipeline settings as one versioned blob
+ * @param prefs Namespace already opened read-write
+ */
+bool savePipelineSettingsBlob(Preferences& prefs, const PipelineSettings& settings);
+
+#endif
@@ -1,8 +1,8 @@
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
 #include <esp32-hal-psram.h>
 #include "SDLogger.h"
-#include "NamedImage.h"
+#include "FrameLease.h"
+#include "ApiConnection.h"
+#include "PayloadHasher.h"
 #include "CatCamHttpClient.h"
 
 CatCamHttpClient::CatCamHttpClient()
@@ -10,8 +10,11 @@ CatCamHttpClient::CatCamHttpClient()
 
 }
 
-String CatCamHttpClient::postImage(NamedImage* namedImage, const char* host, const char* path, AWSAuth* awsAuth, bool trainingMode, bool claudeInfer) {
-    if (!namedImage || !namedImage->image || namedImage->size == 0) {
+String CatCamHttpClient::postImage(const FrameLease& frame, const char* host, const char* path, AWSAuth* awsAuth, UploadMode mode, bool claudeInfer,
+                                   bool overlapHash, UploadTiming* timing) {
+    unsigned long startMs = millis();
+
+    if (!frame) {
         SDLogger::getInstance().errorf("CatCamHttpClient: Invalid image data");
         return "{\"error\": \"Invalid image data\"}";
     }
@@ -21,153 +24,112 @@ String CatCamHttpClient::postImage(NamedImage* namedImage, const char* host, con
         return "{\"error\": \"Invalid AWS credentials\"}";
     }
 
-    size_t imageSize = namedImage->size;
+    size_t imageSize = frame.size();
 
     // Construct the actual path, appending query params as needed
     String actualPath = String(path);
-    if (trainingMode) {
+    if (mode == UploadMode::Training) {
         actualPath += "?mode=training";
+    } else if (mode == UploadMode::Archive) {
+        actualPath += "?mode=archive";
     } else if (claudeInfer) {
         actualPath += "?claude=1";
     }
 
     SDLogger::getInstance().infof("CatCamHttpClient: Posting image (%d bytes) to https://%s%s", imageSize, host, actualPath.c_str());
 
-    // Create SigV4 signed headers for the image POST
-    // For binary payloads, we calculate the actual SHA256 hash
+    // SigV4 needs the payload hash before signing. Unless the capture already
+    // hashed the frame, hash it on the other core while connecting.
     String contentType = "image/jpeg";
+    ApiConnection& connection = ApiConnection::getInstance();
+    UploadTiming timed;
+    String payloadHash;
+    if (frame.sha256()) {
+        payloadHash = awsAuth->bytesToHex(frame.sha256(), FrameLease::SHA256_SIZE);
+        timed.hashSource = PayloadHashSource::Capture;
+    } else {
+        PayloadHasher hasher;
+        uint8_t digest[PayloadHasher::DIGEST_SIZE];
+        if (overlapHash && hasher.start(frame.data(), imageSize)) {
+            connection.prepare(host);  // A failure here is retried, and reported, by request()
+            if (hasher.finish(digest, &timed.hashWaitMs)) {
+                payloadHash = awsAuth->bytesToHex(digest, sizeof(digest));
+                timed.hashSource = PayloadHashSource::Overlapped;
+            }
+        }
+        if (payloadHash.isEmpty()) {
+            unsigned long hashStartMs = millis();
+            payloadHash = awsAuth->sha256HashBinary(frame.data(), imageSize);
+            timed.hashSource = PayloadHashSource::Serial;
+            timed.hashWaitMs = millis() - hashStartMs;
+        }
+    }
 
     // Create the SigV4 headers with the actual binary payload hash
-    SigV4Headers headers = awsAuth->createSigV4HeadersForBinary("POST", actualPath.c_str(), host,
-        namedImage->image, imageSize,
-        contentType);
+    SigV4Headers headers = awsAuth->createSigV4HeadersForPayloadHash("POST", actualPath.c_str(), host,
+        payloadHash, contentType);
 
     if (!headers.isValid) {
         SDLogger::getInstance().errorf("CatCamHttpClient: Failed to create SigV4 headers");
         return "{\"error\": \"Failed to create SigV4 headers\"}";
     }
 
-    WiFiClientSecure client;
-    client.setInsecure();  // For testing - in production, set proper CA cert
-    client.setTimeout(TIMEOUT_MS / 1000);
-
-    // Connect to server
-    SDLogger::getInstance().debugf("CatCamHttpClient: Connecting to %s:443", host);
-    if (!client.connect(host, 443)) {
-        SDLogger::getInstance().errorf("CatCamHttpClient: Connection failed");
-        return "{\"error\": \"Connection failed\"}";
-    }
-    SDLogger::getInstance().debugf("CatCamHttpClient: Connected");
-
-    // Send HTTP request manually to handle binary payload with SigV4
-    client.print("POST ");
-    client.print(actualPath);
-    client.println(" HTTP/1.1");
-    client.print("Host: ");
-    client.println(host);
-    client.println("Connection: close");
-    client.print("Content-Type: ");
-    client.println(contentType);
-    client.print("Content-Length: ");
-    client.println(imageSize);
-    client.print("X-Amz-Date: ");
-    client.println(headers.date);
-    client.print("X-Amz-Security-Token: ");
-    client.println(headers.securityToken);
-    client.print("Authorization: ");
-    client.println(headers.authorization);
+    // Request line and headers; ApiConnection adds Connection: keep-alive
+    String head = "POST " + actualPath + " HTTP/1.1\r\n";
+    head += "Host: " + String(host) + "\r\n";
+    head += "Content-Type: " + contentType + "\r\n";
+    head += "Content-Length: " + String(imageSize) + "\r\n";
+    head += "X-Amz-Date: " + headers.date + "\r\n";
+    head += "X-Amz-Security-Token: " + headers.securityToken + "\r\n";
+    head += "Authorization: " + headers.authorization + "\r\n";
     // Include the actual payload hash (required for API Gateway)
-    client.print("X-Amz-Content-Sha256: ");
-    client.println(headers.payloadHash);
-    client.println();
-
-    // Send image data in chunks
-    size_t bytesRemaining = imageSize;
-    uint8_t* dataPtr = namedImage->image;
-    size_t chunkSize = 1024;
-
-    SDLogger::getInstance().debugf("CatCamHttpClient: Sending %d bytes", imageSize);
-
-    while (bytesRemaining > 0) {
-        size_t chunk = (bytesRemaining < chunkSize) ? bytesRemaining : chunkSize;
-        size_t bytesWritten = client.write(dataPtr, chunk);
-
-        if (bytesWritten != chunk) {
-            SDLogger::getInstance().errorf("CatCamHttpClient: Error writing data (wrote %d of %d)", bytesWritten, chunk);
-            client.stop();
-            return "{\"error\": \"Error writing image data\"}";
-        }
-
-        dataPtr += bytesWritten;
-        bytesRemaining -= bytesWritten;
-        yield(); // Prevent WDT reset
-    }
+    head += "X-Amz-Content-Sha256: " + headers.payloadHash + "\r\n";
 
-    SDLogger::getInstance().debugf("CatCamHttpClient: Data sent, waiting for response");
+    // Send image data in chunks (again from the start if a stale connection is retried)
+    auto writeImage = [&](Client& client) -> bool {
+        size_t bytesRemaining = imageSize;
+        const uint8_t* dataPtr = frame.data();
+        size_t chunkSize = 1024;
 
-    // Read response with timeout
-    unsigned long timeout = millis();
-    while (client.connected() && !client.available()) {
-        if (millis() - timeout > TIMEOUT_MS) {
-            SDLogger::getInstance().errorf("CatCamHttpClient: Response timeout");
-            client.stop();
-            return "{\"error\": \"Response timeout\"}";
-        }
-        delay(10);
-    }
+        SDLogger::getInstance().debugf("CatCamHttpClient: Sending %d bytes", imageSize);
 
-    // Read HTTP status line
-    String statusLine = client.readStringUntil('\n');
-    SDLogger::getInstance().infof("CatCamHttpClient: %s", statusLine.c_str());
+        while (bytesRemaining > 0) {
+            size_t chunk = (bytesRemaining < chunkSize) ? bytesRemaining : chunkSize;
+            size_t bytesWritten = client.write(dataPtr, chunk);
 
-    // Extract status code
-    int statusCode = 0;
-    int spaceIndex = statusLine.indexOf(' ');
-    if (spaceIndex > 0) {
-        statusCode = statusLine.substring(spaceIndex + 1, spaceIndex + 4).toInt();
-    }
+            if (bytesWritten != chunk) {
+                SDLogger::getInstance().errorf("CatCamHttpClient: Error writing data (wrote %d of %d)", bytesWritten, chunk);
+                return false;
+            }
 
-    // Read response headers and get Content-Length
-    int contentLength = 0;
-    while (client.available()) {
-        String line = client.readStringUntil('\n');
-        line.trim();
-        if (line.length() == 0) {
-            break;
-        }
-        if (line.startsWith("Content-Length:")) {
-            contentLength = line.substring(15).toInt();
+            dataPtr += bytesWritten;
+            bytesRemaining -= bytesWritten;
+            yield(); // Prevent WDT reset
         }
-        SDLogger::getInstance().tracef("CatCamHttpClient: Header: %s", line.c_str());
+        return true;
+    };
+
+    ApiResponse reply;
+    bool answered = connection.request(host, head, writeImage, TIMEOUT_MS, reply);
+    if (reply.sentAtMs) {
+        timed.sent = true;
+        timed.firstByteMs = reply.sentAtMs - startMs;
     }
-
-    // Read response body - wait for data if needed
-    String response = "";
-    SDLogger::getInstance().tracef("CatCamHttpClient: Reading body, Content-Length: %d", contentLength);
-
-    if (contentLength > 0) {
-        response.reserve(contentLength + 1);
-        unsigned long bodyTimeout = millis();
-        while ((int)response.length() < contentLength && (millis() - bodyTimeout) < 5000) {
-            while (client.available() && (int)response.length() < contentLength) {
-                char c = client.read();
-                response += c;
-            }
-            if ((int)response.length() < contentLength) {
-                delay(10);
-            }
-        }
-        SDLogger::getInstance().tracef("CatCamHttpClient: Read %d bytes of body", response.length());
+    if (timing) {
+        *timing = timed;
     }
-    else {
-        // Fallback: read whatever is available
-        delay(100); // Give time for data to arrive
-        while (client.available()) {
-            response += (char)client.read();
-        }
+    if (!answered) {
+        SDLogger::getInstance().errorf("CatCamHttpClient: %s", connection.error());
+        return "{\"error\": \"" + String(connection.error()) + "\"}";
     }
-
-    client.stop();
+    SDLogger::getInstance().infof("CatCamHttpClient: %s connection, %lu ms to connect, first byte after %lu ms (hash %s, waited %lu ms)",
+        reply.reused ? "Warm" : "New", (unsigned long)reply.connectMs, (unsigned long)timed.firstByteMs,
+        timed.hashSource == PayloadHashSource::Capture ? "from capture" :
+        timed.hashSource == PayloadHashSource::Overlapped ? "overlapped" : "serial",
+        (unsigned long)timed.hashWaitMs);
+
+    int statusCode = reply.statusCode;
+    String& response = reply.body;
 
     SDLogger::getInstance().infof("CatCamHttpClient: Response code: %d", statusCode);
     // Log response body at INFO level for debugging auth failures
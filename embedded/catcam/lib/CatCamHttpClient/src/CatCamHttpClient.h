@@ -5,7 +5,29 @@
 #include <WiFiClientSecure.h>
 #include <Arduino.h>
 #include "AWSAuth.h"
-#include "NamedImage.h"
+#include "FrameLease.h"
+
+// What the infer Lambda should do with an upload
+enum class UploadMode : uint8_t {
+    Inference,  // Classify and store (default)
+    Training,   // ?mode=training - store for labelling, no inference
+    Archive     // ?mode=archive - full-resolution copy of an already classified capture
+};
+
+// Where an upload's SigV4 payload hash came from
+enum class PayloadHashSource : uint8_t {
+    Capture,     // Hashed while the frame was copied out of the driver
+    Overlapped,  // Hashed on the other core while connecting
+    Serial       // Hashed before connecting
+};
+
+// How long an upload took to get going
+struct UploadTiming {
+    PayloadHashSource hashSource = PayloadHashSource::Serial;
+    uint32_t hashWaitMs = 0;   // Spent waiting for (or computing) the hash
+    uint32_t firstByteMs = 0;  // postImage() call to the request's first byte on the wire
+    bool sent = false;
+};
 
 class CatCamHttpClient
 {
@@ -13,8 +35,13 @@ public:
     CatCamHttpClient();
 
     // Post an image to the specified URL with SigV4 authentication
-    // If trainingMode is true, appends ?mode=training to the path
-    String postImage(NamedImage* namedImage, const char* host, const char* path, AWSAuth* awsAuth, bool trainingMode = false, bool claudeInfer = false);
+    // The payload is streamed straight from the leased frame buffer
+    // Non-inference modes append ?mode=training / ?mode=archive to the path
+    // Without a hash from the capture, overlapHash hashes on the other core while
+    // connecting (false = hash, then connect); timing reports how that went
+    String postImage(const FrameLease& frame, const char* host, const char* path, AWSAuth* awsAuth,
+                     UploadMode mode = UploadMode::Inference, bool claudeInfer = false,
+                     bool overlapHash = true, UploadTiming* timing = nullptr);
 
     std::function<void(int, int)> sendUpdate;
 
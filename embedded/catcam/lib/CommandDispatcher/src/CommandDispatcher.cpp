@@ -1,11 +1,17 @@
 #include "CommandDispatcher.h"
 #include "SystemState.h"
 #include "SDLogger.h"
+#include "SlabAllocator.h"
+#include "CameraSettingsRegistry.h"
+#include "PipelineSettingsRegistry.h"
+#include "CameraProfiles.h"
+#include <esp_heap_caps.h>
 #include "../../../include/version.h"
 
 // Commands that require chunking - only work via BLE
 const char* CommandDispatcher::CHUNKED_COMMANDS[] = {
     "get_image",
+    "get_thumbnail",
     "get_logs",
     "request_logs",
     "list_images",
@@ -19,6 +25,7 @@ CommandDispatcher::CommandDispatcher()
     , _photoCaptureCallback(nullptr)
     , _trainingModeCallback(nullptr)
     , _cameraSettingCallback(nullptr)
+    , _pipelineSettingCallback(nullptr)
     , _rebootCallback(nullptr)
 {
     // Register built-in handlers
@@ -119,7 +126,7 @@ bool CommandDispatcher::handleGetStatus(CommandContext& ctx) {
         return false;
     }
 
-    DynamicJsonDocument response(1024);
+    DynamicJsonDocument response(3072);
     unsigned long uptime = millis() - _systemState->systemStartTime;
 
     response["type"] = "status";
@@ -142,6 +149,105 @@ bool CommandDispatcher::handleGetStatus(CommandContext& ctx) {
     stats["boots_detections"] = _systemState->bootsDetections;
     stats["atomizer_activations"] = _systemState->atomizerActivations;
     stats["false_positives_avoided"] = _systemState->falsePositivesAvoided;
+    stats["uploads_skipped_unchanged"] = _systemState->uploadsSkippedUnchanged;
+    stats["motion_triggers"] = _systemState->motionTriggerCount;
+    stats["visual_triggers"] = _systemState->visualTriggerCount;
+    stats["visual_motion_cost_us"] = _systemState->visualMotionCostUs;
+    stats["visual_motion_interval_ms"] = _systemState->visualMotionIntervalMs;
+    stats["exposure_settle_ms"] = _systemState->exposureSettleMs;
+    stats["exposure_settle_saved_ms"] = _systemState->exposureSettleSavedMs;
+
+    const FrameGateStatus& gate = _systemState->frameGate;
+    JsonObject gateStats = stats.createNestedObject("quality_gate");
+    gateStats["checked"] = gate.checked;
+    gateStats["ok"] = gate.verdicts[0];
+    gateStats["truncated"] = gate.verdicts[1];
+    gateStats["corrupt"] = gate.verdicts[2];
+    gateStats["dark"] = gate.verdicts[3];
+    gateStats["blown_out"] = gate.verdicts[4];
+    gateStats["recaptures"] = gate.recaptures;
+    gateStats["recovered"] = gate.recovered;
+    gateStats["gave_up"] = gate.gaveUp;
+    gateStats["mean_cost_us"] = gate.meanCostUs;
+    gateStats["max_cost_us"] = gate.maxCostUs;
+
+    const UploadTranscodeStatus& transcode = _systemState->uploadTranscode;
+    JsonObject transcodeStats = stats.createNestedObject("upload_transcode");
+    transcodeStats["frames"] = transcode.frames;
+    transcodeStats["failures"] = transcode.failures;
+    transcodeStats["bytes_in"] = transcode.bytesIn;
+    transcodeStats["bytes_out"] = transcode.bytesOut;
+    transcodeStats["mean_cost_us"] = transcode.meanCostUs;
+    transcodeStats["max_cost_us"] = transcode.maxCostUs;
+
+    const InferenceCacheStatus& cache = _systemState->inferenceCache;
+    JsonObject cacheStats = stats.createNestedObject("inference_cache");
+    cacheStats["hits"] = cache.hits;
+    cacheStats["misses"] = cache.misses;
+    cacheStats["entries"] = cache.entries;
+    cacheStats["latency_saved_ms"] = cache.latencySavedMs;
+    cacheStats["last_distance"] = cache.lastDistance;
+
+    const CapturePolicyStatus& policy = _systemState->capturePolicy;
+    JsonObject policyStats = stats.createNestedObject("capture_policy");
+    policyStats["daylight_frames"] = policy.daylightFrames;
+    policyStats["flash_frames"] = policy.flashFrames;
+    policyStats["daylight_rejected"] = policy.daylightRejected;
+    policyStats["mean_daylight_ms"] = policy.meanDaylightMs;
+    policyStats["mean_flash_ms"] = policy.meanFlashMs;
+    policyStats["last_luma"] = policy.lastLuma;
+    policyStats["light_sensor_bright"] = policy.lightSensorBright;
+
+    const LocalInferenceStatus& local = _systemState->localInference;
+    JsonObject localStats = stats.createNestedObject("local_inference");
+    localStats["mode"] = local.mode;
+    localStats["model_loaded"] = local.modelLoaded;
+    localStats["runs"] = local.runs;
+    localStats["decisions"] = local.decisions;
+    localStats["mean_latency_ms"] = local.meanLatencyMs;
+    localStats["max_latency_ms"] = local.maxLatencyMs;
+    localStats["compared"] = local.compared;
+    localStats["agreed"] = local.agreed;
+    localStats["boots_missed"] = local.bootsMissed;
+    localStats["boots_false"] = local.bootsFalse;
+    localStats["mean_cloud_ms"] = local.meanCloudMs;
+
+    const CameraStandbyStatus& standby = _systemState->cameraStandby;
+    JsonObject standbyStats = stats.createNestedObject("camera_standby");
+    standbyStats["asleep"] = standby.asleep;
+    standbyStats["standbys"] = standby.standbys;
+    standbyStats["fast_resumes"] = standby.fastResumes;
+    standbyStats["full_resumes"] = standby.fullResumes;
+    standbyStats["last_resume_ms"] = standby.lastResumeMs;
+    standbyStats["mean_resume_ms"] = standby.meanResumeMs;
+    standbyStats["max_resume_ms"] = standby.maxResumeMs;
+    standbyStats["asleep_seconds"] = standby.asleepSeconds;
+
+    const ApiConnectionStatus& api = _systemState->apiConnection;
+    JsonObject apiStats = stats.createNestedObject("api_connection");
+    apiStats["requests"] = api.requests;
+    apiStats["handshakes"] = api.handshakes;
+    apiStats["resumed_handshakes"] = api.resumedHandshakes;
+    apiStats["reused"] = api.reused;
+    apiStats["stale_retries"] = api.staleRetries;
+    apiStats["memory_closes"] = api.memoryCloses;
+    apiStats["dns_lookups"] = api.dnsLookups;
+    apiStats["dns_cache_hits"] = api.dnsCacheHits;
+    apiStats["last_connect_ms"] = api.lastConnectMs;
+    apiStats["mean_connect_ms"] = api.meanConnectMs;
+    apiStats["mean_handshake_ms"] = api.meanHandshakeMs;
+    apiStats["warm"] = api.warm;
+
+    const UploadHashStatus& hash = _systemState->uploadHash;
+    JsonObject hashStats = stats.createNestedObject("upload_hash");
+    hashStats["from_capture"] = hash.fromCapture;
+    hashStats["overlapped"] = hash.overlapped;
+    hashStats["serial"] = hash.serial;
+    hashStats["last_hash_wait_ms"] = hash.lastHashWaitMs;
+    hashStats["last_first_byte_ms"] = hash.lastFirstByteMs;
+    hashStats["mean_first_byte_capture_ms"] = hash.meanFirstByteCaptureMs;
+    hashStats["mean_first_byte_overlap_ms"] = hash.meanFirstByteOverlapMs;
+    hashStats["mean_first_byte_serial_ms"] = hash.meanFirstByteSerialMs;
 
     JsonObject peripherals = response.createNestedObject("peripherals");
     peripherals["pir_active"] = _systemState->pirActive;
@@ -149,6 +255,25 @@ bool CommandDispatcher::handleGetStatus(CommandContext& ctx) {
     peripherals["led_strip_on"] = _systemState->ledStripOn;
     peripherals["spray_on"] = _systemState->sprayOn;
 
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    JsonObject memory = response.createNestedObject("memory");
+    memory["free_heap"] = ESP.getFreeHeap();
+    memory["free_psram"] = ESP.getFreePsram();
+    memory["largest_psram_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    memory["slab_reserved"] = slab.reservedBytes();
+    memory["slab_failures"] = slab.failureCount();
+    memory["slab_bad_releases"] = slab.badReleaseCount();
+    JsonArray slabClasses = memory.createNestedArray("slab_classes");
+    for (size_t i = 0; i < slab.classCount(); i++) {
+        SlabAllocator::ClassStats cls = slab.classStats(i);
+        JsonObject entry = slabClasses.createNestedObject();
+        entry["block_size"] = cls.blockSize;
+        entry["blocks"] = cls.blockCount;
+        entry["in_use"] = cls.inUse;
+        entry["peak"] = cls.peakInUse;
+        entry["allocations"] = cls.allocations;
+    }
+
     String responseStr;
     serializeJson(response, responseStr);
     ctx.sender->sendResponse(responseStr);
@@ -163,12 +288,26 @@ bool CommandDispatcher::handleGetSettings(CommandContext& ctx) {
         return false;
     }
 
-    DynamicJsonDocument response(256);
+    DynamicJsonDocument response(768);
     response["type"] = "settings";
     response["training_mode"] = _systemState->trainingMode;
     response["trigger_threshold"] = _systemState->triggerThresh;
     response["dry_run"] = _systemState->dryRun;
     response["claude_infer"] = _systemState->claudeInfer;
+    response["change_gate"] = _systemState->pipelineSettings.changeGate;
+    response["change_threshold"] = _systemState->pipelineSettings.changeGateThreshold;
+
+    const VisualMotionSettings& vm = _systemState->pipelineSettings.visualMotion;
+    JsonObject visual = response.createNestedObject("visual_motion");
+    visual["enabled"] = vm.enabled;
+    visual["fps"] = vm.fps;
+    visual["roi_x"] = vm.roiX;
+    visual["roi_y"] = vm.roiY;
+    visual["roi_width"] = vm.roiWidth;
+    visual["roi_height"] = vm.roiHeight;
+    visual["block_delta"] = vm.blockDelta;
+    visual["min_blocks"] = vm.minBlocks;
+    visual["max_cpu_percent"] = vm.maxCpuPercent;
 
     String responseStr;
     serializeJson(response, responseStr);
@@ -178,42 +317,78 @@ bool CommandDispatcher::handleGetSettings(CommandContext& ctx) {
     return true;
 }
 
+// get_camera_settings: one slot per member or element. Every key and string
+// value is a static const char*, so nothing is copied into the document.
+static constexpr size_t CAMERA_SETTINGS_JSON_SIZE =
+    JSON_OBJECT_SIZE(5) +                                        // type, camera, pipeline, profiles, quality_control
+    JSON_OBJECT_SIZE(CAMERA_SETTING_COUNT) +
+    JSON_OBJECT_SIZE(PIPELINE_SETTING_COUNT) +
+    JSON_OBJECT_SIZE(2) +                                        // current, switch_ms
+    JSON_OBJECT_SIZE(CAMERA_PROFILE_COUNT * CAMERA_PROFILE_COUNT) +
+    JSON_OBJECT_SIZE(9) +                                        // quality_control members
+    2 * JSON_ARRAY_SIZE(JpegQualityStatus::HISTOGRAM_BUCKETS);
+
 bool CommandDispatcher::handleGetCameraSettings(CommandContext& ctx) {
     if (!_systemState) {
         sendError(ctx.sender, "System state not available");
         return false;
     }
 
-    DynamicJsonDocument response(768);
+    DynamicJsonDocument response(CAMERA_SETTINGS_JSON_SIZE);
     response["type"] = "camera_settings";
 
     JsonObject cam = response.createNestedObject("camera");
-    cam["frame_size"] = _systemState->cameraSettings.frameSize;
-    cam["jpeg_quality"] = _systemState->cameraSettings.jpegQuality;
-    cam["fb_count"] = _systemState->cameraSettings.fbCount;
-    cam["brightness"] = _systemState->cameraSettings.brightness;
-    cam["contrast"] = _systemState->cameraSettings.contrast;
-    cam["saturation"] = _systemState->cameraSettings.saturation;
-    cam["special_effect"] = _systemState->cameraSettings.specialEffect;
-    cam["white_balance"] = _systemState->cameraSettings.whiteBalance;
-    cam["awb_gain"] = _systemState->cameraSettings.awbGain;
-    cam["wb_mode"] = _systemState->cameraSettings.wbMode;
-    cam["exposure_ctrl"] = _systemState->cameraSettings.exposureCtrl;
-    cam["aec2"] = _systemState->cameraSettings.aec2;
-    cam["ae_level"] = _systemState->cameraSettings.aeLevel;
-    cam["aec_value"] = _systemState->cameraSettings.aecValue;
-    cam["gain_ctrl"] = _systemState->cameraSettings.gainCtrl;
-    cam["agc_gain"] = _systemState->cameraSettings.agcGain;
-    cam["gain_ceiling"] = _systemState->cameraSettings.gainCeiling;
-    cam["bpc"] = _systemState->cameraSettings.bpc;
-    cam["wpc"] = _systemState->cameraSettings.wpc;
-    cam["raw_gma"] = _systemState->cameraSettings.rawGma;
-    cam["lenc"] = _systemState->cameraSettings.lenc;
-    cam["hmirror"] = _systemState->cameraSettings.hmirror;
-    cam["vflip"] = _systemState->cameraSettings.vflip;
-    cam["dcw"] = _systemState->cameraSettings.dcw;
-    cam["colorbar"] = _systemState->cameraSettings.colorbar;
-    cam["led_delay_millis"] = _systemState->cameraSettings.ledDelayMillis;
+    for (size_t i = 0; i < CAMERA_SETTING_COUNT; i++) {
+        const CameraSettingDescriptor& d = CAMERA_SETTINGS[i];
+        if (d.isBool()) {
+            cam[d.name] = getCameraSetting(_systemState->cameraSettings, i) != 0;
+        } else {
+            cam[d.name] = getCameraSetting(_systemState->cameraSettings, i);
+        }
+    }
+
+    JsonObject pipeline = response.createNestedObject("pipeline");
+    for (size_t i = 0; i < PIPELINE_SETTING_COUNT; i++) {
+        const PipelineSettingDescriptor& d = PIPELINE_SETTINGS[i];
+        if (d.isBool()) {
+            pipeline[d.name] = getPipelineSetting(_systemState->pipelineSettings, i) != 0;
+        } else {
+            pipeline[d.name] = getPipelineSetting(_systemState->pipelineSettings, i);
+        }
+    }
+
+    JsonObject profiles = response.createNestedObject("profiles");
+    profiles["current"] = cameraProfileName((CameraProfile)_systemState->cameraProfile);
+    JsonObject switchMs = profiles.createNestedObject("switch_ms");
+    for (size_t from = 0; from < CAMERA_PROFILE_COUNT; from++) {
+        for (size_t to = 0; to < CAMERA_PROFILE_COUNT; to++) {
+            if (_systemState->profileSwitchMs[from][to]) {
+                switchMs[CAMERA_PROFILE_SWITCH_NAMES[from][to]] = _systemState->profileSwitchMs[from][to];
+            }
+        }
+    }
+
+    const JpegQualityStatus& qc = _systemState->jpegQualityControl;
+    JsonObject quality = response.createNestedObject("quality_control");
+    quality["active"] = qc.active;
+    quality["quality"] = qc.quality;
+    quality["target_bytes"] = qc.targetBytes;
+    quality["throughput_bps"] = qc.throughputBps;
+    quality["last_bytes"] = qc.lastBytes;
+    quality["last_upload_ms"] = qc.lastUploadMs;
+    quality["uploads"] = qc.uploads;
+    JsonArray sizes = quality.createNestedArray("size_histogram");
+    JsonArray latency = quality.createNestedArray("latency_histogram");
+    for (int i = 0; i < JpegQualityStatus::HISTOGRAM_BUCKETS; i++) {
+        sizes.add(qc.sizeHistogram[i]);
+        latency.add(qc.latencyHistogram[i]);
+    }
+
+    if (response.overflowed()) {
+        SDLogger::getInstance().errorf("Camera settings response overflowed %u bytes", (unsigned)CAMERA_SETTINGS_JSON_SIZE);
+        sendError(ctx.sender, "Camera settings response too large");
+        return false;
+    }
 
     String responseStr;
     serializeJson(response, responseStr);
@@ -259,48 +434,27 @@ bool CommandDispatcher::handleSetSetting(CommandContext& ctx) {
         String camSetting = setting.substring(7);  // Strip "camera_"
         int intValue = ctx.request["value"] | 0;
         bool boolValue = ctx.request["value"] | false;
-        bool handled = true;
-
-        if (camSetting == "frame_size") { _systemState->cameraSettings.frameSize = intValue; }
-        else if (camSetting == "jpeg_quality") { _systemState->cameraSettings.jpegQuality = intValue; }
-        else if (camSetting == "fb_count") { _systemState->cameraSettings.fbCount = intValue; }
-        else if (camSetting == "brightness") { _systemState->cameraSettings.brightness = intValue; }
-        else if (camSetting == "contrast") { _systemState->cameraSettings.contrast = intValue; }
-        else if (camSetting == "saturation") { _systemState->cameraSettings.saturation = intValue; }
-        else if (camSetting == "special_effect") { _systemState->cameraSettings.specialEffect = intValue; }
-        else if (camSetting == "white_balance") { _systemState->cameraSettings.whiteBalance = boolValue; }
-        else if (camSetting == "awb_gain") { _systemState->cameraSettings.awbGain = boolValue; }
-        else if (camSetting == "wb_mode") { _systemState->cameraSettings.wbMode = intValue; }
-        else if (camSetting == "exposure_ctrl") { _systemState->cameraSettings.exposureCtrl = boolValue; }
-        else if (camSetting == "aec2") { _systemState->cameraSettings.aec2 = boolValue; }
-        else if (camSetting == "ae_level") { _systemState->cameraSettings.aeLevel = intValue; }
-        else if (camSetting == "aec_value") { _systemState->cameraSettings.aecValue = intValue; }
-        else if (camSetting == "gain_ctrl") { _systemState->cameraSettings.gainCtrl = boolValue; }
-        else if (camSetting == "agc_gain") { _systemState->cameraSettings.agcGain = intValue; }
-        else if (camSetting == "gain_ceiling") { _systemState->cameraSettings.gainCeiling = intValue; }
-        else if (camSetting == "bpc") { _systemState->cameraSettings.bpc = boolValue; }
-        else if (camSetting == "wpc") { _systemState->cameraSettings.wpc = boolValue; }
-        else if (camSetting == "raw_gma") { _systemState->cameraSettings.rawGma = boolValue; }
-        else if (camSetting == "lenc") { _systemState->cameraSettings.lenc = boolValue; }
-        else if (camSetting == "hmirror") { _systemState->cameraSettings.hmirror = boolValue; }
-        else if (camSetting == "vflip") { _systemState->cameraSettings.vflip = boolValue; }
-        else if (camSetting == "dcw") { _systemState->cameraSettings.dcw = boolValue; }
-        else if (camSetting == "colorbar") { _systemState->cameraSettings.colorbar = boolValue; }
-        else if (camSetting == "led_delay_millis") { _systemState->cameraSettings.ledDelayMillis = intValue; }
-        else { handled = false; }
-
-        if (handled) {
-            SDLogger::getInstance().infof("Camera setting %s updated via %s",
-                                           camSetting.c_str(), ctx.sender->getName());
+        int index = findCameraSetting(camSetting.c_str());
+
+        if (index >= 0) {
+            // Bools arrive as JSON true/false, everything else as a number; out-of-range values are clamped
+            bool isBool = CAMERA_SETTINGS[index].isBool();
+            int stored = setCameraSetting(_systemState->cameraSettings, index, isBool ? ((boolValue || intValue != 0) ? 1 : 0) : intValue);
+            SDLogger::getInstance().infof("Camera setting %s updated to %d via %s",
+                                           camSetting.c_str(), stored, ctx.sender->getName());
 
             if (_cameraSettingCallback) {
-                _cameraSettingCallback(camSetting, intValue);
+                _cameraSettingCallback(camSetting, stored);
             }
 
             DynamicJsonDocument response(256);
             response["type"] = "setting_updated";
             response["setting"] = setting;
-            response["value"] = ctx.request["value"];
+            if (isBool) {
+                response["value"] = stored != 0;
+            } else {
+                response["value"] = stored;
+            }
             String responseStr;
             serializeJson(response, responseStr);
             ctx.sender->sendResponse(responseStr);
@@ -311,6 +465,40 @@ bool CommandDispatcher::handleSetSetting(CommandContext& ctx) {
         return false;
     }
 
+    if (setting.startsWith("pipeline_")) {
+        String pipeSetting = setting.substring(9);  // Strip "pipeline_"
+        int intValue = ctx.request["value"] | 0;
+        bool boolValue = ctx.request["value"] | false;
+        int index = findPipelineSetting(pipeSetting.c_str());
+
+        if (index >= 0) {
+            bool isBool = PIPELINE_SETTINGS[index].isBool();
+            int stored = setPipelineSetting(_systemState->pipelineSettings, index, isBool ? ((boolValue || intValue != 0) ? 1 : 0) : intValue);
+            SDLogger::getInstance().infof("Pipeline setting %s updated to %d via %s",
+                                           pipeSetting.c_str(), stored, ctx.sender->getName());
+
+            if (_pipelineSettingCallback) {
+                _pipelineSettingCallback(pipeSetting, stored);
+            }
+
+            DynamicJsonDocument response(256);
+            response["type"] = "setting_updated";
+            response["setting"] = setting;
+            if (isBool) {
+                response["value"] = stored != 0;
+            } else {
+                response["value"] = stored;
+            }
+            String responseStr;
+            serializeJson(response, responseStr);
+            ctx.sender->sendResponse(responseStr);
+            return true;
+        }
+
+        sendError(ctx.sender, "Unknown pipeline setting: " + pipeSetting);
+        return false;
+    }
+
     sendError(ctx.sender, "Unknown setting: " + setting);
     return false;
 }
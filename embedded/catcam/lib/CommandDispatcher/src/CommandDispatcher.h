@@ -56,6 +56,7 @@ using CommandHandler = std::function<bool(CommandContext& ctx)>;
 using PhotoCaptureCallback = std::function<String()>;  // Returns new filename
 using TrainingModeCallback = std::function<void(bool)>;
 using CameraSettingCallback = std::function<void(const String&, int)>;
+using PipelineSettingCallback = std::function<void(const String&, int)>;
 using RebootCallback = std::function<void()>;
 
 /**
@@ -80,6 +81,7 @@ public:
     void setPhotoCaptureCallback(PhotoCaptureCallback cb) { _photoCaptureCallback = cb; }
     void setTrainingModeCallback(TrainingModeCallback cb) { _trainingModeCallback = cb; }
     void setCameraSettingCallback(CameraSettingCallback cb) { _cameraSettingCallback = cb; }
+    void setPipelineSettingCallback(PipelineSettingCallback cb) { _pipelineSettingCallback = cb; }
     void setRebootCallback(RebootCallback cb) { _rebootCallback = cb; }
 
     /**
@@ -109,6 +111,7 @@ private:
     PhotoCaptureCallback _photoCaptureCallback;
     TrainingModeCallback _trainingModeCallback;
     CameraSettingCallback _cameraSettingCallback;
+    PipelineSettingCallback _pipelineSettingCallback;
     RebootCallback _rebootCallback;
 
     // Commands that require chunking (BLE-only)
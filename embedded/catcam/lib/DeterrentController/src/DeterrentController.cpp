@@ -4,8 +4,9 @@
 #include "AWSAuth.h"
 #include "SystemState.h"
 #include <SDLogger.h>
+#include <SlabAllocator.h>
 #include <SD_MMC.h>
-#include <WiFiClientSecure.h>
+#include "ApiConnection.h"
 
 DeterrentController::DeterrentController(PCF8574Manager* pcfManager, CaptureController* captureController, AWSAuth* awsAuth)
     : _pcfManager(pcfManager)
@@ -70,11 +71,11 @@ void DeterrentController::activate(SystemState& state, bool dryRun) {
             totalDurationSec, VIDEO_FPS);
 
         VideoConfig config = VideoRecorder::getDefaultConfig();
-        config.frameSize = FRAMESIZE_VGA;
-        config.quality = 12;
+        config.profile = _videoProfile;
         config.fps = VIDEO_FPS;
         config.durationSeconds = totalDurationSec;
         config.outputDir = "/videos";
+        config.includePreRoll = true;  // Show the approach captured before the PIR trigger
 
         PCF8574Manager* pcf = _pcfManager;
         bool atomiserFired = false;
@@ -176,6 +177,25 @@ bool DeterrentController::uploadVideo(const String& filepath) {
         return false;
     }
 
+    // Extract just the filename from the path (e.g., "/videos/video_xxx.avi" -> "video_xxx.avi")
+    String filename = filepath;
+    int lastSlash = filepath.lastIndexOf('/');
+    if (lastSlash >= 0) {
+        filename = filepath.substring(lastSlash + 1);
+    }
+
+    // Upload a requantised copy when upload transcoding is on; the recording on SD stays as it is
+    String transcodedPath = filepath.substring(0, filepath.length() - 4) + ".upload.avi";
+    bool transcoded = _captureController && _captureController->transcodeVideoForUpload(filepath, transcodedPath);
+    bool uploaded = sendVideo(transcoded ? transcodedPath : filepath, filename);
+    if (transcoded) {
+        SD_MMC.remove(transcodedPath.c_str());
+    }
+    return uploaded;
+}
+
+bool DeterrentController::sendVideo(const String& filepath, const String& filename) {
+
     // Pause MQTT to free SSL memory before making HTTPS request
     _awsAuth->pauseMqtt();
 
@@ -200,141 +220,112 @@ bool DeterrentController::uploadVideo(const String& filepath) {
     size_t fileSize = videoFile.size();
     SDLogger::getInstance().infof("DeterrentController: Uploading video %s (%d bytes)", filepath.c_str(), fileSize);
 
-    // Extract just the filename from the path (e.g., "/videos/video_xxx.avi" -> "video_xxx.avi")
-    String filename = filepath;
-    int lastSlash = filepath.lastIndexOf('/');
-    if (lastSlash >= 0) {
-        filename = filepath.substring(lastSlash + 1);
-    }
-
     // Build the API path: /upload-video/{filename}
     String apiPath = "/upload-video/" + filename;
 
-    // Create SigV4 headers for the PUT request
-    // We need to read the file to compute the hash, then reset to beginning
-    // For large files, we'll use a chunked approach, but for now read all
-    uint8_t* videoBuffer = (uint8_t*)ps_malloc(fileSize);
-    if (!videoBuffer) {
-        SDLogger::getInstance().errorf("DeterrentController: Failed to allocate %d bytes for video upload", fileSize);
+    // Stream the file through one fixed chunk instead of holding the whole AVI in PSRAM:
+    // one pass to hash the payload for SigV4, a second pass to send it
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    size_t chunkSize = UPLOAD_CHUNK_BYTES;
+    uint8_t* chunkBuffer = (uint8_t*)slab.allocate(chunkSize);
+    if (!chunkBuffer) {
+        chunkSize = UPLOAD_FALLBACK_CHUNK_BYTES;
+        chunkBuffer = (uint8_t*)malloc(chunkSize);
+    }
+    if (!chunkBuffer) {
+        SDLogger::getInstance().errorf("DeterrentController: Failed to allocate %d byte upload buffer", chunkSize);
         videoFile.close();
         _awsAuth->resumeMqtt();
         return false;
     }
 
-    size_t bytesRead = videoFile.read(videoBuffer, fileSize);
-    videoFile.close();
-
-    if (bytesRead != fileSize) {
-        SDLogger::getInstance().errorf("DeterrentController: Failed to read video file (read %d of %d bytes)",
-            bytesRead, fileSize);
-        free(videoBuffer);
+    auto releaseBuffer = [&]() {
+        if (slab.owns(chunkBuffer)) {
+            slab.release(chunkBuffer);
+        } else {
+            free(chunkBuffer);
+        }
+        chunkBuffer = nullptr;
+    };
+
+    size_t bytesHashed = 0;
+    String payloadHash = _awsAuth->sha256HashStream([&](uint8_t* buffer, size_t maxLen) -> size_t {
+        size_t n = videoFile.read(buffer, maxLen);
+        bytesHashed += n;
+        return n;
+    }, chunkBuffer, chunkSize);
+
+    if (payloadHash.isEmpty() || bytesHashed != fileSize || !videoFile.seek(0)) {
+        SDLogger::getInstance().errorf("DeterrentController: Failed to hash video file (read %d of %d bytes)",
+            bytesHashed, fileSize);
+        releaseBuffer();
+        videoFile.close();
         _awsAuth->resumeMqtt();
         return false;
     }
 
     // Create SigV4 headers for PUT request with binary payload
     String contentType = "video/x-msvideo";
-    SigV4Headers headers = _awsAuth->createSigV4HeadersForBinary("PUT", apiPath, _apiHost,
-        videoBuffer, fileSize, contentType);
+    SigV4Headers headers = _awsAuth->createSigV4HeadersForPayloadHash("PUT", apiPath, _apiHost,
+        payloadHash, contentType);
 
     if (!headers.isValid) {
         SDLogger::getInstance().errorf("DeterrentController: Failed to create SigV4 headers");
-        free(videoBuffer);
-        _awsAuth->resumeMqtt();
-        return false;
-    }
-
-    // Connect to API Gateway
-    WiFiClientSecure client;
-    client.setInsecure();  // For testing - in production, set proper CA cert
-    client.setTimeout(60);  // 60 second timeout for large uploads
-
-    SDLogger::getInstance().debugf("DeterrentController: Connecting to %s:443", _apiHost);
-    if (!client.connect(_apiHost, 443)) {
-        SDLogger::getInstance().errorf("DeterrentController: Connection to API failed");
-        free(videoBuffer);
+        releaseBuffer();
+        videoFile.close();
         _awsAuth->resumeMqtt();
         return false;
     }
 
-    // Send HTTP PUT request
-    client.print("PUT ");
-    client.print(apiPath);
-    client.println(" HTTP/1.1");
-    client.print("Host: ");
-    client.println(_apiHost);
-    client.println("Connection: close");
-    client.print("Content-Type: ");
-    client.println(contentType);
-    client.print("Content-Length: ");
-    client.println(fileSize);
-    client.print("X-Amz-Date: ");
-    client.println(headers.date);
-    client.print("X-Amz-Security-Token: ");
-    client.println(headers.securityToken);
-    client.print("Authorization: ");
-    client.println(headers.authorization);
-    client.print("X-Amz-Content-Sha256: ");
-    client.println(headers.payloadHash);
-    client.println();
-
-    // Send video data in chunks
-    size_t bytesRemaining = fileSize;
-    uint8_t* dataPtr = videoBuffer;
-    size_t chunkSize = 4096;  // Larger chunks for video
-
-    SDLogger::getInstance().debugf("DeterrentController: Sending %d bytes", fileSize);
-
-    while (bytesRemaining > 0) {
-        size_t chunk = (bytesRemaining < chunkSize) ? bytesRemaining : chunkSize;
-        size_t bytesWritten = client.write(dataPtr, chunk);
-
-        if (bytesWritten != chunk) {
-            SDLogger::getInstance().errorf("DeterrentController: Error writing data (wrote %d of %d)",
-                bytesWritten, chunk);
-            free(videoBuffer);
-            client.stop();
-            _awsAuth->resumeMqtt();
+    // Request line and headers; ApiConnection adds Connection: keep-alive
+    String head = "PUT " + apiPath + " HTTP/1.1\r\n";
+    head += "Host: " + String(_apiHost) + "\r\n";
+    head += "Content-Type: " + contentType + "\r\n";
+    head += "Content-Length: " + String(fileSize) + "\r\n";
+    head += "X-Amz-Date: " + headers.date + "\r\n";
+    head += "X-Amz-Security-Token: " + headers.securityToken + "\r\n";
+    head += "Authorization: " + headers.authorization + "\r\n";
+    head += "X-Amz-Content-Sha256: " + headers.payloadHash + "\r\n";
+
+    // Send video data in chunks straight from the SD card (from the start
+    // again if a stale connection is retried)
+    auto writeVideo = [&](Client& client) -> bool {
+        if (!videoFile.seek(0)) {
             return false;
         }
+        size_t bytesRemaining = fileSize;
 
-        dataPtr += bytesWritten;
-        bytesRemaining -= bytesWritten;
-        yield();  // Prevent WDT reset
-    }
+        SDLogger::getInstance().debugf("DeterrentController: Sending %d bytes in %d byte chunks", fileSize, chunkSize);
 
-    free(videoBuffer);
+        while (bytesRemaining > 0) {
+            size_t chunk = (bytesRemaining < chunkSize) ? bytesRemaining : chunkSize;
+            size_t bytesRead = videoFile.read(chunkBuffer, chunk);
+            size_t bytesWritten = bytesRead == chunk ? client.write(chunkBuffer, chunk) : 0;
 
-    SDLogger::getInstance().debugf("DeterrentController: Data sent, waiting for response");
+            if (bytesWritten != chunk) {
+                SDLogger::getInstance().errorf("DeterrentController: Error sending data (read %d, wrote %d of %d)",
+                    bytesRead, bytesWritten, chunk);
+                return false;
+            }
 
-    // Read response with timeout
-    unsigned long timeout = millis();
-    while (client.connected() && !client.available()) {
-        if (millis() - timeout > 30000) {
-            SDLogger::getInstance().errorf("DeterrentController: Response timeout");
-            client.stop();
-            _awsAuth->resumeMqtt();
-            return false;
+            bytesRemaining -= bytesWritten;
+            yield();  // Prevent WDT reset
         }
-        delay(10);
-    }
-
-    // Read HTTP status line
-    String statusLine = client.readStringUntil('\n');
-    SDLogger::getInstance().infof("DeterrentController: %s", statusLine.c_str());
-
-    // Extract status code
-    int statusCode = 0;
-    int spaceIndex = statusLine.indexOf(' ');
-    if (spaceIndex > 0) {
-        statusCode = statusLine.substring(spaceIndex + 1, spaceIndex + 4).toInt();
-    }
+        return true;
+    };
 
-    // Read and discard remaining response
-    while (client.available()) {
-        client.read();
+    // 60 second timeout for large uploads; the response body is not needed
+    ApiConnection& connection = ApiConnection::getInstance();
+    ApiResponse reply;
+    bool answered = connection.request(_apiHost, head, writeVideo, VIDEO_UPLOAD_TIMEOUT_MS, reply, false);
+    releaseBuffer();
+    videoFile.close();
+    if (!answered) {
+        SDLogger::getInstance().errorf("DeterrentController: Video upload failed (%s)", connection.error());
+        _awsAuth->resumeMqtt();
+        return false;
     }
-    client.stop();
+    int statusCode = reply.statusCode;
 
     _awsAuth->resumeMqtt();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include "CameraProfiles.h"
 
 // Forward declarations
 class PCF8574Manager;
@@ -24,6 +25,9 @@ public:
     static constexpr unsigned long PRE_SPRAY_DELAY_MS = 1000;     // LEDs+video before atomizer fires
     static constexpr int VIDEO_FPS = 10;
     static constexpr int BOOTS_INDEX = 0;  // Boots is index 0 in binary model output [0]=Boots, [1]=NotBoots
+    static constexpr size_t UPLOAD_CHUNK_BYTES = 16 * 1024;        // Slab block streamed from SD per write
+    static constexpr size_t UPLOAD_FALLBACK_CHUNK_BYTES = 4096;    // Heap chunk if the slab is exhausted
+    static constexpr uint32_t VIDEO_UPLOAD_TIMEOUT_MS = 60000;     // Response wait after the upload
 
     /**
      * Constructor
@@ -39,6 +43,11 @@ public:
      */
     void setUploadConfig(const char* apiHost);
 
+    /**
+     * Camera profile for the deterrent recording (default: Video)
+     */
+    void setVideoProfile(CameraProfile profile) { _videoProfile = profile; }
+
     /**
      * Check if deterrent should be activated based on detection result
      * @param result Detection result from captureAndDetect()
@@ -82,10 +91,17 @@ private:
     // Upload configuration
     const char* _apiHost = nullptr;
 
+    CameraProfile _videoProfile = CameraProfile::Video;
+
     /**
      * Upload a video file to the cloud
      * @param filepath Full path to the video file on SD card
      * @return true if upload succeeded
      */
     bool uploadVideo(const String& filepath);
+
+    /**
+     * Stream one AVI from the SD card to /upload-video/{filename}
+     */
+    bool sendVideo(const String& filepath, const String& filename);
 };
@@ -1,29 +1,51 @@
 #include "ImageStorage.h"
 #include <SDLogger.h>
+#include <esp_timer.h>
 #include <time.h>
 #include <vector>
 #include <algorithm>
+#include "JpegScaledDecoder.h"
+#include "JpegEncoder.h"
 
 bool ImageStorage::init(const char* imagesDir, int maxImages) {
     _imagesDir = imagesDir;
     _maxImages = maxImages;
 
-    // Create directory if it doesn't exist
-    if (!SD_MMC.exists(_imagesDir)) {
-        if (SD_MMC.mkdir(_imagesDir)) {
-            SDLogger::getInstance().infof("Created images directory: %s", _imagesDir);
-        } else {
-            SDLogger::getInstance().errorf("Failed to create images directory: %s", _imagesDir);
-            return false;
+    // Create directories if they don't exist
+    if (!ensureDir(_imagesDir)) {
+        return false;
+    }
+    bool thumbnails = ensureDir(String(_imagesDir) + "/" + THUMBNAIL_DIR) &&
+                      ensureDir(String(_imagesDir) + "/" + PREVIEW_DIR);
+
+    if (thumbnails && !_thumbnailTask) {
+        _thumbnailQueue = xQueueCreate(THUMBNAIL_QUEUE_SIZE, sizeof(ThumbnailJob));
+        if (_thumbnailQueue && xTaskCreate(thumbnailTask, "Thumbnails", THUMBNAIL_TASK_STACK_SIZE, this,
+                                           THUMBNAIL_TASK_PRIORITY, &_thumbnailTask) != pdPASS) {
+            _thumbnailTask = nullptr;
+        }
+        if (!_thumbnailTask) {
+            SDLogger::getInstance().warnf("Failed to start thumbnail task, images will have no thumbnails");
         }
-    } else {
-        SDLogger::getInstance().debugf("Images directory exists: %s", _imagesDir);
     }
 
     _initialized = true;
     return true;
 }
 
+bool ImageStorage::ensureDir(const String& path) {
+    if (SD_MMC.exists(path.c_str())) {
+        SDLogger::getInstance().debugf("Images directory exists: %s", path.c_str());
+        return true;
+    }
+    if (SD_MMC.mkdir(path.c_str())) {
+        SDLogger::getInstance().infof("Created images directory: %s", path.c_str());
+        return true;
+    }
+    SDLogger::getInstance().errorf("Failed to create images directory: %s", path.c_str());
+    return false;
+}
+
 String ImageStorage::generateFilename() {
     struct timeval tv;
     gettimeofday(&tv, NULL);
@@ -45,12 +67,20 @@ String ImageStorage::generateFilename() {
     return String(timestamp);
 }
 
-bool ImageStorage::saveImage(const String& basename, NamedImage* image) {
-    if (!image || !image->image || image->size == 0) {
+bool ImageStorage::saveImage(const String& basename, const FrameLease& frame, const InferenceMetadata* metadata) {
+    if (!frame) {
         SDLogger::getInstance().errorf("Invalid image data");
         return false;
     }
 
+    // The metadata segment is spliced in while writing, so the frame is not copied
+    uint8_t segment[JPEG_METADATA_MAX_SEGMENT + 4];
+    size_t segmentLen = metadata ? buildJpegMetadataSegment(*metadata, segment, sizeof(segment)) : 0;
+    size_t split = segmentLen ? jpegMetadataInsertOffset(frame.data(), frame.size()) : 0;
+    if (split == 0) {
+        segmentLen = 0;
+    }
+
     String filepath = String(_imagesDir) + "/" + basename + ".jpg";
     File file = SD_MMC.open(filepath.c_str(), FILE_WRITE);
     if (!file) {
@@ -58,19 +88,163 @@ bool ImageStorage::saveImage(const String& basename, NamedImage* image) {
         return false;
     }
 
-    size_t written = file.write(image->image, image->size);
+    size_t written = file.write(frame.data(), split);
+    written += file.write(segment, segmentLen);
+    written += file.write(frame.data() + split, frame.size() - split);
     file.close();
 
-    if (written != image->size) {
-        SDLogger::getInstance().errorf("Failed to write complete image: %d of %d bytes", written, image->size);
+    size_t expected = frame.size() + segmentLen;
+    if (written != expected) {
+        SDLogger::getInstance().errorf("Failed to write complete image: %d of %d bytes", written, expected);
         return false;
     }
 
-    SDLogger::getInstance().infof("Saved image: %s (%d bytes)", filepath.c_str(), image->size);
+    SDLogger::getInstance().infof("Saved image: %s (%d bytes%s)", filepath.c_str(), expected,
+        segmentLen ? ", with inference metadata" : "");
+    queueThumbnails(basename);
     return true;
 }
 
+void ImageStorage::queueThumbnails(const String& basename) {
+    if (!_thumbnailQueue) {
+        return;
+    }
+    ThumbnailJob job;
+    strlcpy(job.basename, basename.c_str(), sizeof(job.basename));
+    if (xQueueSend(_thumbnailQueue, &job, 0) != pdTRUE) {
+        SDLogger::getInstance().warnf("Thumbnail queue full, skipping thumbnails for %s", basename.c_str());
+    }
+}
+
+void ImageStorage::thumbnailTask(void* parameter) {
+    ImageStorage* storage = static_cast<ImageStorage*>(parameter);
+    ThumbnailJob job;
+
+    while (true) {
+        if (xQueueReceive(storage->_thumbnailQueue, &job, portMAX_DELAY) == pdTRUE) {
+            storage->generateThumbnails(String(job.basename));
+        }
+    }
+}
+
+bool ImageStorage::generateThumbnails(const String& basename) {
+    // Decoder tables and encoder state are a few KB each - keep them off the task stack
+    if (!_decoder) {
+        _decoder = new JpegScaledDecoder();
+        _encoder = new JpegEncoder();
+    }
+
+    FrameLease image = loadImage(basename);
+    if (!image) {
+        return false;  // Already cleaned up, or unreadable (logged by loadImage)
+    }
+
+    int64_t startUs = esp_timer_get_time();
+    bool ok = writeScaled(image, THUMBNAIL_SCALE, THUMBNAIL_DIR, basename) &&
+              writeScaled(image, PREVIEW_SCALE, PREVIEW_DIR, basename);
+    _decoder->release();
+
+    if (ok) {
+        SDLogger::getInstance().infof("Thumbnails for %s made in %lu ms", basename.c_str(),
+            (unsigned long)((esp_timer_get_time() - startUs) / 1000));
+    }
+    return ok;
+}
+
+bool ImageStorage::writeScaled(const FrameLease& image, uint8_t scale, const char* subdir, const String& basename) {
+    int64_t startUs = esp_timer_get_time();
+    if (!_decoder->decode(image.data(), image.size(), scale)) {
+        SDLogger::getInstance().warnf("Thumbnail decode failed for %s: %s", basename.c_str(), _decoder->error());
+        return false;
+    }
+    int64_t decodedUs = esp_timer_get_time();
+
+    // Comfortably above what the standard tables produce at this quality
+    int components = _decoder->componentCount();
+    size_t capacity = (size_t)_decoder->width() * _decoder->height() * components / 2 + 1024;
+    uint8_t* out = (uint8_t*)(psramFound() ? ps_malloc(capacity) : malloc(capacity));
+    if (!out) {
+        SDLogger::getInstance().errorf("Failed to allocate %d bytes for thumbnail", capacity);
+        return false;
+    }
+    const uint8_t* planes[3] = {_decoder->plane(0), _decoder->plane(1), _decoder->plane(2)};
+    size_t size = _encoder->encode(planes, components, _decoder->width(), _decoder->height(),
+                                   THUMBNAIL_QUALITY, out, capacity);
+    int64_t encodedUs = esp_timer_get_time();
+
+    bool ok = false;
+    String filepath = String(_imagesDir) + "/" + subdir + "/" + basename + ".jpg";
+    if (size == 0) {
+        SDLogger::getInstance().warnf("Thumbnail encode overflowed %d bytes for %s", capacity, basename.c_str());
+    } else {
+        File file = SD_MMC.open(filepath.c_str(), FILE_WRITE);
+        if (file) {
+            ok = file.write(out, size) == size;
+            file.close();
+        }
+        if (!ok) {
+            SDLogger::getInstance().errorf("Failed to write thumbnail: %s", filepath.c_str());
+        }
+    }
+    free(out);
+
+    if (ok) {
+        SDLogger::getInstance().debugf("Thumbnail 1/%d %dx%d: %d bytes, decode %lu ms, encode %lu ms",
+            scale, _decoder->width(), _decoder->height(), size,
+            (unsigned long)((decodedUs - startUs) / 1000), (unsigned long)((encodedUs - decodedUs) / 1000));
+    }
+    return ok;
+}
+
+FrameLease ImageStorage::loadImage(const String& basename) {
+    String filepath = String(_imagesDir) + "/" + basename + ".jpg";
+    File file = SD_MMC.open(filepath.c_str(), FILE_READ);
+    if (!file) {
+        SDLogger::getInstance().errorf("Failed to open file for reading: %s", filepath.c_str());
+        return FrameLease();
+    }
+
+    size_t size = file.size();
+    uint8_t* data = (uint8_t*)(psramFound() ? ps_malloc(size) : malloc(size));
+    if (!data) {
+        SDLogger::getInstance().errorf("Failed to allocate %d bytes to read %s", size, filepath.c_str());
+        file.close();
+        return FrameLease();
+    }
+
+    size_t read = file.read(data, size);
+    file.close();
+    if (read != size) {
+        SDLogger::getInstance().errorf("Failed to read complete image: %d of %d bytes", read, size);
+        free(data);
+        return FrameLease();
+    }
+    return FrameLease(data, size, 0, data, &ImageStorage::freeLoadedImage, this, true);
+}
+
+void ImageStorage::freeLoadedImage(void* context, void* handle) {
+    free(handle);
+}
+
+bool ImageStorage::readMetadata(const String& basename, InferenceMetadata& metadata) {
+    String filepath = String(_imagesDir) + "/" + basename + ".jpg";
+    File file = SD_MMC.open(filepath.c_str(), FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    // The segment follows SOI/APP0, so the first few hundred bytes hold it
+    uint8_t header[512];
+    size_t read = file.read(header, sizeof(header));
+    file.close();
+    return readJpegMetadata(header, read, metadata);
+}
+
 bool ImageStorage::saveResponse(const String& basename, const String& response) {
+    if (!_responseSidecar) {
+        return true;
+    }
+
     String filepath = String(_imagesDir) + "/" + basename + ".txt";
     File file = SD_MMC.open(filepath.c_str(), FILE_WRITE);
     if (!file) {
@@ -102,8 +276,10 @@ void ImageStorage::cleanupOldImages() {
         return;
     }
 
-    // Collect all .jpg files in the images directory
+    // Collect all .jpg files in the images directory, and the .txt sidecars
+    // so deleting doesn't need an exists() lookup per image
     std::vector<String> imageFiles;
+    std::vector<String> sidecarFiles;
 
     File dir = SD_MMC.open(_imagesDir);
     if (!dir || !dir.isDirectory()) {
@@ -116,6 +292,8 @@ void ImageStorage::cleanupOldImages() {
         String name = entry.name();
         if (name.endsWith(".jpg")) {
             imageFiles.push_back(name);
+        } else if (name.endsWith(".txt")) {
+            sidecarFiles.push_back(name);
         }
         entry.close();
     }
@@ -130,6 +308,7 @@ void ImageStorage::cleanupOldImages() {
 
     // Sort alphabetically (timestamp format ensures chronological order)
     std::sort(imageFiles.begin(), imageFiles.end());
+    std::sort(sidecarFiles.begin(), sidecarFiles.end());
 
     // Delete the oldest files (those at the beginning of the sorted list)
     int filesToDelete = imageFiles.size() - _maxImages;
@@ -137,7 +316,7 @@ void ImageStorage::cleanupOldImages() {
 
     for (int i = 0; i < filesToDelete; i++) {
         String jpgPath = String(_imagesDir) + "/" + imageFiles[i];
-        String txtPath = jpgPath.substring(0, jpgPath.length() - 4) + ".txt";
+        String txtName = imageFiles[i].substring(0, imageFiles[i].length() - 4) + ".txt";
 
         if (SD_MMC.remove(jpgPath.c_str())) {
             SDLogger::getInstance().debugf("Deleted: %s", jpgPath.c_str());
@@ -145,12 +324,25 @@ void ImageStorage::cleanupOldImages() {
             SDLogger::getInstance().warnf("Failed to delete: %s", jpgPath.c_str());
         }
 
-        if (SD_MMC.exists(txtPath.c_str())) {
+        if (std::binary_search(sidecarFiles.begin(), sidecarFiles.end(), txtName)) {
+            String txtPath = String(_imagesDir) + "/" + txtName;
             if (SD_MMC.remove(txtPath.c_str())) {
                 SDLogger::getInstance().debugf("Deleted: %s", txtPath.c_str());
             } else {
                 SDLogger::getInstance().warnf("Failed to delete: %s", txtPath.c_str());
             }
         }
+        removeIfExists(String(_imagesDir) + "/" + THUMBNAIL_DIR + "/" + imageFiles[i]);
+        removeIfExists(String(_imagesDir) + "/" + PREVIEW_DIR + "/" + imageFiles[i]);
+    }
+}
+
+void ImageStorage::removeIfExists(const String& path) {
+    if (SD_MMC.exists(path.c_str())) {
+        if (SD_MMC.remove(path.c_str())) {
+            SDLogger::getInstance().debugf("Deleted: %s", path.c_str());
+        } else {
+            SDLogger::getInstance().warnf("Failed to delete: %s", path.c_str());
+        }
     }
 }
@@ -2,13 +2,29 @@
 
 #include <Arduino.h>
 #include <SD_MMC.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 #include "Camera.h"
+#include "JpegMetadata.h"
+
+class JpegScaledDecoder;
+class JpegEncoder;
 
 /**
  * ImageStorage - Manages image files on SD card
  *
  * Handles saving, organizing, and cleaning up captured images and their
  * associated metadata/response files.
+ *
+ * Inference results go into an APP10 segment of the image itself (see
+ * JpegMetadata.h), written in the same pass as the frame. The old .txt
+ * sidecar per image is only written with setResponseSidecar(true).
+ *
+ * Every saved image also gets a 1/8-scale thumbnail (thumbs/) and a 1/4-scale
+ * preview (previews/) under the same name. A low-priority task makes them
+ * after the capture path has moved on, decoding straight to the reduced
+ * size from the DCT coefficients rather than decoding the full frame.
  */
 class ImageStorage {
 public:
@@ -28,28 +44,59 @@ public:
     String generateFilename();
 
     /**
-     * Save a captured image to SD card
+     * Save a captured image to SD card and queue its thumbnails
      * @param basename Filename without extension
-     * @param image Pointer to NamedImage containing JPEG data
+     * @param frame Leased JPEG frame (written straight from the capture buffer)
+     * @param metadata Inference result to embed, nullptr for none
      * @return true if save successful
      */
-    bool saveImage(const String& basename, NamedImage* image);
+    bool saveImage(const String& basename, const FrameLease& frame, const InferenceMetadata* metadata = nullptr);
+
+    /**
+     * Read the inference result embedded in a saved image
+     * @param basename Filename without extension (will add .jpg)
+     * @return true if the image has one
+     */
+    bool readMetadata(const String& basename, InferenceMetadata& metadata);
+
+    /**
+     * Read a saved image back into PSRAM (e.g. for a deferred upload)
+     * @param basename Filename without extension (will add .jpg)
+     * @return Lease owning the copy, or an invalid lease if it cannot be read
+     */
+    FrameLease loadImage(const String& basename);
 
     /**
      * Save a text response (e.g., AI inference result) to SD card
+     * Does nothing unless the .txt sidecar layout is enabled.
      * @param basename Filename without extension (will add .txt)
      * @param response Text content to save
-     * @return true if save successful
+     * @return true if saved, or if sidecars are off
      */
     bool saveResponse(const String& basename, const String& response);
 
+    /**
+     * Make the thumbnail and preview for a saved image (runs on the thumbnail task)
+     * @param basename Filename without extension
+     * @return true if both were written
+     */
+    bool generateThumbnails(const String& basename);
+
     /**
      * Remove old image pairs, keeping only the most recent maxImages
-     * Pairs consist of .jpg and .txt files with the same basename.
+     * Removes the .jpg with its thumbnail, preview and any .txt sidecar
+     * (written with sidecars on, or by older firmware).
      * Will skip cleanup if system time appears invalid (year < 2000).
      */
     void cleanupOldImages();
 
+    /**
+     * Also write each response to a .txt next to its image (pre-APP10 layout,
+     * for tools that still read the sidecars)
+     */
+    void setResponseSidecar(bool enabled) { _responseSidecar = enabled; }
+    bool getResponseSidecar() const { return _responseSidecar; }
+
     /**
      * Get the configured images directory path
      * @return Directory path string
@@ -62,8 +109,36 @@ public:
      */
     int getMaxImages() const { return _maxImages; }
 
+    static constexpr const char* THUMBNAIL_DIR = "thumbs";
+    static constexpr const char* PREVIEW_DIR = "previews";
+
 private:
+    struct ThumbnailJob {
+        char basename[32];
+    };
+
+    static constexpr uint8_t THUMBNAIL_SCALE = 8;
+    static constexpr uint8_t PREVIEW_SCALE = 4;
+    static constexpr int THUMBNAIL_QUALITY = 70;
+    static constexpr int THUMBNAIL_QUEUE_SIZE = 4;
+    static constexpr int THUMBNAIL_TASK_STACK_SIZE = 8192;
+    static constexpr int THUMBNAIL_TASK_PRIORITY = 1;
+
+    static void freeLoadedImage(void* context, void* handle);
+    static void thumbnailTask(void* parameter);
+
+    bool ensureDir(const String& path);
+    void queueThumbnails(const String& basename);
+    bool writeScaled(const FrameLease& image, uint8_t scale, const char* subdir, const String& basename);
+    void removeIfExists(const String& path);
+
     const char* _imagesDir = "/images";
     int _maxImages = 20;
     bool _initialized = false;
+    bool _responseSidecar = false;
+
+    QueueHandle_t _thumbnailQueue = nullptr;
+    TaskHandle_t _thumbnailTask = nullptr;
+    JpegScaledDecoder* _decoder = nullptr;
+    JpegEncoder* _encoder = nullptr;
 };
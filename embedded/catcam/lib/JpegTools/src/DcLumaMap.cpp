@@ -0,0 +1,74 @@
+#include "DcLumaMap.h"
+#include "JpegBlockDecoder.h"
+
+namespace {
+
+class LumaSink : public JpegBlockSink {
+public:
+    LumaSink(uint8_t* pixels, uint16_t width, uint16_t height, uint16_t maxRows,
+             uint8_t component, uint16_t dcQuant)
+        : _pixels(pixels), _width(width), _height(height), _maxRows(maxRows),
+          _component(component), _dcQuant(dcQuant) {}
+
+    bool onBlock(const JpegBlock& block) override {
+        if (block.component != _component) {
+            return true;
+        }
+        if (block.blockY >= _maxRows) {
+            return false;  // Everything wanted has been decoded
+        }
+        if (block.blockX >= _width || block.blockY >= _height) {
+            return true;
+        }
+        // DC = 8 x (mean - 128) after dequantisation; floor division so
+        // dark blocks round like bright ones rather than toward 128
+        int dc = (int)block.coef[0] * _dcQuant;
+        int value = (dc >= 0 ? (dc + 4) / 8 : -((3 - dc) / 8)) + 128;
+        _pixels[block.blockY * _width + block.blockX] =
+            (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+        return true;
+    }
+
+private:
+    uint8_t* _pixels;
+    uint16_t _width;
+    uint16_t _height;
+    uint16_t _maxRows;
+    uint8_t _component;
+    uint16_t _dcQuant;
+};
+
+}
+
+bool DcLumaMap::build(const uint8_t* jpeg, size_t size, uint16_t maxRows) {
+    if (!parseJpeg(jpeg, size, _info)) {
+        return false;
+    }
+
+    // Luma is the first frame component; it must be part of the first scan
+    bool lumaInScan = false;
+    for (int i = 0; i < _info.scanComponentCount; i++) {
+        lumaInScan |= _info.scanComponents[i] == 0;
+    }
+    if (!lumaInScan) {
+        _info.error = "Luma not in first scan";
+        return false;
+    }
+
+    const JpegComponent& luma = _info.components[0];
+    uint16_t lumaWidth = (uint16_t)((_info.width * luma.h + _info.hMax - 1) / _info.hMax);
+    uint16_t lumaHeight = (uint16_t)((_info.height * luma.v + _info.vMax - 1) / _info.vMax);
+    _width = (uint16_t)((lumaWidth + 7) / 8);
+    _height = (uint16_t)((lumaHeight + 7) / 8);
+    _pixels.assign((size_t)_width * _height, 128);
+
+    if (maxRows == 0 || maxRows > _height) {
+        maxRows = _height;
+    }
+    LumaSink sink(_pixels.data(), _width, _height, maxRows, 0, _info.quant[luma.quantTable][0]);
+    if (!decodeJpegBlocks(jpeg, _info, sink, JpegDecodeMode::DcOnly)) {
+        _info.error = "Corrupt entropy-coded data";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef CATCAM_DCLUMAMAP_H
+#define CATCAM_DCLUMAMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "JpegParser.h"
+
+/**
+ * DcLumaMap - 1/8-scale luma image read straight from JPEG DC coefficients
+ *
+ * Each luma block's DC term is eight times the block's mean sample, so one
+ * entropy pass that skips the AC terms yields a thumbnail with one pixel per
+ * 8x8 block - no dequantise of AC, no IDCT, no colour conversion. A UXGA
+ * frame becomes a 200x150 map.
+ */
+class DcLumaMap {
+public:
+    /**
+     * Decode the luma DC terms of a JPEG into the map
+     * @param maxRows Stop after this many map rows (0 = whole frame); rows
+     *                below are left mid-grey. Saves time when only the top
+     *                of the frame is of interest.
+     * @return false if the JPEG is unsupported or corrupt (see error())
+     */
+    bool build(const uint8_t* jpeg, size_t size, uint16_t maxRows = 0);
+
+    uint16_t width() const { return _width; }
+    uint16_t height() const { return _height; }
+    const uint8_t* data() const { return _pixels.data(); }
+    size_t cellCount() const { return _pixels.size(); }
+    uint8_t at(int x, int y) const { return _pixels[y * _width + x]; }
+
+    /**
+     * Headers of the last JPEG passed to build()
+     */
+    const JpegInfo& info() const { return _info; }
+
+    const char* error() const { return _info.error; }
+
+private:
+    JpegInfo _info;
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    std::vector<uint8_t> _pixels;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "FrameQualityGate.h"
+
+const char* frameVerdictName(FrameVerdict verdict) {
+    switch (verdict) {
+        case FrameVerdict::Ok: return "ok";
+        case FrameVerdict::Truncated: return "truncated";
+        case FrameVerdict::Corrupt: return "corrupt";
+        case FrameVerdict::Dark: return "dark";
+        case FrameVerdict::BlownOut: return "blown_out";
+        default: return "unknown";
+    }
+}
+
+static bool hasEoi(const uint8_t* jpeg, size_t size, size_t maxPadding) {
+    size_t end = size;
+    while (end > 2 && size - end < maxPadding && jpeg[end - 1] == 0x00) {
+        end--;
+    }
+    return end >= 4 && jpeg[end - 2] == 0xFF && jpeg[end - 1] == 0xD9;
+}
+
+FrameQualityGate::Result FrameQualityGate::check(const uint8_t* jpeg, size_t size, DcLumaMap& map) const {
+    Result result;
+
+    if (!jpeg || size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8 || !hasEoi(jpeg, size, MAX_TRAILING_PADDING)) {
+        result.verdict = FrameVerdict::Truncated;
+        return result;
+    }
+    if (!map.build(jpeg, size) || map.cellCount() == 0) {
+        result.verdict = FrameVerdict::Corrupt;
+        return result;
+    }
+
+    const uint8_t* cells = map.data();
+    size_t count = map.cellCount();
+    uint32_t sum = 0;
+    uint32_t dark = 0;
+    uint32_t bright = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t luma = cells[i];
+        sum += luma;
+        result.histogram[luma >> 4]++;
+        dark += luma < _darkLuma;
+        bright += luma >= _brightLuma;
+    }
+    result.meanLuma = (float)sum / count;
+    result.darkFraction = (float)dark / count;
+    result.brightFraction = (float)bright / count;
+
+    if (result.darkFraction >= _maxDarkFraction) {
+        result.verdict = FrameVerdict::Dark;
+    } else if (result.brightFraction >= _maxBrightFraction) {
+        result.verdict = FrameVerdict::BlownOut;
+    } else {
+        result.verdict = FrameVerdict::Ok;
+    }
+    return result;
+}
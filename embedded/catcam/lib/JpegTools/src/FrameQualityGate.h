@@ -0,0 +1,70 @@
+#ifndef CATCAM_FRAMEQUALITYGATE_H
+#define CATCAM_FRAMEQUALITYGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DcLumaMap.h"
+
+/**
+ * Why a frame was rejected (Ok = usable)
+ */
+enum class FrameVerdict : uint8_t {
+    Ok,
+    Truncated,  // No SOI, or no EOI at the end - the transfer was cut short
+    Corrupt,    // Headers or entropy-coded data do not decode
+    Dark,       // Almost every block near black
+    BlownOut,   // Much of the frame saturated (flash too close, sun)
+    Count
+};
+
+const char* frameVerdictName(FrameVerdict verdict);
+
+/**
+ * FrameQualityGate - Cheap check that a frame is worth uploading
+ *
+ * Checks the SOI/EOI framing, then builds the DC luma map (which also proves
+ * the entropy-coded data decodes) and a 16-bin histogram of block means.
+ * Exposure is judged on block means, so a few bright or dark pixels inside an
+ * otherwise normal block do not count. No AC decode or IDCT.
+ */
+class FrameQualityGate {
+public:
+    static constexpr int HISTOGRAM_BINS = 16;
+
+    struct Result {
+        FrameVerdict verdict = FrameVerdict::Corrupt;
+        float meanLuma = 0.0f;
+        float darkFraction = 0.0f;      // Blocks with mean below darkLuma
+        float brightFraction = 0.0f;    // Blocks with mean at or above brightLuma
+        uint32_t histogram[HISTOGRAM_BINS] = {};  // Block means in steps of 16 levels
+    };
+
+    /**
+     * @param darkLuma Block mean below which a block counts as dark
+     * @param maxDarkFraction Dark blocks allowed before the frame is Dark
+     * @param brightLuma Block mean at which a block counts as saturated
+     * @param maxBrightFraction Saturated blocks allowed before the frame is BlownOut
+     */
+    explicit FrameQualityGate(uint8_t darkLuma = 20, float maxDarkFraction = 0.95f,
+                              uint8_t brightLuma = 248, float maxBrightFraction = 0.5f)
+        : _darkLuma(darkLuma), _maxDarkFraction(maxDarkFraction),
+          _brightLuma(brightLuma), _maxBrightFraction(maxBrightFraction) {}
+
+    /**
+     * Check a frame
+     * @param map Scratch map; holds the frame's DC luma map afterwards if it decoded
+     */
+    Result check(const uint8_t* jpeg, size_t size, DcLumaMap& map) const;
+
+private:
+    // Bytes after EOI tolerated (zero padding from DMA-sized buffers)
+    static constexpr size_t MAX_TRAILING_PADDING = 64;
+
+    uint8_t _darkLuma;
+    float _maxDarkFraction;
+    uint8_t _brightLuma;
+    float _maxBrightFraction;
+};
+
+#endif
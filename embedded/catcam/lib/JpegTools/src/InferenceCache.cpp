@@ -0,0 +1,78 @@
+#include "InferenceCache.h"
+#include "PerceptualHash.h"
+
+void InferenceCache::configure(uint32_t ttlMs, int maxDistance) {
+    _ttlMs = ttlMs;
+    _maxDistance = maxDistance < 0 ? 0 : (maxDistance > 63 ? 63 : maxDistance);
+    if (!_ttlMs) {
+        clear();
+    }
+}
+
+void InferenceCache::clear() {
+    for (int i = 0; i < CAPACITY; i++) {
+        _entries[i] = Entry();
+    }
+}
+
+int InferenceCache::nearest(uint64_t hash, uint32_t nowMs, int& distance) const {
+    int best = -1;
+    distance = 64;
+    for (int i = 0; i < CAPACITY; i++) {
+        if (!isLive(_entries[i], nowMs)) {
+            continue;
+        }
+        int d = perceptualHashDistance(hash, _entries[i].hash);
+        if (d < distance) {
+            distance = d;
+            best = i;
+        }
+    }
+    return distance <= _maxDistance ? best : -1;
+}
+
+bool InferenceCache::lookup(uint64_t hash, uint32_t nowMs, InferenceMetadata& result, int& distance) const {
+    if (!enabled()) {
+        return false;
+    }
+    int index = nearest(hash, nowMs, distance);
+    if (index < 0) {
+        return false;
+    }
+    result = _entries[index].result;
+    return true;
+}
+
+void InferenceCache::insert(uint64_t hash, const InferenceMetadata& result, uint32_t nowMs) {
+    if (!enabled()) {
+        return;
+    }
+    int distance;
+    int slot = nearest(hash, nowMs, distance);
+    if (slot < 0) {
+        // A free or expired slot, else the oldest entry
+        slot = 0;
+        for (int i = 0; i < CAPACITY; i++) {
+            if (!isLive(_entries[i], nowMs)) {
+                slot = i;
+                break;
+            }
+            if (nowMs - _entries[i].storedMs > nowMs - _entries[slot].storedMs) {
+                slot = i;
+            }
+        }
+    }
+    Entry& entry = _entries[slot];
+    entry.used = true;
+    entry.hash = hash;
+    entry.storedMs = nowMs;
+    entry.result = result;
+}
+
+int InferenceCache::liveEntries(uint32_t nowMs) const {
+    int count = 0;
+    for (int i = 0; i < CAPACITY; i++) {
+        count += isLive(_entries[i], nowMs);
+    }
+    return count;
+}
@@ -0,0 +1,67 @@
+#ifndef CATCAM_INFERENCECACHE_H
+#define CATCAM_INFERENCECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegMetadata.h"
+
+/**
+ * InferenceCache - Recent inference results keyed by perceptual hash
+ *
+ * A frame whose hash is within maxDistance bits of a cached one, and that
+ * arrives within the TTL of the server's answer, reuses that answer. Hits
+ * do not extend an entry's life, so a scene that keeps matching is still
+ * sent for inference once per TTL. Full: the oldest entry is replaced.
+ * Times are passed in (ms) so the cache has no clock of its own.
+ */
+class InferenceCache {
+public:
+    static constexpr int CAPACITY = 8;
+
+    /**
+     * @param ttlMs Entry lifetime, 0 = cache off
+     * @param maxDistance Largest Hamming distance that counts as a match
+     */
+    void configure(uint32_t ttlMs, int maxDistance);
+
+    /**
+     * Nearest live entry within maxDistance
+     * @param result Receives the cached result on a hit
+     * @param distance Receives the Hamming distance on a hit
+     */
+    bool lookup(uint64_t hash, uint32_t nowMs, InferenceMetadata& result, int& distance) const;
+
+    /**
+     * Store a fresh result; replaces a live entry it matches, else the oldest
+     */
+    void insert(uint64_t hash, const InferenceMetadata& result, uint32_t nowMs);
+
+    void clear();
+
+    bool enabled() const { return _ttlMs > 0; }
+
+    /**
+     * Entries still within the TTL
+     */
+    int liveEntries(uint32_t nowMs) const;
+
+private:
+    struct Entry {
+        bool used = false;
+        uint64_t hash = 0;
+        uint32_t storedMs = 0;
+        InferenceMetadata result;
+    };
+
+    Entry _entries[CAPACITY];
+    uint32_t _ttlMs = 0;
+    int _maxDistance = 0;
+
+    bool isLive(const Entry& entry, uint32_t nowMs) const {
+        return entry.used && nowMs - entry.storedMs < _ttlMs;
+    }
+    int nearest(uint64_t hash, uint32_t nowMs, int& distance) const;
+};
+
+#endif
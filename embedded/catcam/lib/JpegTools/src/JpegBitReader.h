@@ -0,0 +1,147 @@
+#ifndef CATCAM_JPEGBITREADER_H
+#define CATCAM_JPEGBITREADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+
+/**
+ * JpegBitReader - MSB-first reader over entropy-coded JPEG data
+ *
+ * Removes 0xFF00 byte stuffing and stops at the next marker, feeding zero
+ * bits past it so a corrupt stream cannot run off the buffer. restart()
+ * consumes an RSTn marker between restart intervals.
+ */
+class JpegBitReader {
+public:
+    void init(const uint8_t* data, const uint8_t* end) {
+        _p = data;
+        _end = end;
+        _bits = 0;
+        _count = 0;
+        _atMarker = false;
+        _paddingBytes = 0;
+    }
+
+    /**
+     * Next 16 bits without consuming them
+     */
+    inline uint32_t peek16() {
+        fill();
+        return _bits >> 16;
+    }
+
+    inline void skip(int n) {
+        _bits <<= n;
+        _count -= n;
+    }
+
+    /**
+     * Read n raw bits (0..16)
+     */
+    inline int receive(int n) {
+        if (n == 0) return 0;
+        fill();
+        int value = (int)(_bits >> (32 - n));
+        skip(n);
+        return value;
+    }
+
+    /**
+     * Sign-extend an n-bit magnitude category value (JPEG EXTEND procedure)
+     */
+    static inline int extend(int value, int n) {
+        return value < (1 << (n - 1)) ? value - (1 << n) + 1 : value;
+    }
+
+    /**
+     * Decode one Huffman symbol
+     * @return Symbol, or -1 on an invalid code
+     */
+    inline int decode(const JpegHuffmanTable& table) {
+        uint32_t peek = peek16();
+        uint16_t fast = table.fast[peek >> (16 - JPEG_HUFFMAN_FAST_BITS)];
+        if (fast) {
+            skip(fast >> 8);
+            return fast & 0xFF;
+        }
+        for (int len = JPEG_HUFFMAN_FAST_BITS + 1; len <= 16; len++) {
+            int32_t code = (int32_t)(peek >> (16 - len));
+            if (code <= table.maxCode[len]) {
+                skip(len);
+                return table.symbols[code + table.valOffset[len]];
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Discard padding bits and consume the RSTn marker that ends an interval
+     * @return false if no restart marker was found
+     */
+    bool restart() {
+        _bits = 0;
+        _count = 0;
+        _paddingBytes = 0;
+        while (!_atMarker && _p < _end) {
+            if (_p[0] == 0xFF && _p + 1 < _end && _p[1] != 0x00 && _p[1] != 0xFF) {
+                _atMarker = true;
+            } else {
+                _p++;
+            }
+        }
+        if (_atMarker && _p + 1 < _end && (_p[1] & 0xF8) == 0xD0) {
+            _p += 2;
+            _atMarker = false;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * True once the reader has invented more zero bits than any valid
+     * stream could need (the data was truncated or corrupt)
+     */
+    bool overrun() const { return _paddingBytes > 4; }
+
+    /**
+     * Position of the next unread byte (the marker once the scan is exhausted)
+     */
+    const uint8_t* position() const { return _p; }
+
+private:
+    const uint8_t* _p = nullptr;
+    const uint8_t* _end = nullptr;
+    uint32_t _bits = 0;
+    int _count = 0;
+    bool _atMarker = false;
+    int _paddingBytes = 0;
+
+    inline void fill() {
+        while (_count <= 24) {
+            uint32_t byte = 0;
+            if (!_atMarker && _p < _end) {
+                byte = *_p;
+                if (byte == 0xFF) {
+                    uint8_t next = _p + 1 < _end ? _p[1] : 0xD9;
+                    if (next == 0x00) {
+                        _p += 2;
+                    } else {
+                        _atMarker = true;
+                        byte = 0;
+                        _paddingBytes++;
+                    }
+                } else {
+                    _p++;
+                }
+            } else {
+                _paddingBytes++;
+            }
+            _bits |= byte << (24 - _count);
+            _count += 8;
+        }
+    }
+};
+
+#endif
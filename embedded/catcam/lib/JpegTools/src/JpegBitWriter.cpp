@@ -0,0 +1,75 @@
+#include "JpegBitWriter.h"
+
+void JpegHuffmanEncoder::build(const JpegHuffmanTable& table) {
+    for (int i = 0; i < 256; i++) {
+        code[i] = 0;
+        length[i] = 0;
+    }
+    uint16_t next = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < table.counts[len]; i++, k++) {
+            code[table.symbols[k]] = next++;
+            length[table.symbols[k]] = (uint8_t)len;
+        }
+        next <<= 1;
+    }
+}
+
+static inline int magnitudeCategory(int value) {
+    unsigned int magnitude = (unsigned int)(value < 0 ? -value : value);
+    int bits = 0;
+    while (magnitude) {
+        bits++;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+bool encodeJpegBlock(JpegBitWriter& writer, const JpegHuffmanEncoder& dc, const JpegHuffmanEncoder& ac,
+                     const int16_t* coef, int& predictor) {
+    int diff = coef[0] - predictor;
+    predictor = coef[0];
+
+    int category = magnitudeCategory(diff);
+    if (!dc.length[category]) {
+        return false;
+    }
+    writer.write(dc.code[category], dc.length[category]);
+    if (category) {
+        writer.write((uint32_t)(diff < 0 ? diff - 1 : diff), category);
+    }
+
+    int last = 63;
+    while (last > 0 && coef[last] == 0) {
+        last--;
+    }
+
+    int run = 0;
+    for (int k = 1; k <= last; k++) {
+        int value = coef[k];
+        if (value == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            if (!ac.length[0xF0]) return false;
+            writer.write(ac.code[0xF0], ac.length[0xF0]);  // ZRL
+            run -= 16;
+        }
+        category = magnitudeCategory(value);
+        uint8_t symbol = (uint8_t)((run << 4) | category);
+        if (!ac.length[symbol]) {
+            return false;
+        }
+        writer.write(ac.code[symbol], ac.length[symbol]);
+        writer.write((uint32_t)(value < 0 ? value - 1 : value), category);
+        run = 0;
+    }
+
+    if (last < 63) {
+        if (!ac.length[0x00]) return false;
+        writer.write(ac.code[0x00], ac.length[0x00]);  // EOB
+    }
+    return true;
+}
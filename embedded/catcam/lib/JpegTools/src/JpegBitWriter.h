@@ -0,0 +1,103 @@
+#ifndef CATCAM_JPEGBITWRITER_H
+#define CATCAM_JPEGBITWRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+
+/**
+ * JpegBitWriter - MSB-first writer for entropy-coded JPEG data
+ *
+ * Writes into a caller-supplied buffer with 0xFF byte stuffing. Running out
+ * of space sets overflow() instead of writing past the end.
+ */
+class JpegBitWriter {
+public:
+    void init(uint8_t* out, size_t capacity) {
+        _start = out;
+        _p = out;
+        _end = out + capacity;
+        _bits = 0;
+        _count = 0;
+        _overflow = false;
+    }
+
+    /**
+     * Append the low len bits of value (len <= 16)
+     */
+    inline void write(uint32_t value, int len) {
+        _bits = (_bits << len) | (value & ((1u << len) - 1));
+        _count += len;
+        while (_count >= 8) {
+            uint8_t byte = (uint8_t)(_bits >> (_count - 8));
+            put(byte);
+            if (byte == 0xFF) {
+                put(0x00);
+            }
+            _count -= 8;
+        }
+    }
+
+    /**
+     * Pad the last byte with 1 bits, as the standard requires before a marker
+     */
+    void flush() {
+        if (_count > 0) {
+            write(0x7F, 8 - _count);
+        }
+    }
+
+    /**
+     * Append bytes verbatim (headers, markers) - only valid on a byte boundary
+     */
+    void writeBytes(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            put(data[i]);
+        }
+    }
+
+    void writeMarker(uint8_t marker) {
+        put(0xFF);
+        put(marker);
+    }
+
+    size_t size() const { return (size_t)(_p - _start); }
+    bool overflow() const { return _overflow; }
+
+private:
+    uint8_t* _start = nullptr;
+    uint8_t* _p = nullptr;
+    uint8_t* _end = nullptr;
+    uint32_t _bits = 0;
+    int _count = 0;
+    bool _overflow = false;
+
+    inline void put(uint8_t byte) {
+        if (_p < _end) {
+            *_p++ = byte;
+        } else {
+            _overflow = true;
+        }
+    }
+};
+
+/**
+ * Code/length per symbol, derived from a parsed Huffman table
+ */
+struct JpegHuffmanEncoder {
+    uint16_t code[256] = {};
+    uint8_t length[256] = {};   // 0 = symbol not in the table
+
+    void build(const JpegHuffmanTable& table);
+};
+
+/**
+ * Entropy-encode one block of quantised coefficients (zigzag order)
+ * @param predictor DC predictor for the block's component, updated
+ * @return false if a needed symbol is missing from the tables
+ */
+bool encodeJpegBlock(JpegBitWriter& writer, const JpegHuffmanEncoder& dc, const JpegHuffmanEncoder& ac,
+                     const int16_t* coef, int& predictor);
+
+#endif
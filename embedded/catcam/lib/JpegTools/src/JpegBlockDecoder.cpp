@@ -0,0 +1,134 @@
+#include "JpegBlockDecoder.h"
+#include "JpegBitReader.h"
+
+static inline bool decodeBlock(JpegBitReader& reader, const JpegHuffmanTable& dcTable,
+                               const JpegHuffmanTable& acTable, int& predictor,
+                               JpegBlock& block, bool full) {
+    int category = reader.decode(dcTable);
+    if (category < 0 || category > 11) {
+        return false;
+    }
+    if (category) {
+        predictor += JpegBitReader::extend(reader.receive(category), category);
+    }
+    block.coef[0] = (int16_t)predictor;
+
+    if (full) {
+        // Only the coefficients the previous block wrote can be non-zero
+        for (int i = 1; i <= block.lastNonZero; i++) {
+            block.coef[i] = 0;
+        }
+    }
+
+    int last = 0;
+    for (int k = 1; k < 64; k++) {
+        int symbol = reader.decode(acTable);
+        if (symbol < 0) {
+            return false;
+        }
+        int run = symbol >> 4;
+        int size = symbol & 0x0F;
+        if (size == 0) {
+            if (run != 15) break;  // EOB
+            k += 15;               // ZRL: sixteen zeros
+            continue;
+        }
+        k += run;
+        if (k > 63) {
+            return false;
+        }
+        int bits = reader.receive(size);
+        if (full) {
+            block.coef[k] = (int16_t)JpegBitReader::extend(bits, size);
+            last = k;
+        }
+    }
+    block.lastNonZero = (uint8_t)last;
+    return true;
+}
+
+bool decodeJpegBlocks(const uint8_t* data, const JpegInfo& info, JpegBlockSink& sink,
+                      JpegDecodeMode mode) {
+    if (!data || info.scanComponentCount == 0 || info.scanOffset >= info.size) {
+        return false;
+    }
+
+    JpegBitReader reader;
+    reader.init(data + info.scanOffset, data + info.size);
+
+    bool full = mode == JpegDecodeMode::Full;
+    int predictors[JPEG_MAX_COMPONENTS] = {};
+    JpegBlock block;
+    uint32_t mcuIndex = 0;
+
+    auto startMcu = [&]() -> bool {
+        if (info.restartInterval && mcuIndex > 0 && mcuIndex % info.restartInterval == 0) {
+            if (!reader.restart()) {
+                return false;
+            }
+            for (int i = 0; i < JPEG_MAX_COMPONENTS; i++) {
+                predictors[i] = 0;
+            }
+        }
+        mcuIndex++;
+        return true;
+    };
+
+    if (info.scanComponentCount == 1) {
+        // Non-interleaved: one block per MCU over the component's own (unpadded) grid
+        uint8_t index = info.scanComponents[0];
+        const JpegComponent& c = info.components[index];
+        int componentWidth = (info.width * c.h + info.hMax - 1) / info.hMax;
+        int componentHeight = (info.height * c.v + info.vMax - 1) / info.vMax;
+        int blocksX = (componentWidth + 7) / 8;
+        int blocksY = (componentHeight + 7) / 8;
+        const JpegHuffmanTable& dc = info.dcTables[c.dcTable];
+        const JpegHuffmanTable& ac = info.acTables[c.acTable];
+
+        block.component = index;
+        for (int by = 0; by < blocksY; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                if (!startMcu()) return false;
+                if (!decodeBlock(reader, dc, ac, predictors[index], block, full) || reader.overrun()) {
+                    return false;
+                }
+                block.blockX = block.mcuX = (uint16_t)bx;
+                block.blockY = block.mcuY = (uint16_t)by;
+                if (!sink.onBlock(block)) return true;
+            }
+        }
+        return true;
+    }
+
+    for (int my = 0; my < info.mcusY; my++) {
+        for (int mx = 0; mx < info.mcusX; mx++) {
+            if (!startMcu()) return false;
+            block.mcuX = (uint16_t)mx;
+            block.mcuY = (uint16_t)my;
+
+            for (int s = 0; s < info.scanComponentCount; s++) {
+                uint8_t index = info.scanComponents[s];
+                const JpegComponent& c = info.components[index];
+                const JpegHuffmanTable& dc = info.dcTables[c.dcTable];
+                const JpegHuffmanTable& ac = info.acTables[c.acTable];
+                block.component = index;
+
+                for (int v = 0; v < c.v; v++) {
+                    for (int h = 0; h < c.h; h++) {
+                        if (!decodeBlock(reader, dc, ac, predictors[index], block, full)) {
+                            return false;
+                        }
+                        block.blockX = (uint16_t)(mx * c.h + h);
+                        block.blockY = (uint16_t)(my * c.v + v);
+                        if (!sink.onBlock(block)) return true;
+                    }
+                }
+            }
+
+            if (reader.overrun()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
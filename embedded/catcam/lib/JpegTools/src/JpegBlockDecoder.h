@@ -0,0 +1,53 @@
+#ifndef CATCAM_JPEGBLOCKDECODER_H
+#define CATCAM_JPEGBLOCKDECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+
+/**
+ * One 8x8 block of quantised DCT coefficients as it comes out of the scan
+ */
+struct JpegBlock {
+    uint8_t component = 0;      // Index into JpegInfo::components
+    uint16_t blockX = 0;        // Position in the component's block grid
+    uint16_t blockY = 0;
+    uint16_t mcuX = 0;          // MCU holding this block
+    uint16_t mcuY = 0;
+    int16_t coef[64] = {};      // Zigzag order; coef[0] is the absolute (un-differenced) DC
+    uint8_t lastNonZero = 63;   // Last zigzag index with a non-zero AC, 0 if none (Full mode)
+};
+
+/**
+ * Receives blocks in scan order
+ */
+class JpegBlockSink {
+public:
+    virtual ~JpegBlockSink() = default;
+
+    /**
+     * @return false to stop decoding early
+     */
+    virtual bool onBlock(const JpegBlock& block) = 0;
+};
+
+enum class JpegDecodeMode : uint8_t {
+    DcOnly,     // AC codes are skipped; coef[1..63] are not written
+    Full        // All coefficients are decoded
+};
+
+/**
+ * Entropy-decode the first scan into quantised coefficients (no dequantise, no IDCT)
+ * Padding blocks on the right/bottom edge of each MCU are delivered too;
+ * sinks that only care about visible pixels should clip on blockX/blockY.
+ * @param data Buffer that was passed to parseJpeg()
+ * @param info Parsed headers
+ * @param sink Block consumer
+ * @param mode DcOnly is several times cheaper when only the DC terms are needed
+ * @return true if the whole scan decoded (or the sink stopped early)
+ */
+bool decodeJpegBlocks(const uint8_t* data, const JpegInfo& info, JpegBlockSink& sink,
+                      JpegDecodeMode mode = JpegDecodeMode::Full);
+
+#endif
@@ -0,0 +1,153 @@
+#include "JpegCropper.h"
+#include "JpegBlockDecoder.h"
+
+namespace {
+
+class CropSink : public JpegBlockSink {
+public:
+    CropSink(JpegBitWriter& writer, const JpegInfo& info,
+             const JpegHuffmanEncoder* dcEncoders, const JpegHuffmanEncoder* acEncoders,
+             int mcuX0, int mcuY0, int mcuX1, int mcuY1)
+        : _writer(writer), _info(info), _dcEncoders(dcEncoders), _acEncoders(acEncoders),
+          _mcuX0(mcuX0), _mcuY0(mcuY0), _mcuX1(mcuX1), _mcuY1(mcuY1) {}
+
+    bool onBlock(const JpegBlock& block) override {
+        if (block.mcuY >= _mcuY1) {
+            return false;  // Past the last row we keep
+        }
+        if (block.mcuY < _mcuY0 || block.mcuX < _mcuX0 || block.mcuX >= _mcuX1) {
+            return true;
+        }
+        const JpegComponent& c = _info.components[block.component];
+        if (!encodeJpegBlock(_writer, _dcEncoders[c.dcTable], _acEncoders[c.acTable],
+                             block.coef, _predictors[block.component])) {
+            failed = true;
+            return false;
+        }
+        return !_writer.overflow();
+    }
+
+    bool failed = false;
+
+private:
+    JpegBitWriter& _writer;
+    const JpegInfo& _info;
+    const JpegHuffmanEncoder* _dcEncoders;
+    const JpegHuffmanEncoder* _acEncoders;
+    int _mcuX0, _mcuY0, _mcuX1, _mcuY1;
+    int _predictors[JPEG_MAX_COMPONENTS] = {};
+};
+
+}
+
+JpegCropRect JpegCropper::alignToMcu(const JpegInfo& info, const JpegCropRect& rect) {
+    JpegCropRect aligned;
+    if (info.width == 0 || info.height == 0) {
+        return aligned;
+    }
+
+    int x0 = rect.x < info.width ? rect.x : info.width - 1;
+    int y0 = rect.y < info.height ? rect.y : info.height - 1;
+    x0 = x0 / info.mcuWidth * info.mcuWidth;
+    y0 = y0 / info.mcuHeight * info.mcuHeight;
+
+    int x1 = rect.x + rect.width;
+    int y1 = rect.y + rect.height;
+    x1 = (x1 + info.mcuWidth - 1) / info.mcuWidth * info.mcuWidth;
+    y1 = (y1 + info.mcuHeight - 1) / info.mcuHeight * info.mcuHeight;
+    if (x1 > info.width) x1 = info.width;
+    if (y1 > info.height) y1 = info.height;
+    if (x1 <= x0 || y1 <= y0) {
+        return aligned;
+    }
+
+    aligned.x = (uint16_t)x0;
+    aligned.y = (uint16_t)y0;
+    aligned.width = (uint16_t)(x1 - x0);
+    aligned.height = (uint16_t)(y1 - y0);
+    return aligned;
+}
+
+bool JpegCropper::load(const uint8_t* jpeg, size_t size) {
+    _error = nullptr;
+    _jpeg = nullptr;
+
+    if (!parseJpeg(jpeg, size, _info)) {
+        _error = _info.error;
+        return false;
+    }
+    if (_info.scanComponentCount != _info.componentCount) {
+        _error = "Multi-scan JPEG not supported";
+        return false;
+    }
+
+    _jpeg = jpeg;
+    return true;
+}
+
+bool JpegCropper::crop(const JpegCropRect& rect, uint8_t* out, size_t capacity, size_t& outSize,
+                       JpegCropRect* actual) {
+    outSize = 0;
+    if (!_jpeg) {
+        if (!_error) _error = "No JPEG loaded";
+        return false;
+    }
+    _error = nullptr;
+
+    JpegCropRect aligned = alignToMcu(_info, rect);
+    if (aligned.width == 0 || aligned.height == 0) {
+        _error = "Crop rectangle outside image";
+        return false;
+    }
+    if (actual) {
+        *actual = aligned;
+    }
+
+    for (int i = 0; i < JPEG_MAX_HUFFMAN_TABLES; i++) {
+        if (_info.dcTables[i].present) _dcEncoders[i].build(_info.dcTables[i]);
+        if (_info.acTables[i].present) _acEncoders[i].build(_info.acTables[i]);
+    }
+
+    // Headers up to and including SOS are reused as-is apart from the
+    // frame size and restart interval
+    JpegBitWriter writer;
+    writer.init(out, capacity);
+    writer.writeBytes(_jpeg, _info.scanOffset);
+    if (writer.overflow()) {
+        _error = "Output buffer too small";
+        return false;
+    }
+    out[_info.sofOffset + 5] = (uint8_t)(aligned.height >> 8);
+    out[_info.sofOffset + 6] = (uint8_t)(aligned.height & 0xFF);
+    out[_info.sofOffset + 7] = (uint8_t)(aligned.width >> 8);
+    out[_info.sofOffset + 8] = (uint8_t)(aligned.width & 0xFF);
+    if (_info.driOffset) {
+        out[_info.driOffset + 4] = 0;
+        out[_info.driOffset + 5] = 0;
+    }
+
+    int mcuX0 = aligned.x / _info.mcuWidth;
+    int mcuY0 = aligned.y / _info.mcuHeight;
+    int mcuX1 = (aligned.x + aligned.width + _info.mcuWidth - 1) / _info.mcuWidth;
+    int mcuY1 = (aligned.y + aligned.height + _info.mcuHeight - 1) / _info.mcuHeight;
+
+    CropSink sink(writer, _info, _dcEncoders, _acEncoders, mcuX0, mcuY0, mcuX1, mcuY1);
+    if (!decodeJpegBlocks(_jpeg, _info, sink, JpegDecodeMode::Full)) {
+        _error = "Corrupt entropy-coded data";
+        return false;
+    }
+    if (sink.failed) {
+        _error = "Huffman table lacks a needed code";
+        return false;
+    }
+
+    writer.flush();
+    writer.writeMarker(0xD9);  // EOI
+    if (writer.overflow()) {
+        _error = "Output buffer too small";
+        return false;
+    }
+
+    outSize = writer.size();
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef CATCAM_JPEGCROPPER_H
+#define CATCAM_JPEGCROPPER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+#include "JpegBitWriter.h"
+
+/**
+ * Crop rectangle in pixels
+ */
+struct JpegCropRect {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+/**
+ * JpegCropper - Lossless crop of a baseline JPEG at MCU granularity
+ *
+ * Entropy-decodes the scan to quantised coefficients, keeps the MCUs inside
+ * the (outward-snapped) crop rectangle and re-encodes just those with the
+ * original Huffman and quantisation tables. No dequantise, IDCT or colour
+ * conversion, so the pixels are bit-identical to the source. Only the DC
+ * predictors are recomputed; restart markers are dropped (DRI set to 0).
+ *
+ * Decoding stops at the last MCU row of the rectangle.
+ */
+class JpegCropper {
+public:
+    /**
+     * Snap a rectangle outward to the MCU grid and clip it to the image
+     */
+    static JpegCropRect alignToMcu(const JpegInfo& info, const JpegCropRect& rect);
+
+    /**
+     * Parse a source JPEG; info() is valid afterwards (e.g. to size the rectangle)
+     * The buffer must stay valid until crop() has returned.
+     * @return false if the source is unsupported (see error())
+     */
+    bool load(const uint8_t* jpeg, size_t size);
+
+    /**
+     * Crop the loaded JPEG into a caller-supplied buffer
+     * @param rect Requested rectangle (pixels); snapped outward to MCUs
+     * @param out Output buffer
+     * @param capacity Output buffer size (source size + 1 KB is always enough in practice)
+     * @param outSize Bytes written on success
+     * @param actual Optional - receives the MCU-aligned rectangle actually kept
+     * @return false if nothing is loaded or the output did not fit (see error())
+     */
+    bool crop(const JpegCropRect& rect, uint8_t* out, size_t capacity, size_t& outSize,
+              JpegCropRect* actual = nullptr);
+
+    const char* error() const { return _error; }
+
+    /**
+     * Headers of the loaded source
+     */
+    const JpegInfo& info() const { return _info; }
+
+private:
+    JpegInfo _info;
+    const uint8_t* _jpeg = nullptr;
+    JpegHuffmanEncoder _dcEncoders[JPEG_MAX_HUFFMAN_TABLES];
+    JpegHuffmanEncoder _acEncoders[JPEG_MAX_HUFFMAN_TABLES];
+    const char* _error = nullptr;
+};
+
+#endif
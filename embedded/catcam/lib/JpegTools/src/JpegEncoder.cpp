@@ -0,0 +1,270 @@
+#include "JpegEncoder.h"
+#include <math.h>
+
+namespace {
+
+// ITU T.81 Annex K.1, natural order
+const uint8_t STD_LUMA_QUANT[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99,
+};
+
+const uint8_t STD_CHROMA_QUANT[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// ITU T.81 Annex K.3: counts of codes of length 1..16, then the symbols
+const uint8_t STD_DC_LUMA_COUNTS[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t STD_DC_CHROMA_COUNTS[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+const uint8_t STD_DC_SYMBOLS[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+const uint8_t STD_AC_LUMA_COUNTS[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uint8_t STD_AC_LUMA_SYMBOLS[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa,
+};
+
+const uint8_t STD_AC_CHROMA_COUNTS[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+const uint8_t STD_AC_CHROMA_SYMBOLS[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa,
+};
+
+struct StdHuffman {
+    const uint8_t* counts;
+    const uint8_t* symbols;
+    uint16_t symbolCount;
+};
+
+// Indexed [class][table]: class 0 = DC, 1 = AC; table 0 = luma, 1 = chroma
+const StdHuffman STD_HUFFMAN[2][2] = {
+    {{STD_DC_LUMA_COUNTS, STD_DC_SYMBOLS, 12}, {STD_DC_CHROMA_COUNTS, STD_DC_SYMBOLS, 12}},
+    {{STD_AC_LUMA_COUNTS, STD_AC_LUMA_SYMBOLS, 162}, {STD_AC_CHROMA_COUNTS, STD_AC_CHROMA_SYMBOLS, 162}},
+};
+
+// DCT basis with the C(u)/2 normalisation folded in: basis[u][x]
+float dctBasis[8][8];
+bool dctBasisReady = false;
+
+void buildDctBasis() {
+    for (int u = 0; u < 8; u++) {
+        float scale = (u == 0 ? (float)M_SQRT1_2 : 1.0f) / 2.0f;
+        for (int x = 0; x < 8; x++) {
+            dctBasis[u][x] = scale * cosf((2 * x + 1) * u * (float)M_PI / 16.0f);
+        }
+    }
+    dctBasisReady = true;
+}
+
+void writeWord(JpegBitWriter& writer, uint16_t value) {
+    uint8_t bytes[2] = {(uint8_t)(value >> 8), (uint8_t)value};
+    writer.writeBytes(bytes, 2);
+}
+
+}
+
+void jpegStandardQuantTable(bool chroma, int quality, uint16_t* zigzag) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+
+    int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    const uint8_t* base = chroma ? STD_CHROMA_QUANT : STD_LUMA_QUANT;
+    for (int k = 0; k < 64; k++) {
+        long value = ((long)base[JPEG_ZIGZAG_TO_NATURAL[k]] * scale + 50) / 100;
+        zigzag[k] = (uint16_t)(value < 1 ? 1 : (value > 255 ? 255 : value));
+    }
+}
+
+void JpegEncoder::setQuality(int quality) {
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    if (quality == _quality) {
+        return;
+    }
+    _quality = quality;
+
+    for (int t = 0; t < 2; t++) {
+        jpegStandardQuantTable(t != 0, quality, _quant[t]);
+        for (int k = 0; k < 64; k++) {
+            _divisor[t][JPEG_ZIGZAG_TO_NATURAL[k]] = (float)_quant[t][k];
+        }
+    }
+}
+
+void JpegEncoder::forwardDct(const uint8_t* plane, uint16_t width, uint16_t height, int bx, int by, float* out) {
+    float rows[8][8];
+    for (int y = 0; y < 8; y++) {
+        int sy = by * 8 + y;
+        const uint8_t* src = plane + (size_t)(sy < height ? sy : height - 1) * width;
+        float samples[8];
+        for (int x = 0; x < 8; x++) {
+            int sx = bx * 8 + x;
+            samples[x] = (float)src[sx < width ? sx : width - 1] - 128.0f;
+        }
+        for (int u = 0; u < 8; u++) {
+            float sum = 0.0f;
+            for (int x = 0; x < 8; x++) {
+                sum += dctBasis[u][x] * samples[x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+    for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+            float sum = 0.0f;
+            for (int y = 0; y < 8; y++) {
+                sum += dctBasis[v][y] * rows[y][u];
+            }
+            out[v * 8 + u] = sum;
+        }
+    }
+}
+
+void JpegEncoder::writeHeaders(JpegBitWriter& writer, int componentCount, uint16_t width, uint16_t height) {
+    int tableCount = componentCount == 1 ? 1 : 2;
+
+    writer.writeMarker(0xD8);  // SOI
+
+    static const uint8_t JFIF[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    writer.writeMarker(0xE0);
+    writeWord(writer, 2 + sizeof(JFIF));
+    writer.writeBytes(JFIF, sizeof(JFIF));
+
+    writer.writeMarker(0xDB);  // DQT
+    writeWord(writer, 2 + tableCount * 65);
+    for (int t = 0; t < tableCount; t++) {
+        uint8_t table[65];
+        table[0] = (uint8_t)t;
+        for (int k = 0; k < 64; k++) {
+            table[1 + k] = (uint8_t)_quant[t][k];
+        }
+        writer.writeBytes(table, sizeof(table));
+    }
+
+    writer.writeMarker(0xC0);  // SOF0
+    writeWord(writer, 8 + 3 * componentCount);
+    uint8_t frame[6] = {8, (uint8_t)(height >> 8), (uint8_t)height, (uint8_t)(width >> 8), (uint8_t)width,
+                        (uint8_t)componentCount};
+    writer.writeBytes(frame, sizeof(frame));
+    for (int c = 0; c < componentCount; c++) {
+        uint8_t component[3] = {(uint8_t)(c + 1), 0x11, (uint8_t)(c == 0 ? 0 : 1)};
+        writer.writeBytes(component, sizeof(component));
+    }
+
+    writer.writeMarker(0xC4);  // DHT
+    uint16_t length = 2;
+    for (int cls = 0; cls < 2; cls++) {
+        for (int t = 0; t < tableCount; t++) {
+            length += 17 + STD_HUFFMAN[cls][t].symbolCount;
+        }
+    }
+    writeWord(writer, length);
+    for (int cls = 0; cls < 2; cls++) {
+        for (int t = 0; t < tableCount; t++) {
+            const StdHuffman& table = STD_HUFFMAN[cls][t];
+            uint8_t id = (uint8_t)((cls << 4) | t);
+            writer.writeBytes(&id, 1);
+            writer.writeBytes(table.counts, 16);
+            writer.writeBytes(table.symbols, table.symbolCount);
+        }
+    }
+
+    writer.writeMarker(0xDA);  // SOS
+    writeWord(writer, 6 + 2 * componentCount);
+    uint8_t count = (uint8_t)componentCount;
+    writer.writeBytes(&count, 1);
+    for (int c = 0; c < componentCount; c++) {
+        uint8_t selector[2] = {(uint8_t)(c + 1), (uint8_t)(c == 0 ? 0x00 : 0x11)};
+        writer.writeBytes(selector, sizeof(selector));
+    }
+    static const uint8_t SPECTRAL[3] = {0, 63, 0};
+    writer.writeBytes(SPECTRAL, sizeof(SPECTRAL));
+}
+
+size_t JpegEncoder::encode(const uint8_t* const* planes, int componentCount, uint16_t width, uint16_t height,
+                           int quality, uint8_t* out, size_t capacity) {
+    if ((componentCount != 1 && componentCount != 3) || width == 0 || height == 0) {
+        return 0;
+    }
+    if (!dctBasisReady) {
+        buildDctBasis();
+    }
+    if (!_huffmanBuilt) {
+        JpegHuffmanTable table;
+        for (int cls = 0; cls < 2; cls++) {
+            for (int t = 0; t < 2; t++) {
+                const StdHuffman& source = STD_HUFFMAN[cls][t];
+                table.counts[0] = 0;
+                for (int len = 1; len <= 16; len++) {
+                    table.counts[len] = source.counts[len - 1];
+                }
+                for (int i = 0; i < source.symbolCount; i++) {
+                    table.symbols[i] = source.symbols[i];
+                }
+                table.symbolCount = source.symbolCount;
+                (cls == 0 ? _dc[t] : _ac[t]).build(table);
+            }
+        }
+        _huffmanBuilt = true;
+    }
+    setQuality(quality);
+
+    JpegBitWriter writer;
+    writer.init(out, capacity);
+    writeHeaders(writer, componentCount, width, height);
+
+    // With 1x1 sampling an interleaved MCU is one block of each component
+    int blocksX = (width + 7) / 8;
+    int blocksY = (height + 7) / 8;
+    int predictor[3] = {0, 0, 0};
+    float dct[64];
+    int16_t coef[64];
+    for (int by = 0; by < blocksY && !writer.overflow(); by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            for (int c = 0; c < componentCount; c++) {
+                int t = c == 0 ? 0 : 1;
+                forwardDct(planes[c], width, height, bx, by, dct);
+                for (int k = 0; k < 64; k++) {
+                    int natural = JPEG_ZIGZAG_TO_NATURAL[k];
+                    coef[k] = (int16_t)lrintf(dct[natural] / _divisor[t][natural]);
+                }
+                encodeJpegBlock(writer, _dc[t], _ac[t], coef, predictor[c]);
+            }
+        }
+    }
+    writer.flush();
+    writer.writeMarker(0xD9);  // EOI
+
+    return writer.overflow() ? 0 : writer.size();
+}
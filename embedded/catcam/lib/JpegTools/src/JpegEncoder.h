@@ -0,0 +1,48 @@
+#ifndef CATCAM_JPEGENCODER_H
+#define CATCAM_JPEGENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegBitWriter.h"
+
+/**
+ * Standard (Annex K) quantisation table scaled by IJG quality
+ * @param chroma false for the luma table, true for chroma
+ * @param quality 1-100 (clamped)
+ * @param zigzag Receives the 64 steps in zigzag order, each 1-255
+ */
+void jpegStandardQuantTable(bool chroma, int quality, uint16_t* zigzag);
+
+/**
+ * JpegEncoder - Minimal baseline JPEG encoder for thumbnails
+ *
+ * Encodes planar greyscale or YCbCr 4:4:4 samples with the standard
+ * (Annex K) quantisation tables scaled by quality, and the standard Huffman
+ * tables. A plain float DCT - meant for images of a few thousand blocks,
+ * not camera frames. Partial edge blocks repeat the last row/column.
+ */
+class JpegEncoder {
+public:
+    /**
+     * @param planes 1 plane (Y) or 3 (Y, Cb, Cr), each width x height samples
+     * @param quality 1-100, IJG scaling of the standard tables
+     * @return Bytes written to out, 0 if it did not fit in capacity
+     */
+    size_t encode(const uint8_t* const* planes, int componentCount, uint16_t width, uint16_t height,
+                  int quality, uint8_t* out, size_t capacity);
+
+private:
+    uint16_t _quant[2][64];            // Zigzag order, [0] luma, [1] chroma
+    float _divisor[2][64];             // Natural order, for quantising
+    JpegHuffmanEncoder _dc[2];
+    JpegHuffmanEncoder _ac[2];
+    bool _huffmanBuilt = false;
+    int _quality = -1;
+
+    void setQuality(int quality);
+    void writeHeaders(JpegBitWriter& writer, int componentCount, uint16_t width, uint16_t height);
+    void forwardDct(const uint8_t* plane, uint16_t width, uint16_t height, int bx, int by, float* out);
+};
+
+#endif
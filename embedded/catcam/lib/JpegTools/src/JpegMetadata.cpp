@@ -0,0 +1,134 @@
+#include "JpegMetadata.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char IDENTIFIER[] = "CatCamInf";  // Written with its terminating NUL
+static constexpr size_t IDENTIFIER_LEN = sizeof(IDENTIFIER);
+
+static void copyValue(char* dest, size_t destSize, const char* value, size_t len) {
+    if (len >= destSize) {
+        len = destSize - 1;
+    }
+    memcpy(dest, value, len);
+    dest[len] = '\0';
+}
+
+// Newlines would end the value early on the way back in
+static void copySanitised(char* dest, size_t destSize, const char* src) {
+    size_t i = 0;
+    for (; src[i] && i + 1 < destSize; i++) {
+        dest[i] = (src[i] == '\n' || src[i] == '\r') ? ' ' : src[i];
+    }
+    dest[i] = '\0';
+}
+
+size_t buildJpegMetadataSegment(const InferenceMetadata& metadata, uint8_t* out, size_t capacity) {
+    char name[sizeof(metadata.name)];
+    char firmware[sizeof(metadata.firmware)];
+    copySanitised(name, sizeof(name), metadata.name);
+    copySanitised(firmware, sizeof(firmware), metadata.firmware);
+
+    char payload[JPEG_METADATA_MAX_SEGMENT];
+    int payloadLen = snprintf(payload, sizeof(payload),
+        "name=%s\nindex=%d\nconfidence=%.4f\nlatency_ms=%lu\nfirmware=%s\n",
+        name, metadata.index, metadata.confidence, (unsigned long)metadata.latencyMs, firmware);
+    if (payloadLen < 0 || (size_t)payloadLen >= sizeof(payload)) {
+        return 0;
+    }
+
+    size_t segmentLen = 2 + IDENTIFIER_LEN + 1 + (size_t)payloadLen;  // Length field counts itself
+    if (2 + segmentLen > capacity) {
+        return 0;
+    }
+    uint8_t* p = out;
+    *p++ = 0xFF;
+    *p++ = JPEG_METADATA_MARKER;
+    *p++ = (uint8_t)(segmentLen >> 8);
+    *p++ = (uint8_t)segmentLen;
+    memcpy(p, IDENTIFIER, IDENTIFIER_LEN);
+    p += IDENTIFIER_LEN;
+    *p++ = JPEG_METADATA_VERSION;
+    memcpy(p, payload, payloadLen);
+    return 2 + segmentLen;
+}
+
+size_t jpegMetadataInsertOffset(const uint8_t* jpeg, size_t size) {
+    if (!jpeg || size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return 0;
+    }
+    if (size >= 6 && jpeg[2] == 0xFF && jpeg[3] == 0xE0) {
+        size_t app0End = 4 + (((size_t)jpeg[4] << 8) | jpeg[5]);
+        if (app0End <= size) {
+            return app0End;
+        }
+    }
+    return 2;
+}
+
+bool readJpegMetadata(const uint8_t* jpeg, size_t size, InferenceMetadata& metadata) {
+    if (!jpeg || size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return false;
+    }
+
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (jpeg[pos] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xFF) {
+            pos++;  // Fill byte
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) {
+            return false;  // Into the scan without finding it
+        }
+        size_t segmentLen = ((size_t)jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (segmentLen < 2 || pos + 2 + segmentLen > size) {
+            return false;  // Corrupt, or beyond the prefix we were given
+        }
+
+        const char* payload = (const char*)jpeg + pos + 4;
+        size_t payloadLen = segmentLen - 2;
+        if (marker == JPEG_METADATA_MARKER && payloadLen > IDENTIFIER_LEN &&
+            memcmp(payload, IDENTIFIER, IDENTIFIER_LEN) == 0) {
+            if ((uint8_t)payload[IDENTIFIER_LEN] != JPEG_METADATA_VERSION) {
+                return false;
+            }
+            metadata = InferenceMetadata();
+            const char* p = payload + IDENTIFIER_LEN + 1;
+            const char* end = payload + payloadLen;
+            while (p < end) {
+                const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+                if (!lineEnd) {
+                    lineEnd = end;
+                }
+                const char* equals = (const char*)memchr(p, '=', lineEnd - p);
+                if (equals) {
+                    size_t keyLen = equals - p;
+                    const char* value = equals + 1;
+                    size_t valueLen = lineEnd - value;
+                    char number[16];
+                    copyValue(number, sizeof(number), value, valueLen);
+
+                    if (keyLen == 4 && memcmp(p, "name", 4) == 0) {
+                        copyValue(metadata.name, sizeof(metadata.name), value, valueLen);
+                    } else if (keyLen == 5 && memcmp(p, "index", 5) == 0) {
+                        metadata.index = (int)strtol(number, nullptr, 10);
+                    } else if (keyLen == 10 && memcmp(p, "confidence", 10) == 0) {
+                        metadata.confidence = strtof(number, nullptr);
+                    } else if (keyLen == 10 && memcmp(p, "latency_ms", 10) == 0) {
+                        metadata.latencyMs = (uint32_t)strtoul(number, nullptr, 10);
+                    } else if (keyLen == 8 && memcmp(p, "firmware", 8) == 0) {
+                        copyValue(metadata.firmware, sizeof(metadata.firmware), value, valueLen);
+                    }
+                }
+                p = lineEnd + 1;
+            }
+            return true;
+        }
+        pos += 2 + segmentLen;
+    }
+    return false;
+}
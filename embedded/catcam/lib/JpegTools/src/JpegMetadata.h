@@ -0,0 +1,50 @@
+#ifndef CATCAM_JPEGMETADATA_H
+#define CATCAM_JPEGMETADATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Inference result stored inside a saved JPEG
+ *
+ * Carried in an APP10 segment placed after SOI (and APP0, if present):
+ *
+ *   FF EA <length> "CatCamInf\0" <version> <payload>
+ *
+ * The payload is "key=value\n" text (name, index, confidence, latency_ms,
+ * firmware), so it is easy to read on the host as well. Unknown keys are
+ * skipped, missing ones keep their defaults.
+ */
+struct InferenceMetadata {
+    char name[24] = "";
+    int index = -1;
+    float confidence = 0.0f;
+    uint32_t latencyMs = 0;
+    char firmware[16] = "";
+};
+
+static constexpr uint8_t JPEG_METADATA_MARKER = 0xEA;  // APP10
+static constexpr uint8_t JPEG_METADATA_VERSION = 1;
+static constexpr size_t JPEG_METADATA_MAX_SEGMENT = 160;
+
+/**
+ * Build the complete segment, marker included
+ * @return Segment length in bytes, 0 if capacity is too small
+ */
+size_t buildJpegMetadataSegment(const InferenceMetadata& metadata, uint8_t* out, size_t capacity);
+
+/**
+ * Byte offset to insert the segment at: after SOI, and after APP0 since
+ * JFIF requires that to come first
+ * @return Offset, 0 if the data does not start with SOI
+ */
+size_t jpegMetadataInsertOffset(const uint8_t* jpeg, size_t size);
+
+/**
+ * Find and parse the segment among the header segments (stops at SOS).
+ * The segment sits near the start, so a prefix of the file is enough.
+ * @return true if a segment was found and parsed
+ */
+bool readJpegMetadata(const uint8_t* jpeg, size_t size, InferenceMetadata& metadata);
+
+#endif
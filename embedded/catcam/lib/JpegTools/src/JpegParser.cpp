@@ -0,0 +1,294 @@
+#include "JpegParser.h"
+
+const uint8_t JPEG_ZIGZAG_TO_NATURAL[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+bool JpegHuffmanTable::build() {
+    int32_t code = 0;
+    int32_t k = 0;
+    for (int len = 1; len <= 16; len++) {
+        valOffset[len] = k - code;
+        code += counts[len];
+        k += counts[len];
+        maxCode[len] = counts[len] ? code - 1 : -1;
+        if (code > (1 << len)) {
+            return false;
+        }
+        code <<= 1;
+    }
+    maxCode[17] = 0x7FFFFFFF;
+    if (k != symbolCount) {
+        return false;
+    }
+
+    // Short codes resolve with one table lookup
+    for (int i = 0; i < (1 << JPEG_HUFFMAN_FAST_BITS); i++) {
+        fast[i] = 0;
+    }
+    code = 0;
+    k = 0;
+    for (int len = 1; len <= JPEG_HUFFMAN_FAST_BITS; len++) {
+        for (int i = 0; i < counts[len]; i++, code++, k++) {
+            int shift = JPEG_HUFFMAN_FAST_BITS - len;
+            int first = code << shift;
+            for (int j = 0; j < (1 << shift); j++) {
+                fast[first + j] = (uint16_t)((len << 8) | symbols[k]);
+            }
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+int JpegInfo::blocksPerMcu() const {
+    if (scanComponentCount == 1) {
+        return 1;
+    }
+    int blocks = 0;
+    for (int i = 0; i < scanComponentCount; i++) {
+        const JpegComponent& c = components[scanComponents[i]];
+        blocks += c.h * c.v;
+    }
+    return blocks;
+}
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static bool parseDqt(const uint8_t* p, size_t len, JpegInfo& info) {
+    size_t pos = 0;
+    while (pos < len) {
+        uint8_t pq = p[pos] >> 4;
+        uint8_t tq = p[pos] & 0x0F;
+        pos++;
+        size_t entryBytes = pq ? 2 : 1;
+        if (tq >= JPEG_MAX_QUANT_TABLES || pos + 64 * entryBytes > len) {
+            return false;
+        }
+        for (int i = 0; i < 64; i++) {
+            info.quant[tq][i] = pq ? readU16(p + pos + i * 2) : p[pos + i];
+        }
+        info.quantPresent[tq] = true;
+        pos += 64 * entryBytes;
+    }
+    return true;
+}
+
+static bool parseDht(const uint8_t* p, size_t len, JpegInfo& info) {
+    size_t pos = 0;
+    while (pos < len) {
+        if (pos + 17 > len) {
+            return false;
+        }
+        uint8_t tc = p[pos] >> 4;
+        uint8_t th = p[pos] & 0x0F;
+        if (tc > 1 || th >= JPEG_MAX_HUFFMAN_TABLES) {
+            return false;
+        }
+        JpegHuffmanTable& table = tc == 0 ? info.dcTables[th] : info.acTables[th];
+        uint16_t total = 0;
+        table.counts[0] = 0;
+        for (int i = 1; i <= 16; i++) {
+            table.counts[i] = p[pos + i];
+            total += table.counts[i];
+        }
+        pos += 17;
+        if (total > 256 || pos + total > len) {
+            return false;
+        }
+        for (int i = 0; i < total; i++) {
+            table.symbols[i] = p[pos + i];
+        }
+        table.symbolCount = total;
+        pos += total;
+        if (!table.build()) {
+            return false;
+        }
+        table.present = true;
+    }
+    return true;
+}
+
+static bool parseSof(const uint8_t* p, size_t len, JpegInfo& info) {
+    if (len < 6 || p[0] != 8) {
+        info.error = "Only 8-bit precision supported";
+        return false;
+    }
+    info.height = readU16(p + 1);
+    info.width = readU16(p + 3);
+    info.componentCount = p[5];
+    if (info.width == 0 || info.height == 0) {
+        info.error = "Missing image dimensions";
+        return false;
+    }
+    if ((info.componentCount != 1 && info.componentCount != 3) || len < 6 + info.componentCount * 3u) {
+        info.error = "Unsupported component count";
+        return false;
+    }
+
+    info.hMax = 1;
+    info.vMax = 1;
+    for (int i = 0; i < info.componentCount; i++) {
+        JpegComponent& c = info.components[i];
+        const uint8_t* cp = p + 6 + i * 3;
+        c.id = cp[0];
+        c.h = cp[1] >> 4;
+        c.v = cp[1] & 0x0F;
+        c.quantTable = cp[2];
+        if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.quantTable >= JPEG_MAX_QUANT_TABLES) {
+            info.error = "Bad component parameters";
+            return false;
+        }
+        if (c.h > info.hMax) info.hMax = c.h;
+        if (c.v > info.vMax) info.vMax = c.v;
+    }
+
+    info.mcuWidth = info.hMax * 8;
+    info.mcuHeight = info.vMax * 8;
+    info.mcusX = (info.width + info.mcuWidth - 1) / info.mcuWidth;
+    info.mcusY = (info.height + info.mcuHeight - 1) / info.mcuHeight;
+    for (int i = 0; i < info.componentCount; i++) {
+        JpegComponent& c = info.components[i];
+        c.blocksPerLine = info.mcusX * c.h;
+        c.blocksPerColumn = info.mcusY * c.v;
+    }
+    return true;
+}
+
+static bool parseSos(const uint8_t* p, size_t len, JpegInfo& info) {
+    if (len < 1) {
+        return false;
+    }
+    uint8_t count = p[0];
+    if (count < 1 || count > info.componentCount || len < 1 + count * 2u + 3) {
+        info.error = "Bad scan header";
+        return false;
+    }
+    info.scanComponentCount = count;
+    for (int i = 0; i < count; i++) {
+        uint8_t id = p[1 + i * 2];
+        uint8_t tables = p[2 + i * 2];
+        int index = -1;
+        for (int c = 0; c < info.componentCount; c++) {
+            if (info.components[c].id == id) index = c;
+        }
+        if (index < 0) {
+            info.error = "Scan references unknown component";
+            return false;
+        }
+        JpegComponent& c = info.components[index];
+        c.dcTable = tables >> 4;
+        c.acTable = tables & 0x0F;
+        if (c.dcTable >= JPEG_MAX_HUFFMAN_TABLES || c.acTable >= JPEG_MAX_HUFFMAN_TABLES ||
+            !info.dcTables[c.dcTable].present || !info.acTables[c.acTable].present ||
+            !info.quantPresent[c.quantTable]) {
+            info.error = "Scan references missing table";
+            return false;
+        }
+        info.scanComponents[i] = (uint8_t)index;
+    }
+
+    const uint8_t* spectral = p + 1 + count * 2;
+    if (spectral[0] != 0 || spectral[1] != 63 || spectral[2] != 0) {
+        info.error = "Not a sequential scan";
+        return false;
+    }
+    return true;
+}
+
+bool parseJpeg(const uint8_t* data, size_t size, JpegInfo& info) {
+    info = JpegInfo();
+    info.size = size;
+
+    if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        info.error = "Missing SOI";
+        return false;
+    }
+
+    bool haveFrame = false;
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) {
+            info.error = "Expected marker";
+            return false;
+        }
+        uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {
+            pos++;  // Fill byte
+            continue;
+        }
+        if (marker == 0xD9) {
+            break;  // EOI before any scan
+        }
+
+        size_t segmentLen = readU16(data + pos + 2);
+        if (segmentLen < 2 || pos + 2 + segmentLen > size) {
+            info.error = "Truncated segment";
+            return false;
+        }
+        const uint8_t* payload = data + pos + 4;
+        size_t payloadLen = segmentLen - 2;
+
+        switch (marker) {
+            case 0xC0:  // Baseline
+            case 0xC1:  // Extended sequential, Huffman
+                info.sofOffset = pos;
+                if (!parseSof(payload, payloadLen, info)) {
+                    if (!info.error) info.error = "Bad frame header";
+                    return false;
+                }
+                haveFrame = true;
+                break;
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                info.error = "Progressive, lossless or arithmetic JPEG not supported";
+                return false;
+            case 0xC4:
+                if (!parseDht(payload, payloadLen, info)) {
+                    info.error = "Bad Huffman table";
+                    return false;
+                }
+                break;
+            case 0xDB:
+                if (!parseDqt(payload, payloadLen, info)) {
+                    info.error = "Bad quantisation table";
+                    return false;
+                }
+                break;
+            case 0xDD:
+                if (payloadLen < 2) {
+                    info.error = "Bad restart interval";
+                    return false;
+                }
+                info.driOffset = pos;
+                info.restartInterval = readU16(payload);
+                break;
+            case 0xDA:
+                if (!haveFrame) {
+                    info.error = "Scan before frame header";
+                    return false;
+                }
+                if (!parseSos(payload, payloadLen, info)) {
+                    return false;
+                }
+                info.sosOffset = pos;
+                info.scanOffset = pos + 2 + segmentLen;
+                return true;
+            default:
+                break;  // APPn, COM and anything else we don't need
+        }
+        pos += 2 + segmentLen;
+    }
+
+    info.error = "No scan found";
+    return false;
+}
@@ -0,0 +1,105 @@
+#ifndef CATCAM_JPEGPARSER_H
+#define CATCAM_JPEGPARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * JpegParser - Marker-level parser for baseline JPEGs from the camera
+ *
+ * Reads the tables and frame/scan headers needed to walk the entropy-coded
+ * data without a full decode: quantisation tables, Huffman tables, SOF0/SOF1,
+ * DRI and the first SOS. Progressive and arithmetic-coded files are rejected.
+ *
+ * Plain C++ with no Arduino or camera dependency so the JpegTools kernels can
+ * be built and run on the host against captured images.
+ */
+
+static constexpr int JPEG_MAX_COMPONENTS = 3;
+static constexpr int JPEG_MAX_HUFFMAN_TABLES = 2;  // Baseline allows two DC and two AC tables
+static constexpr int JPEG_MAX_QUANT_TABLES = 4;
+static constexpr int JPEG_HUFFMAN_FAST_BITS = 9;
+
+/**
+ * Natural (row-major) index of each zigzag position
+ */
+extern const uint8_t JPEG_ZIGZAG_TO_NATURAL[64];
+
+struct JpegHuffmanTable {
+    bool present = false;
+    uint8_t counts[17] = {};       // counts[len] = number of codes of length len (1..16)
+    uint8_t symbols[256] = {};
+    uint16_t symbolCount = 0;
+
+    // Canonical decode state, filled by build()
+    int32_t maxCode[18] = {};      // Largest code of each length, -1 if none
+    int32_t valOffset[17] = {};    // symbols[] index = code + valOffset[len]
+    uint16_t fast[1 << JPEG_HUFFMAN_FAST_BITS] = {};  // (len << 8) | symbol for short codes, 0 = slow path
+
+    /**
+     * Derive decode tables from counts/symbols
+     * @return false if the code lengths are not a valid prefix code
+     */
+    bool build();
+};
+
+struct JpegComponent {
+    uint8_t id = 0;
+    uint8_t h = 1;              // Horizontal sampling factor
+    uint8_t v = 1;              // Vertical sampling factor
+    uint8_t quantTable = 0;
+    uint8_t dcTable = 0;        // From SOS
+    uint8_t acTable = 0;        // From SOS
+    uint16_t blocksPerLine = 0; // Block grid including MCU padding
+    uint16_t blocksPerColumn = 0;
+};
+
+struct JpegInfo {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t componentCount = 0;
+    JpegComponent components[JPEG_MAX_COMPONENTS];
+
+    uint16_t quant[JPEG_MAX_QUANT_TABLES][64] = {};  // Zigzag order
+    bool quantPresent[JPEG_MAX_QUANT_TABLES] = {};
+    JpegHuffmanTable dcTables[JPEG_MAX_HUFFMAN_TABLES];
+    JpegHuffmanTable acTables[JPEG_MAX_HUFFMAN_TABLES];
+
+    uint16_t restartInterval = 0;   // MCUs between RST markers, 0 = none
+
+    uint8_t hMax = 1;
+    uint8_t vMax = 1;
+    uint16_t mcuWidth = 8;          // Pixels
+    uint16_t mcuHeight = 8;
+    uint16_t mcusX = 0;
+    uint16_t mcusY = 0;
+
+    // Components in the first scan, as indices into components[]
+    uint8_t scanComponentCount = 0;
+    uint8_t scanComponents[JPEG_MAX_COMPONENTS] = {};
+
+    // Byte offsets into the source buffer
+    size_t sofOffset = 0;           // SOF marker
+    size_t driOffset = 0;           // DRI marker (0 if absent)
+    size_t sosOffset = 0;           // SOS marker
+    size_t scanOffset = 0;          // First entropy-coded byte
+    size_t size = 0;                // Size of the whole buffer
+
+    const char* error = nullptr;    // Set when parsing fails
+
+    /**
+     * Number of blocks one MCU holds for the first scan
+     */
+    int blocksPerMcu() const;
+};
+
+/**
+ * Parse headers up to and including the first SOS
+ * @param data JPEG buffer (must start with SOI)
+ * @param size Buffer size
+ * @param info Filled on success; info.error describes a failure
+ * @return true if the file is a supported baseline JPEG
+ */
+bool parseJpeg(const uint8_t* data, size_t size, JpegInfo& info);
+
+#endif
@@ -0,0 +1,162 @@
+#include "JpegScaledDecoder.h"
+#include <math.h>
+#include <string.h>
+#include "JpegBlockDecoder.h"
+
+namespace {
+
+constexpr int MAX_SAMPLES = 4;  // Output pixels per block side at 1/2 scale
+
+inline uint8_t clampSample(float value) {
+    int v = (int)lrintf(value);
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+class ScaledSink : public JpegBlockSink {
+public:
+    struct Target {
+        uint8_t* plane = nullptr;
+        size_t stride = 0;
+        const uint16_t* quant = nullptr;
+    };
+
+    ScaledSink(int samples) : _samples(samples) {
+        // weight[q][u]: C(u) x mean of cos((2x+1)u.pi/16) over the samples output q covers
+        int footprint = 8 / samples;
+        for (int q = 0; q < samples; q++) {
+            for (int u = 0; u < 8; u++) {
+                float sum = 0.0f;
+                for (int x = q * footprint; x < (q + 1) * footprint; x++) {
+                    sum += cosf((2 * x + 1) * u * (float)M_PI / 16.0f);
+                }
+                float weight = sum / footprint * (u == 0 ? (float)M_SQRT1_2 : 1.0f);
+                _weight[q][u] = fabsf(weight) < 1e-6f ? 0.0f : weight;
+            }
+        }
+    }
+
+    Target targets[JPEG_MAX_COMPONENTS];
+
+    bool onBlock(const JpegBlock& block) override {
+        const Target& t = targets[block.component];
+        if (!t.plane) {
+            return true;
+        }
+        uint8_t* out = t.plane + (size_t)block.blockY * _samples * t.stride + (size_t)block.blockX * _samples;
+
+        // DC only: every output pixel is the block mean
+        if (_samples == 1 || block.lastNonZero == 0) {
+            uint8_t mean = clampSample(block.coef[0] * t.quant[0] / 8.0f + 128.0f);
+            for (int y = 0; y < _samples; y++) {
+                memset(out + y * t.stride, mean, _samples);
+            }
+            return true;
+        }
+
+        float coef[64] = {};
+        uint8_t rowUsed = 0;
+        for (int k = 0; k <= block.lastNonZero; k++) {
+            if (block.coef[k]) {
+                int natural = JPEG_ZIGZAG_TO_NATURAL[k];
+                coef[natural] = (float)(block.coef[k] * t.quant[k]);
+                rowUsed |= (uint8_t)(1 << (natural >> 3));
+            }
+        }
+
+        // Separable: reduce each row to _samples columns, then the columns
+        float rows[8][MAX_SAMPLES];
+        for (int v = 0; v < 8; v++) {
+            if (!(rowUsed & (1 << v))) continue;
+            for (int qx = 0; qx < _samples; qx++) {
+                float sum = 0.0f;
+                for (int u = 0; u < 8; u++) {
+                    sum += _weight[qx][u] * coef[v * 8 + u];
+                }
+                rows[v][qx] = sum;
+            }
+        }
+        for (int qy = 0; qy < _samples; qy++) {
+            for (int qx = 0; qx < _samples; qx++) {
+                float sum = 0.0f;
+                for (int v = 0; v < 8; v++) {
+                    if (rowUsed & (1 << v)) {
+                        sum += _weight[qy][v] * rows[v][qx];
+                    }
+                }
+                out[qy * t.stride + qx] = clampSample(sum * 0.25f + 128.0f);
+            }
+        }
+        return true;
+    }
+
+private:
+    int _samples;
+    float _weight[MAX_SAMPLES][8];
+};
+
+}
+
+bool JpegScaledDecoder::decode(const uint8_t* jpeg, size_t size, uint8_t scaleDenominator) {
+    _width = _height = 0;
+    if (!parseJpeg(jpeg, size, _info)) {
+        return false;
+    }
+    if (scaleDenominator != 8 && scaleDenominator != 4 && scaleDenominator != 2) {
+        _info.error = "Scale must be 1/8, 1/4 or 1/2";
+        return false;
+    }
+    if (_info.scanComponentCount != _info.componentCount) {
+        _info.error = "Not all components in first scan";
+        return false;
+    }
+
+    // Decode each component at its own resolution first (MCU padding included)
+    int samples = 8 / scaleDenominator;
+    ScaledSink sink(samples);
+    std::vector<uint8_t> component[JPEG_MAX_COMPONENTS];
+    for (int c = 0; c < _info.componentCount; c++) {
+        const JpegComponent& comp = _info.components[c];
+        size_t stride = (size_t)comp.blocksPerLine * samples;
+        component[c].assign(stride * comp.blocksPerColumn * samples, 128);
+        sink.targets[c].plane = component[c].data();
+        sink.targets[c].stride = stride;
+        sink.targets[c].quant = _info.quant[comp.quantTable];
+    }
+    JpegDecodeMode mode = samples == 1 ? JpegDecodeMode::DcOnly : JpegDecodeMode::Full;
+    if (!decodeJpegBlocks(jpeg, _info, sink, mode)) {
+        _info.error = "Corrupt entropy-coded data";
+        return false;
+    }
+
+    // Crop to the visible area and bring subsampled chroma up to the luma grid
+    _width = (uint16_t)((_info.width + scaleDenominator - 1) / scaleDenominator);
+    _height = (uint16_t)((_info.height + scaleDenominator - 1) / scaleDenominator);
+    for (int c = 0; c < _info.componentCount; c++) {
+        const JpegComponent& comp = _info.components[c];
+        size_t stride = (size_t)comp.blocksPerLine * samples;
+        _planes[c].resize((size_t)_width * _height);
+        if (comp.h == _info.hMax && comp.v == _info.vMax) {
+            for (int y = 0; y < _height; y++) {
+                memcpy(&_planes[c][(size_t)y * _width], &component[c][y * stride], _width);
+            }
+            continue;
+        }
+        for (int y = 0; y < _height; y++) {
+            const uint8_t* src = &component[c][(size_t)(y * comp.v / _info.vMax) * stride];
+            uint8_t* dst = &_planes[c][(size_t)y * _width];
+            for (int x = 0; x < _width; x++) {
+                dst[x] = src[x * comp.h / _info.hMax];
+            }
+        }
+    }
+    for (int c = _info.componentCount; c < JPEG_MAX_COMPONENTS; c++) {
+        _planes[c].clear();
+    }
+    return true;
+}
+
+void JpegScaledDecoder::release() {
+    for (int c = 0; c < JPEG_MAX_COMPONENTS; c++) {
+        std::vector<uint8_t>().swap(_planes[c]);
+    }
+}
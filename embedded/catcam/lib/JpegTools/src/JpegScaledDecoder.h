@@ -0,0 +1,51 @@
+#ifndef CATCAM_JPEGSCALEDDECODER_H
+#define CATCAM_JPEGSCALEDDECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "JpegParser.h"
+
+/**
+ * JpegScaledDecoder - Decodes a JPEG straight to 1/8, 1/4 or 1/2 scale
+ *
+ * Each 8x8 block becomes 1, 2x2 or 4x4 pixels, each the mean of the samples
+ * it covers. That mean only depends on the DC and the odd-frequency AC terms
+ * (even ones average out to zero over a half or quarter block), so no full
+ * IDCT is run, and at 1/8 the AC codes are skipped altogether. Output is
+ * planar Y (and Cb/Cr for colour images, upsampled to the luma grid).
+ */
+class JpegScaledDecoder {
+public:
+    /**
+     * @param scaleDenominator 8, 4 or 2
+     * @return false if the JPEG is unsupported or corrupt (see error())
+     */
+    bool decode(const uint8_t* jpeg, size_t size, uint8_t scaleDenominator);
+
+    uint16_t width() const { return _width; }
+    uint16_t height() const { return _height; }
+    uint8_t componentCount() const { return _info.componentCount; }
+
+    /**
+     * width() x height() samples of component c (0 = Y, 1 = Cb, 2 = Cr)
+     */
+    const uint8_t* plane(int c) const { return _planes[c].data(); }
+
+    /**
+     * Drop the planes (keeps nothing allocated between images)
+     */
+    void release();
+
+    const JpegInfo& info() const { return _info; }
+    const char* error() const { return _info.error; }
+
+private:
+    JpegInfo _info;
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    std::vector<uint8_t> _planes[JPEG_MAX_COMPONENTS];
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "JpegSharpness.h"
+#include "JpegBlockDecoder.h"
+#include <math.h>
+
+namespace {
+
+class AcEnergySink : public JpegBlockSink {
+public:
+    AcEnergySink(const uint16_t* quant, uint16_t width, uint16_t height)
+        : _quant(quant), _width(width), _height(height) {}
+
+    bool onBlock(const JpegBlock& block) override {
+        if (block.component != 0 || block.blockX >= _width || block.blockY >= _height) {
+            return true;
+        }
+        for (int k = JpegSharpness::FIRST_COEFFICIENT; k <= block.lastNonZero; k++) {
+            int32_t value = (int32_t)block.coef[k] * _quant[k];
+            _energy += (uint64_t)((int64_t)value * value);
+        }
+        _blocks++;
+        return true;
+    }
+
+    float rms() const {
+        int coefficients = 64 - JpegSharpness::FIRST_COEFFICIENT;
+        return _blocks ? sqrtf((float)((double)_energy / ((double)_blocks * coefficients))) : 0.0f;
+    }
+
+private:
+    const uint16_t* _quant;
+    uint16_t _width;
+    uint16_t _height;
+    uint64_t _energy = 0;
+    uint32_t _blocks = 0;
+};
+
+}
+
+bool JpegSharpness::score(const uint8_t* jpeg, size_t size, float& score) {
+    score = 0.0f;
+    if (!parseJpeg(jpeg, size, _info)) {
+        return false;
+    }
+
+    bool lumaInScan = false;
+    for (int i = 0; i < _info.scanComponentCount; i++) {
+        lumaInScan |= _info.scanComponents[i] == 0;
+    }
+    if (!lumaInScan) {
+        _info.error = "Luma not in first scan";
+        return false;
+    }
+
+    const JpegComponent& luma = _info.components[0];
+    uint16_t lumaWidth = (uint16_t)((_info.width * luma.h + _info.hMax - 1) / _info.hMax);
+    uint16_t lumaHeight = (uint16_t)((_info.height * luma.v + _info.vMax - 1) / _info.vMax);
+
+    AcEnergySink sink(_info.quant[luma.quantTable], (uint16_t)((lumaWidth + 7) / 8), (uint16_t)((lumaHeight + 7) / 8));
+    if (!decodeJpegBlocks(jpeg, _info, sink, JpegDecodeMode::Full)) {
+        _info.error = "Corrupt entropy-coded data";
+        return false;
+    }
+    score = sink.rms();
+    return true;
+}
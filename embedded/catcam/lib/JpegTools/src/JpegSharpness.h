@@ -0,0 +1,37 @@
+#ifndef CATCAM_JPEGSHARPNESS_H
+#define CATCAM_JPEGSHARPNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+
+/**
+ * JpegSharpness - Focus/motion-blur score read from JPEG AC coefficients
+ *
+ * Blur removes high spatial frequencies, which in a JPEG means the AC terms
+ * past the first few zigzag positions. The score is the RMS of those luma
+ * coefficients after dequantisation (so frames at different JPEG qualities
+ * stay comparable), averaged over all visible blocks. Needs one full entropy
+ * pass but no IDCT. Only meaningful for comparing frames of the same scene,
+ * e.g. the frames of a burst.
+ */
+class JpegSharpness {
+public:
+    // Zigzag positions below this are ignored - they carry shading, not edges
+    static constexpr int FIRST_COEFFICIENT = 6;
+
+    /**
+     * Score a JPEG
+     * @param score Receives the sharpness (higher = sharper)
+     * @return false if the JPEG is unsupported or corrupt (see error())
+     */
+    bool score(const uint8_t* jpeg, size_t size, float& score);
+
+    const char* error() const { return _info.error; }
+
+private:
+    JpegInfo _info;
+};
+
+#endif
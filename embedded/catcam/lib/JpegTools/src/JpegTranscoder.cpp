@@ -0,0 +1,392 @@
+#include "JpegTranscoder.h"
+#include "JpegBlockDecoder.h"
+#include "JpegEncoder.h"
+#include <string.h>
+
+namespace {
+
+inline int magnitudeCategory(int value) {
+    unsigned int magnitude = (unsigned int)(value < 0 ? -value : value);
+    int bits = 0;
+    while (magnitude) {
+        bits++;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+// Rounds to the nearest step of the target table, halves away from zero
+void requantizeBlock(const JpegBlock& block, const uint32_t* scale, int16_t* coef) {
+    memset(coef, 0, 64 * sizeof(int16_t));
+    for (int k = 0; k <= block.lastNonZero; k++) {
+        int value = block.coef[k];
+        if (value == 0) {
+            continue;
+        }
+        uint32_t magnitude = (uint32_t)(value < 0 ? -value : value);
+        magnitude = (magnitude * scale[k] + 0x8000) >> 16;
+        coef[k] = (int16_t)(value < 0 ? -(int)magnitude : (int)magnitude);
+    }
+}
+
+// Same symbol sequence encodeJpegBlock() emits
+void countBlockSymbols(const int16_t* coef, int& predictor, uint32_t* dcFreq, uint32_t* acFreq) {
+    int diff = coef[0] - predictor;
+    predictor = coef[0];
+    dcFreq[magnitudeCategory(diff)]++;
+
+    int last = 63;
+    while (last > 0 && coef[last] == 0) {
+        last--;
+    }
+
+    int run = 0;
+    for (int k = 1; k <= last; k++) {
+        if (coef[k] == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            acFreq[0xF0]++;  // ZRL
+            run -= 16;
+        }
+        acFreq[(run << 4) | magnitudeCategory(coef[k])]++;
+        run = 0;
+    }
+
+    if (last < 63) {
+        acFreq[0x00]++;  // EOB
+    }
+}
+
+// ITU T.81 Annex K.2: code lengths from symbol frequencies, limited to 16 bits
+void buildOptimalTable(const uint32_t* frequencies, JpegHuffmanTable& table) {
+    static constexpr int MAX_CODE_LENGTH = 64;  // Deeper than 32-bit counts can reach
+
+    uint32_t freq[257];
+    int codeSize[257];
+    int others[257];
+    for (int i = 0; i < 256; i++) {
+        freq[i] = frequencies[i];
+    }
+    freq[256] = 1;  // Reserved symbol, so no real code is all ones
+    for (int i = 0; i < 257; i++) {
+        codeSize[i] = 0;
+        others[i] = -1;
+    }
+
+    for (;;) {
+        // Two least frequent nodes; ties go to the higher symbol
+        int c1 = -1;
+        uint32_t v = UINT32_MAX;
+        for (int i = 0; i <= 256; i++) {
+            if (freq[i] && freq[i] <= v) {
+                v = freq[i];
+                c1 = i;
+            }
+        }
+        int c2 = -1;
+        v = UINT32_MAX;
+        for (int i = 0; i <= 256; i++) {
+            if (freq[i] && freq[i] <= v && i != c1) {
+                v = freq[i];
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+
+        freq[c1] += freq[c2];
+        freq[c2] = 0;
+        codeSize[c1]++;
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            codeSize[c1]++;
+        }
+        others[c1] = c2;
+        codeSize[c2]++;
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            codeSize[c2]++;
+        }
+    }
+
+    int bits[MAX_CODE_LENGTH + 1] = {};
+    for (int i = 0; i <= 256; i++) {
+        if (codeSize[i]) {
+            bits[codeSize[i] < MAX_CODE_LENGTH ? codeSize[i] : MAX_CODE_LENGTH]++;
+        }
+    }
+    for (int i = MAX_CODE_LENGTH; i > 16; i--) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) {
+                j--;
+            }
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+    int longest = 16;
+    while (longest > 0 && bits[longest] == 0) {
+        longest--;
+    }
+    if (longest > 0) {
+        bits[longest]--;  // Drop the reserved symbol's code
+    }
+
+    table = JpegHuffmanTable();
+    table.present = true;
+    for (int len = 1; len <= 16; len++) {
+        table.counts[len] = (uint8_t)bits[len];
+    }
+    // Symbols in order of code length, then value; the reserved one sorts last
+    for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+        for (int s = 0; s < 256; s++) {
+            if (codeSize[s] == len) {
+                table.symbols[table.symbolCount++] = (uint8_t)s;
+            }
+        }
+    }
+}
+
+void writeWord(JpegBitWriter& writer, uint16_t value) {
+    uint8_t bytes[2] = {(uint8_t)(value >> 8), (uint8_t)value};
+    writer.writeBytes(bytes, 2);
+}
+
+class CountSink : public JpegBlockSink {
+public:
+    CountSink(const JpegInfo& info, const uint32_t (*scale)[64],
+              uint32_t (*dcFreq)[256], uint32_t (*acFreq)[256])
+        : _info(info), _scale(scale), _dcFreq(dcFreq), _acFreq(acFreq) {}
+
+    bool onBlock(const JpegBlock& block) override {
+        const JpegComponent& c = _info.components[block.component];
+        int16_t coef[64];
+        requantizeBlock(block, _scale[c.quantTable], coef);
+        countBlockSymbols(coef, _predictors[block.component], _dcFreq[c.dcTable], _acFreq[c.acTable]);
+        return true;
+    }
+
+private:
+    const JpegInfo& _info;
+    const uint32_t (*_scale)[64];
+    uint32_t (*_dcFreq)[256];
+    uint32_t (*_acFreq)[256];
+    int _predictors[JPEG_MAX_COMPONENTS] = {};
+};
+
+class EncodeSink : public JpegBlockSink {
+public:
+    EncodeSink(JpegBitWriter& writer, const JpegInfo& info, const uint32_t (*scale)[64],
+               const JpegHuffmanEncoder* dcEncoders, const JpegHuffmanEncoder* acEncoders)
+        : _writer(writer), _info(info), _scale(scale), _dcEncoders(dcEncoders), _acEncoders(acEncoders) {}
+
+    bool onBlock(const JpegBlock& block) override {
+        const JpegComponent& c = _info.components[block.component];
+        int16_t coef[64];
+        requantizeBlock(block, _scale[c.quantTable], coef);
+        if (!encodeJpegBlock(_writer, _dcEncoders[c.dcTable], _acEncoders[c.acTable],
+                             coef, _predictors[block.component])) {
+            failed = true;
+            return false;
+        }
+        return !_writer.overflow();
+    }
+
+    bool failed = false;
+
+private:
+    JpegBitWriter& _writer;
+    const JpegInfo& _info;
+    const uint32_t (*_scale)[64];
+    const JpegHuffmanEncoder* _dcEncoders;
+    const JpegHuffmanEncoder* _acEncoders;
+    int _predictors[JPEG_MAX_COMPONENTS] = {};
+};
+
+}
+
+bool JpegTranscoder::load(const uint8_t* jpeg, size_t size) {
+    _error = nullptr;
+    _jpeg = nullptr;
+
+    if (!parseJpeg(jpeg, size, _info)) {
+        _error = _info.error;
+        return false;
+    }
+    if (_info.scanComponentCount != _info.componentCount) {
+        _error = "Multi-scan JPEG not supported";
+        return false;
+    }
+
+    _jpeg = jpeg;
+    return true;
+}
+
+void JpegTranscoder::buildTargetQuant(int quality) {
+    uint16_t standard[2][64];
+    jpegStandardQuantTable(false, quality, standard[0]);
+    jpegStandardQuantTable(true, quality, standard[1]);
+
+    for (int t = 0; t < JPEG_MAX_QUANT_TABLES; t++) {
+        if (!_info.quantPresent[t]) {
+            continue;
+        }
+        // Whichever table the first component uses is the luma one
+        const uint16_t* target = standard[t == _info.components[0].quantTable ? 0 : 1];
+        for (int k = 0; k < 64; k++) {
+            uint16_t step = _info.quant[t][k];
+            uint16_t coarser = target[k] > step ? target[k] : step;
+            _quant[t][k] = coarser;
+            _scale[t][k] = ((uint32_t)step << 16) / coarser;
+        }
+    }
+}
+
+bool JpegTranscoder::writeHeaders(JpegBitWriter& writer) {
+    writer.writeMarker(0xD8);  // SOI
+
+    // APPn and COM (JFIF, embedded inference result) go across unchanged;
+    // DQT and DHT are rewritten below and DRI is dropped
+    size_t pos = 2;
+    while (pos + 4 <= _info.sosOffset) {
+        if (_jpeg[pos] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = _jpeg[pos + 1];
+        if (marker == 0xFF) {
+            pos++;  // Fill byte
+            continue;
+        }
+        size_t segmentLen = 2 + (((size_t)_jpeg[pos + 2] << 8) | _jpeg[pos + 3]);
+        if ((marker >= 0xE0 && marker <= 0xEF) || marker == 0xFE) {
+            writer.writeBytes(_jpeg + pos, segmentLen);
+        }
+        pos += segmentLen;
+    }
+
+    for (int t = 0; t < JPEG_MAX_QUANT_TABLES; t++) {
+        if (!_info.quantPresent[t]) {
+            continue;
+        }
+        // 16-bit precision only if a source step above 255 survived
+        bool wide = false;
+        for (int k = 0; k < 64; k++) {
+            wide |= _quant[t][k] > 255;
+        }
+        writer.writeMarker(0xDB);  // DQT
+        writeWord(writer, 2 + 1 + (wide ? 128 : 64));
+        uint8_t id = (uint8_t)((wide ? 0x10 : 0x00) | t);
+        writer.writeBytes(&id, 1);
+        for (int k = 0; k < 64; k++) {
+            if (wide) {
+                writeWord(writer, _quant[t][k]);
+            } else {
+                uint8_t step = (uint8_t)_quant[t][k];
+                writer.writeBytes(&step, 1);
+            }
+        }
+    }
+
+    size_t sofLen = 2 + (((size_t)_jpeg[_info.sofOffset + 2] << 8) | _jpeg[_info.sofOffset + 3]);
+    writer.writeBytes(_jpeg + _info.sofOffset, sofLen);
+
+    uint16_t length = 2;
+    for (int t = 0; t < JPEG_MAX_HUFFMAN_TABLES; t++) {
+        if (_dcUsed[t]) length += 17 + _dcTables[t].symbolCount;
+        if (_acUsed[t]) length += 17 + _acTables[t].symbolCount;
+    }
+    writer.writeMarker(0xC4);  // DHT
+    writeWord(writer, length);
+    for (int cls = 0; cls < 2; cls++) {
+        for (int t = 0; t < JPEG_MAX_HUFFMAN_TABLES; t++) {
+            if (!(cls == 0 ? _dcUsed[t] : _acUsed[t])) {
+                continue;
+            }
+            const JpegHuffmanTable& table = cls == 0 ? _dcTables[t] : _acTables[t];
+            uint8_t id = (uint8_t)((cls << 4) | t);
+            writer.writeBytes(&id, 1);
+            writer.writeBytes(table.counts + 1, 16);
+            writer.writeBytes(table.symbols, table.symbolCount);
+        }
+    }
+
+    writer.writeBytes(_jpeg + _info.sosOffset, _info.scanOffset - _info.sosOffset);  // SOS
+    return true;
+}
+
+bool JpegTranscoder::transcode(int quality, uint8_t* out, size_t capacity, size_t& outSize) {
+    outSize = 0;
+    if (!_jpeg) {
+        if (!_error) _error = "No JPEG loaded";
+        return false;
+    }
+    _error = nullptr;
+
+    buildTargetQuant(quality);
+
+    // Pass 1: symbol statistics of the requantised coefficients
+    memset(_dcFreq, 0, sizeof(_dcFreq));
+    memset(_acFreq, 0, sizeof(_acFreq));
+    CountSink counter(_info, _scale, _dcFreq, _acFreq);
+    if (!decodeJpegBlocks(_jpeg, _info, counter, JpegDecodeMode::Full)) {
+        _error = "Corrupt entropy-coded data";
+        return false;
+    }
+
+    for (int t = 0; t < JPEG_MAX_HUFFMAN_TABLES; t++) {
+        _dcUsed[t] = false;
+        _acUsed[t] = false;
+    }
+    for (int i = 0; i < _info.componentCount; i++) {
+        _dcUsed[_info.components[i].dcTable] = true;
+        _acUsed[_info.components[i].acTable] = true;
+    }
+    for (int t = 0; t < JPEG_MAX_HUFFMAN_TABLES; t++) {
+        if (_dcUsed[t]) {
+            buildOptimalTable(_dcFreq[t], _dcTables[t]);
+            _dcEncoders[t].build(_dcTables[t]);
+        }
+        if (_acUsed[t]) {
+            buildOptimalTable(_acFreq[t], _acTables[t]);
+            _acEncoders[t].build(_acTables[t]);
+        }
+    }
+
+    // Pass 2: the same coefficients through the new tables
+    JpegBitWriter writer;
+    writer.init(out, capacity);
+    if (!writeHeaders(writer)) {
+        _error = "Corrupt header segments";
+        return false;
+    }
+    if (writer.overflow()) {
+        _error = "Output buffer too small";
+        return false;
+    }
+
+    EncodeSink sink(writer, _info, _scale, _dcEncoders, _acEncoders);
+    if (!decodeJpegBlocks(_jpeg, _info, sink, JpegDecodeMode::Full)) {
+        _error = "Corrupt entropy-coded data";
+        return false;
+    }
+    if (sink.failed) {
+        _error = "Huffman table lacks a needed code";
+        return false;
+    }
+
+    writer.flush();
+    writer.writeMarker(0xD9);  // EOI
+    if (writer.overflow()) {
+        _error = "Output buffer too small";
+        return false;
+    }
+
+    outSize = writer.size();
+    return true;
+}
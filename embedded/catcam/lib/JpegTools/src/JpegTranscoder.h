@@ -0,0 +1,67 @@
+#ifndef CATCAM_JPEGTRANSCODER_H
+#define CATCAM_JPEGTRANSCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "JpegParser.h"
+#include "JpegBitWriter.h"
+
+/**
+ * JpegTranscoder - Shrink a baseline JPEG without decoding it to pixels
+ *
+ * Works on the quantised DCT coefficients: each one is requantised to a
+ * coarser table (the standard tables at the requested IJG quality, never
+ * finer than the source's own steps) and the scan is re-encoded with
+ * Huffman tables built for this image (ITU T.81 Annex K.2) rather than the
+ * generic ones the sensor uses. No IDCT or colour conversion.
+ *
+ * Two entropy decodes per frame: the first counts symbols to build the
+ * tables, the second writes the output. APPn and COM segments are kept,
+ * restart markers are dropped.
+ */
+class JpegTranscoder {
+public:
+    /**
+     * Parse a source JPEG. The buffer must stay valid until transcode() has returned.
+     * @return false if the source is unsupported (see error())
+     */
+    bool load(const uint8_t* jpeg, size_t size);
+
+    /**
+     * Transcode the loaded JPEG into a caller-supplied buffer
+     * @param quality 1-100, IJG scaling of the target tables; 100 keeps the
+     *                source's quantisation and only re-optimises the Huffman tables
+     * @param capacity Output buffer size (source size + 2 KB is always enough)
+     * @param outSize Bytes written on success
+     * @return false if nothing is loaded or the output did not fit (see error())
+     */
+    bool transcode(int quality, uint8_t* out, size_t capacity, size_t& outSize);
+
+    const char* error() const { return _error; }
+
+    /**
+     * Headers of the loaded source
+     */
+    const JpegInfo& info() const { return _info; }
+
+private:
+    JpegInfo _info;
+    const uint8_t* _jpeg = nullptr;
+    uint16_t _quant[JPEG_MAX_QUANT_TABLES][64];    // Target steps, zigzag order
+    uint32_t _scale[JPEG_MAX_QUANT_TABLES][64];    // Source step / target step, 16.16 fixed point
+    uint32_t _dcFreq[JPEG_MAX_HUFFMAN_TABLES][256];
+    uint32_t _acFreq[JPEG_MAX_HUFFMAN_TABLES][256];
+    JpegHuffmanTable _dcTables[JPEG_MAX_HUFFMAN_TABLES];
+    JpegHuffmanTable _acTables[JPEG_MAX_HUFFMAN_TABLES];
+    JpegHuffmanEncoder _dcEncoders[JPEG_MAX_HUFFMAN_TABLES];
+    JpegHuffmanEncoder _acEncoders[JPEG_MAX_HUFFMAN_TABLES];
+    bool _dcUsed[JPEG_MAX_HUFFMAN_TABLES];
+    bool _acUsed[JPEG_MAX_HUFFMAN_TABLES];
+    const char* _error = nullptr;
+
+    void buildTargetQuant(int quality);
+    bool writeHeaders(JpegBitWriter& writer);
+};
+
+#endif
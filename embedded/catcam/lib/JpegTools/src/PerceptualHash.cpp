@@ -0,0 +1,91 @@
+#include "PerceptualHash.h"
+#include <algorithm>
+#include <math.h>
+
+namespace {
+
+constexpr int GRID = 32;    // Region is resampled to GRID x GRID
+constexpr int BAND = 8;     // Lowest BAND x BAND frequencies form the hash
+
+// cosines[u][x] = cos((2x + 1) u pi / 2N); normalisation does not change the bits
+float cosines[BAND][GRID];
+bool cosinesReady = false;
+
+void buildCosines() {
+    for (int u = 0; u < BAND; u++) {
+        for (int x = 0; x < GRID; x++) {
+            cosines[u][x] = cosf((2 * x + 1) * u * (float)M_PI / (2 * GRID));
+        }
+    }
+    cosinesReady = true;
+}
+
+}
+
+bool perceptualHash(const DcLumaMap& map, int x, int y, int width, int height, uint64_t& hash) {
+    int x0 = std::max(0, x);
+    int y0 = std::max(0, y);
+    int x1 = std::min((int)map.width(), x + width);
+    int y1 = std::min((int)map.height(), y + height);
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+    if (!cosinesReady) {
+        buildCosines();
+    }
+
+    // Box-average into the grid; a region smaller than the grid repeats cells
+    int regionW = x1 - x0;
+    int regionH = y1 - y0;
+    float grid[GRID][GRID];
+    for (int gy = 0; gy < GRID; gy++) {
+        int sy0 = y0 + gy * regionH / GRID;
+        int sy1 = std::max(sy0 + 1, y0 + (gy + 1) * regionH / GRID);
+        for (int gx = 0; gx < GRID; gx++) {
+            int sx0 = x0 + gx * regionW / GRID;
+            int sx1 = std::max(sx0 + 1, x0 + (gx + 1) * regionW / GRID);
+            uint32_t sum = 0;
+            for (int sy = sy0; sy < sy1; sy++) {
+                for (int sx = sx0; sx < sx1; sx++) {
+                    sum += map.at(sx, sy);
+                }
+            }
+            grid[gy][gx] = (float)sum / ((sy1 - sy0) * (sx1 - sx0));
+        }
+    }
+
+    // Separable DCT, low band only: rows first, then columns
+    float rows[GRID][BAND];
+    for (int gy = 0; gy < GRID; gy++) {
+        for (int u = 0; u < BAND; u++) {
+            float sum = 0.0f;
+            for (int gx = 0; gx < GRID; gx++) {
+                sum += grid[gy][gx] * cosines[u][gx];
+            }
+            rows[gy][u] = sum;
+        }
+    }
+    float coef[BAND * BAND];
+    for (int v = 0; v < BAND; v++) {
+        for (int u = 0; u < BAND; u++) {
+            float sum = 0.0f;
+            for (int gy = 0; gy < GRID; gy++) {
+                sum += rows[gy][u] * cosines[v][gy];
+            }
+            coef[v * BAND + u] = sum;
+        }
+    }
+
+    float ac[BAND * BAND - 1];
+    std::copy(coef + 1, coef + BAND * BAND, ac);
+    std::nth_element(ac, ac + (BAND * BAND - 1) / 2, ac + BAND * BAND - 1);
+    float median = ac[(BAND * BAND - 1) / 2];
+
+    hash = 0;
+    for (int i = 1; i < BAND * BAND; i++) {
+        if (coef[i] > median) {
+            hash |= 1ULL << i;
+        }
+    }
+    return true;
+}
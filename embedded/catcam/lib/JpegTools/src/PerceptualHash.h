@@ -0,0 +1,31 @@
+#ifndef CATCAM_PERCEPTUALHASH_H
+#define CATCAM_PERCEPTUALHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "DcLumaMap.h"
+
+/**
+ * 64-bit perceptual (DCT) hash of a region of a DC luma map
+ *
+ * The region is box-averaged down to 32x32 cells and the lowest 8x8 DCT
+ * frequencies are taken; each bit says whether a coefficient is above the
+ * median of the 63 AC terms. The DC term is left out (bit 0 is always 0),
+ * so a change in overall brightness or flash exposure does not move the
+ * hash. Similar images differ in a few bits - compare with
+ * perceptualHashDistance().
+ *
+ * @param x, y, width, height Region in map cells (clipped to the map)
+ * @return false if the region is empty
+ */
+bool perceptualHash(const DcLumaMap& map, int x, int y, int width, int height, uint64_t& hash);
+
+/**
+ * Number of differing bits (0-63)
+ */
+inline int perceptualHashDistance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+#endif
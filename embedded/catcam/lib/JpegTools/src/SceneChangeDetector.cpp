@@ -0,0 +1,66 @@
+#include "SceneChangeDetector.h"
+
+SceneChangeDetector::SceneChangeDetector(uint8_t cellThreshold, float learningRate)
+    : _cellThreshold(cellThreshold), _alpha(64) {
+    setLearningRate(learningRate);
+}
+
+void SceneChangeDetector::setLearningRate(float rate) {
+    if (rate < 0.0f) rate = 0.0f;
+    if (rate > 1.0f) rate = 1.0f;
+    _alpha = (uint16_t)(rate * 256.0f + 0.5f);
+}
+
+void SceneChangeDetector::reset() {
+    _background.clear();
+    _width = 0;
+    _height = 0;
+}
+
+SceneChangeDetector::Result SceneChangeDetector::update(const DcLumaMap& map) {
+    Result result;
+    size_t cells = map.cellCount();
+    const uint8_t* pixels = map.data();
+    result.totalCells = (uint32_t)cells;
+
+    if (cells == 0) {
+        result.backgroundReset = true;
+        return result;
+    }
+
+    // Different resolution (or first frame): start a new background
+    if (_background.empty() || map.width() != _width || map.height() != _height) {
+        _width = map.width();
+        _height = map.height();
+        _background.resize(cells);
+        for (size_t i = 0; i < cells; i++) {
+            _background[i] = (uint16_t)(pixels[i] << 8);
+        }
+        result.backgroundReset = true;
+        return result;
+    }
+
+    // Global shift first, so exposure changes cancel out
+    int64_t sumDiff = 0;
+    for (size_t i = 0; i < cells; i++) {
+        sumDiff += ((int32_t)pixels[i] << 8) - _background[i];
+    }
+    int32_t shift = (int32_t)(sumDiff / (int64_t)cells);
+    result.meanShift = shift / 256.0f;
+
+    int32_t limit = (int32_t)_cellThreshold << 8;
+    uint32_t changed = 0;
+    for (size_t i = 0; i < cells; i++) {
+        int32_t current = (int32_t)pixels[i] << 8;
+        int32_t diff = current - _background[i] - shift;
+        if (diff > limit || diff < -limit) {
+            changed++;
+        }
+        // Exponential blend toward the current frame
+        _background[i] = (uint16_t)(_background[i] + (((current - _background[i]) * _alpha) >> 8));
+    }
+
+    result.changedCells = changed;
+    result.changeRatio = (float)changed / (float)cells;
+    return result;
+}
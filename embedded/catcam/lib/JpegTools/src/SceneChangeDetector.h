@@ -0,0 +1,57 @@
+#ifndef CATCAM_SCENECHANGEDETECTOR_H
+#define CATCAM_SCENECHANGEDETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "DcLumaMap.h"
+
+/**
+ * SceneChangeDetector - Rolling background model over DC luma maps
+ *
+ * Keeps an exponentially weighted background (8.8 fixed point per cell) and
+ * scores each new map by the fraction of cells that differ from it by more
+ * than a per-cell threshold. The mean difference is removed first so a global
+ * exposure or daylight shift does not count as change.
+ */
+class SceneChangeDetector {
+public:
+    struct Result {
+        bool backgroundReset = false;   // No comparable background - treat as changed
+        float changeRatio = 1.0f;       // Fraction of cells that changed (0-1)
+        float meanShift = 0.0f;         // Global brightness shift that was compensated
+        uint32_t changedCells = 0;
+        uint32_t totalCells = 0;
+    };
+
+    /**
+     * @param cellThreshold Luma difference (0-255) for a cell to count as changed
+     * @param learningRate Background update weight per frame (0-1)
+     */
+    explicit SceneChangeDetector(uint8_t cellThreshold = 12, float learningRate = 0.25f);
+
+    /**
+     * Score a map against the background, then blend it into the background
+     */
+    Result update(const DcLumaMap& map);
+
+    /**
+     * Forget the background; the next update() starts a new one
+     */
+    void reset();
+
+    bool hasBackground() const { return !_background.empty(); }
+
+    void setCellThreshold(uint8_t threshold) { _cellThreshold = threshold; }
+    void setLearningRate(float rate);
+
+private:
+    uint8_t _cellThreshold;
+    uint16_t _alpha;                    // Learning rate in 1/256 units
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    std::vector<uint16_t> _background;  // 8.8 fixed point luma
+};
+
+#endif
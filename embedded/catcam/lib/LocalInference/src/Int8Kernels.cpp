@@ -0,0 +1,312 @@
+#include "Int8Kernels.h"
+
+namespace {
+
+constexpr int DEPTHWISE_CHANNEL_BLOCK = 32;  // Accumulators kept on the stack per block
+
+int32_t saturatingRoundingDoublingHighMul(int32_t a, int32_t b) {
+    if (a == b && a == INT32_MIN) {
+        return INT32_MAX;
+    }
+    int64_t ab = (int64_t)a * b;
+    int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+    return (int32_t)((ab + nudge) / (1LL << 31));
+}
+
+int32_t roundingDivideByPowerOfTwo(int32_t x, int exponent) {
+    int32_t mask = (int32_t)((1LL << exponent) - 1);
+    int32_t remainder = x & mask;
+    int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+    return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+inline int8_t requantize(int32_t acc, const Int8Requant& requant, int channel) {
+    int32_t value = int8MultiplyByQuantizedMultiplier(acc + requant.bias[channel],
+                                                      requant.multiplier[channel], requant.shift[channel]);
+    value += requant.outputZeroPoint;
+    if (value < requant.activationMin) value = requant.activationMin;
+    if (value > requant.activationMax) value = requant.activationMax;
+    return (int8_t)value;
+}
+
+inline int8_t sampleOrPad(const int8_t* input, const Int8Shape& shape, int y, int x, int c, int8_t padValue) {
+    if (y < 0 || x < 0 || y >= shape.height || x >= shape.width) {
+        return padValue;
+    }
+    return input[((size_t)y * shape.width + x) * shape.channels + c];
+}
+
+// One output pixel of a depthwise convolution, with bounds checks
+void depthwisePixel(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                    const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                    int8_t* output, const Int8Shape& outShape, int oy, int ox) {
+    int iy0 = oy * window.strideH - window.padTop;
+    int ix0 = ox * window.strideW - window.padLeft;
+    int channels = inShape.channels;
+    int8_t* out = output + ((size_t)oy * outShape.width + ox) * channels;
+    for (int c = 0; c < channels; c++) {
+        int32_t acc = 0;
+        for (int ky = 0; ky < window.kernelH; ky++) {
+            for (int kx = 0; kx < window.kernelW; kx++) {
+                int32_t x = sampleOrPad(input, inShape, iy0 + ky, ix0 + kx, c, padValue);
+                acc += x * weights[(ky * window.kernelW + kx) * channels + c];
+            }
+        }
+        out[c] = requantize(acc, requant, c);
+    }
+}
+
+// 1x1 convolution, stride 1, no padding: a matrix product over pixels.
+// Tiles of 2 pixels x 4 output channels reuse each loaded input and weight.
+void pointwiseConv(const int8_t* input, size_t pixels, int inChannels, const int8_t* weights,
+                   const Int8Requant& requant, int8_t* output, int outChannels) {
+    size_t p = 0;
+    for (; p + 2 <= pixels; p += 2) {
+        const int8_t* x0 = input + p * inChannels;
+        const int8_t* x1 = x0 + inChannels;
+        int8_t* y0 = output + p * outChannels;
+        int8_t* y1 = y0 + outChannels;
+        int oc = 0;
+        for (; oc + 4 <= outChannels; oc += 4) {
+            const int8_t* w0 = weights + (size_t)oc * inChannels;
+            const int8_t* w1 = w0 + inChannels;
+            const int8_t* w2 = w1 + inChannels;
+            const int8_t* w3 = w2 + inChannels;
+            int32_t a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+            int32_t a10 = 0, a11 = 0, a12 = 0, a13 = 0;
+            for (int ic = 0; ic < inChannels; ic++) {
+                int32_t v0 = x0[ic];
+                int32_t v1 = x1[ic];
+                int32_t k0 = w0[ic], k1 = w1[ic], k2 = w2[ic], k3 = w3[ic];
+                a00 += v0 * k0; a01 += v0 * k1; a02 += v0 * k2; a03 += v0 * k3;
+                a10 += v1 * k0; a11 += v1 * k1; a12 += v1 * k2; a13 += v1 * k3;
+            }
+            y0[oc] = requantize(a00, requant, oc);
+            y0[oc + 1] = requantize(a01, requant, oc + 1);
+            y0[oc + 2] = requantize(a02, requant, oc + 2);
+            y0[oc + 3] = requantize(a03, requant, oc + 3);
+            y1[oc] = requantize(a10, requant, oc);
+            y1[oc + 1] = requantize(a11, requant, oc + 1);
+            y1[oc + 2] = requantize(a12, requant, oc + 2);
+            y1[oc + 3] = requantize(a13, requant, oc + 3);
+        }
+        for (; oc < outChannels; oc++) {
+            const int8_t* w = weights + (size_t)oc * inChannels;
+            int32_t a0 = 0, a1 = 0;
+            for (int ic = 0; ic < inChannels; ic++) {
+                a0 += (int32_t)x0[ic] * w[ic];
+                a1 += (int32_t)x1[ic] * w[ic];
+            }
+            y0[oc] = requantize(a0, requant, oc);
+            y1[oc] = requantize(a1, requant, oc);
+        }
+    }
+    for (; p < pixels; p++) {
+        const int8_t* x = input + p * inChannels;
+        int8_t* y = output + p * outChannels;
+        for (int oc = 0; oc < outChannels; oc++) {
+            const int8_t* w = weights + (size_t)oc * inChannels;
+            int32_t acc = 0;
+            for (int ic = 0; ic < inChannels; ic++) {
+                acc += (int32_t)x[ic] * w[ic];
+            }
+            y[oc] = requantize(acc, requant, oc);
+        }
+    }
+}
+
+// 3x3 depthwise: pixels whose window lies inside the input skip the bounds
+// checks and accumulate a block of channels per tap
+void depthwise3x3(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                  const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                  int8_t* output, const Int8Shape& outShape) {
+    int channels = inShape.channels;
+    size_t rowStride = (size_t)inShape.width * channels;
+    for (int oy = 0; oy < outShape.height; oy++) {
+        int iy0 = oy * window.strideH - window.padTop;
+        bool rowInside = iy0 >= 0 && iy0 + 3 <= inShape.height;
+        for (int ox = 0; ox < outShape.width; ox++) {
+            int ix0 = ox * window.strideW - window.padLeft;
+            if (!rowInside || ix0 < 0 || ix0 + 3 > inShape.width) {
+                depthwisePixel(input, inShape, weights, window, padValue, requant, output, outShape, oy, ox);
+                continue;
+            }
+            const int8_t* origin = input + (size_t)iy0 * rowStride + (size_t)ix0 * channels;
+            int8_t* out = output + ((size_t)oy * outShape.width + ox) * channels;
+            for (int c0 = 0; c0 < channels; c0 += DEPTHWISE_CHANNEL_BLOCK) {
+                int count = channels - c0 < DEPTHWISE_CHANNEL_BLOCK ? channels - c0 : DEPTHWISE_CHANNEL_BLOCK;
+                int32_t acc[DEPTHWISE_CHANNEL_BLOCK] = {};
+                for (int ky = 0; ky < 3; ky++) {
+                    for (int kx = 0; kx < 3; kx++) {
+                        const int8_t* x = origin + ky * rowStride + kx * channels + c0;
+                        const int8_t* w = weights + (ky * 3 + kx) * channels + c0;
+                        for (int i = 0; i < count; i++) {
+                            acc[i] += (int32_t)x[i] * w[i];
+                        }
+                    }
+                }
+                for (int i = 0; i < count; i++) {
+                    out[c0 + i] = requantize(acc[i], requant, c0 + i);
+                }
+            }
+        }
+    }
+}
+
+}
+
+int32_t int8MultiplyByQuantizedMultiplier(int32_t x, int32_t multiplier, int shift) {
+    int leftShift = shift > 0 ? shift : 0;
+    int rightShift = shift > 0 ? 0 : -shift;
+    return roundingDivideByPowerOfTwo(saturatingRoundingDoublingHighMul(x * (1 << leftShift), multiplier), rightShift);
+}
+
+namespace int8ref {
+
+void conv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+            const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+            int8_t* output, const Int8Shape& outShape) {
+    int inChannels = inShape.channels;
+    for (int oy = 0; oy < outShape.height; oy++) {
+        for (int ox = 0; ox < outShape.width; ox++) {
+            int iy0 = oy * window.strideH - window.padTop;
+            int ix0 = ox * window.strideW - window.padLeft;
+            int8_t* out = output + ((size_t)oy * outShape.width + ox) * outShape.channels;
+            for (int oc = 0; oc < outShape.channels; oc++) {
+                const int8_t* w = weights + (size_t)oc * window.kernelH * window.kernelW * inChannels;
+                int32_t acc = 0;
+                for (int ky = 0; ky < window.kernelH; ky++) {
+                    for (int kx = 0; kx < window.kernelW; kx++) {
+                        for (int ic = 0; ic < inChannels; ic++) {
+                            int32_t x = sampleOrPad(input, inShape, iy0 + ky, ix0 + kx, ic, padValue);
+                            acc += x * w[(ky * window.kernelW + kx) * inChannels + ic];
+                        }
+                    }
+                }
+                out[oc] = requantize(acc, requant, oc);
+            }
+        }
+    }
+}
+
+void depthwiseConv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                     const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                     int8_t* output, const Int8Shape& outShape) {
+    for (int oy = 0; oy < outShape.height; oy++) {
+        for (int ox = 0; ox < outShape.width; ox++) {
+            depthwisePixel(input, inShape, weights, window, padValue, requant, output, outShape, oy, ox);
+        }
+    }
+}
+
+void fullyConnected(const int8_t* input, size_t inputs, const int8_t* weights,
+                    const Int8Requant& requant, int8_t* output, size_t outputs) {
+    for (size_t o = 0; o < outputs; o++) {
+        int32_t acc = 0;
+        for (size_t i = 0; i < inputs; i++) {
+            acc += (int32_t)input[i] * weights[o * inputs + i];
+        }
+        output[o] = requantize(acc, requant, (int)o);
+    }
+}
+
+}
+
+void int8Conv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                int8_t* output, const Int8Shape& outShape) {
+    bool pointwise = window.kernelH == 1 && window.kernelW == 1 && window.strideH == 1 && window.strideW == 1 &&
+                     window.padTop == 0 && window.padLeft == 0 &&
+                     inShape.height == outShape.height && inShape.width == outShape.width;
+    if (pointwise) {
+        pointwiseConv(input, (size_t)inShape.height * inShape.width, inShape.channels, weights,
+                      requant, output, outShape.channels);
+        return;
+    }
+    int8ref::conv2d(input, inShape, weights, window, padValue, requant, output, outShape);
+}
+
+void int8DepthwiseConv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                         const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                         int8_t* output, const Int8Shape& outShape) {
+    if (window.kernelH == 3 && window.kernelW == 3) {
+        depthwise3x3(input, inShape, weights, window, padValue, requant, output, outShape);
+        return;
+    }
+    int8ref::depthwiseConv2d(input, inShape, weights, window, padValue, requant, output, outShape);
+}
+
+void int8FullyConnected(const int8_t* input, size_t inputs, const int8_t* weights,
+                        const Int8Requant& requant, int8_t* output, size_t outputs) {
+    pointwiseConv(input, 1, (int)inputs, weights, requant, output, (int)outputs);
+}
+
+void int8AveragePool(const int8_t* input, const Int8Shape& inShape, const Int8Window& window,
+                     int8_t* output, const Int8Shape& outShape) {
+    int channels = inShape.channels;
+    for (int oy = 0; oy < outShape.height; oy++) {
+        for (int ox = 0; ox < outShape.width; ox++) {
+            int iy0 = oy * window.strideH - window.padTop;
+            int ix0 = ox * window.strideW - window.padLeft;
+            int8_t* out = output + ((size_t)oy * outShape.width + ox) * channels;
+            for (int c = 0; c < channels; c++) {
+                int32_t sum = 0;
+                int32_t count = 0;
+                for (int ky = 0; ky < window.kernelH; ky++) {
+                    int iy = iy0 + ky;
+                    if (iy < 0 || iy >= inShape.height) continue;
+                    for (int kx = 0; kx < window.kernelW; kx++) {
+                        int ix = ix0 + kx;
+                        if (ix < 0 || ix >= inShape.width) continue;
+                        sum += input[((size_t)iy * inShape.width + ix) * channels + c];
+                        count++;
+                    }
+                }
+                if (count == 0) {
+                    out[c] = 0;
+                    continue;
+                }
+                // Round half away from zero
+                out[c] = (int8_t)((sum + (sum > 0 ? count / 2 : -count / 2)) / count);
+            }
+        }
+    }
+}
+
+void int8MaxPool(const int8_t* input, const Int8Shape& inShape, const Int8Window& window,
+                 int8_t* output, const Int8Shape& outShape) {
+    int channels = inShape.channels;
+    for (int oy = 0; oy < outShape.height; oy++) {
+        for (int ox = 0; ox < outShape.width; ox++) {
+            int iy0 = oy * window.strideH - window.padTop;
+            int ix0 = ox * window.strideW - window.padLeft;
+            int8_t* out = output + ((size_t)oy * outShape.width + ox) * channels;
+            for (int c = 0; c < channels; c++) {
+                int32_t best = -128;
+                for (int ky = 0; ky < window.kernelH; ky++) {
+                    int iy = iy0 + ky;
+                    if (iy < 0 || iy >= inShape.height) continue;
+                    for (int kx = 0; kx < window.kernelW; kx++) {
+                        int ix = ix0 + kx;
+                        if (ix < 0 || ix >= inShape.width) continue;
+                        int32_t v = input[((size_t)iy * inShape.width + ix) * channels + c];
+                        if (v > best) best = v;
+                    }
+                }
+                out[c] = (int8_t)best;
+            }
+        }
+    }
+}
+
+void int8GlobalAveragePool(const int8_t* input, const Int8Shape& inShape, int8_t* output) {
+    int channels = inShape.channels;
+    int32_t count = (int32_t)inShape.height * inShape.width;
+    for (int c = 0; c < channels; c++) {
+        int32_t sum = 0;
+        for (int32_t p = 0; p < count; p++) {
+            sum += input[(size_t)p * channels + c];
+        }
+        output[c] = (int8_t)((sum + (sum > 0 ? count / 2 : -count / 2)) / count);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef CATCAM_INT8KERNELS_H
+#define CATCAM_INT8KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Int8Kernels - Quantised CNN layers (NHWC, int8 activations and weights)
+ *
+ * Arithmetic follows the TFLite int8 scheme so results are bit-exact with
+ * the exporter's reference: weights are symmetric (per output channel),
+ * activations carry a zero point, accumulators are int32 and are scaled
+ * back to int8 with a Q31 multiplier and power-of-two shift per channel.
+ *
+ * The input zero point is folded into the bias by the exporter
+ * (bias - zeroPoint * sum(weights)), so the kernels multiply raw int8
+ * values and pad with the input zero point, which stands for real 0.
+ *
+ * Each layer has a plain reference kernel (int8ref::) and the public entry
+ * point, which takes a specialised path for the shapes that dominate a
+ * MobileNet (1x1 pointwise convolutions, 3x3 depthwise) and falls back to
+ * the reference for anything else. Both give identical output.
+ */
+
+struct Int8Shape {
+    uint16_t height = 0;
+    uint16_t width = 0;
+    uint16_t channels = 0;
+
+    size_t size() const { return (size_t)height * width * channels; }
+};
+
+struct Int8Window {
+    uint8_t kernelH = 1;
+    uint8_t kernelW = 1;
+    uint8_t strideH = 1;
+    uint8_t strideW = 1;
+    uint8_t padTop = 0;     // Bottom/right padding is implied by the output shape
+    uint8_t padLeft = 0;
+};
+
+/**
+ * Per-output-channel rescale of int32 accumulators to int8
+ */
+struct Int8Requant {
+    const int32_t* bias = nullptr;        // Input zero point already folded in
+    const int32_t* multiplier = nullptr;  // Q31, in [2^30, 2^31)
+    const int8_t* shift = nullptr;        // Positive = left shift
+    int32_t outputZeroPoint = 0;
+    int32_t activationMin = -128;         // Clamp after the zero point (fused ReLU / ReLU6)
+    int32_t activationMax = 127;
+};
+
+/**
+ * x * multiplier * 2^shift with TFLite rounding
+ */
+int32_t int8MultiplyByQuantizedMultiplier(int32_t x, int32_t multiplier, int shift);
+
+/**
+ * Convolution; weights are [outChannels][kernelH][kernelW][inChannels]
+ */
+void int8Conv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                int8_t* output, const Int8Shape& outShape);
+
+/**
+ * Depthwise convolution, depth multiplier 1; weights are [kernelH][kernelW][channels]
+ */
+void int8DepthwiseConv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                         const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                         int8_t* output, const Int8Shape& outShape);
+
+/**
+ * Fully connected; weights are [outputs][inputs]
+ */
+void int8FullyConnected(const int8_t* input, size_t inputs, const int8_t* weights,
+                        const Int8Requant& requant, int8_t* output, size_t outputs);
+
+/**
+ * Pooling keeps the input's scale and zero point; padded cells are not
+ * counted (average) or considered (max)
+ */
+void int8AveragePool(const int8_t* input, const Int8Shape& inShape, const Int8Window& window,
+                     int8_t* output, const Int8Shape& outShape);
+void int8MaxPool(const int8_t* input, const Int8Shape& inShape, const Int8Window& window,
+                 int8_t* output, const Int8Shape& outShape);
+
+/**
+ * Mean over height and width; output has inShape.channels values
+ */
+void int8GlobalAveragePool(const int8_t* input, const Int8Shape& inShape, int8_t* output);
+
+namespace int8ref {
+
+void conv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+            const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+            int8_t* output, const Int8Shape& outShape);
+
+void depthwiseConv2d(const int8_t* input, const Int8Shape& inShape, const int8_t* weights,
+                     const Int8Window& window, int8_t padValue, const Int8Requant& requant,
+                     int8_t* output, const Int8Shape& outShape);
+
+void fullyConnected(const int8_t* input, size_t inputs, const int8_t* weights,
+                    const Int8Requant& requant, int8_t* output, size_t outputs);
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include "LocalClassifier.h"
+#include "SDLogger.h"
+#include <SPIFFS.h>
+#include <esp_heap_caps.h>
+#include <math.h>
+
+namespace {
+
+inline int clampByte(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// Source coordinate for an output pixel centre, 16.16 fixed point
+inline int32_t sourcePosition(int out, int outSize, int inStart, int inSize) {
+    return (int32_t)(((int64_t)(2 * out + 1) * inSize * 65536) / (2 * outSize)) - 32768 + inStart * 65536;
+}
+
+// Bilinear sample of a plane at 16.16 coordinates, clamped to [x0, x1] x [y0, y1]
+inline int sample(const uint8_t* plane, int stride, int32_t fx, int32_t fy, int x0, int y0, int x1, int y1) {
+    fx = constrain(fx, x0 * 65536, x1 * 65536);
+    fy = constrain(fy, y0 * 65536, y1 * 65536);
+    int sx = fx >> 16;
+    int sy = fy >> 16;
+    int wx = (fx >> 8) & 0xFF;
+    int wy = (fy >> 8) & 0xFF;
+    int sx1 = sx < x1 ? sx + 1 : x1;
+    int sy1 = sy < y1 ? sy + 1 : y1;
+    const uint8_t* row0 = plane + sy * stride;
+    const uint8_t* row1 = plane + sy1 * stride;
+    int top = row0[sx] * (256 - wx) + row0[sx1] * wx;
+    int bottom = row1[sx] * (256 - wx) + row1[sx1] * wx;
+    return (top * (256 - wy) + bottom * wy + 32768) >> 16;
+}
+
+}
+
+bool LocalClassifier::begin(const char* path) {
+    if (isReady()) {
+        return true;
+    }
+
+    if (!SPIFFS.begin(false)) {
+        SDLogger::getInstance().warnf("Local inference: cannot mount SPIFFS");
+        return false;
+    }
+    File file = SPIFFS.open(path, FILE_READ);
+    if (!file) {
+        SDLogger::getInstance().warnf("Local inference: no model at %s", path);
+        SPIFFS.end();
+        return false;
+    }
+
+    size_t size = file.size();
+    _blob = (uint8_t*)(psramFound() ? ps_malloc(size) : malloc(size));
+    bool read = _blob && file.read(_blob, size) == size;
+    file.close();
+    SPIFFS.end();
+    if (!read) {
+        SDLogger::getInstance().errorf("Local inference: cannot read %u byte model", (unsigned)size);
+        end();
+        return false;
+    }
+
+    if (!_model.load(_blob, size)) {
+        SDLogger::getInstance().errorf("Local inference: bad model (%s)", _model.error());
+        end();
+        return false;
+    }
+
+    // Activations are read many times per layer - prefer internal RAM
+    size_t arenaBytes = _model.arenaBytes();
+    if (heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) >= arenaBytes + INTERNAL_HEADROOM_BYTES) {
+        _arena = (int8_t*)heap_caps_malloc(arenaBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    bool internal = _arena != nullptr;
+    if (!_arena && psramFound()) {
+        _arena = (int8_t*)ps_malloc(arenaBytes);
+    }
+    if (!_arena) {
+        SDLogger::getInstance().errorf("Local inference: cannot allocate %u byte arena", (unsigned)arenaBytes);
+        end();
+        return false;
+    }
+    _model.setArena(_arena);
+
+    if (_model.hasSelfTest()) {
+        int64_t startUs = esp_timer_get_time();
+        if (!_model.selfTest()) {
+            SDLogger::getInstance().errorf("Local inference: model self-test failed - not using it");
+            end();
+            return false;
+        }
+        SDLogger::getInstance().infof("Local inference: self-test passed in %lld ms", (esp_timer_get_time() - startUs) / 1000);
+    }
+
+    SDLogger::getInstance().infof("Local inference: %d layers, %dx%dx%d input, %d classes, %lu MACs, %u KB model, %u KB arena (%s)",
+        _model.layerCount(), _model.inputWidth(), _model.inputHeight(), _model.inputChannels(),
+        _model.classCount(), (unsigned long)_model.macs(), (unsigned)(size / 1024),
+        (unsigned)(arenaBytes / 1024), internal ? "internal" : "PSRAM");
+    return true;
+}
+
+void LocalClassifier::end() {
+    _decoder.release();
+    if (_arena) {
+        heap_caps_free(_arena);
+        _arena = nullptr;
+    }
+    if (_blob) {
+        free(_blob);
+        _blob = nullptr;
+    }
+    _model.setArena(nullptr);
+}
+
+bool LocalClassifier::preprocess(int cropX, int cropY, int cropWidth, int cropHeight) {
+    int width = _decoder.width();
+    int height = _decoder.height();
+    int x0 = width * cropX / 100;
+    int y0 = height * cropY / 100;
+    int cw = max(1, width * cropWidth / 100);
+    int ch = max(1, height * cropHeight / 100);
+    if (x0 + cw > width) cw = width - x0;
+    if (y0 + ch > height) ch = height - y0;
+    if (cw < 1 || ch < 1) {
+        return false;
+    }
+    int x1 = x0 + cw - 1;
+    int y1 = y0 + ch - 1;
+
+    int outW = _model.inputWidth();
+    int outH = _model.inputHeight();
+    int outC = _model.inputChannels();
+    int offset = _model.inputOffset();
+    bool colour = _decoder.componentCount() >= 3;
+    const uint8_t* yPlane = _decoder.plane(0);
+    const uint8_t* cbPlane = colour ? _decoder.plane(1) : nullptr;
+    const uint8_t* crPlane = colour ? _decoder.plane(2) : nullptr;
+
+    int8_t* out = _model.input();
+    for (int oy = 0; oy < outH; oy++) {
+        int32_t fy = sourcePosition(oy, outH, y0, ch);
+        for (int ox = 0; ox < outW; ox++) {
+            int32_t fx = sourcePosition(ox, outW, x0, cw);
+            int luma = sample(yPlane, width, fx, fy, x0, y0, x1, y1);
+            int rgb[3] = { luma, luma, luma };
+            if (colour) {
+                // JFIF YCbCr -> RGB, 16.16 fixed point
+                int cb = sample(cbPlane, width, fx, fy, x0, y0, x1, y1) - 128;
+                int cr = sample(crPlane, width, fx, fy, x0, y0, x1, y1) - 128;
+                rgb[0] = clampByte(luma + ((91881 * cr + 32768) >> 16));
+                rgb[1] = clampByte(luma - ((22554 * cb + 46802 * cr + 32768) >> 16));
+                rgb[2] = clampByte(luma + ((116130 * cb + 32768) >> 16));
+            }
+            for (int c = 0; c < outC; c++) {
+                int q = rgb[c < 3 ? c : 2] + offset;
+                *out++ = (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalClassifier::classify(const uint8_t* jpeg, size_t size, int cropX, int cropY, int cropWidth, int cropHeight,
+                               LocalResult& result) {
+    if (!isReady()) {
+        return false;
+    }
+    int64_t startUs = esp_timer_get_time();
+
+    // Smallest decode that still has a pixel for every model input
+    JpegInfo info;
+    if (!parseJpeg(jpeg, size, info)) {
+        SDLogger::getInstance().warnf("Local inference: cannot read frame (%s)", info.error);
+        return false;
+    }
+    int cropPixelsW = max(1, info.width * cropWidth / 100);
+    int cropPixelsH = max(1, info.height * cropHeight / 100);
+    static const uint8_t DENOMINATORS[] = { 8, 4 };
+    uint8_t denominator = 2;
+    for (uint8_t candidate : DENOMINATORS) {
+        if (cropPixelsW / candidate >= _model.inputWidth() && cropPixelsH / candidate >= _model.inputHeight()) {
+            denominator = candidate;
+            break;
+        }
+    }
+
+    bool ok = _decoder.decode(jpeg, size, denominator) && preprocess(cropX, cropY, cropWidth, cropHeight);
+    _decoder.release();
+    if (!ok) {
+        SDLogger::getInstance().warnf("Local inference: cannot decode frame (%s)", _decoder.error() ? _decoder.error() : "empty crop");
+        return false;
+    }
+    int64_t preprocessedUs = esp_timer_get_time();
+
+    const int8_t* output = _model.invoke();
+    if (!output) {
+        return false;
+    }
+    int64_t doneUs = esp_timer_get_time();
+
+    // Softmax over the dequantised logits
+    int best = 0;
+    for (int i = 1; i < _model.classCount(); i++) {
+        if (output[i] > output[best]) {
+            best = i;
+        }
+    }
+    float top = _model.dequantize(output[best]);
+    float sum = 0.0f;
+    for (int i = 0; i < _model.classCount(); i++) {
+        sum += expf(_model.dequantize(output[i]) - top);
+    }
+
+    result.index = best;
+    result.confidence = 1.0f / sum;
+    strlcpy(result.name, _model.className(best), sizeof(result.name));
+    result.preprocessMs = (uint32_t)((preprocessedUs - startUs) / 1000);
+    result.inferenceMs = (uint32_t)((doneUs - preprocessedUs) / 1000);
+    result.latencyMs = (uint32_t)((doneUs - startUs) / 1000);
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef CATCAM_LOCALCLASSIFIER_H
+#define CATCAM_LOCALCLASSIFIER_H
+
+#include <Arduino.h>
+
+#include "JpegScaledDecoder.h"
+#include "LocalModel.h"
+
+/**
+ * Answer from the on-device model
+ */
+struct LocalResult {
+    int index = -1;                 // Class index in the model (0 = Boots)
+    float confidence = 0.0f;        // Softmax of the dequantised outputs
+    char name[LocalModel::CLASS_NAME_LENGTH] = "";
+    uint32_t preprocessMs = 0;      // Decode, crop, resize
+    uint32_t inferenceMs = 0;       // LocalModel::invoke()
+    uint32_t latencyMs = 0;         // Both
+};
+
+/**
+ * LocalClassifier - On-device Boots/NotBoots classifier
+ *
+ * Loads a model written by local-training/export_for_device.py from the
+ * SPIFFS partition into PSRAM, checks it against the exporter's self-test
+ * vector, and classifies JPEG frames: the crop is decoded at 1/8, 1/4 or
+ * 1/2 scale (the smallest that still covers the model input), resized
+ * bilinearly and converted to RGB.
+ */
+class LocalClassifier {
+public:
+    static constexpr const char* MODEL_PATH = "/model.bbm";
+
+    ~LocalClassifier() { end(); }
+
+    /**
+     * Mount SPIFFS, load and self-test the model, allocate the arena
+     * @return false if there is no usable model (logged)
+     */
+    bool begin(const char* path = MODEL_PATH);
+
+    /**
+     * Free the model and arena
+     */
+    void end();
+
+    bool isReady() const { return _blob != nullptr; }
+
+    /**
+     * Classify the crop (percent of the frame) of a JPEG
+     * @return false if the frame cannot be decoded or no model is loaded
+     */
+    bool classify(const uint8_t* jpeg, size_t size, int cropX, int cropY, int cropWidth, int cropHeight,
+                  LocalResult& result);
+
+    const LocalModel& model() const { return _model; }
+
+private:
+    // Arena goes in internal RAM only if this much is left for TLS and the stacks
+    static constexpr size_t INTERNAL_HEADROOM_BYTES = 64 * 1024;
+
+    LocalModel _model;
+    JpegScaledDecoder _decoder;
+    uint8_t* _blob = nullptr;
+    int8_t* _arena = nullptr;
+
+    bool preprocess(int cropX, int cropY, int cropWidth, int cropHeight);
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "LocalModel.h"
+#include <string.h>
+
+namespace {
+
+constexpr uint16_t FORMAT_VERSION = 1;
+constexpr size_t HEADER_BYTES = 36;
+constexpr size_t LAYER_RECORD_BYTES = 32;
+
+uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+float readF32(const uint8_t* p) {
+    uint32_t bits = readU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+size_t alignUp(size_t value) { return (value + 3) & ~(size_t)3; }
+
+bool inRange(size_t offset, size_t bytes, size_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+}
+
+const char* LocalModel::className(int index) const {
+    return index >= 0 && index < _classCount ? _classNames[index] : "";
+}
+
+bool LocalModel::load(const uint8_t* blob, size_t size) {
+    _error = nullptr;
+    _layerCount = 0;
+    _selfTestInput = nullptr;
+    _selfTestOutput = nullptr;
+    _macs = 0;
+
+    if (!blob || size < HEADER_BYTES || memcmp(blob, "BBM1", 4) != 0) {
+        return fail("Not a BBM1 model");
+    }
+    if (((uintptr_t)blob & 3) != 0) {
+        return fail("Model buffer not 4-byte aligned");
+    }
+    if (readU16(blob + 4) != FORMAT_VERSION) {
+        return fail("Unsupported model version");
+    }
+    int layerCount = readU16(blob + 6);
+    _inputShape.height = readU16(blob + 8);
+    _inputShape.width = readU16(blob + 10);
+    _inputShape.channels = readU16(blob + 12);
+    _classCount = readU16(blob + 14);
+    _inputOffset = (int16_t)readU16(blob + 16);
+    _outputScale = readF32(blob + 20);
+    _outputZeroPoint = (int32_t)readU32(blob + 24);
+    size_t selfTestOffset = readU32(blob + 28);
+    size_t fileSize = readU32(blob + 32);
+
+    if (fileSize != size) {
+        return fail("Model truncated");
+    }
+    if (layerCount < 1 || layerCount > MAX_LAYERS) {
+        return fail("Bad layer count");
+    }
+    if (_classCount < 2 || _classCount > MAX_CLASSES) {
+        return fail("Bad class count");
+    }
+    if (_inputShape.size() == 0) {
+        return fail("Bad input shape");
+    }
+
+    size_t pos = HEADER_BYTES;
+    if (!inRange(pos, (size_t)_classCount * CLASS_NAME_LENGTH, size)) {
+        return fail("Model truncated");
+    }
+    for (int i = 0; i < _classCount; i++) {
+        memcpy(_classNames[i], blob + pos, CLASS_NAME_LENGTH);
+        _classNames[i][CLASS_NAME_LENGTH - 1] = '\0';
+        pos += CLASS_NAME_LENGTH;
+    }
+    pos = alignUp(pos);
+
+    if (!inRange(pos, (size_t)layerCount * LAYER_RECORD_BYTES, size)) {
+        return fail("Model truncated");
+    }
+
+    Int8Shape shape = _inputShape;
+    size_t largest = shape.size();
+    for (int i = 0; i < layerCount; i++, pos += LAYER_RECORD_BYTES) {
+        const uint8_t* r = blob + pos;
+        Layer& layer = _layers[i];
+        layer = Layer();
+        if (r[0] >= (uint8_t)LayerType::Count) {
+            return fail("Unknown layer type");
+        }
+        layer.type = (LayerType)r[0];
+        layer.window.kernelH = r[1];
+        layer.window.kernelW = r[2];
+        layer.window.strideH = r[3];
+        layer.window.strideW = r[4];
+        layer.window.padTop = r[5];
+        layer.window.padLeft = r[6];
+        layer.padValue = (int8_t)r[8];
+        layer.requant.outputZeroPoint = (int8_t)r[9];
+        layer.requant.activationMin = (int8_t)r[10];
+        layer.requant.activationMax = (int8_t)r[11];
+        layer.in = shape;
+        layer.out.height = readU16(r + 12);
+        layer.out.width = readU16(r + 14);
+        layer.out.channels = readU16(r + 16);
+        size_t weightsOffset = readU32(r + 20);
+        size_t paramsOffset = readU32(r + 24);
+
+        if (layer.out.size() == 0) {
+            return fail("Bad layer output shape");
+        }
+
+        size_t weightCount = 0;
+        bool windowed = true;
+        bool requantised = true;
+        switch (layer.type) {
+            case LayerType::Conv2d:
+                weightCount = (size_t)layer.out.channels * layer.window.kernelH * layer.window.kernelW * shape.channels;
+                _macs += (uint32_t)(layer.out.size() * layer.window.kernelH * layer.window.kernelW * shape.channels);
+                break;
+            case LayerType::DepthwiseConv2d:
+                weightCount = (size_t)layer.window.kernelH * layer.window.kernelW * shape.channels;
+                _macs += (uint32_t)(layer.out.size() * layer.window.kernelH * layer.window.kernelW);
+                break;
+            case LayerType::FullyConnected:
+                weightCount = (size_t)layer.out.channels * shape.size();
+                _macs += (uint32_t)weightCount;
+                windowed = false;
+                if (layer.out.height != 1 || layer.out.width != 1) {
+                    return fail("Fully connected output must be 1x1");
+                }
+                break;
+            case LayerType::GlobalAveragePool:
+                windowed = false;
+                requantised = false;
+                if (layer.out.height != 1 || layer.out.width != 1) {
+                    return fail("Global pool output must be 1x1");
+                }
+                break;
+            default:
+                requantised = false;
+                break;
+        }
+
+        if (layer.type != LayerType::Conv2d && layer.type != LayerType::FullyConnected &&
+            layer.out.channels != shape.channels) {
+            return fail("Layer changes channel count");
+        }
+        if (windowed) {
+            const Int8Window& w = layer.window;
+            if (w.kernelH == 0 || w.kernelW == 0 || w.strideH == 0 || w.strideW == 0) {
+                return fail("Bad layer window");
+            }
+            // Every window must start inside the (top/left padded) input
+            if ((int)(layer.out.height - 1) * w.strideH - w.padTop >= shape.height ||
+                (int)(layer.out.width - 1) * w.strideW - w.padLeft >= shape.width) {
+                return fail("Layer output larger than its input");
+            }
+        }
+        if (weightCount) {
+            if (!inRange(weightsOffset, weightCount, size)) {
+                return fail("Layer weights outside the file");
+            }
+            layer.weights = (const int8_t*)(blob + weightsOffset);
+        }
+        if (requantised) {
+            size_t channels = layer.out.channels;
+            if ((paramsOffset & 3) != 0 || !inRange(paramsOffset, channels * 9, size)) {
+                return fail("Layer parameters outside the file");
+            }
+            layer.requant.bias = (const int32_t*)(blob + paramsOffset);
+            layer.requant.multiplier = (const int32_t*)(blob + paramsOffset + channels * 4);
+            layer.requant.shift = (const int8_t*)(blob + paramsOffset + channels * 8);
+        }
+
+        shape = layer.out;
+        if (shape.size() > largest) {
+            largest = shape.size();
+        }
+    }
+
+    if (shape.size() != (size_t)_classCount) {
+        return fail("Output size does not match class count");
+    }
+
+    if (selfTestOffset) {
+        if (!inRange(selfTestOffset, _inputShape.size() + _classCount, size)) {
+            return fail("Self-test data outside the file");
+        }
+        _selfTestInput = (const int8_t*)(blob + selfTestOffset);
+        _selfTestOutput = _selfTestInput + _inputShape.size();
+    }
+
+    _halfBytes = alignUp(largest);
+    _layerCount = layerCount;
+    return true;
+}
+
+const int8_t* LocalModel::invoke() {
+    if (!_arena || _layerCount == 0) {
+        return nullptr;
+    }
+
+    int8_t* src = _arena;
+    int8_t* dst = _arena + _halfBytes;
+    for (int i = 0; i < _layerCount; i++) {
+        const Layer& layer = _layers[i];
+        switch (layer.type) {
+            case LayerType::Conv2d:
+                int8Conv2d(src, layer.in, layer.weights, layer.window, layer.padValue, layer.requant, dst, layer.out);
+                break;
+            case LayerType::DepthwiseConv2d:
+                int8DepthwiseConv2d(src, layer.in, layer.weights, layer.window, layer.padValue, layer.requant,
+                                    dst, layer.out);
+                break;
+            case LayerType::AveragePool:
+                int8AveragePool(src, layer.in, layer.window, dst, layer.out);
+                break;
+            case LayerType::MaxPool:
+                int8MaxPool(src, layer.in, layer.window, dst, layer.out);
+                break;
+            case LayerType::GlobalAveragePool:
+                int8GlobalAveragePool(src, layer.in, dst);
+                break;
+            case LayerType::FullyConnected:
+                int8FullyConnected(src, layer.in.size(), layer.weights, layer.requant, dst, layer.out.channels);
+                break;
+            default:
+                return nullptr;
+        }
+        int8_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    return src;
+}
+
+bool LocalModel::selfTest() {
+    if (!_selfTestInput || !_arena) {
+        return false;
+    }
+    memcpy(input(), _selfTestInput, inputSize());
+    const int8_t* output = invoke();
+    return output && memcmp(output, _selfTestOutput, _classCount) == 0;
+}
@@ -0,0 +1,132 @@
+#ifndef CATCAM_LOCALMODEL_H
+#define CATCAM_LOCALMODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Int8Kernels.h"
+
+/**
+ * LocalModel - Runs a quantised classifier exported by
+ * local-training/export_for_device.py
+ *
+ * The model is a straight chain of layers (convolution, depthwise
+ * convolution, pooling, fully connected) with batch norm and ReLU/ReLU6
+ * already folded in by the exporter. File layout, little-endian, every
+ * section 4-byte aligned:
+ *
+ *   header   "BBM1", version, layer count, input H/W/C, class count,
+ *            input offset (q = pixel + offset), output scale/zero point,
+ *            self-test offset, file size
+ *   names    class count x 16 bytes, NUL padded
+ *   layers   32-byte records: type, window, zero points, clamp, output
+ *            shape, weights offset, params offset
+ *   data     int8 weights; int32 bias, int32 multiplier, int8 shift per
+ *            output channel
+ *   selftest optional input and the exporter's int8 output for it
+ *
+ * Weights are used in place, so the blob must outlive the model.
+ * Activations ping-pong between two halves of a caller-supplied arena.
+ */
+class LocalModel {
+public:
+    enum class LayerType : uint8_t {
+        Conv2d,
+        DepthwiseConv2d,
+        AveragePool,
+        MaxPool,
+        GlobalAveragePool,
+        FullyConnected,
+        Count
+    };
+
+    static constexpr int MAX_LAYERS = 64;
+    static constexpr int MAX_CLASSES = 8;
+    static constexpr int CLASS_NAME_LENGTH = 16;
+
+    /**
+     * Parse and validate a model blob
+     * @return false if the blob is not a valid model (see error())
+     */
+    bool load(const uint8_t* blob, size_t size);
+
+    /**
+     * Activation memory invoke() needs
+     */
+    size_t arenaBytes() const { return _halfBytes * 2; }
+
+    /**
+     * @param arena arenaBytes() bytes, 4-byte aligned; must outlive the model
+     */
+    void setArena(int8_t* arena) { _arena = arena; }
+
+    /**
+     * Where the caller writes the input (H x W x C, RGB, q = pixel + inputOffset())
+     */
+    int8_t* input() { return _arena; }
+    size_t inputSize() const { return _inputShape.size(); }
+
+    /**
+     * Run all layers on input()
+     * @return classCount() quantised outputs (inside the arena), nullptr without an arena
+     */
+    const int8_t* invoke();
+
+    /**
+     * Run the input stored by the exporter and compare with its output
+     * @return true if they match exactly; false if they differ or there is none
+     */
+    bool selfTest();
+    bool hasSelfTest() const { return _selfTestInput != nullptr; }
+
+    float dequantize(int8_t value) const { return (value - _outputZeroPoint) * _outputScale; }
+
+    uint16_t inputHeight() const { return _inputShape.height; }
+    uint16_t inputWidth() const { return _inputShape.width; }
+    uint16_t inputChannels() const { return _inputShape.channels; }
+    int inputOffset() const { return _inputOffset; }
+    int classCount() const { return _classCount; }
+    const char* className(int index) const;
+    int layerCount() const { return _layerCount; }
+
+    /**
+     * Multiply-accumulates per inference (convolution and dense layers)
+     */
+    uint32_t macs() const { return _macs; }
+
+    const char* error() const { return _error; }
+
+private:
+    struct Layer {
+        LayerType type = LayerType::Count;
+        Int8Window window;
+        int8_t padValue = 0;
+        Int8Shape in;
+        Int8Shape out;
+        const int8_t* weights = nullptr;
+        Int8Requant requant;
+    };
+
+    Layer _layers[MAX_LAYERS];
+    int _layerCount = 0;
+    Int8Shape _inputShape;
+    int _inputOffset = 0;
+    int _classCount = 0;
+    char _classNames[MAX_CLASSES][CLASS_NAME_LENGTH] = {};
+    float _outputScale = 1.0f;
+    int32_t _outputZeroPoint = 0;
+    const int8_t* _selfTestInput = nullptr;
+    const int8_t* _selfTestOutput = nullptr;
+    size_t _halfBytes = 0;
+    uint32_t _macs = 0;
+    int8_t* _arena = nullptr;
+    const char* _error = nullptr;
+
+    bool fail(const char* error) {
+        _error = error;
+        _layerCount = 0;
+        return false;
+    }
+};
+
+#endif
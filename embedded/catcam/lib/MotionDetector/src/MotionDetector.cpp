@@ -1,5 +1,6 @@
 #include "MotionDetector.h"
 #include <SDLogger.h>
+#include <esp_timer.h>
 
 MotionDetector::MotionDetector(int pirPin)
     : _pirPin(pirPin)
@@ -8,6 +9,7 @@ MotionDetector::MotionDetector(int pirPin)
     , _lastDebounce(0)
     , _cooldownStart(0)
     , _inCooldown(false)
+    , _lastMotionUs(0)
 {
     pinMode(_pirPin, INPUT);
 }
@@ -23,6 +25,7 @@ void MotionDetector::update() {
             // Valid motion event - check cooldown
             if (!_inCooldown) {
                 _motionDetected = true;
+                _lastMotionUs = esp_timer_get_time();
                 SDLogger::getInstance().debugf("MotionDetector: Rising edge detected");
             } else {
                 unsigned long remaining = getCooldownRemaining();
@@ -55,6 +58,12 @@ bool MotionDetector::wasMotionDetected() {
     return false;
 }
 
+void MotionDetector::startCooldown() {
+    _motionDetected = false;
+    _cooldownStart = millis();
+    _inCooldown = true;
+}
+
 bool MotionDetector::isInCooldown() const {
     return _inCooldown;
 }
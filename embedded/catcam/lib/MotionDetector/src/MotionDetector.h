@@ -35,6 +35,18 @@ public:
      */
     bool wasMotionDetected();
 
+    /**
+     * Start the cooldown without an event, e.g. while a camera-triggered
+     * detection is being handled
+     */
+    void startCooldown();
+
+    /**
+     * Time of the most recent accepted rising edge
+     * @return esp_timer_get_time() microseconds, or 0 if no motion yet
+     */
+    int64_t getLastMotionUs() const { return _lastMotionUs; }
+
     /**
      * Check if currently in cooldown period
      * @return true if cooldown is active
@@ -67,4 +79,5 @@ private:
     unsigned long _lastDebounce;  // Time of last state change (debounce)
     unsigned long _cooldownStart; // Time cooldown started
     bool _inCooldown;             // Currently in cooldown period
+    int64_t _lastMotionUs;        // esp_timer time of the last accepted rising edge
 };
@@ -138,6 +138,22 @@ bool PCF8574Manager::readPIRSensor() {
     return readPinInput(PIR_SENSOR_PIN);
 }
 
+bool PCF8574Manager::readLightSensor() {
+    // LDR comparator modules pull their output low above the threshold. With
+    // nothing fitted P1 floats high, and a failed read also reports dark, so
+    // captures keep the flash.
+    if (!isSafeToOperate()) {
+        return false;
+    }
+
+    uint8_t data;
+    if (!readFromDevice(data)) {
+        return false;
+    }
+
+    return (data & (1 << LIGHT_SENSOR_PIN)) == 0;
+}
+
 bool PCF8574Manager::isConnected() {
     Wire.beginTransmission(_i2cAddress);
     uint8_t error = Wire.endTransmission();
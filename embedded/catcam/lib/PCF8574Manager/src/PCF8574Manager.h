@@ -79,6 +79,7 @@ public:
     bool setLedStrip(bool on);
     bool readPressureSensor();
     bool readPIRSensor();
+    bool readLightSensor();     // true = brighter than the module's threshold; false if unreadable
 
     // System health and safety
     bool isConnected();
@@ -0,0 +1,166 @@
+#include "SlabAllocator.h"
+#include <string.h>
+
+SlabAllocator& SlabAllocator::getInstance() {
+    static SlabAllocator instance;
+    return instance;
+}
+
+SlabAllocator::~SlabAllocator() {
+    deinit();
+}
+
+bool SlabAllocator::init(const SizeClass* classes, size_t classCount,
+                         BackingAlloc backingAlloc, BackingFree backingFree) {
+    deinit();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _backingFree = backingFree;
+
+    for (size_t i = 0; i < classCount && _classCount < MAX_CLASSES; i++) {
+        // Blocks hold a free-list pointer while free, so keep them pointer aligned
+        size_t blockSize = (classes[i].blockSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        size_t blockCount = classes[i].blockCount;
+        if (blockSize == 0 || blockCount == 0) continue;
+
+        // The in-use bitmap shares the arena's allocation, after the blocks
+        size_t bitmapBytes = (blockCount + 31) / 32 * sizeof(uint32_t);
+        uint8_t* base = (uint8_t*)backingAlloc(blockSize * blockCount + bitmapBytes);
+        if (!base) continue;
+
+        Arena& arena = _arenas[_classCount++];
+        arena.base = base;
+        arena.blockSize = blockSize;
+        arena.blockCount = blockCount;
+        arena.inUse = 0;
+        arena.peakInUse = 0;
+        arena.allocations = 0;
+        arena.inUseBits = (uint32_t*)(base + blockSize * blockCount);
+        memset(arena.inUseBits, 0, bitmapBytes);
+
+        // Thread every block onto the free list, lowest address first
+        arena.freeList = nullptr;
+        for (size_t b = blockCount; b > 0; b--) {
+            FreeBlock* block = (FreeBlock*)(base + (b - 1) * blockSize);
+            block->next = arena.freeList;
+            arena.freeList = block;
+        }
+    }
+
+    return _classCount > 0;
+}
+
+void SlabAllocator::deinit() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < _classCount; i++) {
+        if (_backingFree) {
+            _backingFree(_arenas[i].base);
+        }
+        _arenas[i] = Arena();
+    }
+    _classCount = 0;
+    _failures = 0;
+    _badReleases = 0;
+}
+
+void* SlabAllocator::allocate(size_t size) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t i = 0; i < _classCount; i++) {
+        Arena& arena = _arenas[i];
+        if (arena.blockSize < size || !arena.freeList) continue;
+
+        FreeBlock* block = arena.freeList;
+        arena.freeList = block->next;
+        size_t b = ((uint8_t*)block - arena.base) / arena.blockSize;
+        arena.inUseBits[b / 32] |= 1u << (b % 32);
+        arena.inUse++;
+        arena.allocations++;
+        if (arena.inUse > arena.peakInUse) {
+            arena.peakInUse = arena.inUse;
+        }
+        return block;
+    }
+
+    _failures++;
+    return nullptr;
+}
+
+void SlabAllocator::release(void* ptr) {
+    if (!ptr) return;
+
+    const char* error = nullptr;
+    ReleaseErrorHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        int index = arenaIndexOf(ptr);
+        if (index < 0) return;
+
+        Arena& arena = _arenas[index];
+        size_t offset = (uint8_t*)ptr - arena.base;
+        size_t b = offset / arena.blockSize;
+        uint32_t bit = 1u << (b % 32);
+        if (offset % arena.blockSize != 0) {
+            error = "not the start of a block";
+        } else if (!(arena.inUseBits[b / 32] & bit)) {
+            error = "double free";
+        } else {
+            arena.inUseBits[b / 32] &= ~bit;
+            FreeBlock* block = (FreeBlock*)ptr;
+            block->next = arena.freeList;
+            arena.freeList = block;
+            arena.inUse--;
+            return;
+        }
+        _badReleases++;
+        handler = _releaseErrorHandler;
+    }
+    if (handler) {
+        handler(ptr, error);
+    }
+}
+
+bool SlabAllocator::owns(const void* ptr) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return arenaIndexOf(ptr) >= 0;
+}
+
+size_t SlabAllocator::blockSizeOf(const void* ptr) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int index = arenaIndexOf(ptr);
+    return index < 0 ? 0 : _arenas[index].blockSize;
+}
+
+SlabAllocator::ClassStats SlabAllocator::classStats(size_t index) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ClassStats stats = {};
+    if (index < _classCount) {
+        const Arena& arena = _arenas[index];
+        stats.blockSize = arena.blockSize;
+        stats.blockCount = arena.blockCount;
+        stats.inUse = arena.inUse;
+        stats.peakInUse = arena.peakInUse;
+        stats.allocations = arena.allocations;
+    }
+    return stats;
+}
+
+size_t SlabAllocator::reservedBytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t total = 0;
+    for (size_t i = 0; i < _classCount; i++) {
+        total += _arenas[i].blockSize * _arenas[i].blockCount;
+    }
+    return total;
+}
+
+int SlabAllocator::arenaIndexOf(const void* ptr) const {
+    const uint8_t* p = (const uint8_t*)ptr;
+    for (size_t i = 0; i < _classCount; i++) {
+        const Arena& arena = _arenas[i];
+        if (p >= arena.base && p < arena.base + arena.blockSize * arena.blockCount) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,135 @@
+#ifndef CATCAM_SLABALLOCATOR_H
+#define CATCAM_SLABALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+/**
+ * SlabAllocator - Fixed-block arena for frame-sized buffers
+ *
+ * Large per-capture allocations (image copies, upload chunks, transcoded
+ * frames) fragment PSRAM over days of uptime until big requests start to
+ * fail. The slab reserves one arena per size class at boot and hands out
+ * fixed-size blocks from intrusive free lists, so the heap layout never
+ * changes after init().
+ *
+ * allocate() picks the smallest class that fits and falls through to larger
+ * classes when a class is exhausted. Failures are counted, never fatal:
+ * callers fall back to the regular heap or report an error.
+ *
+ * Each block has an in-use bit, so release() can refuse a double free or a
+ * pointer that is not the start of a block instead of corrupting the free
+ * list. Refused releases are counted and passed to the release error
+ * handler, if one is set.
+ *
+ * Portable C++ (std::mutex, no Arduino dependency) so the allocator can be
+ * exercised on the host with malloc() as the backing store.
+ */
+class SlabAllocator {
+public:
+    struct SizeClass {
+        size_t blockSize;
+        size_t blockCount;
+    };
+
+    struct ClassStats {
+        size_t blockSize;
+        size_t blockCount;
+        size_t inUse;
+        size_t peakInUse;
+        uint32_t allocations;
+    };
+
+    using BackingAlloc = void* (*)(size_t size);
+    using BackingFree = void (*)(void* ptr);
+    using ReleaseErrorHandler = void (*)(const void* ptr, const char* reason);
+
+    static constexpr size_t MAX_CLASSES = 6;
+
+    static SlabAllocator& getInstance();
+
+    SlabAllocator() = default;
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    /**
+     * Reserve one arena per size class
+     * Classes must be given in ascending block size. A class whose arena
+     * cannot be reserved is dropped (and logged by the caller via stats).
+     * @return true if at least one class was reserved
+     */
+    bool init(const SizeClass* classes, size_t classCount,
+              BackingAlloc backingAlloc, BackingFree backingFree);
+
+    /**
+     * Release all arenas (blocks still in use become invalid)
+     */
+    void deinit();
+
+    bool isInitialized() const { return _classCount > 0; }
+
+    /**
+     * Take a block of at least size bytes
+     * @return Block pointer, or nullptr if no class can satisfy the request
+     */
+    void* allocate(size_t size);
+
+    /**
+     * Return a block obtained from allocate(); nullptr is ignored
+     * A double free, or a pointer into an arena that is not the start of a
+     * block, leaves the allocator unchanged and is reported as a bad release.
+     * Pointers outside every arena are ignored.
+     */
+    void release(void* ptr);
+
+    /**
+     * Called (outside the allocator's lock) for every bad release
+     */
+    void setReleaseErrorHandler(ReleaseErrorHandler handler) { _releaseErrorHandler = handler; }
+
+    /**
+     * True if ptr lies inside one of the arenas
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * Usable size of the block holding ptr (0 if not owned)
+     */
+    size_t blockSizeOf(const void* ptr) const;
+
+    size_t classCount() const { return _classCount; }
+    ClassStats classStats(size_t index) const;
+    uint32_t failureCount() const { return _failures; }
+    uint32_t badReleaseCount() const { return _badReleases; }
+    size_t reservedBytes() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Arena {
+        uint8_t* base;
+        size_t blockSize;
+        size_t blockCount;
+        FreeBlock* freeList;
+        uint32_t* inUseBits;  // One bit per block, stored after the blocks
+        size_t inUse;
+        size_t peakInUse;
+        uint32_t allocations;
+    };
+
+    Arena _arenas[MAX_CLASSES] = {};
+    size_t _classCount = 0;
+    uint32_t _failures = 0;
+    uint32_t _badReleases = 0;
+    BackingFree _backingFree = nullptr;
+    ReleaseErrorHandler _releaseErrorHandler = nullptr;
+    mutable std::mutex _mutex;
+
+    int arenaIndexOf(const void* ptr) const;
+};
+
+#endif
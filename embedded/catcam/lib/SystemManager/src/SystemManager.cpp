@@ -4,6 +4,8 @@
 #include <WiFi.h>
 #include <BLEDevice.h>
 #include <SDLogger.h>
+#include <SlabAllocator.h>
+#include <esp32-hal-psram.h>
 
 #include "SystemState.h"
 #include "WifiConnect.h"
@@ -12,19 +14,37 @@
 #include "OTAUpdate.h"
 #include "PCF8574Manager.h"
 #include "AWSAuth.h"
+#include "ApiConnection.h"
 #include "Camera.h"
+#include "FrameRing.h"
 #include "VideoRecorder.h"
 #include "ImageStorage.h"
 #include "LedController.h"
 #include "CaptureController.h"
 #include "InputManager.h"
 #include "MotionDetector.h"
+#include "VisualMotionDetector.h"
 #include "DeterrentController.h"
 #include "CommandDispatcher.h"
 #include "MqttService.h"
 #include "MqttOTA.h"
 #include "secrets.h"
 
+// Fixed PSRAM slab classes (~700 KB), sized from what is allocated per capture/upload:
+// - 4 KB: ApiConnection request head (SigV4 headers and session token, ~2 KB)
+// - 16 KB: DeterrentController's SD-to-TLS video upload chunk
+// - 96 KB: crop and transcode outputs of an SVGA decision frame, plus one
+//   copy-mode frame of that size
+// - 384 KB: one copy-mode UXGA frame (the driver's own JPEG buffer size)
+// Less common combinations (bursts in copy mode, crops of full frames) fall
+// back to ps_malloc().
+static const SlabAllocator::SizeClass SLAB_CLASSES[] = {
+    { 4 * 1024, 2 },
+    { 16 * 1024, 1 },
+    { 96 * 1024, 3 },
+    { 384 * 1024, 1 },
+};
+
 SystemManager::SystemManager()
     : _wifiConnect(nullptr)
     , _bluetoothService(nullptr)
@@ -33,10 +53,12 @@ SystemManager::SystemManager()
     , _pcfManager(nullptr)
     , _awsAuth(nullptr)
     , _camera(nullptr)
+    , _frameRing(nullptr)
     , _videoRecorder(nullptr)
     , _imageStorage(nullptr)
     , _captureController(nullptr)
     , _motionDetector(nullptr)
+    , _visualMotionDetector(nullptr)
     , _deterrentController(nullptr)
     , _commandDispatcher(nullptr)
     , _mqttService(nullptr)
@@ -51,10 +73,12 @@ SystemManager::~SystemManager() {
     delete _mqttService;
     delete _commandDispatcher;
     delete _deterrentController;
+    delete _visualMotionDetector;
     delete _motionDetector;
     delete _captureController;
     delete _imageStorage;
     delete _videoRecorder;
+    delete _frameRing;
     delete _camera;
     delete _awsAuth;
     delete _pcfManager;
@@ -82,6 +106,22 @@ bool SystemManager::initHardware(const Config& config, SystemState& state, Input
     SDLogger::getInstance().infof("I2C initialized on GPIO%d (SDA) and GPIO%d (SCL) with internal pull-ups",
                                    config.i2cSDA, config.i2cSCL);
 
+    // Reserve frame-sized buffers before anything else can fragment PSRAM
+    if (psramFound()) {
+        SlabAllocator& slab = SlabAllocator::getInstance();
+        slab.setReleaseErrorHandler([](const void* ptr, const char* reason) {
+            SDLogger::getInstance().errorf("Slab allocator: bad release of %p (%s) - ignored", ptr, reason);
+        });
+        if (slab.init(SLAB_CLASSES, sizeof(SLAB_CLASSES) / sizeof(SLAB_CLASSES[0]),
+                      [](size_t size) -> void* { return ps_malloc(size); },
+                      [](void* ptr) { free(ptr); })) {
+            SDLogger::getInstance().infof("Slab allocator reserved %d KB in %d size classes",
+                                           slab.reservedBytes() / 1024, slab.classCount());
+        } else {
+            SDLogger::getInstance().warnf("Slab allocator could not reserve PSRAM - using heap");
+        }
+    }
+
     SDLogger::getInstance().infof("Hardware initialization complete");
     return true;
 }
@@ -97,6 +137,7 @@ bool SystemManager::initComponents(const Config& config, SystemState& state,
 
         // Initialize image storage for captured photos
         _imageStorage = new ImageStorage();
+        _imageStorage->setResponseSidecar(state.pipelineSettings.responseSidecar);
         if (_imageStorage->init(config.imagesDir, config.maxImagesToKeep)) {
             SDLogger::getInstance().infof("Image storage initialized");
         } else {
@@ -142,9 +183,18 @@ bool SystemManager::initComponents(const Config& config, SystemState& state,
             _captureController = new CaptureController(_camera, _videoRecorder, &ledController,
                                                         _imageStorage, _awsAuth);
             _captureController->setAWSConfig(config.awsRoleAlias, config.apiHost, config.apiPath);
-            _captureController->init(state.cameraSettings);
+            _captureController->init(state.cameraSettings, state.pipelineSettings);
             state.cameraReady = _camera->isReady();
 
+            // Pre-trigger ring (idle unless preTriggerFrames > 0)
+            _frameRing = new FrameRing();
+            if (state.cameraReady) {
+                _frameRing->configure(state.pipelineSettings);
+            }
+            _captureController->setFrameRing(_frameRing);
+            _videoRecorder->setPreRollSource(_frameRing);
+            _videoRecorder->setCamera(_camera);
+
             // Set callbacks for background task handling during LED animations
             _captureController->setCallbacks(
                 [&inputManager]() { return inputManager.isBootButtonPressed(); },
@@ -159,6 +209,9 @@ bool SystemManager::initComponents(const Config& config, SystemState& state,
                 _captureController->setFlashCallback([this](bool on) {
                     _pcfManager->setLedStrip(on);
                 });
+                _captureController->setLightCallback([this]() {
+                    return _pcfManager->readLightSensor();
+                });
             }
 
             SDLogger::getInstance().infof("=== Press BOOT to record video ===");
@@ -262,10 +315,18 @@ bool SystemManager::initComponents(const Config& config, SystemState& state,
         SDLogger::getInstance().infof("Motion Detector initialized on GPIO %d", PIR_GPIO_PIN);
     }
 
+    // Camera-based motion trigger (idle unless enabled in settings)
+    if (_camera) {
+        _visualMotionDetector = new VisualMotionDetector(_camera);
+        _visualMotionDetector->setFrameRing(_frameRing);
+        _visualMotionDetector->configure(state.pipelineSettings.visualMotion);
+    }
+
     // Initialize Deterrent Controller (requires PCF8574Manager, CaptureController, and AWSAuth)
     if (_pcfManager && state.pcf8574Ready && _captureController && _awsAuth) {
         _deterrentController = new DeterrentController(_pcfManager, _captureController, _awsAuth);
         _deterrentController->setUploadConfig("api.bootboots.sandbox.nakomis.com");
+        _deterrentController->setVideoProfile((CameraProfile)state.cameraSettings.videoProfile);
         SDLogger::getInstance().infof("Deterrent Controller initialized (duration: %lu ms, threshold configurable via MQTT)",
                                        DeterrentController::DETERRENT_DURATION_MS);
         SDLogger::getInstance().infof("Video upload enabled to api.bootboots.sandbox.nakomis.com");
@@ -297,6 +358,41 @@ void SystemManager::update(SystemState& state) {
         _motionDetector->update();
     }
 
+    if (_visualMotionDetector) {
+        _visualMotionDetector->update();
+        state.visualMotionCostUs = _visualMotionDetector->getAverageCostUs();
+        state.visualMotionIntervalMs = _visualMotionDetector->getIntervalMs();
+    }
+
+    if (_captureController) {
+        // Camera motion detection needs frames, so the sensor stays awake while it is on
+        _captureController->updateStandby(!(_visualMotionDetector && _visualMotionDetector->isEnabled()));
+        state.cameraStandby = _captureController->getStandbyStatus();
+        state.uploadHash = _captureController->getUploadHashStatus();
+        state.jpegQualityControl = _captureController->getQualityStatus();
+        state.frameGate = _captureController->getFrameGateStatus();
+        state.uploadTranscode = _captureController->getTranscodeStatus();
+        state.inferenceCache = _captureController->getInferenceCacheStatus();
+        state.localInference = _captureController->getLocalInferenceStatus();
+        state.capturePolicy = _captureController->getCapturePolicyStatus();
+        state.exposureSettleMs = _captureController->getLastSettleMs();
+        state.exposureSettleSavedMs = _captureController->getSettleSavedMs();
+    }
+
+    if (_camera) {
+        state.cameraProfile = (int)_camera->getProfile();
+        for (size_t from = 0; from < CAMERA_PROFILE_COUNT; from++) {
+            for (size_t to = 0; to < CAMERA_PROFILE_COUNT; to++) {
+                state.profileSwitchMs[from][to] = _camera->getProfileSwitchMs((CameraProfile)from, (CameraProfile)to);
+            }
+        }
+    }
+
+    // Let the warm API connection go once idle or when RAM is short
+    ApiConnection& apiConnection = ApiConnection::getInstance();
+    apiConnection.maintain();
+    state.apiConnection = apiConnection.status();
+
     // Update WiFi connection status
     updateWifiStatus(state);
 }
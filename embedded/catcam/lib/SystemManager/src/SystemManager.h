@@ -11,12 +11,14 @@ class OTAUpdate;
 class PCF8574Manager;
 class AWSAuth;
 class Camera;
+class FrameRing;
 class VideoRecorder;
 class ImageStorage;
 class LedController;
 class CaptureController;
 class InputManager;
 class MotionDetector;
+class VisualMotionDetector;
 class DeterrentController;
 class CommandDispatcher;
 class MqttService;
@@ -103,10 +105,12 @@ public:
     WifiConnect* getWifiConnect() { return _wifiConnect; }
     AWSAuth* getAwsAuth() { return _awsAuth; }
     Camera* getCamera() { return _camera; }
+    FrameRing* getFrameRing() { return _frameRing; }
     VideoRecorder* getVideoRecorder() { return _videoRecorder; }
     ImageStorage* getImageStorage() { return _imageStorage; }
     CaptureController* getCaptureController() { return _captureController; }
     MotionDetector* getMotionDetector() { return _motionDetector; }
+    VisualMotionDetector* getVisualMotionDetector() { return _visualMotionDetector; }
     DeterrentController* getDeterrentController() { return _deterrentController; }
     CommandDispatcher* getCommandDispatcher() { return _commandDispatcher; }
     MqttService* getMqttService() { return _mqttService; }
@@ -121,10 +125,12 @@ private:
     PCF8574Manager* _pcfManager;
     AWSAuth* _awsAuth;
     Camera* _camera;
+    FrameRing* _frameRing;
     VideoRecorder* _videoRecorder;
     ImageStorage* _imageStorage;
     CaptureController* _captureController;
     MotionDetector* _motionDetector;
+    VisualMotionDetector* _visualMotionDetector;
     DeterrentController* _deterrentController;
     CommandDispatcher* _commandDispatcher;
     MqttService* _mqttService;
@@ -1,4 +1,5 @@
 #include "VideoRecorder.h"
+#include "Camera.h"
 #include "../../SDLogger/src/SDLogger.h"
 
 // AVI uses little-endian format
@@ -25,9 +26,7 @@ static void writeFourCC(File& file, const char* fourcc) {
 VideoRecorder::VideoRecorder()
     : _initialized(false)
     , _isRecording(false)
-    , _stopRequested(false)
-    , _originalFrameSize(FRAMESIZE_UXGA)
-    , _originalQuality(10) {
+    , _stopRequested(false) {
 }
 
 bool VideoRecorder::init() {
@@ -39,11 +38,11 @@ bool VideoRecorder::init() {
 
 VideoConfig VideoRecorder::getDefaultConfig() {
     VideoConfig config;
-    config.frameSize = FRAMESIZE_VGA;      // 640x480
-    config.quality = 12;                    // Good quality JPEG
+    config.profile = CameraProfile::Video;  // 640x480, quality 12
     config.fps = 10;                        // 10 frames per second
     config.durationSeconds = 10;            // 10 second video
     config.outputDir = "/videos";
+    config.includePreRoll = false;
     return config;
 }
 
@@ -77,14 +76,14 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
     _isRecording = true;
     _stopRequested = false;
 
-    // Save current camera settings
-    saveOriginalCameraSettings();
+    // Keep the pre-trigger ring off the camera while it is reconfigured
+    if (_preRoll) _preRoll->pause();
 
     // Configure camera for video
-    if (!setCameraForVideo(config)) {
+    if (!switchCameraForVideo(config)) {
         result.errorMessage = "Failed to configure camera for video";
         SDLogger::getInstance().errorf("VideoRecorder: %s", result.errorMessage.c_str());
-        restoreOriginalCameraSettings();
+        if (_preRoll) _preRoll->resume();
         _isRecording = false;
         return result;
     }
@@ -101,7 +100,7 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
 
     // Get frame dimensions
     uint16_t width = 0, height = 0;
-    switch (config.frameSize) {
+    switch ((framesize_t)_camera->getProfileSettings(config.profile).frameSize) {
         case FRAMESIZE_QVGA:  width = 320;  height = 240;  break;
         case FRAMESIZE_CIF:   width = 400;  height = 296;  break;
         case FRAMESIZE_VGA:   width = 640;  height = 480;  break;
@@ -123,7 +122,8 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
     if (!aviFile) {
         result.errorMessage = "Failed to create video file";
         SDLogger::getInstance().errorf("VideoRecorder: %s", result.errorMessage.c_str());
-        restoreOriginalCameraSettings();
+        restoreCameraProfile();
+        if (_preRoll) _preRoll->resume();
         _isRecording = false;
         return result;
     }
@@ -224,22 +224,47 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
     writeFourCC(aviFile, "movi");
 
     size_t moviDataStart = aviFile.position();
+    uint32_t frameCount = 0;
+
+    // Write one "00dc" chunk and record it in the index
+    auto writeFrame = [&](const uint8_t* data, size_t len) {
+        _frameIndex[frameCount].offset = aviFile.position() - moviDataStart;
+        _frameIndex[frameCount].size = len;
+
+        writeFourCC(aviFile, "00dc");
+        writeU32(aviFile, len);
+        aviFile.write(data, len);
+
+        // Pad to even boundary if needed
+        if (len & 1) {
+            uint8_t pad = 0;
+            aviFile.write(&pad, 1);
+        }
+
+        frameCount++;
+    };
+
+    // === Pre-roll from the pre-trigger ring ===
+    // Added on top of the live frames, within the index capacity
+    if (config.includePreRoll && _preRoll) {
+        _preRoll->forEachSince(0, [&](const uint8_t* data, size_t size, int64_t timestampUs) {
+            if (frameCount + targetFrames < MAX_FRAMES) {
+                writeFrame(data, size);
+            }
+        });
+        SDLogger::getInstance().infof("Prepended %d pre-roll frames", frameCount);
+    }
+    uint32_t preRollCount = frameCount;
 
     // === Record frames ===
     SDLogger::getInstance().infof("Starting video capture: %d fps, %d seconds", config.fps, config.durationSeconds);
 
-    // Flush any stale frames
-    for (int i = 0; i < 3; i++) {
-        camera_fb_t* stale = esp_camera_fb_get();
-        if (stale) esp_camera_fb_return(stale);
-        delay(10);
-    }
+    // No stale-frame flush: the profile switch already dropped the frames it had to
 
     unsigned long startTime = millis();
     unsigned long lastFrameTime = startTime;
-    uint32_t frameCount = 0;
 
-    while (frameCount < targetFrames && !_stopRequested) {
+    while (frameCount - preRollCount < targetFrames && !_stopRequested) {
         unsigned long currentTime = millis();
         unsigned long elapsedSinceLastFrame = currentTime - lastFrameTime;
 
@@ -256,28 +281,14 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
             continue;
         }
 
-        // Record frame position for index
-        _frameIndex[frameCount].offset = aviFile.position() - moviDataStart;
-        _frameIndex[frameCount].size = fb->len;
-
         // Write frame chunk: "00dc" + size + data
-        writeFourCC(aviFile, "00dc");
-        writeU32(aviFile, fb->len);
-        aviFile.write(fb->buf, fb->len);
-
-        // Pad to even boundary if needed
-        if (fb->len & 1) {
-            uint8_t pad = 0;
-            aviFile.write(&pad, 1);
-        }
-
-        frameCount++;
+        writeFrame(fb->buf, fb->len);
         esp_camera_fb_return(fb);
         lastFrameTime = currentTime;
 
         // Progress callback
         if (callback) {
-            callback(frameCount, targetFrames, currentTime - startTime);
+            callback(frameCount - preRollCount, targetFrames, currentTime - startTime);
         }
 
         yield();
@@ -327,7 +338,8 @@ VideoResult VideoRecorder::recordWithProgress(const VideoConfig& config, VideoPr
     aviFile.close();
 
     // Restore original camera settings
-    restoreOriginalCameraSettings();
+    restoreCameraProfile();
+    if (_preRoll) _preRoll->resume();
 
     _isRecording = false;
     result.success = true;
@@ -365,46 +377,29 @@ String VideoRecorder::generateFilename(const char* outputDir) {
     return String(filename);
 }
 
-void VideoRecorder::saveOriginalCameraSettings() {
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        _originalFrameSize = (framesize_t)sensor->status.framesize;
-        _originalQuality = sensor->status.quality;
-        SDLogger::getInstance().debugf("Saved camera settings: framesize=%d, quality=%d",
-            _originalFrameSize, _originalQuality);
-    }
-}
-
-void VideoRecorder::restoreOriginalCameraSettings() {
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (sensor) {
-        sensor->set_framesize(sensor, _originalFrameSize);
-        sensor->set_quality(sensor, _originalQuality);
-        SDLogger::getInstance().debugf("Restored camera settings: framesize=%d, quality=%d",
-            _originalFrameSize, _originalQuality);
-    }
-}
-
-bool VideoRecorder::setCameraForVideo(const VideoConfig& config) {
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (!sensor) {
-        SDLogger::getInstance().errorf("Failed to get camera sensor");
+bool VideoRecorder::switchCameraForVideo(const VideoConfig& config) {
+    if (!_camera || !_camera->isReady()) {
+        SDLogger::getInstance().errorf("Camera not available for video");
         return false;
     }
 
-    if (sensor->set_framesize(sensor, config.frameSize) != 0) {
-        SDLogger::getInstance().errorf("Failed to set frame size");
-        return false;
-    }
+    _previousProfile = _camera->getProfile();
 
-    if (sensor->set_quality(sensor, config.quality) != 0) {
-        SDLogger::getInstance().errorf("Failed to set quality");
-        return false;
+    // Only restarts the driver if tune_camera found a different setup for video
+    if (!_camera->useDriverFor(CameraUseCase::Video)) {
+        SDLogger::getInstance().warnf("Video driver config unavailable - recording with the stills one");
     }
+    _camera->setProfile(config.profile);
 
-    SDLogger::getInstance().infof("Camera configured for video: framesize=%d, quality=%d",
-        config.frameSize, config.quality);
-
-    delay(100);
+    const CameraSettings& settings = _camera->getProfileSettings(config.profile);
+    SDLogger::getInstance().infof("Camera configured for video: %s profile, framesize=%d, quality=%d",
+        cameraProfileName(config.profile), settings.frameSize, settings.jpegQuality);
     return true;
 }
+
+void VideoRecorder::restoreCameraProfile() {
+    if (_camera) {
+        _camera->setProfile(_previousProfile);
+        _camera->useDriverFor(CameraUseCase::Stills);
+    }
+}
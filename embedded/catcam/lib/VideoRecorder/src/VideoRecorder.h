@@ -5,14 +5,18 @@
 #include <SD_MMC.h>
 #include <esp_camera.h>
 #include <functional>
+#include "FrameRing.h"
+#include "CameraProfiles.h"
+
+class Camera;
 
 // Video recording configuration
 struct VideoConfig {
-    framesize_t frameSize;      // Camera frame size (default: VGA 640x480)
-    uint8_t quality;            // JPEG quality 0-63 (lower = better, default: 12)
+    CameraProfile profile;      // Camera profile while recording (default: Video - VGA, quality 12)
     uint8_t fps;                // Target frames per second (default: 10)
     uint16_t durationSeconds;   // Recording duration in seconds (default: 10)
     const char* outputDir;      // Output directory (default: "/videos")
+    bool includePreRoll;        // Prepend frames held in the pre-trigger ring (default: false)
 };
 
 // Recording result
@@ -75,14 +79,29 @@ public:
      */
     static VideoConfig getDefaultConfig();
 
+    /**
+     * Set the pre-trigger ring used for pre-roll (optional)
+     * The ring is paused for the duration of every recording because the
+     * camera is reconfigured for video. Pre-roll frames keep the still frame
+     * size, which MJPEG players handle per frame.
+     */
+    void setPreRollSource(FrameRing* frameRing) { _preRoll = frameRing; }
+
+    /**
+     * Set the camera whose profiles are switched around each recording
+     */
+    void setCamera(Camera* camera) { _camera = camera; }
+
 private:
     bool _initialized;
     volatile bool _isRecording;
     volatile bool _stopRequested;
+    FrameRing* _preRoll = nullptr;
+
+    Camera* _camera = nullptr;
 
-    // Original camera settings to restore after recording
-    framesize_t _originalFrameSize;
-    int _originalQuality;
+    // Profile to switch back to after recording
+    CameraProfile _previousProfile = CameraProfile::Photo;
 
     // AVI file writing helpers
     bool writeAviHeader(File& file, uint16_t width, uint16_t height, uint8_t fps, uint32_t totalFrames);
@@ -99,9 +118,8 @@ private:
 
     // Utility
     String generateFilename(const char* outputDir);
-    void saveOriginalCameraSettings();
-    void restoreOriginalCameraSettings();
-    bool setCameraForVideo(const VideoConfig& config);
+    bool switchCameraForVideo(const VideoConfig& config);
+    void restoreCameraProfile();
 };
 
 #endif
@@ -0,0 +1,89 @@
+#include "BlockMotion.h"
+
+BlockMotion::BlockMotion(uint8_t blockCells, uint8_t blockDelta)
+    : _blockCells(blockCells ? blockCells : 1), _blockDelta(blockDelta) {
+}
+
+static void roiBounds(const MotionRoi& roi, uint16_t width, uint16_t height,
+                      int& x0, int& y0, int& x1, int& y1) {
+    int rx = roi.x > 100 ? 100 : roi.x;
+    int ry = roi.y > 100 ? 100 : roi.y;
+    int rw = roi.width + rx > 100 ? 100 - rx : roi.width;
+    int rh = roi.height + ry > 100 ? 100 - ry : roi.height;
+    x0 = rx * width / 100;
+    y0 = ry * height / 100;
+    x1 = (rx + rw) * width / 100;
+    y1 = (ry + rh) * height / 100;
+}
+
+uint16_t BlockMotion::roiRowLimit(uint16_t mapHeight) const {
+    int x0, y0, x1, y1;
+    roiBounds(_roi, 1, mapHeight, x0, y0, x1, y1);
+    return (uint16_t)y1;
+}
+
+BlockMotion::Result BlockMotion::compare(const uint8_t* map, uint16_t width, uint16_t height) {
+    Result result;
+
+    int x0, y0, x1, y1;
+    roiBounds(_roi, width, height, x0, y0, x1, y1);
+    int roiWidth = x1 - x0;
+    int roiHeight = y1 - y0;
+    if (!map || roiWidth <= 0 || roiHeight <= 0) {
+        return result;
+    }
+
+    size_t roiCells = (size_t)roiWidth * roiHeight;
+    bool comparable = _previous.size() == roiCells && _width == width && _height == height;
+
+    if (comparable) {
+        // Frame-wide shift over the ROI (exposure, flicker)
+        int32_t sumDiff = 0;
+        for (int y = 0; y < roiHeight; y++) {
+            const uint8_t* row = map + (y0 + y) * width + x0;
+            const uint8_t* prev = _previous.data() + y * roiWidth;
+            for (int x = 0; x < roiWidth; x++) {
+                sumDiff += (int32_t)row[x] - prev[x];
+            }
+        }
+        int32_t shift = sumDiff / (int32_t)roiCells;
+
+        for (int by = 0; by < roiHeight; by += _blockCells) {
+            int bh = roiHeight - by < _blockCells ? roiHeight - by : _blockCells;
+            for (int bx = 0; bx < roiWidth; bx += _blockCells) {
+                int bw = roiWidth - bx < _blockCells ? roiWidth - bx : _blockCells;
+                uint32_t sad = 0;
+                for (int y = by; y < by + bh; y++) {
+                    const uint8_t* row = map + (y0 + y) * width + x0;
+                    const uint8_t* prev = _previous.data() + y * roiWidth;
+                    for (int x = bx; x < bx + bw; x++) {
+                        int32_t d = (int32_t)row[x] - prev[x] - shift;
+                        sad += (uint32_t)(d < 0 ? -d : d);
+                    }
+                }
+                uint32_t meanDelta = sad / (uint32_t)(bw * bh);
+                if (meanDelta > result.maxBlockDelta) {
+                    result.maxBlockDelta = (uint8_t)(meanDelta > 255 ? 255 : meanDelta);
+                }
+                if (meanDelta > _blockDelta) {
+                    result.changedBlocks++;
+                }
+                result.totalBlocks++;
+            }
+        }
+        result.valid = true;
+    }
+
+    // Keep this frame's ROI for the next comparison
+    _width = width;
+    _height = height;
+    _previous.resize(roiCells);
+    for (int y = 0; y < roiHeight; y++) {
+        const uint8_t* row = map + (y0 + y) * width + x0;
+        uint8_t* prev = _previous.data() + y * roiWidth;
+        for (int x = 0; x < roiWidth; x++) {
+            prev[x] = row[x];
+        }
+    }
+    return result;
+}
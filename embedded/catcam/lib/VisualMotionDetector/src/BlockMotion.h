@@ -0,0 +1,66 @@
+#ifndef CATCAM_BLOCKMOTION_H
+#define CATCAM_BLOCKMOTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Region of interest in percent of the frame (0-100), origin top-left
+ */
+struct MotionRoi {
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t width = 100;
+    uint8_t height = 100;
+};
+
+/**
+ * BlockMotion - Block-based frame differencing over low-resolution luma maps
+ *
+ * Splits the ROI into square blocks of map cells and compares each block's
+ * mean absolute difference against the previous frame. The frame-wide mean
+ * shift is removed first so exposure steps and flicker do not register as
+ * motion. Plain C++ so the kernel builds and runs on the host.
+ */
+class BlockMotion {
+public:
+    struct Result {
+        bool valid = false;             // False on the first frame or after a size change
+        uint16_t changedBlocks = 0;
+        uint16_t totalBlocks = 0;
+        uint8_t maxBlockDelta = 0;      // Largest per-block mean difference seen
+    };
+
+    /**
+     * @param blockCells Block edge in map cells (4 = 32x32 pixels with a DC map)
+     * @param blockDelta Mean absolute luma difference for a block to count as changed
+     */
+    explicit BlockMotion(uint8_t blockCells = 4, uint8_t blockDelta = 10);
+
+    void setRoi(const MotionRoi& roi) { _roi = roi; _previous.clear(); }
+    void setBlockDelta(uint8_t delta) { _blockDelta = delta; }
+    const MotionRoi& roi() const { return _roi; }
+
+    /**
+     * Last map row the ROI needs (exclusive), for early-stopping decoders
+     */
+    uint16_t roiRowLimit(uint16_t mapHeight) const;
+
+    /**
+     * Compare a luma map with the previous one and keep it for next time
+     */
+    Result compare(const uint8_t* map, uint16_t width, uint16_t height);
+
+    void reset() { _previous.clear(); }
+
+private:
+    MotionRoi _roi;
+    uint8_t _blockCells;
+    uint8_t _blockDelta;
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    std::vector<uint8_t> _previous;  // ROI cells of the previous map, row-major
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "VisualMotionDetector.h"
+#include <SDLogger.h>
+#include <esp_timer.h>
+
+VisualMotionDetector::VisualMotionDetector(Camera* camera)
+    : _camera(camera)
+{
+}
+
+void VisualMotionDetector::configure(const VisualMotionSettings& settings) {
+    _enabled = settings.enabled;
+    _baseIntervalMs = 1000 / constrain(settings.fps, 1, 5);
+    _intervalMs = _baseIntervalMs;
+    _minBlocks = (uint16_t)constrain(settings.minBlocks, 1, 1000);
+    _maxCpuPercent = (uint8_t)constrain(settings.maxCpuPercent, 1, 50);
+    _avgCostUs = 0;
+    _throttled = false;
+
+    MotionRoi roi;
+    roi.x = (uint8_t)constrain(settings.roiX, 0, 99);
+    roi.y = (uint8_t)constrain(settings.roiY, 0, 99);
+    roi.width = (uint8_t)constrain(settings.roiWidth, 1, 100 - roi.x);
+    roi.height = (uint8_t)constrain(settings.roiHeight, 1, 100 - roi.y);
+    _motion.setRoi(roi);
+    _motion.setBlockDelta((uint8_t)constrain(settings.blockDelta, 1, 255));
+
+    SDLogger::getInstance().infof("VisualMotionDetector: %s (%d fps, ROI %d,%d %dx%d%%, delta %d, min %d blocks, cap %d%% CPU)",
+        _enabled ? "enabled" : "disabled", 1000 / _baseIntervalMs, roi.x, roi.y, roi.width, roi.height,
+        settings.blockDelta, _minBlocks, _maxCpuPercent);
+}
+
+void VisualMotionDetector::update() {
+    unsigned long now = millis();
+
+    if (_inCooldown && (now - _cooldownStart) >= COOLDOWN_MS) {
+        _inCooldown = false;
+        SDLogger::getInstance().debugf("VisualMotionDetector: Cooldown expired");
+    }
+
+    if (!_enabled || !_camera || !_camera->isReady() || (now - _lastSampleMs) < _intervalMs) {
+        return;
+    }
+    _lastSampleMs = now;
+
+    int64_t startUs = esp_timer_get_time();
+    FrameLease frame = grabFrame(startUs);
+    if (!frame) {
+        return;
+    }
+    _lastFrameUs = frame.timestampUs();
+
+    // Only decode as far down as the ROI reaches (map height is stable between frames)
+    uint16_t rowLimit = _map.height() ? _motion.roiRowLimit(_map.height()) : 0;
+    bool decoded = _map.build(frame.data(), frame.size(), rowLimit);
+    frame.reset();
+
+    if (!decoded) {
+        SDLogger::getInstance().warnf("VisualMotionDetector: Cannot read frame (%s)", _map.error());
+        return;
+    }
+
+    BlockMotion::Result result = _motion.compare(_map.data(), _map.width(), _map.height());
+    recordCost((uint32_t)(esp_timer_get_time() - startUs));
+
+    if (result.valid && result.changedBlocks >= _minBlocks) {
+        if (!_inCooldown && !_motionDetected) {
+            _motionDetected = true;
+            _lastMotionUs = _lastFrameUs;
+            SDLogger::getInstance().debugf("VisualMotionDetector: %d of %d blocks changed (max delta %d)",
+                result.changedBlocks, result.totalBlocks, result.maxBlockDelta);
+        }
+    }
+}
+
+bool VisualMotionDetector::wasMotionDetected() {
+    if (_motionDetected) {
+        _motionDetected = false;
+        startCooldown();
+        return true;
+    }
+    return false;
+}
+
+void VisualMotionDetector::startCooldown() {
+    _motionDetected = false;
+    _cooldownStart = millis();
+    _inCooldown = true;
+    // The scene after a trigger is handled is not comparable (flash, deterrent)
+    _motion.reset();
+}
+
+FrameLease VisualMotionDetector::grabFrame(int64_t nowUs) {
+    if (_frameRing && _frameRing->isRunning()) {
+        FrameLease frame = _frameRing->leaseNearest(nowUs, (int64_t)_intervalMs * 1000);
+        if (frame && frame.timestampUs() <= _lastFrameUs) {
+            return FrameLease();  // Already looked at this one
+        }
+        return frame;
+    }
+    // Any frame will do - no need to wait for one exposed after this instant
+    return _camera->captureFrameAfter(0, _intervalMs);
+}
+
+void VisualMotionDetector::recordCost(uint32_t costUs) {
+    _avgCostUs = _avgCostUs ? (_avgCostUs * 7 + costUs) / 8 : costUs;
+
+    // Stretch the interval so sampling stays within the CPU cap
+    uint32_t minIntervalMs = (_avgCostUs / 1000) * 100 / _maxCpuPercent;
+    uint32_t interval = max(_baseIntervalMs, minIntervalMs);
+    bool throttled = interval > _baseIntervalMs;
+    if (throttled != _throttled) {
+        _throttled = throttled;
+        if (throttled) {
+            SDLogger::getInstance().warnf("VisualMotionDetector: %lu us per frame exceeds %d%% CPU - sampling every %lu ms",
+                (unsigned long)_avgCostUs, _maxCpuPercent, (unsigned long)interval);
+        } else {
+            SDLogger::getInstance().infof("VisualMotionDetector: Back to sampling every %lu ms", (unsigned long)interval);
+        }
+    }
+    _intervalMs = interval;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Camera.h"
+#include "FrameRing.h"
+#include "DcLumaMap.h"
+#include "BlockMotion.h"
+#include "SystemState.h"
+
+/**
+ * VisualMotionDetector - Camera-based motion trigger alongside the PIR sensor
+ *
+ * Samples frames at a low rate (reusing pre-trigger ring frames when the
+ * ring is running, so the camera is not read twice), reduces each to a 1/8
+ * scale luma map from its DC coefficients and runs block differencing over
+ * the configured region of interest. Raises the same edge-style event as
+ * MotionDetector, with the same cooldown.
+ *
+ * Sampling cost is measured per frame; when the running average would use
+ * more than maxCpuPercent of the loop, the sample interval is stretched.
+ */
+class VisualMotionDetector {
+public:
+    static constexpr unsigned long COOLDOWN_MS = 30000;  // Matches MotionDetector
+
+    explicit VisualMotionDetector(Camera* camera);
+
+    /**
+     * Use frames from the pre-trigger ring while it is running
+     */
+    void setFrameRing(FrameRing* frameRing) { _frameRing = frameRing; }
+
+    /**
+     * Apply settings (rate, ROI, thresholds, cost cap); disabling drops the reference frame
+     */
+    void configure(const VisualMotionSettings& settings);
+
+    /**
+     * Sample a frame when one is due - call frequently from the main loop
+     */
+    void update();
+
+    /**
+     * Check if motion was detected since last call (starts the cooldown)
+     */
+    bool wasMotionDetected();
+
+    /**
+     * Hold off new events, e.g. while a PIR trigger is being handled
+     */
+    void startCooldown();
+
+    /**
+     * Capture time of the frame that raised the last event (esp_timer microseconds)
+     */
+    int64_t getLastMotionUs() const { return _lastMotionUs; }
+
+    bool isEnabled() const { return _enabled; }
+
+    /**
+     * Running average cost of one sample (grab + decode + compare)
+     */
+    uint32_t getAverageCostUs() const { return _avgCostUs; }
+
+    /**
+     * Current sample interval after the cost cap is applied
+     */
+    uint32_t getIntervalMs() const { return _intervalMs; }
+
+private:
+    Camera* _camera;
+    FrameRing* _frameRing = nullptr;
+
+    bool _enabled = false;
+    uint32_t _baseIntervalMs = 500;
+    uint32_t _intervalMs = 500;
+    uint16_t _minBlocks = 3;
+    uint8_t _maxCpuPercent = 15;
+
+    DcLumaMap _map;
+    BlockMotion _motion;
+
+    unsigned long _lastSampleMs = 0;
+    int64_t _lastFrameUs = 0;
+    uint32_t _avgCostUs = 0;
+    bool _throttled = false;
+
+    bool _motionDetected = false;
+    int64_t _lastMotionUs = 0;
+    bool _inCooldown = false;
+    unsigned long _cooldownStart = 0;
+
+    FrameLease grabFrame(int64_t nowUs);
+    void recordCost(uint32_t costUs);
+};
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+Print the inference result embedded in CatCam images.
+
+The camera stores each result in an APP10 segment of the saved JPEG
+("CatCamInf" identifier, key=value lines - see lib/JpegTools/src/JpegMetadata.h).
+Output is one JSON object per image, shaped like the inference response
+(mostLikelyCat.name / .index / .confidence) so jq filters written for the old
+.txt sidecars keep working.
+
+Usage:
+    ./jpeg_metadata.py image.jpg [image.jpg ...]
+
+Exits 1 if any image has no embedded result.
+"""
+
+import json
+import struct
+import sys
+
+MARKER = 0xEA  # APP10
+IDENTIFIER = b"CatCamInf\0"
+VERSION = 1
+
+
+def read_metadata(path):
+    """Return the embedded fields as a dict, or None."""
+    with open(path, "rb") as f:
+        data = f.read(4096)
+
+    if data[:2] != b"\xff\xd8":
+        return None
+    pos = 2
+    while pos + 4 <= len(data):
+        if data[pos] != 0xFF:
+            return None
+        marker = data[pos + 1]
+        if marker == 0xFF:
+            pos += 1
+            continue
+        if marker in (0xDA, 0xD9):
+            return None
+        (length,) = struct.unpack(">H", data[pos + 2:pos + 4])
+        payload = data[pos + 4:pos + 2 + length]
+        if marker == MARKER and payload.startswith(IDENTIFIER):
+            if payload[len(IDENTIFIER)] != VERSION:
+                return None
+            fields = {}
+            for line in payload[len(IDENTIFIER) + 1:].decode("utf-8", "replace").splitlines():
+                key, sep, value = line.partition("=")
+                if sep:
+                    fields[key] = value
+            return fields
+        pos += 2 + length
+    return None
+
+
+def to_response(fields):
+    return {
+        "success": True,
+        "mostLikelyCat": {
+            "name": fields.get("name", ""),
+            "index": int(fields.get("index", -1)),
+            "confidence": float(fields.get("confidence", 0)),
+        },
+        "latencyMs": int(fields.get("latency_ms", 0)),
+        "firmware": fields.get("firmware", ""),
+    }
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+
+    missing = False
+    for path in sys.argv[1:]:
+        fields = read_metadata(path)
+        if fields is None:
+            print(f"{path}: no embedded inference result", file=sys.stderr)
+            missing = True
+            continue
+        response = to_response(fields)
+        if len(sys.argv) > 2:
+            response["file"] = path
+        print(json.dumps(response))
+    sys.exit(1 if missing else 0)
+
+
+if __name__ == "__main__":
+    main()
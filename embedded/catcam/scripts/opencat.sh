@@ -31,16 +31,22 @@ REGEX=$(printf '|"%s"' "$@")
 REGEX=${REGEX:1}               # strip leading |
 REGEX="\"name\"[[:space:]]*:[[:space:]]*(${REGEX})"
 
-for txt in $IMAGES_DIR/*.txt; do
-  jpg="${txt%.txt}.jpg"
-  [ -f "$jpg" ] || continue
+for jpg in $IMAGES_DIR/*.jpg; do
+  txt="${jpg%.jpg}.txt"
+
+  # Older images have a .txt sidecar, newer ones carry the result in the JPEG
+  if [ -f "$txt" ]; then
+    metadata=$(cat "$txt")
+  else
+    metadata=$("$SCRIPT_DIR/jpeg_metadata.py" "$jpg" 2>/dev/null) || continue
+  fi
 
   if $NEGATIVE; then
-    if ! grep -Eq "$REGEX" "$txt"; then
+    if ! grep -Eq "$REGEX" <<< "$metadata"; then
       echo "$jpg"
     fi
   else
-    if grep -Eq "$REGEX" "$txt"; then
+    if grep -Eq "$REGEX" <<< "$metadata"; then
       echo "$jpg"
     fi
   fi
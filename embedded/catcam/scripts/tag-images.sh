@@ -7,17 +7,22 @@ IMAGES_DIR=$SCRIPT_DIR/../catcam-images
 
 mkdir -p $IMAGES_DIR/tagged
 
-for txt in $IMAGES_DIR/*.txt; do
-    jpg="${txt%.txt}.jpg"
-    [ -f "$jpg" ] || continue
+for jpg in $IMAGES_DIR/*.jpg; do
+    txt="${jpg%.jpg}.txt"
 
     filename=$(basename $jpg)
-    txtname=$(basename $txt)
 
     [ -f "$IMAGES_DIR/tagged/$filename" ] && continue
 
-    likely=$(jq '.mostLikelyCat.name' catcam-images/$txtname | tr -d '"')
-    confidence=$(jq '.mostLikelyCat.confidence' catcam-images/$txtname)
+    # Older images have a .txt sidecar, newer ones carry the result in the JPEG
+    if [ -f "$txt" ]; then
+        metadata=$(cat $txt)
+    else
+        metadata=$($SCRIPT_DIR/jpeg_metadata.py $jpg 2>/dev/null) || continue
+    fi
+
+    likely=$(jq '.mostLikelyCat.name' <<< "$metadata" | tr -d '"')
+    confidence=$(jq '.mostLikelyCat.confidence' <<< "$metadata")
     text=$(echo $((100 * $confidence)) | bc -l | xargs printf "%.2f%%\n")
     magick catcam-images/$filename \( -background black -fill white -font Arial -pointsize 36 label:"$likely - $text" \) -gravity northwest -geometry +10+10 -composite catcam-images/tagged/$filename
     
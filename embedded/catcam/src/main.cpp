@@ -12,10 +12,14 @@
 #include "InputManager.h"
 #include "CaptureController.h"
 #include "MotionDetector.h"
+#include "VisualMotionDetector.h"
 #include "DeterrentController.h"
 #include "BluetoothService.h"
 #include "CommandDispatcher.h"
 #include "Camera.h"
+#include "CameraTuner.h"
+#include "PipelineSettingsRegistry.h"
+#include "FrameRing.h"
 #include "version.h"
 #include "secrets.h"
 
@@ -62,6 +66,9 @@ bool isBootButtonPressed();
 void saveTrainingMode(bool enabled);
 void loadCameraSettings();
 void saveCameraSetting(const String& setting, int value);
+void loadPipelineSettings();
+void savePipelineSettings();
+void savePipelineSetting(const String& setting, int value);
 
 // Wrapper for BluetoothService extern - delegates to CaptureController
 String captureAndPostPhoto();
@@ -123,8 +130,9 @@ void setup() {
     SDLogger::getInstance().infof("Claude inference loaded from NVS: %s", systemState.claudeInfer ? "ON" : "OFF");
     preferences.end();
 
-    // Load camera settings from NVS
+    // Load camera and pipeline settings from NVS
     loadCameraSettings();
+    loadPipelineSettings();
 
     // Configure SystemManager
     SystemManager::Config config = {
@@ -153,6 +161,7 @@ void setup() {
     if (dispatcher) {
         dispatcher->setTrainingModeCallback(saveTrainingMode);
         dispatcher->setCameraSettingCallback(saveCameraSetting);
+        dispatcher->setPipelineSettingCallback(savePipelineSetting);
 
         // set_trigger_threshold {"value": 0.85} — update Boots confidence threshold
         dispatcher->registerHandler("set_trigger_threshold", [](CommandContext& ctx) {
@@ -213,6 +222,180 @@ void setup() {
             return true;
         });
 
+        // set_change_gate {"enabled": true, "threshold": 0.02} — skip uploads when the scene is unchanged
+        dispatcher->registerHandler("set_change_gate", [](CommandContext& ctx) {
+            PipelineSettings& ps = systemState.pipelineSettings;
+            bool enabled = ctx.request["enabled"] | ps.changeGate;
+            float threshold = ctx.request["threshold"] | ps.changeGateThreshold;
+            if (threshold < 0.0f) threshold = 0.0f;
+            if (threshold > 1.0f) threshold = 1.0f;
+            ps.changeGate = enabled;
+            ps.changeGateThreshold = threshold;
+            savePipelineSettings();
+
+            CaptureController* cc = systemManager.getCaptureController();
+            if (cc) {
+                cc->setChangeGate(enabled, threshold);
+            }
+
+            DynamicJsonDocument response(256);
+            response["type"] = "setting_updated";
+            response["setting"] = "change_gate";
+            response["enabled"] = enabled;
+            response["threshold"] = threshold;
+            String responseStr;
+            serializeJson(response, responseStr);
+            ctx.sender->sendResponse(responseStr);
+            return true;
+        });
+
+        // set_visual_motion {"enabled": true, "fps": 2, "roi_x": 0, "roi_y": 40, "roi_width": 100,
+        //                    "roi_height": 60, "block_delta": 10, "min_blocks": 3, "max_cpu_percent": 15}
+        // Camera-based motion trigger; any subset of fields may be given
+        dispatcher->registerHandler("set_visual_motion", [](CommandContext& ctx) {
+            VisualMotionSettings& vm = systemState.pipelineSettings.visualMotion;
+            vm.enabled = ctx.request["enabled"] | vm.enabled;
+            vm.fps = constrain(ctx.request["fps"] | vm.fps, 1, 5);
+            vm.roiX = constrain(ctx.request["roi_x"] | vm.roiX, 0, 99);
+            vm.roiY = constrain(ctx.request["roi_y"] | vm.roiY, 0, 99);
+            vm.roiWidth = constrain(ctx.request["roi_width"] | vm.roiWidth, 1, 100 - vm.roiX);
+            vm.roiHeight = constrain(ctx.request["roi_height"] | vm.roiHeight, 1, 100 - vm.roiY);
+            vm.blockDelta = constrain(ctx.request["block_delta"] | vm.blockDelta, 1, 255);
+            vm.minBlocks = constrain(ctx.request["min_blocks"] | vm.minBlocks, 1, 1000);
+            vm.maxCpuPercent = constrain(ctx.request["max_cpu_percent"] | vm.maxCpuPercent, 1, 50);
+
+            savePipelineSettings();
+
+            VisualMotionDetector* detector = systemManager.getVisualMotionDetector();
+            if (detector) {
+                detector->configure(vm);
+            }
+
+            DynamicJsonDocument response(512);
+            response["type"] = "setting_updated";
+            response["setting"] = "visual_motion";
+            response["enabled"] = vm.enabled;
+            response["fps"] = vm.fps;
+            response["roi_x"] = vm.roiX;
+            response["roi_y"] = vm.roiY;
+            response["roi_width"] = vm.roiWidth;
+            response["roi_height"] = vm.roiHeight;
+            response["block_delta"] = vm.blockDelta;
+            response["min_blocks"] = vm.minBlocks;
+            response["max_cpu_percent"] = vm.maxCpuPercent;
+            String responseStr;
+            serializeJson(response, responseStr);
+            ctx.sender->sendResponse(responseStr);
+            return true;
+        });
+
+        // tune_camera {"use_case": "stills"|"video"|"both", "measure_ms": 1000, "apply": true}
+        // Sweeps frame buffer count, XCLK and buffer placement at each use case's profile
+        // frame size and stores the best. Blocking: roughly a minute per use case.
+        dispatcher->registerHandler("tune_camera", [](CommandContext& ctx) {
+            // The tuner reads frames itself - bring the sensor out of standby first
+            CaptureController* captureController = systemManager.getCaptureController();
+            if (captureController) captureController->wakeCamera();
+            Camera* camera = systemManager.getCamera();
+            if (!camera || !camera->isReady()) {
+                DynamicJsonDocument error(128);
+                error["type"] = "error";
+                error["message"] = "Camera not available";
+                String errorStr;
+                serializeJson(error, errorStr);
+                ctx.sender->sendResponse(errorStr);
+                return false;
+            }
+
+            String useCase = ctx.request["use_case"] | "both";
+            uint32_t measureMs = constrain(ctx.request["measure_ms"] | (int)CameraTuner::DEFAULT_MEASURE_MS, 250, 5000);
+            bool apply = ctx.request["apply"] | true;
+            CameraSettings& cs = systemState.cameraSettings;
+
+            DynamicJsonDocument ack(128);
+            ack["type"] = "camera_tune_started";
+            ack["message"] = "Tuning camera...";
+            String ackStr;
+            serializeJson(ack, ackStr);
+            ctx.sender->sendResponse(ackStr);
+
+            FrameRing* frameRing = systemManager.getFrameRing();
+            if (frameRing) frameRing->pause();
+
+            CameraTuner tuner(camera);
+            static CameraTuneReport report;  // ~1KB - kept off the loop task stack
+            bool changed = false;
+            for (CameraUseCase uc : { CameraUseCase::Stills, CameraUseCase::Video }) {
+                bool video = uc == CameraUseCase::Video;
+                if (useCase != "both" && useCase != (video ? "video" : "stills")) {
+                    continue;
+                }
+                CameraProfile profile = (CameraProfile)(video ? cs.videoProfile : cs.photoProfile);
+                if (!tuner.tune(uc, profile, report, measureMs)) {
+                    continue;
+                }
+
+                bool applied = false;
+                if (apply && report.best >= 0) {
+                    const CameraDriverConfig& best = report.candidates[report.best].driver;
+                    setCameraSetting(cs, findCameraSetting(video ? "video_fb_count" : "fb_count"), best.fbCount);
+                    setCameraSetting(cs, findCameraSetting(video ? "video_xclk_mhz" : "xclk_mhz"), best.xclkMHz);
+                    setCameraSetting(cs, findCameraSetting(video ? "video_fb_in_psram" : "fb_in_psram"), best.fbInPsram);
+                    applied = changed = true;
+                }
+
+                // One message per use case keeps each under the MQTT buffer size
+                DynamicJsonDocument response(2048);
+                response["type"] = "camera_tune";
+                response["use_case"] = video ? "video" : "stills";
+                response["profile"] = cameraProfileName(profile);
+                response["frame_size"] = report.frameSize;
+                response["measure_ms"] = measureMs;
+                response["applied"] = applied;
+                response["best"] = report.best;
+                JsonArray columns = response.createNestedArray("columns");
+                for (const char* column : { "fb_count", "xclk_mhz", "psram", "status", "fps", "latency_ms",
+                                            "latency_max_ms", "init_ms", "dram_kb", "psram_kb" }) {
+                    columns.add(column);
+                }
+                JsonArray rows = response.createNestedArray("candidates");
+                for (size_t i = 0; i < report.candidateCount; i++) {
+                    const CameraTuneCandidate& c = report.candidates[i];
+                    JsonArray row = rows.createNestedArray();
+                    row.add(c.driver.fbCount);
+                    row.add(c.driver.xclkMHz);
+                    row.add(c.driver.fbInPsram ? 1 : 0);
+                    row.add(c.status);
+                    row.add(roundf(c.fps * 10.0f) / 10.0f);
+                    row.add(roundf(c.meanLatencyUs / 100.0f) / 10.0f);
+                    row.add(roundf(c.maxLatencyUs / 100.0f) / 10.0f);
+                    row.add(c.initMs);
+                    row.add(c.dramBytes / 1024);
+                    row.add(c.psramBytes / 1024);
+                }
+                String responseStr;
+                serializeJson(response, responseStr);
+                ctx.sender->sendResponse(responseStr);
+            }
+
+            if (changed) {
+                // Driver settings only - no sensor registers or pipeline settings to re-apply
+                if (preferences.begin("bootboots", false)) {
+                    saveCameraSettingsBlob(preferences, cs);
+                    preferences.end();
+                } else {
+                    SDLogger::getInstance().errorf("Failed to open NVS namespace 'bootboots' for writing");
+                }
+                // The camera picks driver configurations from its copy of the settings
+                camera->applySettings(cs);
+                camera->useDriverFor(CameraUseCase::Stills);
+            }
+            systemState.cameraReady = camera->isReady();
+
+            if (frameRing) frameRing->resume();
+            return true;
+        });
+
         // set_peripheral {"peripheral": "flash_led"|"led_strip"|"spray", "state": true|false}
         // Direct peripheral control for hardware testing via the test UI.
         dispatcher->registerHandler("set_peripheral", [](CommandContext& ctx) {
@@ -355,15 +538,32 @@ void loop() {
         }
     }
 
-    // Check for PIR motion detection
+    // Check for PIR or camera motion detection
     MotionDetector* motionDetector = systemManager.getMotionDetector();
-    if (motionDetector && motionDetector->wasMotionDetected()) {
-        SDLogger::getInstance().infof("PIR motion detected");
+    VisualMotionDetector* visualMotion = systemManager.getVisualMotionDetector();
+    bool pirMotion = motionDetector && motionDetector->wasMotionDetected();
+    bool cameraMotion = !pirMotion && visualMotion && visualMotion->wasMotionDetected();
+    if (pirMotion || cameraMotion) {
+        SDLogger::getInstance().infof("%s motion detected", pirMotion ? "PIR" : "Camera");
         systemState.motionTriggerCount++;
+        int64_t triggerUs;
+        if (pirMotion) {
+            triggerUs = motionDetector->getLastMotionUs();
+            if (visualMotion) visualMotion->startCooldown();
+        } else {
+            systemState.visualTriggerCount++;
+            triggerUs = visualMotion->getLastMotionUs();
+            if (motionDetector) motionDetector->startCooldown();
+        }
 
         CaptureController* captureController = systemManager.getCaptureController();
         DeterrentController* deterrentController = systemManager.getDeterrentController();
 
+        // Freeze the pre-trigger ring so frames around the PIR edge survive
+        // until detection (and any deterrent pre-roll) is done
+        FrameRing* frameRing = systemManager.getFrameRing();
+        if (frameRing) frameRing->pause();
+
         if (captureController) {
             // Training mode: capture photo without inference/deterrent
             if (systemState.trainingMode) {
@@ -373,8 +573,10 @@ void loop() {
             // Normal mode: capture photo and run inference with deterrent
             else if (deterrentController) {
                 // Capture photo and run inference
-                DetectionResult result = captureController->captureAndDetect(systemState.claudeInfer);
-                if (result.success && deterrentController->shouldActivate(result, systemState.triggerThresh)) {
+                DetectionResult result = captureController->captureAndDetect(systemState.claudeInfer, triggerUs);
+                if (result.skippedUnchanged) {
+                    systemState.uploadsSkippedUnchanged++;
+                } else if (result.success && deterrentController->shouldActivate(result, systemState.triggerThresh)) {
                     SDLogger::getInstance().criticalf("Boots detected (%.1f%%) - activating deterrent! (dryRun=%s)",
                         result.confidence * 100.0f, systemState.dryRun ? "ON" : "OFF");
                     systemState.deterrentActivationCount++;
@@ -388,6 +590,15 @@ void loop() {
                 }
             }
         }
+
+        if (frameRing) frameRing->resume();
+    }
+    // Deferred full-resolution upload from the last dual capture
+    else {
+        CaptureController* captureController = systemManager.getCaptureController();
+        if (captureController) {
+            captureController->uploadPendingArchive();
+        }
     }
 
     // Poll PIR sensor state so the BLE status broadcast reflects live readings
@@ -452,46 +663,48 @@ void saveTrainingMode(bool enabled) {
     }
 }
 
-// Load camera settings from NVS
+// Load camera settings from NVS (one blob; see CameraSettingsRegistry)
 void loadCameraSettings() {
     CameraSettings& cs = systemState.cameraSettings;
+    // Read-write: the first boot after the upgrade migrates the old per-field keys
+    if (!preferences.begin("bootboots", false)) {
+        SDLogger::getInstance().errorf("Failed to open NVS namespace 'bootboots'");
+        return;
+    }
+
+    bool stored = loadCameraSettingsBlob(preferences, cs);
+
+    preferences.end();
+    SDLogger::getInstance().infof("Camera settings %s (ledDelayMillis=%d)",
+        stored ? "loaded from NVS" : "not in NVS - using defaults", cs.ledDelayMillis);
+}
+
+// Load pipeline settings, scene-change gate and visual motion included, from NVS
+void loadPipelineSettings() {
+    PipelineSettings& ps = systemState.pipelineSettings;
     if (!preferences.begin("bootboots", true)) {  // read-only
         SDLogger::getInstance().errorf("Failed to open NVS namespace 'bootboots' for reading");
         return;
     }
 
-    cs.frameSize = preferences.getInt("camFrmSize", cs.frameSize);
-    cs.jpegQuality = preferences.getInt("camJpgQual", cs.jpegQuality);
-    cs.fbCount = preferences.getInt("camFbCount", cs.fbCount);
-    cs.brightness = preferences.getInt("camBright", cs.brightness);
-    cs.contrast = preferences.getInt("camContrast", cs.contrast);
-    cs.saturation = preferences.getInt("camSat", cs.saturation);
-    cs.specialEffect = preferences.getInt("camEffect", cs.specialEffect);
-    cs.whiteBalance = preferences.getBool("camWB", cs.whiteBalance);
-    cs.awbGain = preferences.getBool("camAWBGain", cs.awbGain);
-    cs.wbMode = preferences.getInt("camWBMode", cs.wbMode);
-    cs.exposureCtrl = preferences.getBool("camExpCtrl", cs.exposureCtrl);
-    cs.aec2 = preferences.getBool("camAEC2", cs.aec2);
-    cs.aeLevel = preferences.getInt("camAELevel", cs.aeLevel);
-    cs.aecValue = preferences.getInt("camAECVal", cs.aecValue);
-    cs.gainCtrl = preferences.getBool("camGainCtrl", cs.gainCtrl);
-    cs.agcGain = preferences.getInt("camAGCGain", cs.agcGain);
-    cs.gainCeiling = preferences.getInt("camGainCeil", cs.gainCeiling);
-    cs.bpc = preferences.getBool("camBPC", cs.bpc);
-    cs.wpc = preferences.getBool("camWPC", cs.wpc);
-    cs.rawGma = preferences.getBool("camGamma", cs.rawGma);
-    cs.lenc = preferences.getBool("camLenc", cs.lenc);
-    cs.hmirror = preferences.getBool("camHMirror", cs.hmirror);
-    cs.vflip = preferences.getBool("camVFlip", cs.vflip);
-    cs.dcw = preferences.getBool("camDCW", cs.dcw);
-    cs.colorbar = preferences.getBool("camColorbar", cs.colorbar);
-    cs.ledDelayMillis = preferences.getInt("ledDelayMillis", cs.ledDelayMillis);
+    bool stored = loadPipelineSettingsBlob(preferences, ps);
 
     preferences.end();
-    SDLogger::getInstance().infof("Camera settings loaded from NVS (ledDelayMillis=%d)", cs.ledDelayMillis);
+    SDLogger::getInstance().infof("Pipeline settings %s (scene-change gate %s, visual motion %s)",
+        stored ? "loaded from NVS" : "not in NVS - using defaults",
+        ps.changeGate ? "ON" : "OFF", ps.visualMotion.enabled ? "ON" : "OFF");
 }
 
-// Save a single camera setting to NVS and apply to camera
+void savePipelineSettings() {
+    if (!preferences.begin("bootboots", false)) {
+        SDLogger::getInstance().errorf("Failed to open NVS namespace 'bootboots' for writing");
+        return;
+    }
+    savePipelineSettingsBlob(preferences, systemState.pipelineSettings);
+    preferences.end();
+}
+
+// Save camera settings to NVS and apply the changed one to the camera
 void saveCameraSetting(const String& setting, int value) {
     CameraSettings& cs = systemState.cameraSettings;
     if (!preferences.begin("bootboots", false)) {
@@ -499,46 +712,86 @@ void saveCameraSetting(const String& setting, int value) {
         return;
     }
 
-    if (setting == "frame_size") { preferences.putInt("camFrmSize", cs.frameSize); }
-    else if (setting == "jpeg_quality") { preferences.putInt("camJpgQual", cs.jpegQuality); }
-    else if (setting == "fb_count") { preferences.putInt("camFbCount", cs.fbCount); }
-    else if (setting == "brightness") { preferences.putInt("camBright", cs.brightness); }
-    else if (setting == "contrast") { preferences.putInt("camContrast", cs.contrast); }
-    else if (setting == "saturation") { preferences.putInt("camSat", cs.saturation); }
-    else if (setting == "special_effect") { preferences.putInt("camEffect", cs.specialEffect); }
-    else if (setting == "white_balance") { preferences.putBool("camWB", cs.whiteBalance); }
-    else if (setting == "awb_gain") { preferences.putBool("camAWBGain", cs.awbGain); }
-    else if (setting == "wb_mode") { preferences.putInt("camWBMode", cs.wbMode); }
-    else if (setting == "exposure_ctrl") { preferences.putBool("camExpCtrl", cs.exposureCtrl); }
-    else if (setting == "aec2") { preferences.putBool("camAEC2", cs.aec2); }
-    else if (setting == "ae_level") { preferences.putInt("camAELevel", cs.aeLevel); }
-    else if (setting == "aec_value") { preferences.putInt("camAECVal", cs.aecValue); }
-    else if (setting == "gain_ctrl") { preferences.putBool("camGainCtrl", cs.gainCtrl); }
-    else if (setting == "agc_gain") { preferences.putInt("camAGCGain", cs.agcGain); }
-    else if (setting == "gain_ceiling") { preferences.putInt("camGainCeil", cs.gainCeiling); }
-    else if (setting == "bpc") { preferences.putBool("camBPC", cs.bpc); }
-    else if (setting == "wpc") { preferences.putBool("camWPC", cs.wpc); }
-    else if (setting == "raw_gma") { preferences.putBool("camGamma", cs.rawGma); }
-    else if (setting == "lenc") { preferences.putBool("camLenc", cs.lenc); }
-    else if (setting == "hmirror") { preferences.putBool("camHMirror", cs.hmirror); }
-    else if (setting == "vflip") { preferences.putBool("camVFlip", cs.vflip); }
-    else if (setting == "dcw") { preferences.putBool("camDCW", cs.dcw); }
-    else if (setting == "colorbar") { preferences.putBool("camColorbar", cs.colorbar); }
-    else if (setting == "led_delay_millis") {
-        SDLogger::getInstance().infof("Saving ledDelayMillis=%d to NVS", cs.ledDelayMillis);
-        size_t written = preferences.putInt("ledDelayMillis", cs.ledDelayMillis);
-        if (written == 0) {
-            SDLogger::getInstance().errorf("Failed to write ledDelayMillis to NVS");
-        }
-    }
+    saveCameraSettingsBlob(preferences, cs);
 
     preferences.end();
 
-    // Apply updated settings to camera
+    // Apply updated settings to camera (only changed registers are written)
     Camera* camera = systemManager.getCamera();
     if (camera) {
         camera->applySettings(cs);
     }
 
+    DeterrentController* deterrentController = systemManager.getDeterrentController();
+    if (deterrentController && setting == "video_profile") {
+        deterrentController->setVideoProfile((CameraProfile)cs.videoProfile);
+    }
+
+    CaptureController* captureController = systemManager.getCaptureController();
+    if (captureController) {
+        if (setting.endsWith("_profile")) {
+            captureController->setCameraProfiles((CameraProfile)cs.photoProfile, (CameraProfile)cs.videoProfile);
+        }
+        // applySettings() may have put jpegQuality back on the sensor
+        captureController->setQualityTarget(cs, systemState.pipelineSettings);
+    }
+
     SDLogger::getInstance().infof("Camera setting '%s' saved to NVS and applied", setting.c_str());
 }
+
+// Save pipeline settings to NVS and hand the changed one to its component
+void savePipelineSetting(const String& setting, int value) {
+    PipelineSettings& ps = systemState.pipelineSettings;
+    savePipelineSettings();
+
+    // Pre-trigger ring memory and rate are fixed at configure time
+    FrameRing* frameRing = systemManager.getFrameRing();
+    if (frameRing && setting.startsWith("pre_trigger_")) {
+        frameRing->configure(ps);
+    }
+
+    ImageStorage* imageStorage = systemManager.getImageStorage();
+    if (imageStorage && setting == "response_sidecar") {
+        imageStorage->setResponseSidecar(ps.responseSidecar);
+    }
+
+    // Upload crop, adaptive quality and the capture policies live in the capture controller
+    CaptureController* captureController = systemManager.getCaptureController();
+    if (captureController) {
+        if (setting.startsWith("crop_")) {
+            captureController->setUploadCrop(ps.cropX, ps.cropY, ps.cropWidth, ps.cropHeight);
+        }
+        if (setting.startsWith("burst_")) {
+            captureController->setBurst(ps.burstFrames, ps.burstBudgetMs);
+        }
+        if (setting.startsWith("upload_target_")) {
+            captureController->setQualityTarget(systemState.cameraSettings, ps);
+        }
+        if (setting == "dual_capture" || setting == "archive_upload") {
+            captureController->setDualCapture(ps.dualCapture, ps.archiveUpload);
+        }
+        if (setting == "quality_gate" || setting == "gate_recaptures") {
+            captureController->setQualityGate(ps.qualityGate, ps.gateRecaptures);
+        }
+        if (setting == "upload_transcode_quality") {
+            captureController->setUploadTranscode(ps.uploadTranscodeQuality);
+        }
+        if (setting.startsWith("inference_cache_")) {
+            captureController->setInferenceCache(ps.inferenceCacheTtlS, ps.inferenceCacheDistance);
+        }
+        if (setting.startsWith("daylight_")) {
+            captureController->setDaylightCapture(ps.daylightCapture, ps.daylightMinLuma);
+        }
+        if (setting == "local_inference") {
+            captureController->setLocalInference(ps.localInference);
+        }
+        if (setting == "idle_standby_s") {
+            captureController->setIdleStandby(ps.idleStandbyS);
+        }
+        if (setting == "upload_hash_overlap") {
+            captureController->setUploadHashOverlap(ps.uploadHashOverlap);
+        }
+    }
+
+    SDLogger::getInstance().infof("Pipeline setting '%s' saved to NVS and applied", setting.c_str());
+}
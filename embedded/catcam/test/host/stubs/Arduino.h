@@ -0,0 +1,75 @@
+#ifndef CATCAM_HOST_ARDUINO_H
+#define CATCAM_HOST_ARDUINO_H
+
+// Host stand-in for the Arduino core: just what the libraries under test use
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+// The ESP32 core's Arduino.h brings these in too
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+void delay(unsigned long ms);
+inline void yield() {}
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(int v) : _s(std::to_string(v)) {}
+    explicit String(unsigned v) : _s(std::to_string(v)) {}
+    explicit String(long v) : _s(std::to_string(v)) {}
+    explicit String(unsigned long v) : _s(std::to_string(v)) {}
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); }
+    bool reserve(unsigned n) { _s.reserve(n); return true; }
+    bool isEmpty() const { return _s.empty(); }
+
+    String& operator+=(const String& o) { _s += o._s; return *this; }
+    String& operator+=(const char* o) { _s += o; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    bool concat(const char* p, unsigned n) { _s.append(p, n); return true; }
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a) + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+    bool operator==(const char* o) const { return _s == o; }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator!=(const char* o) const { return _s != o; }
+    char operator[](unsigned i) const { return _s[i]; }
+
+    int indexOf(char c) const { auto p = _s.find(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned a) const { return a >= _s.size() ? String() : String(_s.substr(a)); }
+    String substring(unsigned a, unsigned b) const { return a >= _s.size() ? String() : String(_s.substr(a, b - a)); }
+    long toInt() const { return atol(_s.c_str()); }
+    bool startsWith(const char* p) const { return _s.rfind(p, 0) == 0; }
+    bool equalsIgnoreCase(const char* o) const { return strcasecmp(_s.c_str(), o) == 0; }
+    void trim() {
+        size_t a = _s.find_first_not_of(" \t\r\n");
+        if (a == std::string::npos) {
+            _s.clear();
+            return;
+        }
+        _s = _s.substr(a, _s.find_last_not_of(" \t\r\n") - a + 1);
+    }
+
+private:
+    std::string _s;
+};
+
+#endif
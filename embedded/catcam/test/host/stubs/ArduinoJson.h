@@ -0,0 +1,6 @@
+#ifndef CATCAM_HOST_ARDUINOJSON_H
+#define CATCAM_HOST_ARDUINOJSON_H
+
+// Host stand-in: AWSAuth.h includes it, nothing built on the host parses JSON
+
+#endif
@@ -0,0 +1,112 @@
+// Scripted HTTP/1.1 server behind IApiTransport for the ApiConnection tests
+
+#include "FakeApiServer.h"
+#include <esp_timer.h>
+
+FakeApiServer::FakeApiServer() : _client(*this) {}
+
+bool FakeApiServer::resolve(const char*, IPAddress& address) {
+    _lookups++;
+    address = IPAddress(10, 0, 0, 1);
+    return true;
+}
+
+bool FakeApiServer::connect(const IPAddress&, uint16_t, const char* host) {
+    _connects++;
+    closeSession();
+    if (_failConnects > 0) {
+        _failConnects--;
+        return false;
+    }
+    if (_handshakeSleeps) {
+        delay(_handshakeMs);
+    } else {
+        hostAdvanceClock((int64_t)_handshakeMs * 1000);
+    }
+    _open = true;
+    _sniHost = host ? host : "";
+    return true;
+}
+
+void FakeApiServer::dropConnection(bool writeFails) {
+    _dropped = true;
+    _dropWriteFails = writeFails;
+}
+
+int FakeApiServer::Socket::read() {
+    uint8_t byte;
+    return read(&byte, 1) == 1 ? byte : -1;
+}
+
+int FakeApiServer::Socket::read(uint8_t* buf, size_t size) {
+    size_t n = std::min(size, (size_t)available());
+    if (n == 0) {
+        return -1;
+    }
+    memcpy(buf, _server._outbound.data() + _server._readPos, n);
+    _server._readPos += n;
+    return (int)n;
+}
+
+size_t FakeApiServer::receive(const uint8_t* buf, size_t size) {
+    if (!_open || _peerClosed) {
+        return 0;
+    }
+    if (_dropped) {
+        // The server's end is gone: a reset comes back either way
+        _peerClosed = true;
+        return _dropWriteFails ? 0 : size;
+    }
+
+    _inbound.append((const char*)buf, size);
+    size_t headEnd = _inbound.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        return size;
+    }
+    size_t bodyLength = 0;
+    size_t field = _inbound.find("Content-Length:");
+    if (field != std::string::npos && field < headEnd) {
+        bodyLength = strtoul(_inbound.c_str() + field + 15, nullptr, 10);
+    }
+    size_t total = headEnd + 4 + bodyLength;
+    if (_inbound.size() >= total) {
+        _requests.push_back(_inbound.substr(0, total));
+        _inbound.erase(0, total);
+        Reply next;
+        if (!_replies.empty()) {
+            next = _replies.front();
+            _replies.pop_front();
+        }
+        reply(next);
+    }
+    return size;
+}
+
+void FakeApiServer::reply(const Reply& reply) {
+    hostAdvanceClock((int64_t)_thinkMs * 1000);
+    if (reply.hangUp) {
+        _peerClosed = true;
+        return;
+    }
+    char head[160];
+    if (reply.unsized) {
+        snprintf(head, sizeof(head), "HTTP/1.1 %d Status\r\nContent-Type: application/json\r\n\r\n", reply.status);
+    } else {
+        snprintf(head, sizeof(head), "HTTP/1.1 %d Status\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n%s\r\n",
+                 reply.status, reply.body.size(), reply.close ? "Connection: close\r\n" : "");
+    }
+    _outbound.erase(0, _readPos);
+    _readPos = 0;
+    _outbound += head;
+    _outbound += reply.body;
+    _peerClosed = reply.close || reply.unsized;
+}
+
+void FakeApiServer::closeSession() {
+    _open = false;
+    _peerClosed = false;
+    _dropped = false;
+    _inbound.clear();
+    _outbound.clear();
+    _readPos = 0;
+}
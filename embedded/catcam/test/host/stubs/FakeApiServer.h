@@ -0,0 +1,112 @@
+#ifndef CATCAM_HOST_FAKEAPISERVER_H
+#define CATCAM_HOST_FAKEAPISERVER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ApiTransport.h"
+
+/**
+ * FakeApiServer - IApiTransport with a scripted HTTP/1.1 server behind it
+ *
+ * Every connect() starts a new server-side session. Once a request's head
+ * and Content-Length bytes have been written, the next queued reply (or a
+ * plain 200 keep-alive one) becomes readable. The TLS handshake and the
+ * server's think time advance the host clock rather than sleeping, so the
+ * timings ApiConnection reports are exact - unless setHandshakeSleeps()
+ * asks for a real wait that other threads can overlap.
+ */
+class FakeApiServer : public IApiTransport {
+public:
+    struct Reply {
+        int status = 200;
+        std::string body = "{}";
+        bool close = false;        // Connection: close, and hang up once it is read
+        bool unsized = false;      // No Content-Length: the body runs to the end of the connection
+        bool hangUp = false;       // Close without replying at all
+    };
+
+    FakeApiServer();
+
+    Client& client() override { return _client; }
+    bool resolve(const char* host, IPAddress& address) override;
+    bool connect(const IPAddress& address, uint16_t port, const char* host) override;
+    void setTimeout(uint32_t timeoutMs) override { _timeoutMs = timeoutMs; }
+    bool resumed() const override { return false; }
+
+    void queueReply(const Reply& reply) { _replies.push_back(reply); }
+
+    /**
+     * The server drops the open connection while it is idle (keep-alive
+     * timeout). The client only finds out on its next request: with
+     * writeFails the write itself errors, otherwise the write goes out and
+     * is answered by a reset.
+     */
+    void dropConnection(bool writeFails);
+
+    void setHandshakeMs(uint32_t ms) { _handshakeMs = ms; }
+    void setHandshakeSleeps(bool sleeps) { _handshakeSleeps = sleeps; }
+    void setThinkMs(uint32_t ms) { _thinkMs = ms; }
+    void failNextConnects(int count) { _failConnects = count; }
+
+    int lookups() const { return _lookups; }
+    int connects() const { return _connects; }
+    const std::string& lastSniHost() const { return _sniHost; }
+    uint32_t timeoutMs() const { return _timeoutMs; }
+
+    /**
+     * Complete requests received, head and body, in order
+     */
+    const std::vector<std::string>& requests() const { return _requests; }
+
+private:
+    class Socket : public Client {
+    public:
+        explicit Socket(FakeApiServer& server) : _server(server) {}
+
+        int connect(IPAddress, uint16_t) override { return 0; }
+        int connect(const char*, uint16_t) override { return 0; }
+        size_t write(uint8_t byte) override { return write(&byte, 1); }
+        size_t write(const uint8_t* buf, size_t size) override { return _server.receive(buf, size); }
+        int available() override { return (int)(_server._outbound.size() - _server._readPos); }
+        int read() override;
+        int read(uint8_t* buf, size_t size) override;
+        int peek() override { return available() > 0 ? (uint8_t)_server._outbound[_server._readPos] : -1; }
+        void flush() override {}
+        void stop() override { _server.closeSession(); }
+        uint8_t connected() override { return _server._open && !(_server._peerClosed && available() == 0); }
+        operator bool() override { return connected(); }
+
+    private:
+        FakeApiServer& _server;
+    };
+
+    Socket _client;
+    std::deque<Reply> _replies;
+    std::vector<std::string> _requests;
+
+    // Current session
+    bool _open = false;
+    bool _peerClosed = false;    // FIN/RST seen: readable data drains, then connected() goes false
+    bool _dropped = false;
+    bool _dropWriteFails = false;
+    std::string _inbound;
+    std::string _outbound;
+    size_t _readPos = 0;
+
+    uint32_t _handshakeMs = 0;
+    bool _handshakeSleeps = false;
+    uint32_t _thinkMs = 0;
+    uint32_t _timeoutMs = 0;
+    int _failConnects = 0;
+    int _lookups = 0;
+    int _connects = 0;
+    std::string _sniHost;
+
+    size_t receive(const uint8_t* buf, size_t size);
+    void reply(const Reply& reply);
+    void closeSession();
+};
+
+#endif
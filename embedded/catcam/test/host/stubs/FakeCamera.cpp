@@ -0,0 +1,167 @@
+#include "FakeCamera.h"
+#include <esp_camera.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+constexpr size_t MAX_BUFFERS = 3;
+constexpr size_t BUFFER_BYTES = 256 * 1024;
+
+struct Driver {
+    bool running = false;
+    size_t fbCount = 0;
+    camera_fb_t fbs[MAX_BUFFERS] = {};
+    bool out[MAX_BUFFERS] = {};
+    framesize_t frameSize = FRAMESIZE_UXGA;
+    int quality = 10;
+    const uint8_t* frame = nullptr;
+    size_t frameLen = 0;
+    int width = 0;
+    int height = 0;
+    int64_t periodUs = 66000;
+    const uint8_t* lastBuffer = nullptr;
+    uint32_t served = 0;
+    sensor_t sensor = {};
+};
+
+Driver driver;
+
+int setFramesize(sensor_t*, framesize_t size) {
+    driver.frameSize = size;
+    return 0;
+}
+
+int setQuality(sensor_t*, int quality) {
+    driver.quality = quality;
+    return 0;
+}
+
+int setInt(sensor_t*, int) { return 0; }
+int setGainCeiling(sensor_t*, gainceiling_t) { return 0; }
+int setReg(sensor_t*, int, int, int) { return 0; }
+
+void initSensor() {
+    sensor_t& s = driver.sensor;
+    s.id.PID = OV2640_PID;
+    s.set_framesize = setFramesize;
+    s.set_quality = setQuality;
+    s.set_brightness = s.set_contrast = s.set_saturation = s.set_special_effect = setInt;
+    s.set_whitebal = s.set_awb_gain = s.set_wb_mode = s.set_exposure_ctrl = s.set_aec2 = setInt;
+    s.set_ae_level = s.set_aec_value = s.set_gain_ctrl = s.set_agc_gain = setInt;
+    s.set_bpc = s.set_wpc = s.set_raw_gma = s.set_lenc = s.set_hmirror = s.set_vflip = setInt;
+    s.set_dcw = s.set_colorbar = setInt;
+    s.set_gainceiling = setGainCeiling;
+    s.set_reg = setReg;
+}
+
+}
+
+// esp32-camera's table, up to the sizes the profiles use
+const resolution_info_t resolution[FRAMESIZE_INVALID] = {
+    { 96, 96 }, { 160, 120 }, { 176, 144 }, { 240, 176 }, { 240, 240 }, { 320, 240 },
+    { 400, 296 }, { 480, 320 }, { 640, 480 }, { 800, 600 }, { 1024, 768 }, { 1280, 720 },
+    { 1280, 1024 }, { 1600, 1200 }, { 1920, 1080 }, { 720, 1280 }, { 864, 1536 },
+    { 2048, 1536 }, { 2560, 1440 }, { 2560, 1600 }, { 1080, 1920 }, { 2560, 1920 },
+};
+
+esp_err_t esp_camera_init(const camera_config_t* config) {
+    if (driver.running || config->fb_count < 1 || config->fb_count > MAX_BUFFERS) {
+        return ESP_FAIL;
+    }
+    for (size_t i = 0; i < config->fb_count; i++) {
+        driver.fbs[i].buf = (uint8_t*)malloc(BUFFER_BYTES);
+        driver.fbs[i].format = PIXFORMAT_JPEG;
+        driver.out[i] = false;
+    }
+    driver.fbCount = config->fb_count;
+    driver.frameSize = config->frame_size;
+    driver.quality = config->jpeg_quality;
+    initSensor();
+    driver.running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+    for (size_t i = 0; i < driver.fbCount; i++) {
+        free(driver.fbs[i].buf);
+        driver.fbs[i].buf = nullptr;
+    }
+    driver.fbCount = 0;
+    driver.running = false;
+    return ESP_OK;
+}
+
+camera_fb_t* esp_camera_fb_get() {
+    if (!driver.running) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < driver.fbCount; i++) {
+        if (driver.out[i]) {
+            continue;
+        }
+        camera_fb_t* fb = &driver.fbs[i];
+        size_t len = driver.frameLen < BUFFER_BYTES ? driver.frameLen : BUFFER_BYTES;
+        if (driver.frame) {
+            memcpy(fb->buf, driver.frame, len);
+        }
+        fb->len = len;
+        fb->width = driver.width ? driver.width : resolution[driver.frameSize].width;
+        fb->height = driver.height ? driver.height : resolution[driver.frameSize].height;
+
+        hostAdvanceClock(driver.periodUs);
+        int64_t now = esp_timer_get_time();
+        fb->timestamp.tv_sec = now / 1000000;
+        fb->timestamp.tv_usec = now % 1000000;
+
+        driver.out[i] = true;
+        driver.lastBuffer = fb->buf;
+        driver.served++;
+        return fb;
+    }
+    return nullptr;
+}
+
+void esp_camera_fb_return(camera_fb_t* fb) {
+    for (size_t i = 0; i < driver.fbCount; i++) {
+        if (fb == &driver.fbs[i]) {
+            driver.out[i] = false;
+        }
+    }
+}
+
+sensor_t* esp_camera_sensor_get() {
+    return driver.running ? &driver.sensor : nullptr;
+}
+
+namespace FakeCamera {
+
+void setFrame(const uint8_t* data, size_t len, int width, int height) {
+    driver.frame = data;
+    driver.frameLen = len;
+    driver.width = width;
+    driver.height = height;
+}
+
+void setFramePeriodUs(int64_t periodUs) {
+    driver.periodUs = periodUs;
+}
+
+size_t buffersOut() {
+    size_t count = 0;
+    for (size_t i = 0; i < driver.fbCount; i++) {
+        count += driver.out[i] ? 1 : 0;
+    }
+    return count;
+}
+
+const uint8_t* lastBuffer() {
+    return driver.lastBuffer;
+}
+
+uint32_t framesServed() {
+    return driver.served;
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef CATCAM_HOST_FAKECAMERA_H
+#define CATCAM_HOST_FAKECAMERA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * FakeCamera - Controls for the host esp_camera driver
+ *
+ * esp_camera_init() reserves fb_count buffers up front like the real driver;
+ * esp_camera_fb_get() fills a free one with the current frame, advances the
+ * host clock by one frame period and stamps it, and returns nullptr when
+ * every buffer is out (the real driver would block until one comes back).
+ */
+namespace FakeCamera {
+
+/**
+ * Frame every fb_get() returns from now on; data must outlive its use
+ */
+void setFrame(const uint8_t* data, size_t len, int width, int height);
+
+void setFramePeriodUs(int64_t periodUs);
+
+/**
+ * Buffers handed out by fb_get() and not yet returned
+ */
+size_t buffersOut();
+
+/**
+ * The driver buffer fb_get() last handed out
+ */
+const uint8_t* lastBuffer();
+
+uint32_t framesServed();
+
+}
+
+#endif
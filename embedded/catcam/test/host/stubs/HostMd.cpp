@@ -0,0 +1,193 @@
+#include <mbedtls/md.h>
+#include <string.h>
+
+namespace {
+
+const mbedtls_md_info_t SHA256_INFO = { MBEDTLS_MD_SHA256 };
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void compress(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void shaStart(mbedtls_sha256_state_t& s) {
+    static const uint32_t IV[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    memcpy(s.state, IV, sizeof(IV));
+    s.length = 0;
+    s.blockUsed = 0;
+}
+
+void shaUpdate(mbedtls_sha256_state_t& s, const uint8_t* data, size_t len) {
+    s.length += len;
+    if (s.blockUsed > 0) {
+        size_t take = len < 64 - s.blockUsed ? len : 64 - s.blockUsed;
+        memcpy(s.block + s.blockUsed, data, take);
+        s.blockUsed += take;
+        data += take;
+        len -= take;
+        if (s.blockUsed < 64) {
+            return;
+        }
+        compress(s.state, s.block);
+        s.blockUsed = 0;
+    }
+    for (; len >= 64; data += 64, len -= 64) {
+        compress(s.state, data);
+    }
+    memcpy(s.block, data, len);
+    s.blockUsed = len;
+}
+
+void shaFinish(mbedtls_sha256_state_t& s, uint8_t out[32]) {
+    uint64_t bits = s.length * 8;
+    uint8_t pad[72] = { 0x80 };
+    size_t padLen = (s.blockUsed < 56 ? 56 : 120) - s.blockUsed;
+    for (int i = 0; i < 8; i++) {
+        pad[padLen + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    shaUpdate(s, pad, padLen + 8);
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (uint8_t)(s.state[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(s.state[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(s.state[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)s.state[i];
+    }
+}
+
+}
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    return type == MBEDTLS_MD_SHA256 ? &SHA256_INFO : nullptr;
+}
+
+void mbedtls_md_init(mbedtls_md_context_t* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_md_free(mbedtls_md_context_t* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac) {
+    if (info == nullptr) {
+        return -1;
+    }
+    ctx->md_info = info;
+    ctx->hmac = hmac;
+    return 0;
+}
+
+int mbedtls_md_starts(mbedtls_md_context_t* ctx) {
+    shaStart(ctx->sha);
+    return 0;
+}
+
+int mbedtls_md_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t len) {
+    shaUpdate(ctx->sha, input, len);
+    return 0;
+}
+
+int mbedtls_md_finish(mbedtls_md_context_t* ctx, unsigned char* output) {
+    shaFinish(ctx->sha, output);
+    return 0;
+}
+
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t len, unsigned char* output) {
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    if (mbedtls_md_setup(&ctx, info, 0) != 0) {
+        return -1;
+    }
+    mbedtls_md_starts(&ctx);
+    mbedtls_md_update(&ctx, input, len);
+    return mbedtls_md_finish(&ctx, output);
+}
+
+int mbedtls_md_hmac_starts(mbedtls_md_context_t* ctx, const unsigned char* key, size_t keylen) {
+    if (!ctx->hmac) {
+        return -1;
+    }
+    uint8_t block[64] = {};
+    if (keylen > sizeof(block)) {
+        mbedtls_sha256_state_t s;
+        shaStart(s);
+        shaUpdate(s, key, keylen);
+        shaFinish(s, block);
+    } else {
+        memcpy(block, key, keylen);
+    }
+    uint8_t ipad[64];
+    for (int i = 0; i < 64; i++) {
+        ipad[i] = block[i] ^ 0x36;
+        ctx->opad[i] = block[i] ^ 0x5c;
+    }
+    shaStart(ctx->sha);
+    shaUpdate(ctx->sha, ipad, sizeof(ipad));
+    return 0;
+}
+
+int mbedtls_md_hmac_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t len) {
+    shaUpdate(ctx->sha, input, len);
+    return 0;
+}
+
+int mbedtls_md_hmac_finish(mbedtls_md_context_t* ctx, unsigned char* output) {
+    uint8_t inner[32];
+    shaFinish(ctx->sha, inner);
+    shaStart(ctx->sha);
+    shaUpdate(ctx->sha, ctx->opad, sizeof(ctx->opad));
+    shaUpdate(ctx->sha, inner, sizeof(inner));
+    shaFinish(ctx->sha, output);
+    return 0;
+}
+
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keylen,
+                    const unsigned char* input, size_t len, unsigned char* output) {
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    if (mbedtls_md_setup(&ctx, info, 1) != 0) {
+        return -1;
+    }
+    mbedtls_md_hmac_starts(&ctx, key, keylen);
+    mbedtls_md_hmac_update(&ctx, input, len);
+    return mbedtls_md_hmac_finish(&ctx, output);
+}
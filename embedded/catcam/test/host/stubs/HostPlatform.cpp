@@ -0,0 +1,89 @@
+// Host implementations behind Arduino.h, esp_timer.h and SDLogger.h
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdarg.h>
+#include <chrono>
+#include <thread>
+
+#include "../../../lib/SDLogger/src/SDLogger.h"
+
+namespace {
+
+int64_t clockOffsetUs = 0;
+
+int64_t steadyUs() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+// Quiet unless CATCAM_HOST_LOG is set; formats on the stack so logging
+// never shows up in allocation counts
+void emit(const char* level, const char* format, va_list args) {
+    static const bool enabled = getenv("CATCAM_HOST_LOG") != nullptr;
+    if (!enabled) {
+        return;
+    }
+    char line[256];
+    vsnprintf(line, sizeof(line), format, args);
+    fprintf(stderr, "[%s] %s\n", level, line);
+}
+
+const char* levelName(LogLevel level) {
+    static const char* NAMES[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL" };
+    return level >= LOG_TRACE && level <= LOG_CRITICAL ? NAMES[level] : "?";
+}
+
+}
+
+int64_t esp_timer_get_time() {
+    return steadyUs() + clockOffsetUs;
+}
+
+void hostAdvanceClock(int64_t us) {
+    clockOffsetUs += us;
+}
+
+unsigned long millis() {
+    return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+SDLogger& SDLogger::getInstance() {
+    static SDLogger instance;
+    return instance;
+}
+
+void SDLogger::logf(LogLevel level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    emit(levelName(level), format, args);
+    va_end(args);
+}
+
+void SDLogger::log(LogLevel level, const char* message) { logf(level, "%s", message); }
+void SDLogger::trace(const char* message) { log(LOG_TRACE, message); }
+void SDLogger::debug(const char* message) { log(LOG_DEBUG, message); }
+void SDLogger::info(const char* message) { log(LOG_INFO, message); }
+void SDLogger::warn(const char* message) { log(LOG_WARN, message); }
+void SDLogger::error(const char* message) { log(LOG_ERROR, message); }
+void SDLogger::critical(const char* message) { log(LOG_CRITICAL, message); }
+
+#define HOST_LOGF(method, level)                  \
+    void SDLogger::method(const char* format, ...) { \
+        va_list args;                                \
+        va_start(args, format);                      \
+        emit(levelName(level), format, args);        \
+        va_end(args);                                \
+    }
+
+HOST_LOGF(tracef, LOG_TRACE)
+HOST_LOGF(debugf, LOG_DEBUG)
+HOST_LOGF(infof, LOG_INFO)
+HOST_LOGF(warnf, LOG_WARN)
+HOST_LOGF(errorf, LOG_ERROR)
+HOST_LOGF(criticalf, LOG_CRITICAL)
@@ -0,0 +1,59 @@
+// FreeRTOS tasks and binary semaphores as host threads
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+namespace {
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable given;
+    bool available = false;
+};
+
+static_assert(sizeof(HostSemaphore) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+}
+
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer) {
+    return new (buffer->storage) HostSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t) {
+    HostSemaphore* s = static_cast<HostSemaphore*>(semaphore);
+    std::unique_lock<std::mutex> lock(s->mutex);
+    s->given.wait(lock, [s] { return s->available; });
+    s->available = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    HostSemaphore* s = static_cast<HostSemaphore*>(semaphore);
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (s->available) {
+            return pdFALSE;
+        }
+        s->available = true;
+    }
+    s->given.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char*, uint32_t, void* parameter,
+                                   UBaseType_t, TaskHandle_t* created, BaseType_t) {
+    std::thread(function, parameter).detach();
+    if (created) {
+        *created = nullptr;
+    }
+    return pdPASS;
+}
@@ -0,0 +1,26 @@
+#ifndef CATCAM_HOST_IPADDRESS_H
+#define CATCAM_HOST_IPADDRESS_H
+
+#include <Arduino.h>
+
+// Host stand-in for the Arduino core's IPv4 address
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{ a, b, c, d } {}
+
+    uint8_t operator[](int index) const { return _octets[index]; }
+    bool operator==(const IPAddress& o) const { return memcmp(_octets, o._octets, 4) == 0; }
+
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", _octets[0], _octets[1], _octets[2], _octets[3]);
+        return String(text);
+    }
+
+private:
+    uint8_t _octets[4] = {};
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef CATCAM_HOST_PREFERENCES_H
+#define CATCAM_HOST_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Host stand-in for NVS Preferences: one in-memory namespace per instance,
+ * every value kept as raw bytes
+ */
+class Preferences {
+public:
+    bool begin(const char*, bool = false) { return true; }
+    void end() {}
+
+    bool isKey(const char* key) const { return _values.count(key) != 0; }
+    size_t getBytesLength(const char* key) const {
+        auto it = _values.find(key);
+        return it == _values.end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char* key, void* buf, size_t maxLen) const {
+        auto it = _values.find(key);
+        if (it == _values.end() || it->second.size() > maxLen) {
+            return 0;
+        }
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        _values[key].assign((const uint8_t*)value, (const uint8_t*)value + len);
+        return len;
+    }
+
+    int32_t getInt(const char* key, int32_t defaultValue = 0) const { return get(key, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) const { return get(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false) const { return get(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = 0) const { return get(key, defaultValue); }
+    size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+
+private:
+    std::map<std::string, std::vector<uint8_t>> _values;
+
+    template <typename T>
+    T get(const char* key, T defaultValue) const {
+        T value;
+        return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+    }
+};
+
+#endif
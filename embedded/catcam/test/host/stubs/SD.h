@@ -0,0 +1,6 @@
+#ifndef CATCAM_HOST_SD_H
+#define CATCAM_HOST_SD_H
+
+// Host stand-in: SDLogger.h includes it, the host logger never touches a card
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef CATCAM_HOST_SPI_H
+#define CATCAM_HOST_SPI_H
+
+#endif
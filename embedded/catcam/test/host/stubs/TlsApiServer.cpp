@@ -0,0 +1,430 @@
+// Loopback TLS server and client behind IApiTransport for the ApiConnection TLS tests
+
+#include "TlsApiServer.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+namespace {
+
+// Self-signed P-256 certificate for the server; the client does not verify it
+bool useSelfSignedCertificate(SSL_CTX* context) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* certificate = X509_new();
+    bool ok = key && certificate;
+    if (ok) {
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 3600);
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"catcam-host-test", -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_set_pubkey(certificate, key);
+        ok = X509_sign(certificate, key, EVP_sha256()) > 0 &&
+             SSL_CTX_use_certificate(context, certificate) == 1 &&
+             SSL_CTX_use_PrivateKey(context, key) == 1;
+    }
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+void formatReply(const FakeApiServer::Reply& reply, std::string& out) {
+    char head[160];
+    if (reply.unsized) {
+        snprintf(head, sizeof(head), "HTTP/1.1 %d Status\r\nContent-Type: application/json\r\n\r\n", reply.status);
+    } else {
+        snprintf(head, sizeof(head), "HTTP/1.1 %d Status\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n%s\r\n",
+                 reply.status, reply.body.size(), reply.close ? "Connection: close\r\n" : "");
+    }
+    out = head;
+    out += reply.body;
+}
+
+}
+
+TlsApiServer::TlsApiServer() : _client(*this) {
+    signal(SIGPIPE, SIG_IGN);  // A write to a connection the peer closed fails instead
+
+    _clientContext = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(_clientContext, TLS1_2_VERSION);
+    SSL_CTX_set_verify(_clientContext, SSL_VERIFY_NONE, nullptr);
+    if (!makeServerContext() || pipe(_wake) != 0) {
+        return;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 4) != 0 ||
+        getsockname(fd, (sockaddr*)&address, &length) != 0) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    _port = ntohs(address.sin_port);
+    _listenFd = fd;
+    _thread = std::thread([this] { serve(); });
+}
+
+TlsApiServer::~TlsApiServer() {
+    _client.stop();
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        wake();
+        _thread.join();
+    }
+    if (_listenFd >= 0) close(_listenFd);
+    if (_wake[0] >= 0) close(_wake[0]);
+    if (_wake[1] >= 0) close(_wake[1]);
+    SSL_SESSION_free(_session);
+    SSL_CTX_free(_clientContext);
+    SSL_CTX_free(_serverContext);
+}
+
+bool TlsApiServer::makeServerContext() {
+    _serverContext = SSL_CTX_new(TLS_server_method());
+    if (!_serverContext) {
+        return false;
+    }
+    SSL_CTX_set_max_proto_version(_serverContext, TLS1_2_VERSION);
+    return useSelfSignedCertificate(_serverContext);
+}
+
+// --- Client end ---
+
+bool TlsApiServer::resolve(const char*, IPAddress& address) {
+    address = IPAddress(127, 0, 0, 1);
+    return ready();
+}
+
+bool TlsApiServer::connect(const IPAddress&, uint16_t, const char* host) {
+    _client.stop();
+    _resumed = false;
+    if (!ready()) {
+        return false;
+    }
+    // Whatever port ApiConnection asks for, the server is on _port
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(_port);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    return _client.open(fd, host);
+}
+
+bool TlsApiServer::Socket::open(int fd, const char* host) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    _fd = fd;
+    _ssl = SSL_new(_owner._clientContext);
+    SSL_set_fd(_ssl, fd);
+    if (host) {
+        SSL_set_tlsext_host_name(_ssl, host);
+    }
+    if (_owner._session && host && _owner._sessionHost == host) {
+        SSL_set_session(_ssl, _owner._session);
+    }
+
+    int ret;
+    while ((ret = SSL_connect(_ssl)) != 1) {
+        if (!waitFor(SSL_get_error(_ssl, ret))) {
+            stop();
+            return false;
+        }
+    }
+    _owner._resumed = SSL_session_reused(_ssl);
+
+    // Kept for the next connect, as TlsClient keeps the mbedtls session
+    SSL_SESSION_free(_owner._session);
+    _owner._session = SSL_get1_session(_ssl);
+    _owner._sessionHost = host ? host : "";
+    return true;
+}
+
+bool TlsApiServer::Socket::waitFor(int error) {
+    pollfd fd = { _fd, 0, 0 };
+    if (error == SSL_ERROR_WANT_READ) {
+        fd.events = POLLIN;
+    } else if (error == SSL_ERROR_WANT_WRITE) {
+        fd.events = POLLOUT;
+    } else {
+        return false;
+    }
+    return poll(&fd, 1, (int)_owner._timeoutMs) == 1;
+}
+
+size_t TlsApiServer::Socket::write(const uint8_t* buf, size_t size) {
+    if (!_ssl || _peerClosed) {
+        return 0;
+    }
+    size_t written = 0;
+    while (written < size) {
+        int ret = SSL_write(_ssl, buf + written, (int)(size - written));
+        if (ret > 0) {
+            written += ret;
+        } else if (!waitFor(SSL_get_error(_ssl, ret))) {
+            _peerClosed = true;
+            break;
+        }
+    }
+    return written;
+}
+
+void TlsApiServer::Socket::receive() {
+    if (!_ssl || _peerClosed) {
+        return;
+    }
+    uint8_t buffer[4096];
+    while (true) {
+        int ret = SSL_read(_ssl, buffer, sizeof(buffer));
+        if (ret > 0) {
+            _inbound.append((const char*)buffer, ret);
+            continue;
+        }
+        if (SSL_get_error(_ssl, ret) != SSL_ERROR_WANT_READ) {
+            _peerClosed = true;  // close_notify, FIN or reset
+        }
+        return;
+    }
+}
+
+int TlsApiServer::Socket::available() {
+    receive();
+    return (int)(_inbound.size() - _readPos);
+}
+
+int TlsApiServer::Socket::read() {
+    uint8_t byte;
+    return read(&byte, 1) == 1 ? byte : -1;
+}
+
+int TlsApiServer::Socket::read(uint8_t* buf, size_t size) {
+    size_t n = std::min(size, (size_t)available());
+    if (n == 0) {
+        return -1;
+    }
+    memcpy(buf, _inbound.data() + _readPos, n);
+    _readPos += n;
+    if (_readPos == _inbound.size()) {
+        _inbound.clear();
+        _readPos = 0;
+    }
+    return (int)n;
+}
+
+uint8_t TlsApiServer::Socket::connected() {
+    // Reads first, so a close_notify that arrived while idle is seen
+    int pending = available();
+    return _ssl && !(_peerClosed && pending == 0);
+}
+
+void TlsApiServer::Socket::stop() {
+    if (_ssl) {
+        // An SSL freed without a shutdown has its session made unresumable
+        if (_peerClosed) {
+            SSL_set_shutdown(_ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        } else {
+            SSL_shutdown(_ssl);
+        }
+        SSL_free(_ssl);
+        _ssl = nullptr;
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _peerClosed = false;
+    _inbound.clear();
+    _readPos = 0;
+}
+
+// --- Server end ---
+
+void TlsApiServer::queueReply(const Reply& reply) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _replies.push_back(reply);
+}
+
+void TlsApiServer::dropConnection() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _dropRequested = true;
+    wake();
+    _changed.wait(lock, [this] { return !_dropRequested; });
+}
+
+void TlsApiServer::forgetSessions() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _generation++;
+}
+
+int TlsApiServer::accepted() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _accepted;
+}
+
+int TlsApiServer::fullHandshakes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _fullHandshakes;
+}
+
+int TlsApiServer::resumedHandshakes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _resumedHandshakes;
+}
+
+std::string TlsApiServer::lastSniHost() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sniHost;
+}
+
+std::vector<std::string> TlsApiServer::requests() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requests;
+}
+
+void TlsApiServer::wake() {
+    char byte = 0;
+    (void)!::write(_wake[1], &byte, 1);
+}
+
+void TlsApiServer::serve() {
+    while (true) {
+        pollfd fds[2] = { { _listenFd, POLLIN, 0 }, { _wake[0], POLLIN, 0 } };
+        poll(fds, 2, -1);
+        if (fds[1].revents) {
+            char drain[16];
+            (void)!::read(_wake[0], drain, sizeof(drain));
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping) {
+                return;
+            }
+            // Nothing open to drop
+            _dropRequested = false;
+            _changed.notify_all();
+        }
+        if (fds[0].revents) {
+            int fd = accept(_listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                serveConnection(fd);
+            }
+            // The wake-up that stopped the connection may have been the last one
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping) {
+                return;
+            }
+        }
+    }
+}
+
+void TlsApiServer::serveConnection(int fd) {
+    SSL* ssl = SSL_new(_serverContext);
+    SSL_set_fd(ssl, fd);
+    {
+        // Sessions only resume within the context they were issued in
+        std::lock_guard<std::mutex> lock(_mutex);
+        _accepted++;
+        SSL_set_session_id_context(ssl, (const unsigned char*)&_generation, sizeof(_generation));
+    }
+
+    if (SSL_accept(ssl) == 1) {
+        const char* sni = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            (SSL_session_reused(ssl) ? _resumedHandshakes : _fullHandshakes)++;
+            _sniHost = sni ? sni : "";
+        }
+
+        std::string inbound;
+        bool closed = false;
+        while (!closed) {
+            // Decrypted bytes can be left over from the last record
+            if (SSL_pending(ssl) == 0) {
+                pollfd fds[2] = { { fd, POLLIN, 0 }, { _wake[0], POLLIN, 0 } };
+                poll(fds, 2, -1);
+                if (fds[1].revents) {
+                    char drain[16];
+                    (void)!::read(_wake[0], drain, sizeof(drain));
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_stopping || _dropRequested) {
+                        SSL_shutdown(ssl);
+                        break;
+                    }
+                    continue;
+                }
+            }
+            char buffer[4096];
+            int n = SSL_read(ssl, buffer, sizeof(buffer));
+            if (n <= 0) {
+                // The client closed; a reset is not a reason to forget the session
+                SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+                break;
+            }
+            inbound.append(buffer, n);
+            while (!closed && answer(ssl, inbound, closed)) {
+            }
+        }
+    }
+
+    SSL_free(ssl);
+    close(fd);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_dropRequested) {
+        _dropRequested = false;
+        _changed.notify_all();
+    }
+}
+
+bool TlsApiServer::answer(SSL* ssl, std::string& inbound, bool& closed) {
+    size_t headEnd = inbound.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        return false;
+    }
+    size_t bodyLength = 0;
+    size_t field = inbound.find("Content-Length:");
+    if (field != std::string::npos && field < headEnd) {
+        bodyLength = strtoul(inbound.c_str() + field + 15, nullptr, 10);
+    }
+    size_t total = headEnd + 4 + bodyLength;
+    if (inbound.size() < total) {
+        return false;
+    }
+
+    Reply reply;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _requests.push_back(inbound.substr(0, total));
+        if (!_replies.empty()) {
+            reply = _replies.front();
+            _replies.pop_front();
+        }
+    }
+    inbound.erase(0, total);
+
+    if (!reply.hangUp) {
+        std::string out;
+        formatReply(reply, out);
+        SSL_write(ssl, out.data(), (int)out.size());
+    }
+    if (reply.hangUp || reply.close || reply.unsized) {
+        SSL_shutdown(ssl);
+        closed = true;
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+#ifndef CATCAM_HOST_TLSAPISERVER_H
+#define CATCAM_HOST_TLSAPISERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <openssl/ssl.h>
+
+#include "ApiTransport.h"
+#include "FakeApiServer.h"
+
+/**
+ * TlsApiServer - IApiTransport over real TLS on the loopback interface
+ *
+ * An OpenSSL server thread (self-signed P-256 certificate, TLS 1.2 like
+ * the ESP32's mbedtls) answers with scripted FakeApiServer replies. The
+ * client end keeps the session of each handshake and offers it on the
+ * next connect to the same host, as TlsClient does on the device, so
+ * ApiConnection's handshake, resumption and keep-alive counts can be
+ * checked against what the server actually saw.
+ */
+class TlsApiServer : public IApiTransport {
+public:
+    using Reply = FakeApiServer::Reply;
+
+    TlsApiServer();
+    ~TlsApiServer() override;
+
+    /**
+     * Whether the server is listening (certificate made, port bound)
+     */
+    bool ready() const { return _listenFd >= 0; }
+
+    Client& client() override { return _client; }
+    bool resolve(const char* host, IPAddress& address) override;
+    bool connect(const IPAddress& address, uint16_t port, const char* host) override;
+    void setTimeout(uint32_t timeoutMs) override { _timeoutMs = timeoutMs; }
+    bool resumed() const override { return _resumed; }
+
+    void queueReply(const Reply& reply);
+
+    /**
+     * The server closes the open connection (close_notify, then FIN) as an
+     * idle timeout would; returns once it has
+     */
+    void dropConnection();
+
+    /**
+     * The server no longer resumes sessions it issued so far (restart,
+     * cache expiry), so the next connect is a full handshake
+     */
+    void forgetSessions();
+
+    int accepted() const;
+    int fullHandshakes() const;
+    int resumedHandshakes() const;
+    std::string lastSniHost() const;
+    std::vector<std::string> requests() const;
+
+private:
+    class Socket : public Client {
+    public:
+        explicit Socket(TlsApiServer& owner) : _owner(owner) {}
+
+        int connect(IPAddress, uint16_t) override { return 0; }
+        int connect(const char*, uint16_t) override { return 0; }
+        size_t write(uint8_t byte) override { return write(&byte, 1); }
+        size_t write(const uint8_t* buf, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t* buf, size_t size) override;
+        int peek() override { return available() > 0 ? (uint8_t)_inbound[_readPos] : -1; }
+        void flush() override {}
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override { return connected(); }
+
+        bool open(int fd, const char* host);
+
+    private:
+        TlsApiServer& _owner;
+        SSL* _ssl = nullptr;
+        int _fd = -1;
+        bool _peerClosed = false;
+        std::string _inbound;
+        size_t _readPos = 0;
+
+        void receive();
+        bool waitFor(int error);
+    };
+
+    // Client end
+    Socket _client;
+    SSL_CTX* _clientContext = nullptr;
+    SSL_SESSION* _session = nullptr;
+    std::string _sessionHost;
+    bool _resumed = false;
+    uint32_t _timeoutMs = 10000;
+
+    // Server end, shared with the server thread under _mutex
+    SSL_CTX* _serverContext = nullptr;
+    int _listenFd = -1;
+    uint16_t _port = 0;
+    int _wake[2] = { -1, -1 };
+    std::thread _thread;
+    mutable std::mutex _mutex;
+    std::condition_variable _changed;
+    std::deque<Reply> _replies;
+    std::vector<std::string> _requests;
+    bool _stopping = false;
+    bool _dropRequested = false;
+    int _generation = 0;  // Session ID context; bumped to forget sessions
+    int _accepted = 0;
+    int _fullHandshakes = 0;
+    int _resumedHandshakes = 0;
+    std::string _sniHost;
+
+    bool makeServerContext();
+    void serve();
+    void serveConnection(int fd);
+    bool answer(SSL* ssl, std::string& inbound, bool& closed);
+    void wake();
+};
+
+#endif
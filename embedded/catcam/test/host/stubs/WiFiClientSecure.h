@@ -0,0 +1,27 @@
+#ifndef CATCAM_HOST_WIFICLIENTSECURE_H
+#define CATCAM_HOST_WIFICLIENTSECURE_H
+
+#include "Client.h"
+
+// Host stand-in: never connects; tests use a fake IApiTransport instead
+
+class WiFiClientSecure : public Client {
+public:
+    void setInsecure() {}
+    void setTimeout(uint32_t) {}
+    int connect(IPAddress, uint16_t, const char*, const char*, const char*, const char*) { return 0; }
+    int connect(IPAddress, uint16_t) override { return 0; }
+    int connect(const char*, uint16_t) override { return 0; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t*, size_t) override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+    void stop() override {}
+    uint8_t connected() override { return 0; }
+    operator bool() override { return false; }
+};
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef CATCAM_HOST_RTC_IO_H
+#define CATCAM_HOST_RTC_IO_H
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef CATCAM_HOST_ESP32_HAL_PSRAM_H
+#define CATCAM_HOST_ESP32_HAL_PSRAM_H
+
+#include <stdlib.h>
+
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef CATCAM_HOST_ESP_TIMER_H
+#define CATCAM_HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+/**
+ * Microseconds since start on the host clock
+ * The fake camera driver advances this clock by a frame period for every
+ * frame it hands out, standing in for the time fb_get() would block.
+ */
+int64_t esp_timer_get_time();
+
+void hostAdvanceClock(int64_t us);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CATCAM_HOST_FREERTOS_H
+#define CATCAM_HOST_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Handle types, plus the few task and semaphore calls PayloadHasher makes
+// (HostRtos.cpp runs tasks as host threads)
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffu
+
+BaseType_t xPortGetCoreID();
+
+#endif
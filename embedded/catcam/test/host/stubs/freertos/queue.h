@@ -0,0 +1,6 @@
+#ifndef CATCAM_HOST_FREERTOS_QUEUE_H
+#define CATCAM_HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef CATCAM_HOST_FREERTOS_SEMPHR_H
+#define CATCAM_HOST_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+struct StaticSemaphore_t {
+    alignas(16) unsigned char storage[128];
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);  // Host: only portMAX_DELAY
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif
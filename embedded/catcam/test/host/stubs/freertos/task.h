@@ -0,0 +1,13 @@
+#ifndef CATCAM_HOST_FREERTOS_TASK_H
+#define CATCAM_HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+// The task runs on a detached host thread; stack, priority and core are ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core);
+
+// Host: only vTaskDelete(nullptr) as a task's last call; the thread then returns
+inline void vTaskDelete(TaskHandle_t) {}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CATCAM_HOST_MBEDTLS_MD_H
+#define CATCAM_HOST_MBEDTLS_MD_H
+
+// Host stand-in for mbedtls' message-digest API, SHA-256 only, implemented
+// in HostMd.cpp so the host tests need no crypto library
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+typedef struct {
+    mbedtls_md_type_t type;
+} mbedtls_md_info_t;
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;        // Bytes hashed so far
+    uint8_t block[64];
+    size_t blockUsed;
+} mbedtls_sha256_state_t;
+
+typedef struct {
+    const mbedtls_md_info_t* md_info;
+    mbedtls_sha256_state_t sha;
+    int hmac;
+    uint8_t opad[64];       // Outer key pad, kept for hmac_finish
+} mbedtls_md_context_t;
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type);
+
+void mbedtls_md_init(mbedtls_md_context_t* ctx);
+void mbedtls_md_free(mbedtls_md_context_t* ctx);
+int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac);
+int mbedtls_md_starts(mbedtls_md_context_t* ctx);
+int mbedtls_md_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t len);
+int mbedtls_md_finish(mbedtls_md_context_t* ctx, unsigned char* output);
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t len, unsigned char* output);
+
+int mbedtls_md_hmac_starts(mbedtls_md_context_t* ctx, const unsigned char* key, size_t keylen);
+int mbedtls_md_hmac_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t len);
+int mbedtls_md_hmac_finish(mbedtls_md_context_t* ctx, unsigned char* output);
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keylen,
+                    const unsigned char* input, size_t len, unsigned char* output);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef CATCAM_HOST_ALLOCATIONCOUNTER_H
+#define CATCAM_HOST_ALLOCATIONCOUNTER_H
+
+#include <stddef.h>
+
+/**
+ * Heap allocations (malloc, calloc, realloc, operator new) made by this
+ * process so far - tests diff it around the code under test
+ */
+size_t hostAllocationCount();
+
+#endif
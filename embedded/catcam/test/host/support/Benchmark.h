@@ -0,0 +1,36 @@
+#ifndef CATCAM_HOST_BENCHMARK_H
+#define CATCAM_HOST_BENCHMARK_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <chrono>
+
+/**
+ * Runs fn repeatedly for about minSeconds (at least minRuns times) and
+ * prints the time per run, plus throughput when bytes per run is given.
+ * Host timings only rank alternatives; they say nothing absolute about the
+ * ESP32-S3.
+ * @return Microseconds per run
+ */
+template <typename Fn>
+double benchmark(const char* name, size_t bytesPerRun, Fn&& fn, double minSeconds = 0.2, int minRuns = 5) {
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds || runs < minRuns);
+
+    double usPerRun = elapsed * 1e6 / runs;
+    if (bytesPerRun) {
+        printf("  %-40s %10.1f us/run %9.1f MB/s\n", name, usPerRun, bytesPerRun / usPerRun);
+    } else {
+        printf("  %-40s %10.1f us/run\n", name, usPerRun);
+    }
+    return usPerRun;
+}
+
+#endif
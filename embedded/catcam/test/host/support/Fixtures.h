@@ -0,0 +1,84 @@
+#ifndef CATCAM_HOST_FIXTURES_H
+#define CATCAM_HOST_FIXTURES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/**
+ * Fixture JPEGs and libjpeg reference outputs written by tools/make_fixtures
+ * (see fixtures/README.md). CATCAM_FIXTURES_DIR is set by CMakeLists.txt.
+ */
+
+inline std::vector<uint8_t> loadFixture(const std::string& file) {
+    std::string path = std::string(CATCAM_FIXTURES_DIR) + "/" + file;
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        fprintf(stderr, "Missing fixture %s\n", path.c_str());
+        exit(2);
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return data;
+}
+
+inline std::vector<uint8_t> loadJpeg(const char* name) {
+    return loadFixture(std::string(name) + ".jpg");
+}
+
+struct ReferenceImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    uint8_t at(int x, int y) const { return pixels[(size_t)y * width + x]; }
+};
+
+/**
+ * reference/<name><suffix>, a binary PGM (e.g. suffix ".dc.pgm")
+ */
+inline ReferenceImage loadReference(const char* name, const char* suffix) {
+    std::vector<uint8_t> file = loadFixture(std::string("reference/") + name + suffix);
+    ReferenceImage image;
+    int maxValue = 0;
+    int headerBytes = 0;
+    file.push_back(0);
+    if (sscanf((const char*)file.data(), "P5 %d %d %d%n", &image.width, &image.height, &maxValue, &headerBytes) != 3 ||
+        maxValue != 255) {
+        fprintf(stderr, "Bad reference image %s%s\n", name, suffix);
+        exit(2);
+    }
+    const uint8_t* pixels = file.data() + headerBytes + 1;  // One whitespace byte after maxval
+    image.pixels.assign(pixels, pixels + (size_t)image.width * image.height);
+    return image;
+}
+
+/**
+ * Value for name from a "name value" reference table, e.g. reference/sharpness.txt
+ */
+inline double referenceValue(const char* table, const char* name) {
+    std::vector<uint8_t> file = loadFixture(std::string("reference/") + table);
+    std::string text(file.begin(), file.end());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        std::string line = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        size_t space = line.find(' ');
+        if (space != std::string::npos && line.compare(0, space, name) == 0 && space == strlen(name)) {
+            return atof(line.c_str() + space + 1);
+        }
+        pos = end == std::string::npos ? text.size() : end + 1;
+    }
+    fprintf(stderr, "No %s in reference/%s\n", name, table);
+    exit(2);
+}
+
+#endif
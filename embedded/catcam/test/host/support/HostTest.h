@@ -0,0 +1,43 @@
+#ifndef CATCAM_HOST_HOSTTEST_H
+#define CATCAM_HOST_HOSTTEST_H
+
+#include <stdio.h>
+
+/**
+ * Minimal checks for the host tests: a failed CHECK prints where and carries
+ * on, and main() returns hostTestResult() so ctest sees the failure
+ */
+
+inline int hostTestFailures = 0;
+inline int hostTestChecks = 0;
+
+inline bool hostCheck(bool ok, const char* expr, const char* file, int line) {
+    hostTestChecks++;
+    if (!ok) {
+        hostTestFailures++;
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+    }
+    return ok;
+}
+
+template <typename A, typename B>
+inline bool hostCheckEq(const A& a, const B& b, const char* exprA, const char* exprB, const char* file, int line) {
+    hostTestChecks++;
+    if (!(a == b)) {
+        hostTestFailures++;
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", file, line, exprA, exprB,
+                (long long)a, (long long)b);
+        return false;
+    }
+    return true;
+}
+
+#define CHECK(cond) hostCheck((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(a, b) hostCheckEq((a), (b), #a, #b, __FILE__, __LINE__)
+
+inline int hostTestResult(const char* name) {
+    printf("%s: %d checks, %d failed\n", name, hostTestChecks, hostTestFailures);
+    return hostTestFailures == 0 ? 0 : 1;
+}
+
+#endif
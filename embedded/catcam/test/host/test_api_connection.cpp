@@ -0,0 +1,232 @@
+// ApiConnection keep-alive reuse, stale-connection retry and DNS caching
+// against a scripted server
+
+#include "ApiConnection.h"
+#include "FakeApiServer.h"
+#include <esp_timer.h>
+
+#include "support/HostTest.h"
+
+namespace {
+
+const char* HOST = "api.example.com";
+const uint32_t HANDSHAKE_MS = 300;
+
+String head(const char* path, size_t bodyLength) {
+    char text[200];
+    snprintf(text, sizeof(text), "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Length: %zu\r\n", path, HOST, bodyLength);
+    return String(text);
+}
+
+/**
+ * Sends a fixed body and counts how often it was asked to
+ */
+struct Body {
+    const char* text;
+    int writes = 0;
+
+    ApiConnection::BodyWriter writer() {
+        return [this](Client& client) {
+            writes++;
+            size_t length = strlen(text);
+            return client.write((const uint8_t*)text, length) == length;
+        };
+    }
+};
+
+bool post(ApiConnection& connection, Body& body, ApiResponse& response) {
+    return connection.request(HOST, head("/infer", strlen(body.text)), body.writer(), 10000, response);
+}
+
+void testWarmConnectionIsReused() {
+    FakeApiServer server;
+    server.setHandshakeMs(HANDSHAKE_MS);
+    ApiConnection connection(server);
+    Body body{ "{\"image\":1}" };
+
+    FakeApiServer::Reply first;
+    first.body = "{\"cat\":\"Boots\"}";
+    server.queueReply(first);
+
+    ApiResponse response;
+    CHECK(post(connection, body, response));
+    CHECK_EQ(response.statusCode, 200);
+    CHECK(response.body == "{\"cat\":\"Boots\"}");
+    CHECK(!response.reused);
+    CHECK_EQ(response.connectMs, HANDSHAKE_MS);
+    CHECK(connection.isWarm());
+    CHECK(server.lastSniHost() == HOST);
+    CHECK_EQ(server.timeoutMs(), 10000u);
+
+    // What went on the wire: the caller's head, keep-alive, then the body
+    CHECK(server.requests().size() == 1 &&
+          server.requests()[0] == std::string(head("/infer", 11).c_str()) +
+                                  "Connection: keep-alive\r\n\r\n{\"image\":1}");
+
+    for (int i = 0; i < 3; i++) {
+        CHECK(post(connection, body, response));
+        CHECK(response.reused);
+        CHECK_EQ(response.connectMs, 0u);
+    }
+    CHECK_EQ(server.connects(), 1);
+    CHECK_EQ(server.lookups(), 1);
+    const ApiConnectionStatus& status = connection.status();
+    CHECK_EQ(status.requests, 4ul);
+    CHECK_EQ(status.handshakes, 1ul);
+    CHECK_EQ(status.reused, 3ul);
+    CHECK_EQ(status.staleRetries, 0ul);
+    CHECK_EQ(status.meanHandshakeMs, (unsigned long)HANDSHAKE_MS);
+    CHECK(status.warm);
+}
+
+void testStaleConnectionIsRetriedOnce() {
+    for (bool writeFails : { true, false }) {
+        FakeApiServer server;
+        server.setHandshakeMs(HANDSHAKE_MS);
+        ApiConnection connection(server);
+        Body body{ "{}" };
+        ApiResponse response;
+        CHECK(post(connection, body, response));
+
+        // Server's keep-alive timer fired while we were idle
+        server.dropConnection(writeFails);
+        CHECK(post(connection, body, response));
+        CHECK_EQ(response.statusCode, 200);
+        CHECK(!response.reused);
+        CHECK_EQ(response.connectMs, HANDSHAKE_MS);
+        CHECK_EQ(body.writes, writeFails ? 2 : 3);  // A failed head write never reaches the body
+        CHECK_EQ(server.connects(), 2);
+        CHECK_EQ(server.requests().size(), (size_t)2);
+        CHECK_EQ(connection.status().staleRetries, 1ul);
+        CHECK_EQ(connection.status().dnsCacheHits, 1ul);
+        CHECK(connection.isWarm());
+    }
+
+    // A request without a body: the write goes out and the reset shows up
+    // as the connection closing before any response
+    FakeApiServer server;
+    ApiConnection connection(server);
+    ApiResponse response;
+    String get = "GET /status HTTP/1.1\r\nHost: api.example.com\r\n";
+    CHECK(connection.request(HOST, get, nullptr, 1000, response));
+    server.dropConnection(false);
+    CHECK(connection.request(HOST, get, nullptr, 1000, response));
+    CHECK_EQ(connection.status().staleRetries, 1ul);
+    CHECK_EQ(server.connects(), 2);
+}
+
+void testNewConnectionFailuresAreNotRetried() {
+    FakeApiServer server;
+    ApiConnection connection(server);
+    Body body{ "{}" };
+    ApiResponse response;
+
+    // Hang-up on a fresh connection is the server's answer, not staleness
+    FakeApiServer::Reply hangUp;
+    hangUp.hangUp = true;
+    server.queueReply(hangUp);
+    CHECK(!post(connection, body, response));
+    CHECK(connection.error() != nullptr && strcmp(connection.error(), "Connection closed") == 0);
+    CHECK_EQ(server.connects(), 1);
+    CHECK_EQ(body.writes, 1);
+    CHECK(!connection.isWarm());
+
+    // Stale, then the reconnect fails too: one retry only
+    CHECK(post(connection, body, response));
+    server.dropConnection(true);
+    server.failNextConnects(2);  // Second attempt also re-resolves after the cached address fails
+    CHECK(!post(connection, body, response));
+    CHECK(strcmp(connection.error(), "Connection failed") == 0);
+    CHECK_EQ(connection.status().staleRetries, 1ul);
+}
+
+void testResponsesThatEndTheConnection() {
+    FakeApiServer server;
+    ApiConnection connection(server);
+    Body body{ "{}" };
+    ApiResponse response;
+
+    FakeApiServer::Reply close;
+    close.status = 503;
+    close.close = true;
+    server.queueReply(close);
+    CHECK(post(connection, body, response));
+    CHECK_EQ(response.statusCode, 503);
+    CHECK(!connection.isWarm());
+
+    FakeApiServer::Reply unsized;
+    unsized.unsized = true;
+    unsized.body = "streamed to the end";
+    server.queueReply(unsized);
+    CHECK(post(connection, body, response));
+    CHECK(response.body == "streamed to the end");
+    CHECK(!connection.isWarm());
+
+    FakeApiServer::Reply discarded;
+    discarded.body = "not kept";
+    server.queueReply(discarded);
+    CHECK(connection.request(HOST, head("/infer", 2), body.writer(), 1000, response, false));
+    CHECK(response.body == "");
+    CHECK(connection.isWarm());  // Body read to its length, so still reusable
+    CHECK_EQ(server.connects(), 3);
+}
+
+void testIdleCloseAndDnsCache() {
+    FakeApiServer server;
+    ApiConnection connection(server);
+    Body body{ "{}" };
+    ApiResponse response;
+
+    CHECK(post(connection, body, response));
+    hostAdvanceClock(30 * 1000000LL);
+    connection.maintain();
+    CHECK(connection.isWarm());
+
+    hostAdvanceClock(31 * 1000000LL);
+    connection.maintain();
+    CHECK(!connection.isWarm());
+    CHECK(post(connection, body, response));
+    CHECK(!response.reused);
+    CHECK_EQ(server.lookups(), 1);  // Address still cached
+
+    // Not used for a minute: request() reconnects even without maintain()
+    hostAdvanceClock(61 * 1000000LL);
+    CHECK(post(connection, body, response));
+    CHECK(!response.reused);
+
+    hostAdvanceClock(10 * 60 * 1000000LL);
+    CHECK(post(connection, body, response));
+    CHECK_EQ(server.lookups(), 2);
+    CHECK_EQ(server.connects(), 4);
+}
+
+void testPrepareConnectsAhead() {
+    FakeApiServer server;
+    server.setHandshakeMs(HANDSHAKE_MS);
+    ApiConnection connection(server);
+    Body body{ "{}" };
+    ApiResponse response;
+
+    CHECK(connection.prepare(HOST));
+    CHECK(connection.isWarm());
+    CHECK(post(connection, body, response));
+    CHECK(!response.reused);
+    CHECK_EQ(response.connectMs, HANDSHAKE_MS);  // Still this request's cost
+    CHECK(connection.prepare(HOST));             // Warm: nothing to do
+    CHECK(post(connection, body, response));
+    CHECK(response.reused);
+    CHECK_EQ(server.connects(), 1);
+    CHECK_EQ(connection.status().meanConnectMs, (unsigned long)(HANDSHAKE_MS * 7 / 8));
+}
+
+}
+
+int main() {
+    testWarmConnectionIsReused();
+    testStaleConnectionIsRetriedOnce();
+    testNewConnectionFailuresAreNotRetried();
+    testResponsesThatEndTheConnection();
+    testIdleCloseAndDnsCache();
+    testPrepareConnectsAhead();
+    return hostTestResult("test_api_connection");
+}
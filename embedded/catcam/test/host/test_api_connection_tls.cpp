@@ -0,0 +1,145 @@
+// ApiConnection over real TLS: handshakes, keep-alive reuse and session
+// resumption as counted by a loopback OpenSSL server
+
+#include "ApiConnection.h"
+#include "TlsApiServer.h"
+#include <esp_timer.h>
+
+#include "support/HostTest.h"
+
+namespace {
+
+const char* HOST = "api.example.com";
+
+String head(size_t bodyLength) {
+    char text[160];
+    snprintf(text, sizeof(text), "POST /infer HTTP/1.1\r\nHost: %s\r\nContent-Length: %zu\r\n", HOST, bodyLength);
+    return String(text);
+}
+
+bool post(ApiConnection& connection, ApiResponse& response) {
+    const char* body = "{\"image\":1}";
+    size_t length = strlen(body);
+    return connection.request(HOST, head(length), [&](Client& client) {
+        return client.write((const uint8_t*)body, length) == length;
+    }, 10000, response);
+}
+
+void testKeepAliveOverTls() {
+    TlsApiServer server;
+    CHECK(server.ready());
+    ApiConnection connection(server);
+    ApiResponse response;
+
+    TlsApiServer::Reply first;
+    first.body = "{\"cat\":\"Boots\"}";
+    server.queueReply(first);
+    CHECK(post(connection, response));
+    CHECK_EQ(response.statusCode, 200);
+    CHECK(response.body == "{\"cat\":\"Boots\"}");
+    CHECK(!response.reused);
+    CHECK(server.lastSniHost() == HOST);
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(post(connection, response));
+        CHECK_EQ(response.statusCode, 200);
+        CHECK(response.reused);
+    }
+
+    // Five requests, one TCP connection, one handshake
+    CHECK_EQ(server.accepted(), 1);
+    CHECK_EQ(server.fullHandshakes(), 1);
+    CHECK_EQ(server.resumedHandshakes(), 0);
+    CHECK_EQ(server.requests().size(), (size_t)5);
+    CHECK_EQ(connection.status().handshakes, 1ul);
+    CHECK_EQ(connection.status().reused, 4ul);
+    CHECK_EQ(connection.status().resumedHandshakes, 0ul);
+}
+
+void testReconnectsResumeTheSession() {
+    TlsApiServer server;
+    ApiConnection connection(server);
+    ApiResponse response;
+
+    CHECK(post(connection, response));
+    uint32_t fullMs = response.connectMs;
+
+    // Idle timeout on the server: close_notify arrives while idle, the
+    // next request reconnects up front and resumes
+    server.dropConnection();
+    CHECK(post(connection, response));
+    CHECK_EQ(response.statusCode, 200);
+    CHECK(!response.reused);
+    CHECK(server.resumed());
+    CHECK_EQ(connection.status().staleRetries, 0ul);
+    uint32_t resumedMs = response.connectMs;
+
+    // Connection: close from the server, then our own idle close
+    TlsApiServer::Reply close;
+    close.close = true;
+    server.queueReply(close);
+    CHECK(post(connection, response));
+    CHECK(!connection.isWarm());
+    CHECK(post(connection, response));
+    CHECK(server.resumed());
+    hostAdvanceClock(61 * 1000000LL);
+    connection.maintain();
+    CHECK(!connection.isWarm());
+    CHECK(post(connection, response));
+    CHECK(server.resumed());
+
+    CHECK_EQ(server.accepted(), 4);
+    CHECK_EQ(server.fullHandshakes(), 1);
+    CHECK_EQ(server.resumedHandshakes(), 3);
+    CHECK_EQ(connection.status().handshakes, 4ul);
+    CHECK_EQ(connection.status().resumedHandshakes, 3ul);
+
+    // A server that no longer knows the session: full handshake, and the
+    // new session is the one offered next time
+    server.forgetSessions();
+    server.dropConnection();
+    CHECK(post(connection, response));
+    CHECK(!server.resumed());
+    CHECK_EQ(server.fullHandshakes(), 2);
+    server.dropConnection();
+    CHECK(post(connection, response));
+    CHECK(server.resumed());
+    CHECK_EQ(server.resumedHandshakes(), 4);
+    CHECK_EQ(connection.status().resumedHandshakes, 4ul);
+
+    printf("  handshake on loopback: full %lu ms, resumed %lu ms\n", (unsigned long)fullMs, (unsigned long)resumedMs);
+}
+
+void testResponsesThatEndTheConnection() {
+    TlsApiServer server;
+    ApiConnection connection(server);
+    ApiResponse response;
+
+    TlsApiServer::Reply unsized;
+    unsized.unsized = true;
+    unsized.body = "streamed to the end";
+    server.queueReply(unsized);
+    CHECK(post(connection, response));
+    CHECK(response.body == "streamed to the end");
+    CHECK(!connection.isWarm());
+
+    TlsApiServer::Reply hangUp;
+    hangUp.hangUp = true;
+    server.queueReply(hangUp);
+    CHECK(!post(connection, response));
+    CHECK(connection.error() != nullptr && strcmp(connection.error(), "Connection closed") == 0);
+    CHECK(!connection.isWarm());
+
+    CHECK(post(connection, response));
+    CHECK_EQ(server.accepted(), 3);
+    CHECK_EQ(server.resumedHandshakes(), 2);
+}
+
+}
+
+int main() {
+    testKeepAliveOverTls();
+    testReconnectsResumeTheSession();
+    testResponsesThatEndTheConnection();
+    return hostTestResult("test_api_connection_tls");
+}
@@ -0,0 +1,221 @@
+// BlockMotion (the VisualMotionDetector kernel) on fixture DC luma maps, and
+// against a straightforward reference of the same rule on random maps
+
+#include "BlockMotion.h"
+#include "DcLumaMap.h"
+#include <random>
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+// VisualMotionSettings defaults
+constexpr uint8_t BLOCK_CELLS = 4;
+constexpr uint8_t BLOCK_DELTA = 10;
+constexpr int MIN_BLOCKS = 3;
+
+struct Ellipse {
+    int cx;
+    int cy;
+    int rx;
+    int ry;
+};
+
+// Where the cat is in scene.jpg and scene_moved.jpg (fixtures/README.md)
+const Ellipse CAT_BEFORE = { 300, 380, 60, 40 };
+const Ellipse CAT_AFTER = { 420, 400, 60, 40 };
+
+DcLumaMap mapOf(const char* name) {
+    std::vector<uint8_t> jpeg = loadJpeg(name);
+    DcLumaMap map;
+    CHECK(map.build(jpeg.data(), jpeg.size()));
+    return map;
+}
+
+BlockMotion::Result motionBetween(BlockMotion& motion, const DcLumaMap& a, const DcLumaMap& b) {
+    motion.reset();
+    CHECK(!motion.compare(a.data(), a.width(), a.height()).valid);
+    return motion.compare(b.data(), b.width(), b.height());
+}
+
+bool boxesOverlap(int x0, int y0, int x1, int y1, const Ellipse& e) {
+    return x0 < e.cx + e.rx && x1 > e.cx - e.rx && y0 < e.cy + e.ry && y1 > e.cy - e.ry;
+}
+
+// The rule BlockMotion documents, written out plainly
+BlockMotion::Result referenceCompare(const uint8_t* previous, const uint8_t* current, int width, int height,
+                                     const MotionRoi& roi, int blockCells, int blockDelta) {
+    int x0 = roi.x * width / 100;
+    int y0 = roi.y * height / 100;
+    int x1 = (roi.x + roi.width) * width / 100;
+    int y1 = (roi.y + roi.height) * height / 100;
+
+    long sum = 0;
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            sum += current[y * width + x] - previous[y * width + x];
+        }
+    }
+    int shift = (int)(sum / ((x1 - x0) * (y1 - y0)));
+
+    BlockMotion::Result result;
+    result.valid = true;
+    for (int by = y0; by < y1; by += blockCells) {
+        for (int bx = x0; bx < x1; bx += blockCells) {
+            int sad = 0;
+            int cells = 0;
+            for (int y = by; y < std::min(by + blockCells, y1); y++) {
+                for (int x = bx; x < std::min(bx + blockCells, x1); x++) {
+                    sad += abs(current[y * width + x] - previous[y * width + x] - shift);
+                    cells++;
+                }
+            }
+            int delta = sad / cells;
+            result.maxBlockDelta = (uint8_t)std::max<int>(result.maxBlockDelta, std::min(delta, 255));
+            result.changedBlocks += delta > blockDelta;
+            result.totalBlocks++;
+        }
+    }
+    return result;
+}
+
+void testMovedCatIsLocalised() {
+    DcLumaMap before = mapOf("scene");
+    DcLumaMap after = mapOf("scene_moved");
+    BlockMotion motion(BLOCK_CELLS, BLOCK_DELTA);
+    BlockMotion::Result result = motionBetween(motion, before, after);
+    CHECK(result.valid);
+    CHECK_EQ(result.totalBlocks, (80 / BLOCK_CELLS) * (60 / BLOCK_CELLS));
+    CHECK(result.changedBlocks >= MIN_BLOCKS);
+
+    // Block by block: only blocks under either cat outline may change
+    int block = BLOCK_CELLS * 8;
+    int outside = 0;
+    int inside = 0;
+    for (int by = 0; by < 480; by += block) {
+        for (int bx = 0; bx < 640; bx += block) {
+            // The frame-wide shift is ~0 here, so plain differences will do
+            int sad = 0;
+            for (int y = by / 8; y < (by + block) / 8; y++) {
+                for (int x = bx / 8; x < (bx + block) / 8; x++) {
+                    sad += abs(after.at(x, y) - before.at(x, y));
+                }
+            }
+            bool changed = sad / (BLOCK_CELLS * BLOCK_CELLS) > BLOCK_DELTA;
+            bool underCat = boxesOverlap(bx, by, bx + block, by + block, CAT_BEFORE) ||
+                            boxesOverlap(bx, by, bx + block, by + block, CAT_AFTER);
+            outside += changed && !underCat;
+            inside += changed && underCat;
+        }
+    }
+    CHECK_EQ(outside, 0);
+    CHECK_EQ(inside, (int)result.changedBlocks);
+}
+
+void testExposureStepIsNotMotion() {
+    BlockMotion motion(BLOCK_CELLS, BLOCK_DELTA);
+    BlockMotion::Result result = motionBetween(motion, mapOf("scene"), mapOf("scene_brighter"));
+    CHECK(result.valid);
+    CHECK(result.changedBlocks < MIN_BLOCKS);
+
+    result = motionBetween(motion, mapOf("scene"), mapOf("scene_q40"));
+    CHECK_EQ(result.changedBlocks, 0);
+}
+
+void testRoiExcludesMotionOutsideIt() {
+    BlockMotion motion(BLOCK_CELLS, BLOCK_DELTA);
+    MotionRoi top;
+    top.height = 50;   // Cat stays in the bottom half
+    motion.setRoi(top);
+    CHECK_EQ(motion.roiRowLimit(60), 30);
+
+    BlockMotion::Result result = motionBetween(motion, mapOf("scene"), mapOf("scene_moved"));
+    CHECK(result.valid);
+    CHECK_EQ(result.changedBlocks, 0);
+
+    // A map decoded only down to the ROI row limit gives the same answer
+    std::vector<uint8_t> jpeg = loadJpeg("scene_moved");
+    DcLumaMap partial;
+    CHECK(partial.build(jpeg.data(), jpeg.size(), motion.roiRowLimit(60)));
+    CHECK_EQ(motion.compare(partial.data(), partial.width(), partial.height()).changedBlocks, 0);
+}
+
+void testSizeChangeRestarts() {
+    BlockMotion motion(BLOCK_CELLS, BLOCK_DELTA);
+    DcLumaMap scene = mapOf("scene");
+    DcLumaMap odd = mapOf("grey_odd");
+    motion.compare(scene.data(), scene.width(), scene.height());
+    CHECK(!motion.compare(odd.data(), odd.width(), odd.height()).valid);
+    CHECK(motion.compare(odd.data(), odd.width(), odd.height()).valid);
+}
+
+void testMatchesReferenceOnRandomMaps() {
+    std::mt19937 rng(6);
+    for (int round = 0; round < 200; round++) {
+        int width = 8 + rng() % 193;
+        int height = 8 + rng() % 143;
+        std::vector<uint8_t> previous((size_t)width * height);
+        std::vector<uint8_t> current(previous.size());
+        int drift = (int)(rng() % 41) - 20;
+        for (size_t i = 0; i < previous.size(); i++) {
+            previous[i] = (uint8_t)(rng() % 256);
+            int moved = previous[i] + drift + (rng() % 8 == 0 ? (int)(rng() % 121) - 60 : 0);
+            current[i] = (uint8_t)std::min(std::max(moved, 0), 255);
+        }
+        MotionRoi roi;
+        roi.x = (uint8_t)(rng() % 50);
+        roi.y = (uint8_t)(rng() % 50);
+        roi.width = (uint8_t)(20 + rng() % (81 - roi.x > 20 ? 81 - roi.x - 20 : 1));
+        roi.height = (uint8_t)(20 + rng() % (81 - roi.y > 20 ? 81 - roi.y - 20 : 1));
+        int blockCells = 1 + rng() % 6;
+        int blockDelta = 1 + rng() % 30;
+
+        BlockMotion motion((uint8_t)blockCells, (uint8_t)blockDelta);
+        motion.setRoi(roi);
+        motion.compare(previous.data(), (uint16_t)width, (uint16_t)height);
+        BlockMotion::Result got = motion.compare(current.data(), (uint16_t)width, (uint16_t)height);
+        BlockMotion::Result want = referenceCompare(previous.data(), current.data(), width, height,
+                                                    roi, blockCells, blockDelta);
+        CHECK(got.valid);
+        CHECK_EQ(got.totalBlocks, want.totalBlocks);
+        CHECK_EQ(got.changedBlocks, want.changedBlocks);
+        CHECK_EQ(got.maxBlockDelta, want.maxBlockDelta);
+    }
+}
+
+void benchmarks() {
+    DcLumaMap before = mapOf("scene");
+    DcLumaMap after = mapOf("scene_moved");
+    BlockMotion motion(BLOCK_CELLS, BLOCK_DELTA);
+    bool flip = false;
+    benchmark("BlockMotion::compare 80x60", 0, [&] {
+        const DcLumaMap& map = flip ? before : after;
+        flip = !flip;
+        motion.compare(map.data(), map.width(), map.height());
+    });
+
+    // One motion sample as the detector takes it: map down to the ROI, then compare
+    std::vector<uint8_t> jpeg = loadJpeg("scene_moved");
+    MotionRoi top;
+    top.height = 50;
+    motion.setRoi(top);
+    DcLumaMap map;
+    benchmark("DC map (top half) + compare", jpeg.size(), [&] {
+        map.build(jpeg.data(), jpeg.size(), motion.roiRowLimit(60));
+        motion.compare(map.data(), map.width(), map.height());
+    });
+}
+
+}
+
+int main() {
+    testMovedCatIsLocalised();
+    testExposureStepIsNotMotion();
+    testRoiExcludesMotionOutsideIt();
+    testSizeChangeRestarts();
+    testMatchesReferenceOnRandomMaps();
+    benchmarks();
+    return hostTestResult("test_block_motion");
+}
@@ -0,0 +1,150 @@
+// DcLumaMap against libjpeg's decode, and the SceneChangeDetector gate on
+// fixture scenes that change, shift exposure, or stay the same
+
+#include "DcLumaMap.h"
+#include "SceneChangeDetector.h"
+#include <math.h>
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+const char* const FIXTURES[] = {
+    "scene", "scene_moved", "scene_brighter", "scene_blurred", "scene_q40",
+    "scene_restart", "scene_420", "grey_odd", "dark", "blown",
+};
+
+// Same as the change gate's default threshold (PipelineSettings::changeGateThreshold)
+constexpr float GATE_THRESHOLD = 0.02f;
+
+void testMatchesReferenceBlockMeans() {
+    for (const char* name : FIXTURES) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        ReferenceImage reference = loadReference(name, ".dc.pgm");
+        DcLumaMap map;
+        if (!CHECK(map.build(jpeg.data(), jpeg.size()))) {
+            continue;
+        }
+        CHECK_EQ(map.width(), reference.width);
+        CHECK_EQ(map.height(), reference.height);
+
+        // The DC term is the exact block mean; libjpeg's means come from
+        // rounded, clamped pixels, so allow a level or two
+        int maxDiff = 0;
+        long sumDiff = 0;
+        for (int y = 0; y < map.height(); y++) {
+            for (int x = 0; x < map.width(); x++) {
+                int diff = abs((int)map.at(x, y) - reference.at(x, y));
+                maxDiff = diff > maxDiff ? diff : maxDiff;
+                sumDiff += diff;
+            }
+        }
+        double meanDiff = (double)sumDiff / map.cellCount();
+        if (!CHECK(maxDiff <= 2 && meanDiff < 0.5)) {
+            fprintf(stderr, "  %s: max %d, mean %.3f\n", name, maxDiff, meanDiff);
+        }
+    }
+}
+
+void testLayoutsGiveTheSameMap() {
+    // Restart markers and 4:2:0 MCUs change the stream, not the luma blocks
+    std::vector<uint8_t> scene = loadJpeg("scene");
+    DcLumaMap expected;
+    CHECK(expected.build(scene.data(), scene.size()));
+    for (const char* name : { "scene_restart", "scene_420" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        DcLumaMap map;
+        CHECK(map.build(jpeg.data(), jpeg.size()));
+        CHECK(map.cellCount() == expected.cellCount() &&
+              memcmp(map.data(), expected.data(), map.cellCount()) == 0);
+    }
+}
+
+void testRowLimitStopsEarly() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    DcLumaMap full;
+    DcLumaMap top;
+    CHECK(full.build(jpeg.data(), jpeg.size()));
+    CHECK(top.build(jpeg.data(), jpeg.size(), 10));
+    CHECK_EQ(top.height(), full.height());
+    CHECK(memcmp(top.data(), full.data(), (size_t)top.width() * 10) == 0);
+    bool restGrey = true;
+    for (size_t i = (size_t)top.width() * 10; i < top.cellCount(); i++) {
+        restGrey &= top.data()[i] == 128;
+    }
+    CHECK(restGrey);
+}
+
+void testRejectsBrokenJpegs() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    DcLumaMap map;
+
+    CHECK(!map.build(jpeg.data(), 100));                // Cut off in the headers
+    CHECK(map.error() != nullptr);
+    CHECK(!map.build(jpeg.data(), jpeg.size() / 2));    // Cut off in the scan
+
+    std::vector<uint8_t> notJpeg(jpeg.size(), 0x55);
+    CHECK(!map.build(notJpeg.data(), notJpeg.size()));
+}
+
+SceneChangeDetector::Result changeBetween(const char* background, const char* frame) {
+    std::vector<uint8_t> first = loadJpeg(background);
+    std::vector<uint8_t> second = loadJpeg(frame);
+    DcLumaMap map;
+    SceneChangeDetector detector;
+    map.build(first.data(), first.size());
+    CHECK(detector.update(map).backgroundReset);
+    map.build(second.data(), second.size());
+    return detector.update(map);
+}
+
+void testSceneChangeGate() {
+    SceneChangeDetector::Result same = changeBetween("scene", "scene");
+    CHECK(!same.backgroundReset);
+    CHECK_EQ(same.changedCells, 0u);
+
+    // Re-encoding at another quality is not a change
+    SceneChangeDetector::Result requantised = changeBetween("scene", "scene_q40");
+    CHECK(requantised.changeRatio < GATE_THRESHOLD);
+
+    // Exposure step: compensated, reported as a shift
+    SceneChangeDetector::Result brighter = changeBetween("scene", "scene_brighter");
+    CHECK(brighter.changeRatio < GATE_THRESHOLD);
+    CHECK(fabsf(brighter.meanShift - 24.0f) < 4.0f);
+
+    // The cat moved: its old and new outlines (two 120x80 ellipses, ~2 x 120
+    // of the 4800 cells) change
+    SceneChangeDetector::Result moved = changeBetween("scene", "scene_moved");
+    CHECK(moved.changeRatio >= GATE_THRESHOLD);
+    CHECK(moved.changedCells > 150 && moved.changedCells < 400);
+
+    // A different resolution starts a new background
+    SceneChangeDetector::Result resized = changeBetween("scene", "grey_odd");
+    CHECK(resized.backgroundReset);
+}
+
+void benchmarks() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    DcLumaMap map;
+    benchmark("DcLumaMap::build 640x480", jpeg.size(), [&] { map.build(jpeg.data(), jpeg.size()); });
+    benchmark("DcLumaMap::build top 10 rows", jpeg.size(), [&] { map.build(jpeg.data(), jpeg.size(), 10); });
+
+    map.build(jpeg.data(), jpeg.size());
+    SceneChangeDetector detector;
+    detector.update(map);
+    benchmark("SceneChangeDetector::update 80x60", 0, [&] { detector.update(map); });
+}
+
+}
+
+int main() {
+    testMatchesReferenceBlockMeans();
+    testLayoutsGiveTheSameMap();
+    testRowLimitStopsEarly();
+    testRejectsBrokenJpegs();
+    testSceneChangeGate();
+    benchmarks();
+    return hostTestResult("test_dc_luma_map");
+}
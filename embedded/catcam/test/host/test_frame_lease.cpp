@@ -0,0 +1,130 @@
+// Camera capture on the host against the fake esp_camera driver: leased
+// frames must cost no heap allocations, in either lease mode
+
+#include "Camera.h"
+#include "SlabAllocator.h"
+#include <mbedtls/md.h>
+#include <vector>
+
+#include "FakeCamera.h"
+#include "support/AllocationCounter.h"
+#include "support/HostTest.h"
+
+namespace {
+
+constexpr int FRAMES = 1000;
+constexpr size_t FRAME_BYTES = 60 * 1024;
+
+std::vector<uint8_t> makeFrame() {
+    std::vector<uint8_t> jpeg(FRAME_BYTES);
+    for (size_t i = 0; i < jpeg.size(); i++) {
+        jpeg[i] = (uint8_t)(i * 31 + 7);
+    }
+    jpeg[0] = 0xFF;
+    jpeg[1] = 0xD8;
+    jpeg[jpeg.size() - 2] = 0xFF;
+    jpeg[jpeg.size() - 1] = 0xD9;
+    return jpeg;
+}
+
+CameraSettings settingsWithBuffers(int fbCount) {
+    CameraSettings settings;
+    settings.fbCount = fbCount;
+    return settings;
+}
+
+void testZeroCopyLeaseAllocatesNothing(const std::vector<uint8_t>& jpeg) {
+    Camera camera;
+    camera.init(settingsWithBuffers(2));
+    CHECK(camera.isReady());
+    CHECK(!camera.isCopyMode());
+
+    size_t before = hostAllocationCount();
+    for (int i = 0; i < FRAMES; i++) {
+        FrameLease frame = camera.captureFrame();
+        CHECK(frame.isValid());
+        CHECK(!frame.isCopy());
+        CHECK(frame.data() == FakeCamera::lastBuffer());
+        CHECK_EQ(frame.size(), jpeg.size());
+        CHECK_EQ(FakeCamera::buffersOut(), 1u);
+    }
+    CHECK_EQ(hostAllocationCount() - before, 0u);
+    CHECK_EQ(FakeCamera::buffersOut(), 0u);
+    camera.deInit();
+}
+
+void testLeaseReturnsBufferExactlyOnce() {
+    Camera camera;
+    camera.init(settingsWithBuffers(2));
+
+    FrameLease first = camera.captureFrame();
+    FrameLease second = camera.captureFrame();
+    CHECK(first && second);
+    CHECK(first.data() != second.data());
+    CHECK_EQ(FakeCamera::buffersOut(), 2u);
+
+    // Both driver buffers leased: nothing left to capture into
+    CHECK(!camera.captureFrame());
+
+    FrameLease moved = std::move(first);
+    CHECK(!first);
+    CHECK_EQ(FakeCamera::buffersOut(), 2u);
+
+    moved = std::move(second);   // Drops the first frame
+    CHECK_EQ(FakeCamera::buffersOut(), 1u);
+    moved.reset();
+    CHECK_EQ(FakeCamera::buffersOut(), 0u);
+    camera.deInit();
+}
+
+void testCopyModeDrawsFromSlab(const std::vector<uint8_t>& jpeg) {
+    static const SlabAllocator::SizeClass CLASSES[] = { { 96 * 1024, 2 } };
+    SlabAllocator& slab = SlabAllocator::getInstance();
+    CHECK(slab.init(CLASSES, 1, malloc, free));
+
+    Camera camera;
+    camera.init(settingsWithBuffers(1));
+    CHECK(camera.isCopyMode());
+
+    uint8_t expected[FrameLease::SHA256_SIZE];
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), jpeg.data(), jpeg.size(), expected);
+
+    size_t before = hostAllocationCount();
+    for (int i = 0; i < FRAMES; i++) {
+        bool hash = (i % 2) == 0;
+        FrameLease frame = camera.captureFrameAfter(esp_timer_get_time(), 1000, hash);
+        CHECK(frame.isCopy());
+        CHECK(slab.owns(frame.data()));
+        CHECK_EQ(FakeCamera::buffersOut(), 0u);   // Driver buffer handed straight back
+        CHECK(memcmp(frame.data(), jpeg.data(), jpeg.size()) == 0);
+        if (hash) {
+            CHECK(frame.sha256() && memcmp(frame.sha256(), expected, sizeof(expected)) == 0);
+        } else {
+            CHECK(frame.sha256() == nullptr);
+        }
+    }
+    CHECK_EQ(hostAllocationCount() - before, 0u);
+    CHECK_EQ(slab.classStats(0).inUse, 0u);
+
+    // Without the slab every copy is a heap allocation
+    slab.deinit();
+    before = hostAllocationCount();
+    {
+        FrameLease frame = camera.captureFrame();
+        CHECK(frame.isCopy());
+    }
+    CHECK_EQ(hostAllocationCount() - before, 1u);
+    camera.deInit();
+}
+
+}
+
+int main() {
+    std::vector<uint8_t> jpeg = makeFrame();
+    FakeCamera::setFrame(jpeg.data(), jpeg.size(), 0, 0);
+
+    testZeroCopyLeaseAllocatesNothing(jpeg);
+    testLeaseReturnsBufferExactlyOnce();
+    testCopyModeDrawsFromSlab(jpeg);
+    return hostTestResult("test_frame_lease");
+}
@@ -0,0 +1,105 @@
+// FrameQualityGate verdicts on fixture frames and on damaged copies of them
+
+#include "FrameQualityGate.h"
+#include <math.h>
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+FrameQualityGate::Result checkFrame(const std::vector<uint8_t>& jpeg) {
+    FrameQualityGate gate;
+    DcLumaMap map;
+    return gate.check(jpeg.data(), jpeg.size(), map);
+}
+
+FrameVerdict verdictOf(const char* name) {
+    return checkFrame(loadJpeg(name)).verdict;
+}
+
+void testExposureVerdicts() {
+    CHECK(verdictOf("scene") == FrameVerdict::Ok);
+    CHECK(verdictOf("scene_brighter") == FrameVerdict::Ok);
+    CHECK(verdictOf("scene_blurred") == FrameVerdict::Ok);
+    CHECK(verdictOf("grey_odd") == FrameVerdict::Ok);
+    CHECK(verdictOf("dark") == FrameVerdict::Dark);
+    CHECK(verdictOf("blown") == FrameVerdict::BlownOut);
+}
+
+void testStatisticsMatchReference() {
+    FrameQualityGate gate;
+    for (const char* name : { "scene", "dark", "blown" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        ReferenceImage reference = loadReference(name, ".dc.pgm");
+        DcLumaMap map;
+        FrameQualityGate::Result result = gate.check(jpeg.data(), jpeg.size(), map);
+
+        size_t cells = reference.pixels.size();
+        double sum = 0;
+        size_t dark = 0;
+        size_t bright = 0;
+        for (uint8_t luma : reference.pixels) {
+            sum += luma;
+            dark += luma < 20;      // FrameQualityGate defaults
+            bright += luma >= 248;
+        }
+        CHECK(fabs(result.meanLuma - sum / cells) < 0.5);
+        CHECK(fabs(result.darkFraction - (double)dark / cells) < 0.01);
+        CHECK(fabs(result.brightFraction - (double)bright / cells) < 0.01);
+
+        uint32_t histogramTotal = 0;
+        for (uint32_t count : result.histogram) {
+            histogramTotal += count;
+        }
+        CHECK_EQ(histogramTotal, map.cellCount());
+    }
+}
+
+void testDamagedFrames() {
+    const std::vector<uint8_t> jpeg = loadJpeg("scene");
+
+    // Transfer cut short: no EOI
+    std::vector<uint8_t> cut(jpeg.begin(), jpeg.begin() + jpeg.size() / 2);
+    CHECK(checkFrame(cut).verdict == FrameVerdict::Truncated);
+
+    // No SOI
+    std::vector<uint8_t> headless(jpeg.begin() + 2, jpeg.end());
+    CHECK(checkFrame(headless).verdict == FrameVerdict::Truncated);
+
+    // Framing intact but the headers are gone
+    std::vector<uint8_t> hollow = { 0xFF, 0xD8, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xD9 };
+    CHECK(checkFrame(hollow).verdict == FrameVerdict::Corrupt);
+
+    // A stray marker in the middle of the scan
+    std::vector<uint8_t> marker = jpeg;
+    size_t middle = marker.size() / 2;
+    marker[middle] = 0xFF;
+    marker[middle + 1] = 0xC4;
+    CHECK(checkFrame(marker).verdict == FrameVerdict::Corrupt);
+
+    // Zero padding after EOI from DMA-sized buffers is fine up to a point
+    std::vector<uint8_t> padded = jpeg;
+    padded.resize(jpeg.size() + 32, 0);
+    CHECK(checkFrame(padded).verdict == FrameVerdict::Ok);
+    padded.resize(jpeg.size() + 256, 0);
+    CHECK(checkFrame(padded).verdict == FrameVerdict::Truncated);
+}
+
+void benchmarks() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    FrameQualityGate gate;
+    DcLumaMap map;
+    benchmark("FrameQualityGate::check 640x480", jpeg.size(), [&] { gate.check(jpeg.data(), jpeg.size(), map); });
+}
+
+}
+
+int main() {
+    testExposureVerdicts();
+    testStatisticsMatchReference();
+    testDamagedFrames();
+    benchmarks();
+    return hostTestResult("test_frame_quality_gate");
+}
@@ -0,0 +1,567 @@
+// Int8Kernels fast paths against int8ref on random shapes, hand-worked
+// cases for the rounding rules, and a LocalModel blob run end to end
+
+#include "Int8Kernels.h"
+#include "LocalModel.h"
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "support/Benchmark.h"
+#include "support/HostTest.h"
+
+namespace {
+
+std::mt19937 rng(20251016);
+
+int randomInt(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+std::vector<int8_t> randomInt8(size_t count) {
+    std::vector<int8_t> values(count);
+    for (int8_t& v : values) {
+        v = (int8_t)randomInt(-128, 127);
+    }
+    return values;
+}
+
+/**
+ * Per-channel requantisation parameters with the storage to back them
+ */
+struct Requant {
+    std::vector<int32_t> bias;
+    std::vector<int32_t> multiplier;
+    std::vector<int8_t> shift;
+    Int8Requant params;
+
+    Requant(size_t channels, int accumulatorBits) : bias(channels), multiplier(channels), shift(channels) {
+        for (size_t c = 0; c < channels; c++) {
+            bias[c] = randomInt(-5000, 5000);
+            multiplier[c] = randomInt(1 << 30, INT32_MAX);
+            // Bring accumulators of about 2^accumulatorBits down to int8, give or take
+            shift[c] = (int8_t)(7 - accumulatorBits + randomInt(-1, 1));
+        }
+        params.bias = bias.data();
+        params.multiplier = multiplier.data();
+        params.shift = shift.data();
+        params.outputZeroPoint = randomInt(-20, 20);
+        if (randomInt(0, 1)) {
+            params.activationMin = params.outputZeroPoint;  // Fused ReLU
+        }
+    }
+};
+
+int accumulatorBits(size_t taps) {
+    int bits = 14;  // One int8 x int8 product
+    while (taps > 1) {
+        taps >>= 2;
+        bits++;  // Random signs: the sum grows with sqrt(taps)
+    }
+    return bits;
+}
+
+uint16_t outputSize(int in, int kernel, int stride, int pad) {
+    return (uint16_t)((in + 2 * pad - kernel) / stride + 1);
+}
+
+void testMultiplyByQuantizedMultiplier() {
+    const int32_t HALF = 1 << 30;  // 0.5 in Q31
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(100, HALF, 0), 50);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(100, HALF, 1), 100);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(100, HALF, -2), 13);    // 12.5 away from zero
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(-100, HALF, -2), -13);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(3, HALF, -1), 1);       // 0.75
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(-3, HALF, -1), -1);
+    // The doubling high multiply rounds its own halves up (gemmlowp): 2.5 -> 3, -2.5 -> -2
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(5, HALF, 0), 3);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(-5, HALF, 0), -2);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(INT32_MIN, INT32_MIN, 0), INT32_MAX);
+    CHECK_EQ(int8MultiplyByQuantizedMultiplier(1000000, 1518500250, -10), 691);  // 690.5: x * 0.7071 / 1024
+}
+
+void testHandWorkedLayers() {
+    // 3x3 single-channel input, zero point -1 (so padding is -1), all-ones
+    // 3x3 kernel, multiplier 1.0: each output is the sum of its window
+    const int8_t input[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    const int8_t ones[9] = { 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    const int32_t bias[1] = { 0 };
+    const int32_t multiplier[1] = { 1 << 30 };
+    const int8_t shift[1] = { 1 };
+    Int8Requant unit;
+    unit.bias = bias;
+    unit.multiplier = multiplier;
+    unit.shift = shift;
+
+    Int8Shape shape;
+    shape.height = 3;
+    shape.width = 3;
+    shape.channels = 1;
+    Int8Window window;
+    window.kernelH = 3;
+    window.kernelW = 3;
+    window.padTop = 1;
+    window.padLeft = 1;
+
+    const int8_t expected[9] = {
+        1 + 2 + 4 + 5 - 5, 1 + 2 + 3 + 4 + 5 + 6 - 3, 2 + 3 + 5 + 6 - 5,
+        1 + 2 + 4 + 5 + 7 + 8 - 3, 45, 2 + 3 + 5 + 6 + 8 + 9 - 3,
+        4 + 5 + 7 + 8 - 5, 4 + 5 + 6 + 7 + 8 + 9 - 3, 5 + 6 + 8 + 9 - 5,
+    };
+    int8_t output[9];
+    int8Conv2d(input, shape, ones, window, -1, unit, output, shape);
+    CHECK(memcmp(output, expected, 9) == 0);
+    int8DepthwiseConv2d(input, shape, ones, window, -1, unit, output, shape);
+    CHECK(memcmp(output, expected, 9) == 0);
+
+    // Fused ReLU6-style clamp
+    Int8Requant clamped = unit;
+    clamped.activationMin = 0;
+    clamped.activationMax = 20;
+    int8Conv2d(input, shape, ones, window, -1, clamped, output, shape);
+    CHECK_EQ(output[0], 7);
+    CHECK_EQ(output[4], 20);
+
+    // 2x2 pools, stride 2, one cell of padding on the top/left
+    Int8Window pool;
+    pool.kernelH = 2;
+    pool.kernelW = 2;
+    pool.strideH = 2;
+    pool.strideW = 2;
+    pool.padTop = 1;
+    pool.padLeft = 1;
+    Int8Shape pooled;
+    pooled.height = 2;
+    pooled.width = 2;
+    pooled.channels = 1;
+    const int8_t signedInput[9] = { -3, 2, -1, 4, -5, 6, -7, 8, -9 };
+    int8AveragePool(signedInput, shape, pool, output, pooled);
+    CHECK_EQ(output[0], -3);        // Just the corner
+    CHECK_EQ(output[1], 1);         // (2 - 1) / 2 = 0.5, away from zero
+    CHECK_EQ(output[2], -2);        // (4 - 7) / 2 = -1.5, away from zero
+    CHECK_EQ(output[3], 0);         // (-5 + 6 + 8 - 9) / 4
+    int8MaxPool(signedInput, shape, pool, output, pooled);
+    CHECK_EQ(output[0], -3);        // Padding never wins, even over a negative value
+    CHECK_EQ(output[1], 2);
+    CHECK_EQ(output[2], 4);
+    CHECK_EQ(output[3], 8);
+
+    // Two channels interleaved: means of 1..9 and of -1..-9 with a remainder
+    int8_t twoChannels[18];
+    for (int i = 0; i < 9; i++) {
+        twoChannels[i * 2] = (int8_t)(i + 1);
+        twoChannels[i * 2 + 1] = (int8_t)(i == 0 ? 1 : -(i + 1));
+    }
+    shape.channels = 2;
+    int8GlobalAveragePool(twoChannels, shape, output);
+    CHECK_EQ(output[0], 5);
+    CHECK_EQ(output[1], -5);        // -43 / 9 = -4.8
+
+    // Fully connected: [1, -2, 3] . [[1, 1, 1], [2, 0, -1]] = [2, -1], bias [10, 0]
+    const int8_t vector[3] = { 1, -2, 3 };
+    const int8_t matrix[6] = { 1, 1, 1, 2, 0, -1 };
+    const int32_t fcBias[2] = { 10, 0 };
+    const int32_t fcMultiplier[2] = { 1 << 30, 1 << 30 };
+    const int8_t fcShift[2] = { 1, 1 };
+    Int8Requant fc;
+    fc.bias = fcBias;
+    fc.multiplier = fcMultiplier;
+    fc.shift = fcShift;
+    fc.outputZeroPoint = 5;
+    int8FullyConnected(vector, 3, matrix, fc, output, 2);
+    CHECK_EQ(output[0], 17);
+    CHECK_EQ(output[1], 4);
+}
+
+void testConvMatchesReference() {
+    for (int trial = 0; trial < 200; trial++) {
+        bool pointwise = trial % 2 == 0;
+        Int8Shape in;
+        in.height = (uint16_t)randomInt(1, 12);
+        in.width = (uint16_t)randomInt(1, 12);
+        in.channels = (uint16_t)randomInt(1, 40);
+        Int8Window window;
+        if (!pointwise) {
+            window.kernelH = (uint8_t)randomInt(1, 3);
+            window.kernelW = (uint8_t)randomInt(1, 3);
+            window.strideH = (uint8_t)randomInt(1, 2);
+            window.strideW = (uint8_t)randomInt(1, 2);
+            window.padTop = (uint8_t)randomInt(0, window.kernelH / 2);
+            window.padLeft = (uint8_t)randomInt(0, window.kernelW / 2);
+        }
+        Int8Shape out;
+        out.height = outputSize(in.height, window.kernelH, window.strideH, window.padTop);
+        out.width = outputSize(in.width, window.kernelW, window.strideW, window.padLeft);
+        out.channels = (uint16_t)randomInt(1, 40);
+        if (out.height == 0 || out.width == 0) {
+            continue;
+        }
+
+        std::vector<int8_t> input = randomInt8(in.size());
+        std::vector<int8_t> weights = randomInt8((size_t)out.channels * window.kernelH * window.kernelW * in.channels);
+        Requant requant(out.channels, accumulatorBits((size_t)window.kernelH * window.kernelW * in.channels));
+        int8_t padValue = (int8_t)randomInt(-128, 127);
+
+        std::vector<int8_t> expected(out.size());
+        std::vector<int8_t> actual(out.size());
+        int8ref::conv2d(input.data(), in, weights.data(), window, padValue, requant.params, expected.data(), out);
+        int8Conv2d(input.data(), in, weights.data(), window, padValue, requant.params, actual.data(), out);
+        if (!CHECK(actual == expected)) {
+            fprintf(stderr, "  conv %dx%dx%d k%dx%d s%d -> %d channels\n", in.height, in.width, in.channels,
+                    window.kernelH, window.kernelW, window.strideH, out.channels);
+        }
+    }
+}
+
+void testDepthwiseMatchesReference() {
+    for (int trial = 0; trial < 200; trial++) {
+        Int8Shape in;
+        in.height = (uint16_t)randomInt(1, 16);
+        in.width = (uint16_t)randomInt(1, 16);
+        in.channels = (uint16_t)randomInt(1, 80);  // Across DEPTHWISE_CHANNEL_BLOCK boundaries
+        Int8Window window;
+        window.kernelH = 3;
+        window.kernelW = 3;
+        window.strideH = (uint8_t)randomInt(1, 2);
+        window.strideW = window.strideH;
+        window.padTop = (uint8_t)randomInt(0, 1);
+        window.padLeft = window.padTop;
+        Int8Shape out;
+        out.height = outputSize(in.height, 3, window.strideH, window.padTop);
+        out.width = outputSize(in.width, 3, window.strideW, window.padLeft);
+        out.channels = in.channels;
+        if (in.height + 2 * window.padTop < 3 || in.width + 2 * window.padLeft < 3) {
+            continue;
+        }
+
+        std::vector<int8_t> input = randomInt8(in.size());
+        std::vector<int8_t> weights = randomInt8((size_t)9 * in.channels);
+        Requant requant(in.channels, accumulatorBits(9));
+        int8_t padValue = (int8_t)randomInt(-128, 127);
+
+        std::vector<int8_t> expected(out.size());
+        std::vector<int8_t> actual(out.size());
+        int8ref::depthwiseConv2d(input.data(), in, weights.data(), window, padValue, requant.params,
+                                 expected.data(), out);
+        int8DepthwiseConv2d(input.data(), in, weights.data(), window, padValue, requant.params, actual.data(), out);
+        if (!CHECK(actual == expected)) {
+            fprintf(stderr, "  depthwise %dx%dx%d s%d p%d\n", in.height, in.width, in.channels,
+                    window.strideH, window.padTop);
+        }
+    }
+}
+
+void testFullyConnectedMatchesReference() {
+    for (int trial = 0; trial < 100; trial++) {
+        size_t inputs = (size_t)randomInt(1, 300);
+        size_t outputs = (size_t)randomInt(1, 20);
+        std::vector<int8_t> input = randomInt8(inputs);
+        std::vector<int8_t> weights = randomInt8(inputs * outputs);
+        Requant requant(outputs, accumulatorBits(inputs));
+        std::vector<int8_t> expected(outputs);
+        std::vector<int8_t> actual(outputs);
+        int8ref::fullyConnected(input.data(), inputs, weights.data(), requant.params, expected.data(), outputs);
+        int8FullyConnected(input.data(), inputs, weights.data(), requant.params, actual.data(), outputs);
+        CHECK(actual == expected);
+    }
+}
+
+/**
+ * Writes a BBM1 blob the way local-training/export_for_device.py does
+ */
+class ModelWriter {
+public:
+    struct Layer {
+        LocalModel::LayerType type;
+        Int8Window window;
+        int8_t padValue = 0;
+        Int8Shape out;
+        std::vector<int8_t> weights;
+        Requant* requant = nullptr;
+    };
+
+    std::vector<uint8_t> write(const Int8Shape& input, const std::vector<Layer>& layers,
+                               const std::vector<const char*>& classNames,
+                               const std::vector<int8_t>& selfTestInput, const std::vector<int8_t>& selfTestOutput) {
+        _body.assign(36, 0);
+        for (const char* name : classNames) {
+            char padded[LocalModel::CLASS_NAME_LENGTH] = {};
+            strncpy(padded, name, sizeof(padded) - 1);
+            append(padded, sizeof(padded));
+        }
+        align();
+        size_t records = _body.size();
+        _body.resize(records + 32 * layers.size(), 0);
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const Layer& layer = layers[i];
+            uint32_t weightsOffset = 0;
+            uint32_t paramsOffset = 0;
+            if (!layer.weights.empty()) {
+                align();
+                weightsOffset = (uint32_t)_body.size();
+                append(layer.weights.data(), layer.weights.size());
+                align();
+                paramsOffset = (uint32_t)_body.size();
+                const Requant& r = *layer.requant;
+                append(r.bias.data(), r.bias.size() * 4);
+                append(r.multiplier.data(), r.multiplier.size() * 4);
+                append(r.shift.data(), r.shift.size());
+            }
+            uint8_t* record = _body.data() + records + i * 32;
+            record[0] = (uint8_t)layer.type;
+            record[1] = layer.window.kernelH;
+            record[2] = layer.window.kernelW;
+            record[3] = layer.window.strideH;
+            record[4] = layer.window.strideW;
+            record[5] = layer.window.padTop;
+            record[6] = layer.window.padLeft;
+            record[8] = (uint8_t)layer.padValue;
+            if (layer.requant) {
+                record[9] = (uint8_t)layer.requant->params.outputZeroPoint;
+                record[10] = (uint8_t)layer.requant->params.activationMin;
+                record[11] = (uint8_t)layer.requant->params.activationMax;
+            } else {
+                record[10] = (uint8_t)-128;
+                record[11] = 127;
+            }
+            put16(record + 12, layer.out.height);
+            put16(record + 14, layer.out.width);
+            put16(record + 16, layer.out.channels);
+            put32(record + 20, weightsOffset);
+            put32(record + 24, paramsOffset);
+        }
+
+        align();
+        uint32_t selfTestOffset = (uint32_t)_body.size();
+        append(selfTestInput.data(), selfTestInput.size());
+        append(selfTestOutput.data(), selfTestOutput.size());
+        align();
+
+        float outputScale = 0.05f;
+        uint8_t* header = _body.data();
+        memcpy(header, "BBM1", 4);
+        put16(header + 4, 1);
+        put16(header + 6, (uint16_t)layers.size());
+        put16(header + 8, input.height);
+        put16(header + 10, input.width);
+        put16(header + 12, input.channels);
+        put16(header + 14, (uint16_t)classNames.size());
+        put16(header + 16, (uint16_t)-128);
+        memcpy(header + 20, &outputScale, 4);
+        put32(header + 24, (uint32_t)-10);
+        put32(header + 28, selfTestOffset);
+        put32(header + 32, (uint32_t)_body.size());
+        return _body;
+    }
+
+private:
+    std::vector<uint8_t> _body;
+
+    void append(const void* data, size_t bytes) {
+        const uint8_t* p = (const uint8_t*)data;
+        _body.insert(_body.end(), p, p + bytes);
+    }
+    void align() { _body.resize((_body.size() + 3) & ~(size_t)3, 0); }
+    static void put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+    static void put32(uint8_t* p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+};
+
+Int8Shape makeShape(uint16_t height, uint16_t width, uint16_t channels) {
+    Int8Shape shape;
+    shape.height = height;
+    shape.width = width;
+    shape.channels = channels;
+    return shape;
+}
+
+Int8Window makeWindow(uint8_t kernel, uint8_t stride, uint8_t pad) {
+    Int8Window window;
+    window.kernelH = window.kernelW = kernel;
+    window.strideH = window.strideW = stride;
+    window.padTop = window.padLeft = pad;
+    return window;
+}
+
+/**
+ * A small MobileNet-shaped chain: every layer type, both fast paths
+ */
+struct TinyNet {
+    Int8Shape input = makeShape(16, 16, 3);
+    Requant stem{ 8, accumulatorBits(27) };
+    Requant depthwise{ 8, accumulatorBits(9) };
+    Requant pointwise{ 16, accumulatorBits(8) };
+    Requant dense{ 3, accumulatorBits(16) };
+    std::vector<ModelWriter::Layer> layers;
+    uint32_t macs = 0;
+
+    TinyNet() {
+        ModelWriter::Layer conv{ LocalModel::LayerType::Conv2d, makeWindow(3, 2, 1), -128, makeShape(8, 8, 8),
+                                 randomInt8(8 * 27), &stem };
+        ModelWriter::Layer dw{ LocalModel::LayerType::DepthwiseConv2d, makeWindow(3, 1, 1),
+                               (int8_t)stem.params.outputZeroPoint, makeShape(8, 8, 8), randomInt8(9 * 8), &depthwise };
+        ModelWriter::Layer pw{ LocalModel::LayerType::Conv2d, makeWindow(1, 1, 0), 0, makeShape(8, 8, 16),
+                               randomInt8(16 * 8), &pointwise };
+        ModelWriter::Layer maxPool{ LocalModel::LayerType::MaxPool, makeWindow(2, 2, 0), 0, makeShape(4, 4, 16), {},
+                                    nullptr };
+        ModelWriter::Layer avgPool{ LocalModel::LayerType::AveragePool, makeWindow(2, 2, 0), 0, makeShape(2, 2, 16),
+                                    {}, nullptr };
+        ModelWriter::Layer global{ LocalModel::LayerType::GlobalAveragePool, Int8Window(), 0, makeShape(1, 1, 16),
+                                   {}, nullptr };
+        ModelWriter::Layer fc{ LocalModel::LayerType::FullyConnected, Int8Window(), 0, makeShape(1, 1, 3),
+                               randomInt8(3 * 16), &dense };
+        layers = { conv, dw, pw, maxPool, avgPool, global, fc };
+        macs = 8 * 8 * 8 * 27 + 8 * 8 * 8 * 9 + 8 * 8 * 16 * 8 + 3 * 16;
+    }
+
+    /**
+     * Chain the reference kernels by hand
+     */
+    std::vector<int8_t> forward(const std::vector<int8_t>& x) const {
+        std::vector<int8_t> a = x;
+        Int8Shape shape = input;
+        for (const ModelWriter::Layer& layer : layers) {
+            std::vector<int8_t> b(layer.out.size());
+            switch (layer.type) {
+                case LocalModel::LayerType::Conv2d:
+                    int8ref::conv2d(a.data(), shape, layer.weights.data(), layer.window, layer.padValue,
+                                    layer.requant->params, b.data(), layer.out);
+                    break;
+                case LocalModel::LayerType::DepthwiseConv2d:
+                    int8ref::depthwiseConv2d(a.data(), shape, layer.weights.data(), layer.window, layer.padValue,
+                                             layer.requant->params, b.data(), layer.out);
+                    break;
+                case LocalModel::LayerType::MaxPool:
+                    int8MaxPool(a.data(), shape, layer.window, b.data(), layer.out);
+                    break;
+                case LocalModel::LayerType::AveragePool:
+                    int8AveragePool(a.data(), shape, layer.window, b.data(), layer.out);
+                    break;
+                case LocalModel::LayerType::GlobalAveragePool:
+                    int8GlobalAveragePool(a.data(), shape, b.data());
+                    break;
+                default:
+                    int8ref::fullyConnected(a.data(), shape.size(), layer.weights.data(), layer.requant->params,
+                                            b.data(), layer.out.channels);
+                    break;
+            }
+            a.swap(b);
+            shape = layer.out;
+        }
+        return a;
+    }
+};
+
+/**
+ * Blob copy in 4-byte aligned storage, as LocalModel::load() requires
+ */
+struct AlignedBlob {
+    std::vector<uint32_t> words;
+
+    explicit AlignedBlob(const std::vector<uint8_t>& bytes) : words((bytes.size() + 3) / 4) {
+        memcpy(words.data(), bytes.data(), bytes.size());
+        size = bytes.size();
+    }
+    uint8_t* data() { return (uint8_t*)words.data(); }
+    size_t size;
+};
+
+void testLocalModel() {
+    TinyNet net;
+    std::vector<int8_t> selfTestInput = randomInt8(net.input.size());
+    std::vector<int8_t> expected = net.forward(selfTestInput);
+    ModelWriter writer;
+    std::vector<uint8_t> bytes = writer.write(net.input, net.layers, { "cat", "boots", "nothing-to-see-here" },
+                                              selfTestInput, expected);
+
+    AlignedBlob blob(bytes);
+    LocalModel model;
+    if (!CHECK(model.load(blob.data(), blob.size))) {
+        fprintf(stderr, "  %s\n", model.error());
+        return;
+    }
+    CHECK_EQ(model.layerCount(), 7);
+    CHECK_EQ(model.classCount(), 3);
+    CHECK(strcmp(model.className(2), "nothing-to-see-") == 0);  // 15 characters and the NUL
+    CHECK_EQ(model.inputOffset(), -128);
+    CHECK_EQ(model.macs(), net.macs);
+    CHECK_EQ(model.arenaBytes(), (size_t)2 * 8 * 8 * 16);
+    CHECK(model.invoke() == nullptr);  // No arena yet
+
+    std::vector<uint32_t> arena((model.arenaBytes() + 3) / 4);
+    model.setArena((int8_t*)arena.data());
+    CHECK(model.hasSelfTest() && model.selfTest());
+
+    for (int trial = 0; trial < 20; trial++) {
+        std::vector<int8_t> x = randomInt8(net.input.size());
+        memcpy(model.input(), x.data(), x.size());
+        const int8_t* output = model.invoke();
+        CHECK(output && memcmp(output, net.forward(x).data(), 3) == 0);
+    }
+
+    // A wrong recorded output fails the self-test
+    AlignedBlob tampered(bytes);
+    tampered.data()[tampered.size - 4] ^= 1;
+    LocalModel other;
+    CHECK(other.load(tampered.data(), tampered.size));
+    other.setArena((int8_t*)arena.data());
+    CHECK(!other.selfTest());
+
+    // Load failures
+    AlignedBlob broken(bytes);
+    CHECK(!other.load(broken.data(), broken.size - 4));
+    CHECK(!other.load(broken.data() + 4, broken.size - 4));
+    broken.data()[0] = 'X';
+    CHECK(!other.load(broken.data(), broken.size));
+    AlignedBlob badShape(bytes);
+    size_t records = (36 + 3 * LocalModel::CLASS_NAME_LENGTH + 3) & ~(size_t)3;
+    badShape.data()[records + 6 * 32 + 16] = 4;  // Dense layer writing 4 outputs for 3 classes
+    CHECK(!other.load(badShape.data(), badShape.size));
+    CHECK(other.error() != nullptr);
+}
+
+void benchmarks() {
+    // A mid-network MobileNet block at 96x96 input
+    Int8Shape shape = makeShape(24, 24, 64);
+    std::vector<int8_t> input = randomInt8(shape.size());
+    std::vector<int8_t> output(shape.size());
+
+    std::vector<int8_t> pointwiseWeights = randomInt8(64 * 64);
+    Requant pointwise(64, accumulatorBits(64));
+    Int8Window one = makeWindow(1, 1, 0);
+    double pointwiseMacs = (double)shape.size() * 64;
+    double us = benchmark("pointwise 24x24x64 -> 64", 0, [&] {
+        int8Conv2d(input.data(), shape, pointwiseWeights.data(), one, 0, pointwise.params, output.data(), shape);
+    });
+    double refUs = benchmark("pointwise 24x24x64 -> 64 (int8ref)", 0, [&] {
+        int8ref::conv2d(input.data(), shape, pointwiseWeights.data(), one, 0, pointwise.params, output.data(), shape);
+    });
+    printf("    %.0f vs %.0f MMAC/s\n", pointwiseMacs / us, pointwiseMacs / refUs);
+
+    std::vector<int8_t> depthwiseWeights = randomInt8(9 * 64);
+    Requant depthwise(64, accumulatorBits(9));
+    Int8Window three = makeWindow(3, 1, 1);
+    double depthwiseMacs = (double)shape.size() * 9;
+    us = benchmark("depthwise 3x3 24x24x64", 0, [&] {
+        int8DepthwiseConv2d(input.data(), shape, depthwiseWeights.data(), three, 0, depthwise.params,
+                            output.data(), shape);
+    });
+    refUs = benchmark("depthwise 3x3 24x24x64 (int8ref)", 0, [&] {
+        int8ref::depthwiseConv2d(input.data(), shape, depthwiseWeights.data(), three, 0, depthwise.params,
+                                 output.data(), shape);
+    });
+    printf("    %.0f vs %.0f MMAC/s\n", depthwiseMacs / us, depthwiseMacs / refUs);
+}
+
+}
+
+int main() {
+    testMultiplyByQuantizedMultiplier();
+    testHandWorkedLayers();
+    testConvMatchesReference();
+    testDepthwiseMatchesReference();
+    testFullyConnectedMatchesReference();
+    testLocalModel();
+    benchmarks();
+    return hostTestResult("test_int8_kernels");
+}
@@ -0,0 +1,83 @@
+// JpegSharpness against the metric computed from libjpeg's coefficients,
+// and the burst use: picking the sharp frame out of blurred ones
+
+#include "JpegSharpness.h"
+#include <math.h>
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+const char* const FIXTURES[] = {
+    "scene", "scene_moved", "scene_brighter", "scene_blurred", "scene_q40",
+    "scene_restart", "scene_420", "grey_odd", "dark", "blown",
+};
+
+float scoreOf(const char* name) {
+    std::vector<uint8_t> jpeg = loadJpeg(name);
+    JpegSharpness sharpness;
+    float score = -1.0f;
+    CHECK(sharpness.score(jpeg.data(), jpeg.size(), score));
+    return score;
+}
+
+void testMatchesReference() {
+    for (const char* name : FIXTURES) {
+        double expected = referenceValue("sharpness.txt", name);
+        float score = scoreOf(name);
+        if (!CHECK(fabs(score - expected) <= 1e-3 * expected + 1e-3)) {
+            fprintf(stderr, "  %s: %.4f, reference %.4f\n", name, score, expected);
+        }
+    }
+}
+
+void testRanksBurstFrames() {
+    float sharp = scoreOf("scene");
+    float blurred = scoreOf("scene_blurred");
+    CHECK(blurred < sharp * 0.5f);
+
+    // Dequantised, so a coarser JPEG of the same frame scores about the same
+    float coarse = scoreOf("scene_q40");
+    CHECK(fabsf(coarse - sharp) < sharp * 0.15f);
+
+    // How a burst keeps its best frame
+    const char* const burst[] = { "scene_blurred", "scene", "scene_blurred" };
+    int best = -1;
+    float bestScore = -1.0f;
+    for (int i = 0; i < 3; i++) {
+        float score = scoreOf(burst[i]);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    CHECK_EQ(best, 1);
+}
+
+void testRejectsBrokenJpegs() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    JpegSharpness sharpness;
+    float score = 1.0f;
+    CHECK(!sharpness.score(jpeg.data(), jpeg.size() / 2, score));
+    CHECK(score == 0.0f);
+    CHECK(sharpness.error() != nullptr);
+}
+
+void benchmarks() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    JpegSharpness sharpness;
+    float score;
+    benchmark("JpegSharpness::score 640x480", jpeg.size(), [&] { sharpness.score(jpeg.data(), jpeg.size(), score); });
+}
+
+}
+
+int main() {
+    testMatchesReference();
+    testRanksBurstFrames();
+    testRejectsBrokenJpegs();
+    benchmarks();
+    return hostTestResult("test_jpeg_sharpness");
+}
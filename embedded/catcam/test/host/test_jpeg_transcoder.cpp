@@ -0,0 +1,267 @@
+// JpegTranscoder requantisation/Huffman re-optimisation and the JpegEncoder
+// thumbnail path, checked with the repo's own decoders (and libjpeg when found)
+
+#include "DcLumaMap.h"
+#include "JpegEncoder.h"
+#include "JpegScaledDecoder.h"
+#include "JpegSharpness.h"
+#include "JpegTranscoder.h"
+
+#ifdef CATCAM_HOST_LIBJPEG
+#include <stdio.h>
+#include <jpeglib.h>
+#endif
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+const size_t CAPACITY_SLACK = 2048;  // JpegTranscoder::transcode() contract
+
+std::vector<uint8_t> transcode(const std::vector<uint8_t>& jpeg, int quality) {
+    JpegTranscoder transcoder;
+    std::vector<uint8_t> out(jpeg.size() + CAPACITY_SLACK);
+    size_t outSize = 0;
+    if (!CHECK(transcoder.load(jpeg.data(), jpeg.size())) ||
+        !CHECK(transcoder.transcode(quality, out.data(), out.size(), outSize))) {
+        fprintf(stderr, "  q%d: %s\n", quality, transcoder.error());
+        return {};
+    }
+    out.resize(outSize);
+    return out;
+}
+
+struct LumaDiff {
+    int max = 0;
+    double mean = 0;
+};
+
+LumaDiff compare(const uint8_t* a, const uint8_t* b, size_t count) {
+    LumaDiff result;
+    long sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int diff = abs((int)a[i] - b[i]);
+        result.max = diff > result.max ? diff : result.max;
+        sum += diff;
+    }
+    result.mean = count ? (double)sum / count : 0;
+    return result;
+}
+
+LumaDiff compareDcMaps(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    DcLumaMap mapA;
+    DcLumaMap mapB;
+    if (!CHECK(mapA.build(a.data(), a.size())) || !CHECK(mapB.build(b.data(), b.size())) ||
+        !CHECK(mapA.cellCount() == mapB.cellCount())) {
+        LumaDiff broken;
+        broken.max = 255;
+        return broken;
+    }
+    return compare(mapA.data(), mapB.data(), mapA.cellCount());
+}
+
+#ifdef CATCAM_HOST_LIBJPEG
+/**
+ * Full-resolution libjpeg decode (interleaved samples), empty on failure
+ */
+std::vector<uint8_t> libjpegDecode(const std::vector<uint8_t>& jpeg) {
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = [](j_common_ptr info) { throw (int)info->err->msg_code; };
+    std::vector<uint8_t> pixels;
+    try {
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, jpeg.data(), jpeg.size());
+        jpeg_read_header(&cinfo, TRUE);
+        jpeg_start_decompress(&cinfo);
+        size_t stride = (size_t)cinfo.output_width * cinfo.output_components;
+        pixels.resize(stride * cinfo.output_height);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = pixels.data() + stride * cinfo.output_scanline;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+        if (jerr.num_warnings) {
+            pixels.clear();  // Corrupt data libjpeg papered over
+        }
+    } catch (int) {
+        pixels.clear();
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return pixels;
+}
+#endif
+
+void testLosslessAtQuality100() {
+    for (const char* name : { "scene", "scene_restart", "scene_420", "scene_q40", "grey_odd", "dark" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        std::vector<uint8_t> out = transcode(jpeg, 100);
+        if (out.empty()) {
+            continue;
+        }
+        // Same coefficients, better Huffman tables, no restart markers
+        CHECK(out.size() <= jpeg.size());
+        CHECK_EQ(compareDcMaps(jpeg, out).max, 0);
+
+        JpegSharpness sharpness;
+        float before = 0;
+        float after = 0;
+        CHECK(sharpness.score(jpeg.data(), jpeg.size(), before));
+        CHECK(sharpness.score(out.data(), out.size(), after));
+        CHECK(before == after);
+
+#ifdef CATCAM_HOST_LIBJPEG
+        std::vector<uint8_t> expected = libjpegDecode(jpeg);
+        std::vector<uint8_t> actual = libjpegDecode(out);
+        CHECK(!actual.empty() && actual == expected);
+#endif
+    }
+}
+
+void testRequantisedOutput() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    size_t previous = jpeg.size();
+    for (int quality : { 60, 40, 20 }) {
+        std::vector<uint8_t> out = transcode(jpeg, quality);
+        if (out.empty()) {
+            continue;
+        }
+        CHECK(out.size() < previous);
+        previous = out.size();
+
+        // Requantising moves each DC term by at most half the new step, and
+        // 8x8 means are DC / 8; allow one more for the map's own rounding
+        uint16_t steps[64];
+        jpegStandardQuantTable(false, quality, steps);
+        double halfStep = steps[0] / 16.0;
+        LumaDiff diff = compareDcMaps(jpeg, out);
+        if (!CHECK(diff.max <= halfStep + 1 && diff.mean < halfStep / 2 + 0.5)) {
+            fprintf(stderr, "  q%d DC map: max %d, mean %.3f\n", quality, diff.max, diff.mean);
+        }
+
+        JpegScaledDecoder decoded;
+        CHECK(decoded.decode(out.data(), out.size(), 2));
+        CHECK_EQ(decoded.componentCount(), 3);
+
+#ifdef CATCAM_HOST_LIBJPEG
+        std::vector<uint8_t> expected = libjpegDecode(jpeg);
+        std::vector<uint8_t> actual = libjpegDecode(out);
+        if (CHECK(actual.size() == expected.size())) {
+            LumaDiff pixels = compare(actual.data(), expected.data(), actual.size());
+            if (!CHECK(pixels.mean < 3.0 + (60 - quality) / 10.0)) {
+                fprintf(stderr, "  q%d pixels: max %d, mean %.3f\n", quality, pixels.max, pixels.mean);
+            }
+        }
+#endif
+    }
+
+    // Never finer than the source's own steps: asking for more than q80 buys nothing
+    std::vector<uint8_t> q95 = transcode(jpeg, 95);
+    std::vector<uint8_t> q100 = transcode(jpeg, 100);
+    CHECK(q95.size() <= q100.size() + 64);
+}
+
+void testCapacityAndBadInput() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    JpegTranscoder transcoder;
+    CHECK(transcoder.load(jpeg.data(), jpeg.size()));
+    std::vector<uint8_t> out(1024);
+    size_t outSize = 0;
+    CHECK(!transcoder.transcode(100, out.data(), out.size(), outSize));
+    CHECK(transcoder.error() != nullptr);
+
+    JpegTranscoder empty;
+    CHECK(!empty.transcode(80, out.data(), out.size(), outSize));
+
+    std::vector<uint8_t> cut(jpeg.begin(), jpeg.begin() + 300);
+    CHECK(!transcoder.load(cut.data(), cut.size()) ||
+          !transcoder.transcode(80, out.data(), out.size(), outSize));
+}
+
+void testEncoderRoundTrip() {
+    for (const char* name : { "scene", "grey_odd" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        JpegScaledDecoder source;
+        if (!CHECK(source.decode(jpeg.data(), jpeg.size(), 2))) {
+            continue;
+        }
+        int components = source.componentCount();
+        const uint8_t* planes[3] = { source.plane(0), nullptr, nullptr };
+        if (components == 3) {
+            planes[1] = source.plane(1);
+            planes[2] = source.plane(2);
+        }
+
+        JpegEncoder encoder;
+        std::vector<uint8_t> out(256 * 1024);
+        size_t size = encoder.encode(planes, components, source.width(), source.height(), 90,
+                                     out.data(), out.size());
+        if (!CHECK(size > 0)) {
+            continue;
+        }
+        out.resize(size);
+        CHECK_EQ(encoder.encode(planes, components, source.width(), source.height(), 90, out.data(), 100),
+                 (size_t)0);
+
+        // 1/4 of the half-scale thumbnail vs 1/8 of the original: both 8x8 means
+        JpegScaledDecoder thumbnail;
+        JpegScaledDecoder original;
+        CHECK(thumbnail.decode(out.data(), out.size(), 4));
+        CHECK(original.decode(jpeg.data(), jpeg.size(), 8));
+        CHECK_EQ(thumbnail.componentCount(), components);
+        if (CHECK(thumbnail.width() == original.width() && thumbnail.height() == original.height())) {
+            LumaDiff diff = compare(thumbnail.plane(0), original.plane(0),
+                                    (size_t)thumbnail.width() * thumbnail.height());
+            if (!CHECK(diff.max <= 4 && diff.mean < 1.0)) {
+                fprintf(stderr, "  %s round trip: max %d, mean %.3f\n", name, diff.max, diff.mean);
+            }
+        }
+
+#ifdef CATCAM_HOST_LIBJPEG
+        std::vector<uint8_t> pixels = libjpegDecode(out);
+        CHECK_EQ(pixels.size(), (size_t)source.width() * source.height() * components);
+#endif
+    }
+
+    uint16_t zigzag[64];
+    jpegStandardQuantTable(false, 50, zigzag);
+    CHECK_EQ(zigzag[0], 16);  // Annex K table K.1 as is
+    CHECK_EQ(zigzag[63], 99);
+    jpegStandardQuantTable(true, 100, zigzag);
+    CHECK_EQ(zigzag[0], 1);
+    jpegStandardQuantTable(false, 1, zigzag);
+    CHECK_EQ(zigzag[63], 255);
+}
+
+void benchmarks() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    std::vector<uint8_t> out(jpeg.size() + CAPACITY_SLACK);
+    size_t outSize = 0;
+    JpegTranscoder transcoder;
+    transcoder.load(jpeg.data(), jpeg.size());
+    benchmark("JpegTranscoder q100 640x480", jpeg.size(), [&] { transcoder.transcode(100, out.data(), out.size(), outSize); });
+    benchmark("JpegTranscoder q50 640x480", jpeg.size(), [&] { transcoder.transcode(50, out.data(), out.size(), outSize); });
+
+    JpegScaledDecoder source;
+    source.decode(jpeg.data(), jpeg.size(), 4);
+    const uint8_t* planes[3] = { source.plane(0), source.plane(1), source.plane(2) };
+    JpegEncoder encoder;
+    size_t samples = (size_t)source.width() * source.height() * 3;
+    benchmark("JpegEncoder 160x120 YCbCr", samples, [&] {
+        encoder.encode(planes, 3, source.width(), source.height(), 80, out.data(), out.size());
+    });
+}
+
+}
+
+int main() {
+    testLosslessAtQuality100();
+    testRequantisedOutput();
+    testCapacityAndBadInput();
+    testEncoderRoundTrip();
+    benchmarks();
+    return hostTestResult("test_jpeg_transcoder");
+}
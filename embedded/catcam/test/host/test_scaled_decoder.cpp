@@ -0,0 +1,108 @@
+// JpegScaledDecoder at 1/8, 1/4 and 1/2 against box-averaged libjpeg decodes
+
+#include "JpegScaledDecoder.h"
+
+#include "support/Benchmark.h"
+#include "support/Fixtures.h"
+#include "support/HostTest.h"
+
+namespace {
+
+struct Scale {
+    uint8_t denominator;
+    const char* reference;
+};
+
+const Scale SCALES[] = { { 8, ".dc.pgm" }, { 4, ".y4.pgm" }, { 2, ".y2.pgm" } };
+
+void testLumaMatchesReference() {
+    for (const char* name : { "scene", "grey_odd" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        for (const Scale& scale : SCALES) {
+            ReferenceImage reference = loadReference(name, scale.reference);
+            JpegScaledDecoder decoder;
+            if (!CHECK(decoder.decode(jpeg.data(), jpeg.size(), scale.denominator))) {
+                continue;
+            }
+            CHECK_EQ(decoder.width(), reference.width);
+            CHECK_EQ(decoder.height(), reference.height);
+
+            // Means taken from coefficients vs from libjpeg's rounded, clamped pixels
+            const uint8_t* y = decoder.plane(0);
+            int maxDiff = 0;
+            long sumDiff = 0;
+            for (int i = 0; i < reference.width * reference.height; i++) {
+                int diff = abs((int)y[i] - reference.pixels[i]);
+                maxDiff = diff > maxDiff ? diff : maxDiff;
+                sumDiff += diff;
+            }
+            double meanDiff = (double)sumDiff / (reference.width * reference.height);
+            if (!CHECK(maxDiff <= 2 && meanDiff < 0.25)) {
+                fprintf(stderr, "  %s 1/%d: max %d, mean %.3f\n", name, scale.denominator, maxDiff, meanDiff);
+            }
+        }
+    }
+}
+
+void testLayoutsGiveTheSameLuma() {
+    std::vector<uint8_t> scene = loadJpeg("scene");
+    for (const char* name : { "scene_restart", "scene_420" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        for (const Scale& scale : SCALES) {
+            JpegScaledDecoder expected;
+            JpegScaledDecoder decoder;
+            CHECK(expected.decode(scene.data(), scene.size(), scale.denominator));
+            CHECK(decoder.decode(jpeg.data(), jpeg.size(), scale.denominator));
+            size_t samples = (size_t)decoder.width() * decoder.height();
+            CHECK(samples == (size_t)expected.width() * expected.height() &&
+                  memcmp(decoder.plane(0), expected.plane(0), samples) == 0);
+        }
+    }
+}
+
+void testChromaOnTheLumaGrid() {
+    // The door (x 60-180, y 80-330) is brown: blue-difference low, red-difference high
+    for (const char* name : { "scene", "scene_420" }) {
+        std::vector<uint8_t> jpeg = loadJpeg(name);
+        JpegScaledDecoder decoder;
+        CHECK(decoder.decode(jpeg.data(), jpeg.size(), 4));
+        CHECK_EQ(decoder.componentCount(), 3);
+        size_t door = (size_t)(200 / 4) * decoder.width() + 120 / 4;
+        CHECK(decoder.plane(1)[door] < 115);
+        CHECK(decoder.plane(2)[door] > 140);
+    }
+
+    std::vector<uint8_t> grey = loadJpeg("grey_odd");
+    JpegScaledDecoder decoder;
+    CHECK(decoder.decode(grey.data(), grey.size(), 2));
+    CHECK_EQ(decoder.componentCount(), 1);
+}
+
+void testRejectsBadInput() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    JpegScaledDecoder decoder;
+    CHECK(!decoder.decode(jpeg.data(), jpeg.size(), 3));
+    CHECK(!decoder.decode(jpeg.data(), jpeg.size() / 2, 4));
+    CHECK(decoder.error() != nullptr);
+}
+
+void benchmarks() {
+    std::vector<uint8_t> jpeg = loadJpeg("scene");
+    JpegScaledDecoder decoder;
+    for (const Scale& scale : SCALES) {
+        char name[48];
+        snprintf(name, sizeof(name), "JpegScaledDecoder 1/%d 640x480", scale.denominator);
+        benchmark(name, jpeg.size(), [&] { decoder.decode(jpeg.data(), jpeg.size(), scale.denominator); });
+    }
+}
+
+}
+
+int main() {
+    testLumaMatchesReference();
+    testLayoutsGiveTheSameLuma();
+    testChromaOnTheLumaGrid();
+    testRejectsBadInput();
+    benchmarks();
+    return hostTestResult("test_scaled_decoder");
+}
@@ -0,0 +1,230 @@
+// SHA-256/HMAC known answers, AWSAuth's SigV4 signatures against an
+// independent implementation (tools/sigv4_reference.py) and signing throughput
+
+#include "AWSAuth.h"
+#include <mbedtls/md.h>
+#include <time.h>
+
+#include "support/AllocationCounter.h"
+#include "support/Benchmark.h"
+#include "support/HostTest.h"
+
+// AWSAuth reads the wall clock with time(); the tests set it
+namespace {
+time_t fixedNow = 0;
+}
+
+extern "C" time_t time(time_t* out) {
+    if (out) {
+        *out = fixedNow;
+    }
+    return fixedNow;
+}
+
+namespace {
+
+const char* HOST = "abcdef1234.execute-api.eu-west-2.amazonaws.com";
+const char* ACCESS_KEY = "AKIDEXAMPLE";
+const char* SECRET = "wJalrXUtnFEMI/K7MDENG/bPxRfiCYEXAMPLEKEY";
+const char* OTHER_SECRET = "anotherSecretKeyEXAMPLEanotherSecretKeyEX";
+const char* EMPTY_SHA256 = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+const char* IMAGE_SHA256 = "21ac2586e213d1f490778a07bf0025a98fc57595863a282372bac594b398322b";  // "not really a jpeg"
+const time_t BEFORE_MIDNIGHT = 1760659199;  // 2025-10-16T23:59:59Z
+const time_t AFTER_MIDNIGHT = 1760659201;   // 2025-10-17T00:00:01Z
+
+String hex(const uint8_t* bytes, size_t length) {
+    AWSAuth auth;
+    return auth.bytesToHex(bytes, length);
+}
+
+String sha256Hex(const void* data, size_t length) {
+    uint8_t digest[32];
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const uint8_t*)data, length, digest);
+    return hex(digest, sizeof(digest));
+}
+
+String hmacHex(const void* key, size_t keyLength, const char* message) {
+    uint8_t digest[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const uint8_t*)key, keyLength,
+                    (const uint8_t*)message, strlen(message), digest);
+    return hex(digest, sizeof(digest));
+}
+
+void testSha256KnownAnswers() {
+    // FIPS 180-2 appendix B
+    CHECK(sha256Hex("", 0) == EMPTY_SHA256);
+    CHECK(sha256Hex("abc", 3) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    const char* twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    CHECK(sha256Hex(twoBlocks, strlen(twoBlocks)) ==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    // A million 'a's fed in uneven pieces, across block boundaries
+    std::string million(1000000, 'a');
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    CHECK_EQ(mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0), 0);
+    mbedtls_md_starts(&ctx);
+    size_t offset = 0;
+    for (size_t piece = 1; offset < million.size(); piece = piece * 3 % 1031 + 1) {
+        size_t n = std::min(piece, million.size() - offset);
+        mbedtls_md_update(&ctx, (const uint8_t*)million.data() + offset, n);
+        offset += n;
+    }
+    uint8_t digest[32];
+    mbedtls_md_finish(&ctx, digest);
+    mbedtls_md_free(&ctx);
+    CHECK(hex(digest, 32) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    AWSAuth auth;
+    size_t position = 0;
+    uint8_t buffer[100];
+    String streamed = auth.sha256HashStream([&](uint8_t* out, size_t maxLen) {
+        size_t n = std::min(maxLen, million.size() - position);
+        memcpy(out, million.data() + position, n);
+        position += n;
+        return n;
+    }, buffer, sizeof(buffer));
+    CHECK(streamed == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    CHECK(auth.sha256HashBinary((const uint8_t*)"not really a jpeg", 17) == IMAGE_SHA256);
+}
+
+void testHmacKnownAnswers() {
+    // RFC 4231 test cases 1, 2 and 6 (key longer than a block)
+    uint8_t key[131];
+    memset(key, 0x0b, 20);
+    CHECK(hmacHex(key, 20, "Hi There") == "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+    CHECK(hmacHex("Jefe", 4, "what do ya want for nothing?") ==
+          "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    memset(key, 0xaa, sizeof(key));
+    const char* longKeyMessage = "Test Using Larger Than Block-Size Key - Hash Key First";
+    CHECK(hmacHex(key, sizeof(key), longKeyMessage) ==
+          "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+
+    // Streamed through one context, reused the way AWSAuth reuses _md
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    CHECK_EQ(mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1), 0);
+    for (int round = 0; round < 2; round++) {
+        mbedtls_md_hmac_starts(&ctx, key, sizeof(key));
+        mbedtls_md_hmac_update(&ctx, (const uint8_t*)longKeyMessage, 10);
+        mbedtls_md_hmac_update(&ctx, (const uint8_t*)longKeyMessage + 10, strlen(longKeyMessage) - 10);
+        uint8_t digest[32];
+        mbedtls_md_hmac_finish(&ctx, digest);
+        CHECK(hex(digest, 32) == "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+        mbedtls_md_starts(&ctx);  // Plain hashing in between must not disturb the next HMAC
+        mbedtls_md_update(&ctx, (const uint8_t*)"abc", 3);
+        mbedtls_md_finish(&ctx, digest);
+        CHECK(hex(digest, 32) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    }
+    mbedtls_md_free(&ctx);
+
+    // The signing key example in the AWS SigV4 documentation
+    const mbedtls_md_info_t* sha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    const char* secret = "AWS4wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY";
+    uint8_t k[32];
+    mbedtls_md_hmac(sha256, (const uint8_t*)secret, strlen(secret), (const uint8_t*)"20120215", 8, k);
+    mbedtls_md_hmac(sha256, k, 32, (const uint8_t*)"us-east-1", 9, k);
+    mbedtls_md_hmac(sha256, k, 32, (const uint8_t*)"iam", 3, k);
+    mbedtls_md_hmac(sha256, k, 32, (const uint8_t*)"aws4_request", 12, k);
+    CHECK(hex(k, 32) == "f4780e2d9f65fa895f9c67b32ce1baf0b0d8a43505a000a1a9e090d414db404d");
+}
+
+String sessionToken() {
+    String token;
+    for (int i = 0; i < 24; i++) {
+        token += "IQoJb3JpZ2luX2VjEXAMPLETOKEN/";
+    }
+    return token;
+}
+
+AWSCredentials credentials(const char* secret) {
+    AWSCredentials creds;
+    creds.accessKeyId = ACCESS_KEY;
+    creds.secretAccessKey = secret;
+    creds.sessionToken = sessionToken();
+    creds.expiration = AFTER_MIDNIGHT + 3600;
+    creds.isValid = true;
+    return creds;
+}
+
+String authorization(const char* date, const char* signature) {
+    return String("AWS4-HMAC-SHA256 Credential=") + ACCESS_KEY + "/" + date +
+           "/eu-west-2/execute-api/aws4_request, SignedHeaders=content-type;host;x-amz-date;x-amz-security-token, "
+           "Signature=" + signature;
+}
+
+void testSignaturesMatchReference() {
+    AWSAuth auth("eu-west-2");
+    auth.setCredentials(credentials(SECRET));
+
+    fixedNow = BEFORE_MIDNIGHT;
+    SigV4Headers headers = auth.createSigV4HeadersForPayloadHash("POST", "/infer?mode=training", HOST,
+                                                                 IMAGE_SHA256, "image/jpeg");
+    CHECK(headers.isValid);
+    CHECK(headers.date == "20251016T235959Z");
+    CHECK(headers.authorization ==
+          authorization("20251016", "d07d0e8ca9b67aee8ef27c2d35663482957b8b19604e2ab604bd0794d920411c"));
+    CHECK(headers.securityToken == sessionToken());
+    CHECK(headers.payloadHash == IMAGE_SHA256);
+
+    // Across midnight: the cached signing key and scope must follow the date
+    fixedNow = AFTER_MIDNIGHT;
+    headers = auth.createSigV4HeadersForPayloadHash("POST", "/infer?mode=training", HOST, IMAGE_SHA256, "image/jpeg");
+    CHECK(headers.authorization ==
+          authorization("20251017", "fdc1af1837b8ad57f7c87e3e7eb6441f6a666a9d7cff17f0784421559f4ed360"));
+
+    headers = auth.createSigV4Headers("POST", "/infer", HOST, "{\"cat\":\"Boots\"}", "application/json");
+    CHECK(headers.authorization ==
+          authorization("20251017", "f6d3dedf965c524d25d9f7835a5471767048b512ef310a3606ca71ae750386be"));
+
+    // New credentials on the same day: the key must be derived again
+    auth.setCredentials(credentials(OTHER_SECRET));
+    headers = auth.createSigV4HeadersForBinary("PUT", "/videos/x.avi", HOST, nullptr, 0, "video/x-msvideo");
+    CHECK(headers.payloadHash == EMPTY_SHA256);
+    CHECK(headers.authorization ==
+          authorization("20251017", "5cc53dce1b008f1319f967ab676735ec007bb95ec0f0bd19987e870c9e6d9090"));
+
+    // Within five minutes of expiry nothing is signed
+    fixedNow = AFTER_MIDNIGHT + 3600 - 299;
+    CHECK(!auth.createSigV4HeadersForPayloadHash("POST", "/infer", HOST, EMPTY_SHA256, "image/jpeg").isValid);
+}
+
+void benchmarks() {
+    fixedNow = AFTER_MIDNIGHT;
+    AWSAuth auth("eu-west-2");
+    auth.setCredentials(credentials(SECRET));
+    String uri = "/infer?mode=training";
+    String host = HOST;
+    String payloadHash = IMAGE_SHA256;
+    String contentType = "image/jpeg";
+    auth.createSigV4HeadersForPayloadHash("POST", uri, host, payloadHash, contentType);
+
+    size_t before = hostAllocationCount();
+    auth.createSigV4HeadersForPayloadHash("POST", uri, host, payloadHash, contentType);
+    size_t allocations = hostAllocationCount() - before;
+
+    double us = benchmark("SigV4 sign, cached signing key", 0, [&] {
+        auth.createSigV4HeadersForPayloadHash("POST", uri, host, payloadHash, contentType);
+    });
+    printf("    %.0f signatures/s, %zu allocations each (host String)\n", 1e6 / us, allocations);
+
+    AWSCredentials creds = credentials(SECRET);
+    us = benchmark("SigV4 sign, key derived each time", 0, [&] {
+        auth.setCredentials(creds);
+        auth.createSigV4HeadersForPayloadHash("POST", uri, host, payloadHash, contentType);
+    });
+    printf("    %.0f signatures/s\n", 1e6 / us);
+
+    std::vector<uint8_t> frame(200 * 1024, 0x5a);
+    benchmark("SHA-256 200 KB frame", frame.size(), [&] { auth.sha256HashBinary(frame.data(), frame.size()); });
+}
+
+}
+
+int main() {
+    testSha256KnownAnswers();
+    testHmacKnownAnswers();
+    testSignaturesMatchReference();
+    benchmarks();
+    return hostTestResult("test_sigv4");
+}
@@ -0,0 +1,295 @@
+// SlabAllocator under 100k random allocate/release operations, checked
+// against a model of which blocks each class has out
+
+#include "SlabAllocator.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "support/AllocationCounter.h"
+#include "support/HostTest.h"
+
+namespace {
+
+// Same shape as SystemManager's SLAB_CLASSES
+const SlabAllocator::SizeClass CLASSES[] = {
+    { 4 * 1024, 2 },
+    { 16 * 1024, 1 },
+    { 96 * 1024, 3 },
+    { 384 * 1024, 1 },
+};
+constexpr size_t CLASS_COUNT = sizeof(CLASSES) / sizeof(CLASSES[0]);
+constexpr size_t TOTAL_BLOCKS = 7;
+
+constexpr int OPERATIONS = 100000;
+constexpr int THREADS = 4;
+
+struct Live {
+    uint8_t* ptr;
+    size_t size;
+    uint32_t tag;
+};
+
+int classOf(const void* ptr, const SlabAllocator& slab) {
+    size_t blockSize = slab.blockSizeOf(ptr);
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        if (slab.classStats(i).blockSize == blockSize) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Requests spread over every class plus sizes nothing can hold
+size_t randomSize(std::mt19937& rng) {
+    static const size_t LIMITS[] = { 64, 4 * 1024, 16 * 1024, 96 * 1024, 384 * 1024, 512 * 1024 };
+    size_t band = rng() % 6;
+    size_t low = band == 0 ? 1 : LIMITS[band - 1] + 1;
+    return low + rng() % (LIMITS[band] - low + 1);
+}
+
+// First and last word of a block carry a per-allocation tag, so any two
+// live blocks that overlapped would clobber each other's
+void stamp(const Live& live) {
+    memcpy(live.ptr, &live.tag, sizeof(live.tag));
+    memcpy(live.ptr + live.size - sizeof(live.tag), &live.tag, sizeof(live.tag));
+}
+
+bool intact(const Live& live) {
+    uint32_t head;
+    uint32_t tail;
+    memcpy(&head, live.ptr, sizeof(head));
+    memcpy(&tail, live.ptr + live.size - sizeof(tail), sizeof(tail));
+    return head == live.tag && tail == live.tag;
+}
+
+void testRandomOperationsMatchModel() {
+    SlabAllocator slab;
+    CHECK(slab.init(CLASSES, CLASS_COUNT, malloc, free));
+    CHECK_EQ(slab.classCount(), CLASS_COUNT);
+
+    std::mt19937 rng(12345);
+    std::vector<Live> live;
+    live.reserve(TOTAL_BLOCKS);
+    size_t inUse[CLASS_COUNT] = {};
+    size_t peak[CLASS_COUNT] = {};
+    uint32_t failures = 0;
+    uint32_t nextTag = 1;
+
+    size_t allocationsBefore = hostAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int op = 0; op < OPERATIONS; op++) {
+        bool release = !live.empty() && (live.size() == TOTAL_BLOCKS || rng() % 2 == 0);
+        if (release) {
+            size_t pick = rng() % live.size();
+            Live block = live[pick];
+            live[pick] = live.back();
+            live.pop_back();
+            CHECK(intact(block));
+            int cls = classOf(block.ptr, slab);
+            CHECK(cls >= 0);
+            slab.release(block.ptr);
+            inUse[cls]--;
+            continue;
+        }
+
+        size_t size = randomSize(rng);
+        void* ptr = slab.allocate(size);
+
+        // Smallest class that fits and has a free block, or nothing
+        int expected = -1;
+        for (size_t i = 0; i < CLASS_COUNT && expected < 0; i++) {
+            if (CLASSES[i].blockSize >= size && inUse[i] < CLASSES[i].blockCount) {
+                expected = (int)i;
+            }
+        }
+        if (expected < 0) {
+            CHECK(ptr == nullptr);
+            failures++;
+            continue;
+        }
+        if (!CHECK(ptr != nullptr)) {
+            continue;
+        }
+        CHECK_EQ(classOf(ptr, slab), expected);
+        CHECK(slab.blockSizeOf(ptr) >= size);
+        CHECK_EQ((uintptr_t)ptr % sizeof(void*), 0u);
+
+        Live block = { (uint8_t*)ptr, size < sizeof(uint32_t) * 2 ? sizeof(uint32_t) * 2 : size, nextTag++ };
+        stamp(block);
+        live.push_back(block);
+        inUse[expected]++;
+        peak[expected] = std::max(peak[expected], inUse[expected]);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    CHECK_EQ(hostAllocationCount() - allocationsBefore, 0u);
+
+    for (const Live& block : live) {
+        CHECK(intact(block));
+    }
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        SlabAllocator::ClassStats stats = slab.classStats(i);
+        CHECK_EQ(stats.inUse, inUse[i]);
+        CHECK_EQ(stats.peakInUse, peak[i]);
+    }
+    CHECK_EQ(slab.failureCount(), failures);
+
+    for (const Live& block : live) {
+        slab.release(block.ptr);
+    }
+    live.clear();
+
+    // Every block is back on its free list: each class fills exactly once more
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        CHECK_EQ(slab.classStats(i).inUse, 0u);
+    }
+    std::vector<void*> all;
+    for (size_t i = 0; i < TOTAL_BLOCKS; i++) {
+        all.push_back(slab.allocate(1));
+        CHECK(all.back() != nullptr);
+    }
+    CHECK(slab.allocate(1) == nullptr);
+    for (void* ptr : all) {
+        slab.release(ptr);
+    }
+
+    printf("  %d operations in %.1f ms (%.0f ns/op), %u refused\n",
+           OPERATIONS, seconds * 1e3, seconds * 1e9 / OPERATIONS, failures);
+}
+
+void testConcurrentUseKeepsBlocksDisjoint() {
+    SlabAllocator slab;
+    CHECK(slab.init(CLASSES, CLASS_COUNT, malloc, free));
+
+    std::vector<int> corrupt(THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&slab, &corrupt, t] {
+            std::mt19937 rng(t + 1);
+            Live held[2] = {};
+            for (int op = 0; op < OPERATIONS / THREADS; op++) {
+                Live& slot = held[rng() % 2];
+                if (slot.ptr) {
+                    corrupt[t] += intact(slot) ? 0 : 1;
+                    slab.release(slot.ptr);
+                    slot.ptr = nullptr;
+                    continue;
+                }
+                size_t size = 8 + rng() % (96 * 1024 - 8);
+                slot.ptr = (uint8_t*)slab.allocate(size);
+                if (slot.ptr) {
+                    slot.size = size;
+                    slot.tag = (uint32_t)(t << 24 | op);
+                    stamp(slot);
+                }
+            }
+            for (Live& slot : held) {
+                if (slot.ptr) {
+                    corrupt[t] += intact(slot) ? 0 : 1;
+                    slab.release(slot.ptr);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < THREADS; t++) {
+        CHECK_EQ(corrupt[t], 0);
+    }
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        CHECK_EQ(slab.classStats(i).inUse, 0u);
+    }
+}
+
+void testForeignPointersIgnored() {
+    SlabAllocator slab;
+    CHECK(slab.init(CLASSES, CLASS_COUNT, malloc, free));
+
+    uint8_t local[16];
+    CHECK(!slab.owns(local));
+    CHECK_EQ(slab.blockSizeOf(local), 0u);
+    slab.release(local);
+    slab.release(nullptr);
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        CHECK_EQ(slab.classStats(i).inUse, 0u);
+    }
+    CHECK_EQ(slab.badReleaseCount(), 0u);
+}
+
+struct ReleaseError {
+    const void* ptr;
+    std::string reason;
+};
+std::vector<ReleaseError> releaseErrors;
+
+void recordReleaseError(const void* ptr, const char* reason) {
+    releaseErrors.push_back({ ptr, reason });
+}
+
+void testBadReleasesRefused() {
+    SlabAllocator slab;
+    slab.setReleaseErrorHandler(recordReleaseError);
+    CHECK(slab.init(CLASSES, CLASS_COUNT, malloc, free));
+    releaseErrors.clear();
+
+    // Double free: the block must not go on the free list twice
+    uint8_t* first = (uint8_t*)slab.allocate(4 * 1024);
+    CHECK(first != nullptr);
+    slab.release(first);
+    slab.release(first);
+    CHECK_EQ(slab.classStats(0).inUse, 0u);
+    CHECK_EQ(slab.badReleaseCount(), 1u);
+    CHECK_EQ(releaseErrors.size(), (size_t)1);
+    CHECK(releaseErrors[0].ptr == first && releaseErrors[0].reason == "double free");
+
+    // The class still hands out each of its two blocks exactly once
+    void* a = slab.allocate(4 * 1024);
+    void* b = slab.allocate(4 * 1024);
+    CHECK(a != nullptr && b != nullptr && a != b);
+    CHECK_EQ(slab.classStats(0).inUse, 2u);
+    void* overflow = slab.allocate(4 * 1024);
+    CHECK_EQ(classOf(overflow, slab), 1);  // The 4 KB class is full
+
+    // Pointers into a block, or into a free block, are not blocks
+    slab.release((uint8_t*)a + 8);
+    slab.release((uint8_t*)a + 4 * 1024 - 1);
+    CHECK_EQ(slab.classStats(0).inUse, 2u);
+    CHECK_EQ(slab.badReleaseCount(), 3u);
+    CHECK(releaseErrors.back().reason == "not the start of a block");
+    uint8_t* free96 = (uint8_t*)slab.allocate(96 * 1024);
+    slab.release(free96);
+    slab.release(free96 + 96 * 1024);  // Start of the next, never allocated block
+    CHECK_EQ(slab.badReleaseCount(), 4u);
+    CHECK(releaseErrors.back().reason == "double free");
+
+    // Outside every arena: ignored, not an error
+    uint8_t local[16];
+    slab.release(local);
+    CHECK_EQ(slab.badReleaseCount(), 4u);
+    CHECK_EQ(releaseErrors.size(), (size_t)4);
+
+    slab.release(a);
+    slab.release(b);
+    slab.release(overflow);
+    for (size_t i = 0; i < CLASS_COUNT; i++) {
+        CHECK_EQ(slab.classStats(i).inUse, 0u);
+    }
+}
+
+}
+
+int main() {
+    testRandomOperationsMatchModel();
+    testConcurrentUseKeepsBlocksDisjoint();
+    testForeignPointersIgnored();
+    testBadReleasesRefused();
+    return hostTestResult("test_slab_allocator");
+}
@@ -0,0 +1,112 @@
+// Time to the first byte of an upload: payload hash then connect (serial),
+// hash on the other core while connecting (overlapped), or hash already
+// taken during the capture copy - the three paths of CatCamHttpClient::postImage()
+
+#include "ApiConnection.h"
+#include "FakeApiServer.h"
+#include "PayloadHasher.h"
+#include <mbedtls/md.h>
+#include <vector>
+
+#include "support/HostTest.h"
+
+namespace {
+
+const char* HOST = "api.example.com";
+const size_t PAYLOAD_BYTES = 4 * 1024 * 1024;  // Big enough for the host's hash time to register
+const int RUNS = 5;
+
+enum class Mode { Serial, Overlapped, Capture };
+
+void sha256(const std::vector<uint8_t>& data, uint8_t* digest) {
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), data.data(), data.size(), digest);
+}
+
+void testPayloadHasher(const std::vector<uint8_t>& payload) {
+    uint8_t expected[PayloadHasher::DIGEST_SIZE];
+    sha256(payload, expected);
+
+    PayloadHasher hasher;
+    uint8_t digest[PayloadHasher::DIGEST_SIZE] = {};
+    CHECK(!hasher.finish(digest));  // Nothing started
+    CHECK(hasher.start(payload.data(), payload.size()));
+    CHECK(!hasher.start(payload.data(), payload.size()));  // One at a time
+    uint32_t waitedMs = 12345;
+    CHECK(hasher.finish(digest, &waitedMs));
+    CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    CHECK(waitedMs != 12345);
+
+    // Reusable once finished, and the destructor waits for an unfinished one
+    CHECK(hasher.start(payload.data(), 1000));
+    {
+        PayloadHasher abandoned;
+        CHECK(abandoned.start(payload.data(), payload.size()));
+    }
+    CHECK(hasher.finish(digest));
+}
+
+/**
+ * Mean milliseconds from the start of the upload to the request going out
+ */
+double timeToFirstByte(ApiConnection& connection, const std::vector<uint8_t>& payload, Mode mode, bool warm) {
+    String head = "POST /infer HTTP/1.1\r\nHost: api.example.com\r\nContent-Length: 0\r\n";
+    ApiResponse response;
+    unsigned long total = 0;
+    for (int run = 0; run < RUNS; run++) {
+        if (warm) {
+            CHECK(connection.request(HOST, head, nullptr, 1000, response));
+        } else {
+            connection.close();
+        }
+
+        unsigned long startMs = millis();
+        uint8_t digest[PayloadHasher::DIGEST_SIZE];
+        if (mode == Mode::Serial) {
+            sha256(payload, digest);
+        } else if (mode == Mode::Overlapped) {
+            PayloadHasher hasher;
+            CHECK(hasher.start(payload.data(), payload.size()));
+            connection.prepare(HOST);
+            CHECK(hasher.finish(digest));
+        }
+        CHECK(connection.request(HOST, head, nullptr, 1000, response));
+        total += response.sentAtMs - startMs;
+    }
+    return (double)total / RUNS;
+}
+
+void benchmarks(const std::vector<uint8_t>& payload) {
+    uint8_t digest[PayloadHasher::DIGEST_SIZE];
+    unsigned long hashStartMs = millis();
+    sha256(payload, digest);
+    unsigned long hashMs = millis() - hashStartMs;
+
+    // Handshake a little longer than the hash, as on the device, and really
+    // slept so the hashing thread can run alongside it
+    FakeApiServer server;
+    server.setHandshakeMs((uint32_t)(hashMs * 3 / 2 + 10));
+    server.setHandshakeSleeps(true);
+    ApiConnection connection(server);
+
+    printf("  %zu KB payload hashed in %lu ms, handshake %lu ms\n", payload.size() / 1024, hashMs,
+           (unsigned long)(hashMs * 3 / 2 + 10));
+    for (bool warm : { false, true }) {
+        double serial = timeToFirstByte(connection, payload, Mode::Serial, warm);
+        double overlapped = timeToFirstByte(connection, payload, Mode::Overlapped, warm);
+        double capture = timeToFirstByte(connection, payload, Mode::Capture, warm);
+        printf("  %s connection, first byte after: serial %.1f ms, overlapped %.1f ms, hash from capture %.1f ms\n",
+               warm ? "warm" : "new ", serial, overlapped, capture);
+    }
+}
+
+}
+
+int main() {
+    std::vector<uint8_t> payload(PAYLOAD_BYTES);
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = (uint8_t)(i * 131 + (i >> 9));
+    }
+    testPayloadHasher(payload);
+    benchmarks(payload);
+    return hostTestResult("test_upload_ttfb");
+}
@@ -0,0 +1,366 @@
+// Writes the JPEG fixtures and their reference outputs under fixtures/
+//
+//   make_fixtures <fixtures dir>
+//
+// Scenes are drawn procedurally (deterministic) and encoded with libjpeg in
+// the camera's layout: baseline, standard Huffman tables, 4:2:2. References
+// come from libjpeg too, so they are independent of the JpegTools decoders:
+//   reference/<name>.dc.pgm      8x8 block means of libjpeg's full decode
+//   reference/<name>.y4.pgm      4x4 block means of the decoded luma (scene, grey_odd)
+//   reference/<name>.y2.pgm      2x2 block means of the decoded luma (scene, grey_odd)
+//   reference/sharpness.txt      JpegSharpness' metric from libjpeg's coefficients
+// Edge blocks are completed by repeating the last row/column, as the encoder pads.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+
+namespace {
+
+constexpr int WIDTH = 640;
+constexpr int HEIGHT = 480;
+constexpr int QUALITY = 80;
+constexpr int SHARPNESS_FIRST_COEFFICIENT = 6;  // JpegSharpness::FIRST_COEFFICIENT
+
+// Natural (row-major) index of each zigzag position (libjpeg keeps its own private)
+const int ZIGZAG_TO_NATURAL[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+struct Image {
+    int width;
+    int height;
+    int channels;
+    std::vector<float> pixels;  // Interleaved, 0-255
+
+    Image(int w, int h, int c) : width(w), height(h), channels(c), pixels((size_t)w * h * c) {}
+    float* at(int x, int y) { return &pixels[((size_t)y * width + x) * channels]; }
+};
+
+struct Encoding {
+    int quality = QUALITY;
+    int hLuma = 2;
+    int vLuma = 1;
+    int restartMcus = 0;
+};
+
+void fill(float* px, float r, float g, float b) {
+    px[0] = r;
+    px[1] = g;
+    px[2] = b;
+}
+
+// Hallway: graded wall, planked door, bright window, checked floor, and a
+// dark cat whose centre is given (see fixtures/README.md)
+Image drawScene(int catX, int catY) {
+    Image img(WIDTH, HEIGHT, 3);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            float* px = img.at(x, y);
+            float wall = 90.0f + 60.0f * y / HEIGHT + 10.0f * sinf(x * 0.02f);
+            fill(px, wall + 12, wall + 4, wall - 8);
+            if (x >= 60 && x < 180 && y >= 80 && y < 330) {
+                float plank = (x - 60) % 12 < 2 ? 30.0f : 0.0f;
+                fill(px, 130 - plank, 88 - plank, 52 - plank);
+            }
+            if (x >= 420 && x < 580 && y >= 60 && y < 200) {
+                bool bar = abs(x - 500) < 3 || abs(y - 130) < 3;
+                float sky = 215.0f + 20.0f * (200 - y) / 140;
+                if (bar) {
+                    fill(px, 70, 70, 75);
+                } else {
+                    fill(px, sky - 10, sky - 4, sky);
+                }
+            }
+            if (y >= 330) {
+                float tile = ((x / 6) + (y / 6)) % 2 ? 18.0f : -18.0f;
+                fill(px, 150 + tile, 140 + tile, 120 + tile);
+            }
+            float dx = (x - catX) / 60.0f;
+            float dy = (y - catY) / 40.0f;
+            if (dx * dx + dy * dy <= 1.0f) {
+                float stripe = ((x - catX + 600) / 10) % 2 ? 8.0f : 0.0f;
+                fill(px, 44 + stripe, 40 + stripe, 38 + stripe);
+            }
+        }
+    }
+    return img;
+}
+
+Image adjust(const Image& src, float gain, float offset) {
+    Image out = src;
+    for (float& v : out.pixels) {
+        v = v * gain + offset;
+    }
+    return out;
+}
+
+Image boxBlur(const Image& src, int radius) {
+    Image tmp = src;
+    Image out = src;
+    for (int pass = 0; pass < 2; pass++) {
+        const Image& in = pass == 0 ? src : tmp;
+        Image& dst = pass == 0 ? tmp : out;
+        for (int y = 0; y < src.height; y++) {
+            for (int x = 0; x < src.width; x++) {
+                for (int c = 0; c < src.channels; c++) {
+                    float sum = 0.0f;
+                    for (int k = -radius; k <= radius; k++) {
+                        int sx = pass == 0 ? std::min(std::max(x + k, 0), src.width - 1) : x;
+                        int sy = pass == 1 ? std::min(std::max(y + k, 0), src.height - 1) : y;
+                        sum += const_cast<Image&>(in).at(sx, sy)[c];
+                    }
+                    dst.at(x, y)[c] = sum / (2 * radius + 1);
+                }
+            }
+        }
+    }
+    return out;
+}
+
+// Top of the frame saturated, as with the flash right against the lens
+Image blowOut(const Image& src) {
+    Image out = src;
+    for (int y = 0; y < out.height * 7 / 10; y++) {
+        for (int x = 0; x < out.width; x++) {
+            fill(out.at(x, y), 255, 255, 255);
+        }
+    }
+    return out;
+}
+
+Image toGrey(const Image& src, int width, int height) {
+    Image out(width, height, 1);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const float* px = const_cast<Image&>(src).at(x, y);
+            out.at(x, y)[0] = 0.299f * px[0] + 0.587f * px[1] + 0.114f * px[2];
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> encode(const Image& img, const Encoding& enc) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+
+    cinfo.image_width = img.width;
+    cinfo.image_height = img.height;
+    cinfo.input_components = img.channels;
+    cinfo.in_color_space = img.channels == 3 ? JCS_RGB : JCS_GRAYSCALE;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, enc.quality, TRUE);
+    cinfo.optimize_coding = FALSE;
+    cinfo.restart_interval = enc.restartMcus;
+    cinfo.write_JFIF_header = TRUE;
+    if (img.channels == 3) {
+        cinfo.comp_info[0].h_samp_factor = enc.hLuma;
+        cinfo.comp_info[0].v_samp_factor = enc.vLuma;
+        cinfo.comp_info[1].h_samp_factor = cinfo.comp_info[1].v_samp_factor = 1;
+        cinfo.comp_info[2].h_samp_factor = cinfo.comp_info[2].v_samp_factor = 1;
+    }
+
+    jpeg_start_compress(&cinfo, TRUE);
+    std::vector<uint8_t> row((size_t)img.width * img.channels);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const float* src = &img.pixels[(size_t)cinfo.next_scanline * img.width * img.channels];
+        for (size_t i = 0; i < row.size(); i++) {
+            long v = lrintf(src[i]);
+            row[i] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uint8_t> out(buffer, buffer + size);
+    free(buffer);
+    return out;
+}
+
+// Decoded luma (Y of YCbCr, or the grey channel)
+std::vector<uint8_t> decodeLuma(const std::vector<uint8_t>& jpeg, int& width, int& height) {
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg.data(), jpeg.size());
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = cinfo.num_components == 3 ? JCS_YCbCr : JCS_GRAYSCALE;
+    cinfo.dct_method = JDCT_ISLOW;
+    cinfo.do_fancy_upsampling = FALSE;
+    jpeg_start_decompress(&cinfo);
+
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    int channels = cinfo.output_components;
+    std::vector<uint8_t> luma((size_t)width * height);
+    std::vector<uint8_t> row((size_t)width * channels);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        int y = cinfo.output_scanline;
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        for (int x = 0; x < width; x++) {
+            luma[(size_t)y * width + x] = row[(size_t)x * channels];
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return luma;
+}
+
+std::vector<uint8_t> blockMeans(const std::vector<uint8_t>& luma, int width, int height, int block,
+                                int& outWidth, int& outHeight) {
+    outWidth = (width + block - 1) / block;
+    outHeight = (height + block - 1) / block;
+    std::vector<uint8_t> out((size_t)outWidth * outHeight);
+    for (int by = 0; by < outHeight; by++) {
+        for (int bx = 0; bx < outWidth; bx++) {
+            int sum = 0;
+            for (int y = by * block; y < (by + 1) * block; y++) {
+                for (int x = bx * block; x < (bx + 1) * block; x++) {
+                    sum += luma[(size_t)std::min(y, height - 1) * width + std::min(x, width - 1)];
+                }
+            }
+            int n = block * block;
+            out[(size_t)by * outWidth + bx] = (uint8_t)((sum + n / 2) / n);
+        }
+    }
+    return out;
+}
+
+// JpegSharpness' definition: RMS of dequantised luma AC terms from zigzag
+// position 6 on, over the luma blocks inside the visible area
+double sharpness(const std::vector<uint8_t>& jpeg) {
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg.data(), jpeg.size());
+    jpeg_read_header(&cinfo, TRUE);
+    jvirt_barray_ptr* coefficients = jpeg_read_coefficients(&cinfo);
+
+    jpeg_component_info* luma = &cinfo.comp_info[0];
+    int hMax = cinfo.max_h_samp_factor;
+    int vMax = cinfo.max_v_samp_factor;
+    int blocksX = ((cinfo.image_width * luma->h_samp_factor + hMax - 1) / hMax + 7) / 8;
+    int blocksY = ((cinfo.image_height * luma->v_samp_factor + vMax - 1) / vMax + 7) / 8;
+    const UINT16* quant = luma->quant_table->quantval;  // Natural order
+
+    double energy = 0.0;
+    for (int by = 0; by < blocksY; by++) {
+        JBLOCKARRAY rows = (*cinfo.mem->access_virt_barray)((j_common_ptr)&cinfo, coefficients[0], by, 1, FALSE);
+        for (int bx = 0; bx < blocksX; bx++) {
+            for (int k = SHARPNESS_FIRST_COEFFICIENT; k < 64; k++) {
+                int natural = ZIGZAG_TO_NATURAL[k];
+                double value = (double)rows[0][bx][natural] * quant[natural];
+                energy += value * value;
+            }
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return sqrt(energy / ((double)blocksX * blocksY * (64 - SHARPNESS_FIRST_COEFFICIENT)));
+}
+
+bool writeFile(const std::string& path, const void* data, size_t size) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+    fwrite(data, 1, size, f);
+    fclose(f);
+    return true;
+}
+
+bool writePgm(const std::string& path, const std::vector<uint8_t>& pixels, int width, int height) {
+    std::string header = "P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<uint8_t> file(header.begin(), header.end());
+    file.insert(file.end(), pixels.begin(), pixels.end());
+    return writeFile(path, file.data(), file.size());
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <fixtures dir>\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+
+    const Image scene = drawScene(300, 380);
+    Encoding camera;
+    Encoding restarts;
+    restarts.restartMcus = 8;
+    Encoding coarse;
+    coarse.quality = 40;
+    Encoding quarterChroma;
+    quarterChroma.vLuma = 2;
+
+    // Variants that keep the scene's pixels share its luma coefficients, so
+    // only scene and grey_odd need scaled references
+    struct Fixture {
+        const char* name;
+        Image image;
+        Encoding encoding;
+        bool scaledReference;
+    };
+    const Fixture fixtures[] = {
+        { "scene", scene, camera, true },
+        { "scene_moved", drawScene(420, 400), camera, false },
+        { "scene_brighter", adjust(scene, 1.0f, 24.0f), camera, false },
+        { "scene_blurred", boxBlur(scene, 3), camera, false },
+        { "scene_q40", scene, coarse, false },
+        { "scene_restart", scene, restarts, false },
+        { "scene_420", scene, quarterChroma, false },
+        { "grey_odd", toGrey(scene, 317, 239), camera, true },
+        { "dark", adjust(scene, 0.05f, 0.0f), camera, false },
+        { "blown", blowOut(scene), camera, false },
+    };
+
+    std::string sharpnessLines;
+    for (const Fixture& fixture : fixtures) {
+        std::vector<uint8_t> jpeg = encode(fixture.image, fixture.encoding);
+        if (!writeFile(dir + "/" + fixture.name + ".jpg", jpeg.data(), jpeg.size())) {
+            return 1;
+        }
+
+        int width;
+        int height;
+        std::vector<uint8_t> luma = decodeLuma(jpeg, width, height);
+        for (int block : { 8, 4, 2 }) {
+            if (block != 8 && !fixture.scaledReference) {
+                continue;
+            }
+            int w;
+            int h;
+            std::vector<uint8_t> means = blockMeans(luma, width, height, block, w, h);
+            const char* suffix = block == 8 ? ".dc.pgm" : (block == 4 ? ".y4.pgm" : ".y2.pgm");
+            if (!writePgm(dir + "/reference/" + fixture.name + suffix, means, w, h)) {
+                return 1;
+            }
+        }
+
+        char line[96];
+        snprintf(line, sizeof(line), "%s %.4f\n", fixture.name, sharpness(jpeg));
+        sharpnessLines += line;
+        printf("%-16s %6zu bytes\n", fixture.name, jpeg.size());
+    }
+    return writeFile(dir + "/reference/sharpness.txt", sharpnessLines.data(), sharpnessLines.size()) ? 0 : 1;
+}
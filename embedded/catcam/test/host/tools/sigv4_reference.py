@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Expected SigV4 signatures for test_sigv4.cpp, from Python's hashlib/hmac.
+
+Builds the canonical request the way AWSAuth signs for API Gateway
+(execute-api, signed headers content-type;host;x-amz-date;x-amz-security-token)
+and prints one signature per case; paste them into test_sigv4.cpp.
+"""
+
+import hashlib
+import hmac
+
+SIGNED_HEADERS = "content-type;host;x-amz-date;x-amz-security-token"
+REGION = "eu-west-2"
+SERVICE = "execute-api"
+HOST = "abcdef1234.execute-api.eu-west-2.amazonaws.com"
+TOKEN = "IQoJb3JpZ2luX2VjEXAMPLETOKEN/" * 24
+EMPTY_SHA256 = hashlib.sha256(b"").hexdigest()
+
+
+def signing_key(secret, date_stamp, region, service):
+    key = ("AWS4" + secret).encode()
+    for part in (date_stamp, region, service, "aws4_request"):
+        key = hmac.new(key, part.encode(), hashlib.sha256).digest()
+    return key
+
+
+def sign(secret, amz_date, method, uri, content_type, payload_hash=EMPTY_SHA256):
+    path, _, query = uri.partition("?")
+    canonical = "\n".join([
+        method, path, query,
+        "content-type:" + content_type,
+        "host:" + HOST,
+        "x-amz-date:" + amz_date,
+        "x-amz-security-token:" + TOKEN,
+        "",
+        SIGNED_HEADERS,
+        payload_hash,
+    ])
+    scope = f"{amz_date[:8]}/{REGION}/{SERVICE}/aws4_request"
+    to_sign = "\n".join(["AWS4-HMAC-SHA256", amz_date, scope, hashlib.sha256(canonical.encode()).hexdigest()])
+    return hmac.new(signing_key(secret, amz_date[:8], REGION, SERVICE), to_sign.encode(), hashlib.sha256).hexdigest()
+
+
+# The worked example in the AWS SigV4 documentation ("Deriving the signing key")
+assert signing_key("wJalrXUtnFEMI/K7MDENG+bPxRfiCYEXAMPLEKEY", "20120215", "us-east-1", "iam").hex() == \
+    "f4780e2d9f65fa895f9c67b32ce1baf0b0d8a43505a000a1a9e090d414db404d"
+
+SECRET = "wJalrXUtnFEMI/K7MDENG/bPxRfiCYEXAMPLEKEY"
+OTHER_SECRET = "anotherSecretKeyEXAMPLEanotherSecretKeyEX"
+IMAGE_HASH = hashlib.sha256(b"not really a jpeg").hexdigest()
+
+print(sign(SECRET, "20251016T235959Z", "POST", "/infer?mode=training", "image/jpeg", IMAGE_HASH))
+print(sign(SECRET, "20251017T000001Z", "POST", "/infer?mode=training", "image/jpeg", IMAGE_HASH))
+print(sign(SECRET, "20251017T000001Z", "POST", "/infer", "application/json",
+           hashlib.sha256(b'{"cat":"Boots"}').hexdigest()))
+print(sign(OTHER_SECRET, "20251017T000001Z", "PUT", "/videos/x.avi", "video/x-msvideo"))
+print(IMAGE_HASH)
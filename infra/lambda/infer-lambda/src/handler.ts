@@ -159,13 +159,13 @@ async function createCatadataRecord(s3Key: string): Promise<void> {
 }
 
 // Function to save image to S3
-async function saveImageToS3(imageBuffer: Buffer, timestamp: string, trainingMode: boolean = false): Promise<string> {
+async function saveImageToS3(imageBuffer: Buffer, timestamp: string, mode: 'inference' | 'training' | 'archive' = 'inference'): Promise<string> {
     const bucketName = process.env.IMAGES_BUCKET_NAME;
     if (!bucketName) {
         throw new Error('IMAGES_BUCKET_NAME environment variable is not set');
     }
 
-    const imagePrefix = trainingMode ? 'catcam-training' : 'catcam-images';
+    const imagePrefix = mode === 'training' ? 'catcam-training' : mode === 'archive' ? 'catcam-archive' : 'catcam-images';
     const key = `${imagePrefix}/${timestamp}.jpg`;
 
     const putCommand = new PutObjectCommand({
@@ -265,6 +265,9 @@ export async function handler(event: APIGatewayProxyEvent, _context: Context): P
 
             // Check for training mode and Claude inference flag
             const trainingMode = event.queryStringParameters?.mode === 'training';
+            // Archive: full-resolution frame of a capture the device already
+            // classified from a smaller inference frame - store only
+            const archiveMode = event.queryStringParameters?.mode === 'archive';
             const claudeInfer = event.queryStringParameters?.claude === '1';
             if (trainingMode) {
                 logger.info('Training mode detected - will skip SageMaker inference');
@@ -365,13 +368,29 @@ export async function handler(event: APIGatewayProxyEvent, _context: Context): P
             // Save image to S3 bucket
             let s3ImageKey: string | null = null;
             try {
-                s3ImageKey = await saveImageToS3(imageBuffer, timestamp, trainingMode);
-                logger.info('Image saved to S3 successfully', { s3ImageKey, trainingMode });
+                s3ImageKey = await saveImageToS3(imageBuffer, timestamp,
+                    trainingMode ? 'training' : archiveMode ? 'archive' : 'inference');
+                logger.info('Image saved to S3 successfully', { s3ImageKey, trainingMode, archiveMode });
             } catch (s3Error) {
                 logger.error('Failed to save image to S3, continuing with inference', { error: s3Error });
                 // Continue with SageMaker inference even if S3 upload fails
             }
 
+            if (archiveMode) {
+                return {
+                    statusCode: s3ImageKey ? 200 : 500,
+                    headers: corsHeaders,
+                    body: JSON.stringify({
+                        success: !!s3ImageKey,
+                        mode: 'archive',
+                        metadata: {
+                            timestamp: new Date().toISOString(),
+                            s3ImageKey: s3ImageKey || null
+                        }
+                    })
+                };
+            }
+
             // If training mode, create catadata record and return early (skip SageMaker inference)
             if (trainingMode) {
                 logger.info('Training mode: skipping SageMaker inference');
@@ -0,0 +1,536 @@
+#!/usr/bin/env python3
+"""
+Quantise a model from train_device.py to int8 and write the catcam's
+on-device model file (BBM1), loaded from SPIFFS by the firmware's
+LocalInference library.
+
+Steps:
+  1. Flatten the Keras graph into a chain of convolution / depthwise /
+     pooling / dense layers, folding Rescaling, ZeroPadding, batch norm and
+     ReLU / ReLU6 into them (Dropout is dropped).
+  2. Calibrate activation ranges on validation images.
+  3. Quantise: weights symmetric per output channel, activations asymmetric
+     per tensor, bias with the input zero point folded in, Q31 multipliers -
+     the arithmetic of lib/LocalInference/src/Int8Kernels.cpp.
+  4. Run an int8 reference of those kernels (bit-exact with the firmware)
+     against the float model and report how often they agree.
+  5. Write model.bbm with a self-test vector the firmware checks at boot.
+
+Usage:
+    python export_for_device.py [--model-dir models_device] [--data data_multiclass] [--output model.bbm]
+
+Upload to the catcam's SPIFFS partition (see README.md).
+"""
+
+import argparse
+import json
+import math
+import struct
+from pathlib import Path
+
+import numpy as np
+import tensorflow as tf
+
+IMG_SIZE = (128, 128)
+INPUT_OFFSET = -128  # Firmware input: q = pixel + INPUT_OFFSET (scale 1 in pixel units)
+
+# LocalModel::LayerType
+CONV2D, DEPTHWISE, AVERAGE_POOL, MAX_POOL, GLOBAL_AVERAGE_POOL, DENSE = range(6)
+
+MAX_LAYERS = 64
+MAX_CLASSES = 8
+CLASS_NAME_LENGTH = 16
+HEADER_BYTES = 36
+LAYER_RECORD_BYTES = 32
+
+
+# ---------------------------------------------------------------------------
+# 1. Float layer chain
+# ---------------------------------------------------------------------------
+
+class Op:
+    """One firmware layer in float: weights already folded, activation clamp in real units."""
+
+    def __init__(self, kind, in_shape, kernel=(1, 1), stride=(1, 1), pads=(0, 0, 0, 0)):
+        self.kind = kind
+        self.in_shape = in_shape          # (H, W, C)
+        self.kernel = kernel
+        self.stride = stride
+        self.pads = list(pads)            # top, bottom, left, right
+        self.weights = None               # conv HWIO, depthwise HWC, dense (in, out)
+        self.bias = None
+        self.act = (-math.inf, math.inf)
+        self.pad_value = 0.0              # Input value that stands for real 0 (first layer: folded Rescaling)
+        self.out_shape = None
+
+
+def flatten_layers(model):
+    """Keras layers in order, nested models expanded."""
+    for layer in model.layers:
+        if isinstance(layer, tf.keras.Model):
+            yield from flatten_layers(layer)
+        else:
+            yield layer
+
+
+def same_padding(size, kernel, stride):
+    out = -(-size // stride)
+    total = max((out - 1) * stride + kernel - size, 0)
+    return out, total // 2, total - total // 2
+
+
+def activation_range(name):
+    return {"linear": (-math.inf, math.inf), "relu": (0.0, math.inf), "relu6": (0.0, 6.0),
+            "softmax": (-math.inf, math.inf)}.get(name)
+
+
+def build_ops(model):
+    """Fold the Keras graph into Ops; raises on anything the firmware cannot run."""
+    ops = []
+    shape = tuple(int(d) for d in model.input_shape[1:])
+    if shape != IMG_SIZE + (3,):
+        raise ValueError(f"Model input is {shape}, expected {IMG_SIZE + (3,)}")
+    rescale = (1.0, 0.0)
+    pending_pad = [0, 0, 0, 0]
+
+    for layer in flatten_layers(model):
+        kind = type(layer).__name__
+        if kind in ("Add", "Concatenate", "Multiply"):
+            raise ValueError(f"{layer.name}: branching graphs are not supported")
+
+        if kind in ("InputLayer", "Dropout"):
+            continue
+        if kind == "Rescaling":
+            if ops:
+                raise ValueError(f"{layer.name}: Rescaling is only supported before the first layer")
+            scale = float(np.asarray(layer.scale))
+            offset = float(np.asarray(layer.offset))
+            rescale = (rescale[0] * scale, rescale[1] * scale + offset)
+            continue
+        if kind == "ZeroPadding2D":
+            (top, bottom), (left, right) = layer.padding
+            pending_pad = [pending_pad[0] + top, pending_pad[1] + bottom, pending_pad[2] + left, pending_pad[3] + right]
+            shape = (shape[0] + top + bottom, shape[1] + left + right, shape[2])
+            continue
+        if kind in ("Flatten", "Reshape"):
+            shape = (1, 1, int(np.prod(shape)))
+            continue
+
+        if kind in ("Conv2D", "DepthwiseConv2D"):
+            depthwise = kind == "DepthwiseConv2D"
+            if tuple(layer.dilation_rate) != (1, 1) or getattr(layer, "groups", 1) != 1:
+                raise ValueError(f"{layer.name}: dilation and groups are not supported")
+            if depthwise and layer.depth_multiplier != 1:
+                raise ValueError(f"{layer.name}: depth multiplier must be 1")
+            kernel = np.asarray(layer.kernel if not depthwise else layer.depthwise_kernel, dtype=np.float64)
+            kh, kw = kernel.shape[:2]
+            sh, sw = layer.strides
+            h, w, c = shape
+            # ZeroPadding2D grew the shape; the firmware pads on the fly instead
+            h -= pending_pad[0] + pending_pad[1]
+            w -= pending_pad[2] + pending_pad[3]
+            pads = list(pending_pad)
+            if layer.padding == "same":
+                oh, pt, pb = same_padding(h + pads[0] + pads[1], kh, sh)
+                ow, pl, pr = same_padding(w + pads[2] + pads[3], kw, sw)
+                pads = [pads[0] + pt, pads[1] + pb, pads[2] + pl, pads[3] + pr]
+            else:
+                oh = (h + pads[0] + pads[1] - kh) // sh + 1
+                ow = (w + pads[2] + pads[3] - kw) // sw + 1
+            op = Op(DEPTHWISE if depthwise else CONV2D, (h, w, c), (kh, kw), (sh, sw), pads)
+            op.weights = kernel[:, :, :, 0] if depthwise else kernel
+            out_c = c if depthwise else kernel.shape[3]
+            op.bias = np.asarray(layer.bias, dtype=np.float64) if layer.use_bias else np.zeros(out_c)
+            op.act = activation_range(layer.activation.__name__)
+            if op.act is None or layer.activation.__name__ == "softmax":
+                raise ValueError(f"{layer.name}: unsupported activation {layer.activation.__name__}")
+            op.out_shape = (oh, ow, out_c)
+            pending_pad = [0, 0, 0, 0]
+        elif kind == "Dense":
+            op = Op(DENSE, shape)
+            op.weights = np.asarray(layer.kernel, dtype=np.float64)
+            out_c = op.weights.shape[1]
+            op.bias = np.asarray(layer.bias, dtype=np.float64) if layer.use_bias else np.zeros(out_c)
+            op.act = activation_range(layer.activation.__name__)
+            if op.act is None:
+                raise ValueError(f"{layer.name}: unsupported activation {layer.activation.__name__}")
+            if layer.activation.__name__ == "softmax" and layer is not model.layers[-1]:
+                raise ValueError(f"{layer.name}: softmax is only supported on the output layer")
+            op.out_shape = (1, 1, out_c)
+        elif kind == "GlobalAveragePooling2D":
+            op = Op(GLOBAL_AVERAGE_POOL, shape)
+            op.out_shape = (1, 1, shape[2])
+        elif kind in ("AveragePooling2D", "MaxPooling2D"):
+            if layer.padding != "valid":
+                raise ValueError(f"{layer.name}: only 'valid' pooling is supported")
+            kh, kw = layer.pool_size
+            sh, sw = layer.strides
+            op = Op(AVERAGE_POOL if kind == "AveragePooling2D" else MAX_POOL, shape, (kh, kw), (sh, sw))
+            op.out_shape = ((shape[0] - kh) // sh + 1, (shape[1] - kw) // sw + 1, shape[2])
+        elif kind == "BatchNormalization":
+            prev = ops[-1] if ops else None
+            if prev is None or prev.kind not in (CONV2D, DEPTHWISE, DENSE) or prev.act != (-math.inf, math.inf):
+                raise ValueError(f"{layer.name}: batch norm must directly follow a linear layer")
+            gamma = np.asarray(layer.gamma, dtype=np.float64) if layer.scale else 1.0
+            beta = np.asarray(layer.beta, dtype=np.float64) if layer.center else 0.0
+            scale = gamma / np.sqrt(np.asarray(layer.moving_variance, dtype=np.float64) + layer.epsilon)
+            prev.weights = prev.weights * scale  # Output channel is the last axis for every kind
+            prev.bias = (prev.bias - np.asarray(layer.moving_mean, dtype=np.float64)) * scale + beta
+            continue
+        elif kind in ("ReLU", "Activation"):
+            prev = ops[-1] if ops else None
+            if kind == "ReLU":
+                if float(layer.negative_slope) != 0.0 or float(layer.threshold) != 0.0:
+                    raise ValueError(f"{layer.name}: leaky / thresholded ReLU is not supported")
+                act = (0.0, math.inf if layer.max_value is None else float(layer.max_value))
+            else:
+                act = activation_range(layer.activation.__name__)
+                if act is None:
+                    raise ValueError(f"{layer.name}: unsupported activation {layer.activation.__name__}")
+            if prev is None or prev.kind not in (CONV2D, DEPTHWISE, DENSE):
+                raise ValueError(f"{layer.name}: activation must follow a convolution or dense layer")
+            prev.act = (max(prev.act[0], act[0]), min(prev.act[1], act[1]))
+            continue
+        else:
+            raise ValueError(f"{layer.name}: unsupported layer type {kind}")
+
+        ops.append(op)
+        shape = op.out_shape
+
+    if not ops or ops[0].kind not in (CONV2D, DEPTHWISE):
+        raise ValueError("The first layer must be a convolution")
+    if ops[-1].out_shape != (1, 1, ops[-1].out_shape[2]):
+        raise ValueError("The model must end in a 1x1 output")
+
+    # Fold Rescaling into the first layer: it now takes raw pixels, and padding
+    # uses the pixel value that rescales to 0
+    first = ops[0]
+    scale, offset = rescale
+    if first.kind == CONV2D:
+        first.bias = first.bias + offset * first.weights.sum(axis=(0, 1, 2))
+    else:
+        first.bias = first.bias + offset * first.weights.sum(axis=(0, 1))
+    first.weights = first.weights * scale
+    first.pad_value = -offset / scale
+    return ops
+
+
+# ---------------------------------------------------------------------------
+# Shared helpers for the float and int8 forward passes
+# ---------------------------------------------------------------------------
+
+def patches(x, op, pad_value):
+    """(outH, outW, kh, kw, C) windows of x (H, W, C), padded with pad_value."""
+    kh, kw = op.kernel
+    sh, sw = op.stride
+    oh, ow, _ = op.out_shape
+    top, _, left, _ = op.pads
+    h, w, c = x.shape
+    need_h = (oh - 1) * sh + kh
+    need_w = (ow - 1) * sw + kw
+    padded = np.full((need_h, need_w, c), pad_value, dtype=x.dtype)
+    src_y0, src_x0 = max(0, -top), max(0, -left)
+    dst_y0, dst_x0 = max(0, top), max(0, left)
+    copy_h = min(h - src_y0, need_h - dst_y0)
+    copy_w = min(w - src_x0, need_w - dst_x0)
+    padded[dst_y0:dst_y0 + copy_h, dst_x0:dst_x0 + copy_w] = x[src_y0:src_y0 + copy_h, src_x0:src_x0 + copy_w]
+    s0, s1, s2 = padded.strides
+    return np.lib.stride_tricks.as_strided(padded, (oh, ow, kh, kw, c), (s0 * sh, s1 * sw, s0, s1, s2))
+
+
+def float_forward(ops, pixels, record=None):
+    """Float pass on (H, W, 3) pixels in 0-255; record collects each op's output."""
+    x = pixels.astype(np.float64)
+    for op in ops:
+        if op.kind == CONV2D:
+            y = np.tensordot(patches(x, op, op.pad_value), op.weights, axes=([2, 3, 4], [0, 1, 2])) + op.bias
+        elif op.kind == DEPTHWISE:
+            y = np.einsum("yxijc,ijc->yxc", patches(x, op, op.pad_value), op.weights) + op.bias
+        elif op.kind == DENSE:
+            y = (x.reshape(-1) @ op.weights + op.bias).reshape(op.out_shape)
+        elif op.kind == GLOBAL_AVERAGE_POOL:
+            y = x.mean(axis=(0, 1)).reshape(op.out_shape)
+        elif op.kind == AVERAGE_POOL:
+            y = patches(x, op, 0.0).mean(axis=(2, 3))
+        else:
+            y = patches(x, op, 0.0).max(axis=(2, 3))
+        if op.kind in (CONV2D, DEPTHWISE, DENSE):
+            y = np.clip(y, op.act[0], op.act[1])
+        x = y
+        if record is not None:
+            record.append(x)
+    return x.reshape(-1)
+
+
+# ---------------------------------------------------------------------------
+# 2-3. Calibration and quantisation
+# ---------------------------------------------------------------------------
+
+def list_images(split_dir):
+    paths, labels = [], []
+    for class_dir in sorted(p for p in split_dir.iterdir() if p.is_dir()):
+        for fpath in sorted(class_dir.iterdir()):
+            if fpath.suffix.lower() in (".jpg", ".jpeg"):
+                paths.append(fpath)
+                labels.append(0 if class_dir.name == "Boots" else 1)
+    return paths, labels
+
+
+def load_pixels(path):
+    image = tf.image.decode_jpeg(tf.io.read_file(str(path)), channels=3)
+    resized = tf.image.resize(image, IMG_SIZE, method="bilinear")
+    return np.clip(np.round(resized.numpy()), 0, 255).astype(np.uint8)
+
+
+def quantize_multiplier(real):
+    """Q31 multiplier in [2^30, 2^31) and power-of-two shift with real = m * 2^shift / 2^31."""
+    if real <= 0:
+        return 0, 0
+    mantissa, shift = math.frexp(real)
+    q = int(round(mantissa * (1 << 31)))
+    if q == 1 << 31:
+        q //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    return q, shift
+
+
+class QuantParams:
+    def __init__(self, scale, zero_point):
+        self.scale = scale
+        self.zero_point = zero_point
+
+
+def activation_params(lo, hi):
+    lo, hi = min(lo, 0.0), max(hi, 0.0)
+    scale = max(hi - lo, 1e-8) / 255.0
+    zero_point = int(np.clip(round(-128 - lo / scale), -128, 127))
+    return QuantParams(scale, zero_point)
+
+
+def quantize(ops, ranges):
+    """Attach int8 weights / requant parameters to each op."""
+    in_q = QuantParams(1.0, INPUT_OFFSET)
+    for op, (lo, hi) in zip(ops, ranges):
+        op.in_q = in_q
+        op.pad_q = int(np.clip(round(op.pad_value / in_q.scale) + in_q.zero_point, -128, 127))
+        if op.kind in (CONV2D, DEPTHWISE, DENSE):
+            # Clamp the calibrated range to what the activation can produce
+            lo = max(lo, op.act[0])
+            hi = min(hi, op.act[1])
+            out_q = activation_params(lo, hi)
+            w = op.weights
+            w_max = np.abs(w.reshape(-1, w.shape[-1])).max(axis=0)
+            w_scale = np.where(w_max > 0, w_max / 127.0, 1.0)
+            op.weights_q = np.clip(np.round(w / w_scale), -127, 127).astype(np.int8)
+            bias_q = np.round(op.bias / (in_q.scale * w_scale)).astype(np.int64)
+            weight_sums = op.weights_q.reshape(-1, w.shape[-1]).astype(np.int64).sum(axis=0)
+            op.bias_q = bias_q - in_q.zero_point * weight_sums
+            if np.abs(op.bias_q).max() >= 2 ** 31:
+                raise ValueError("Bias overflows int32")
+            pairs = [quantize_multiplier(in_q.scale * s / out_q.scale) for s in w_scale]
+            op.multiplier = np.array([m for m, _ in pairs], dtype=np.int64)
+            op.shift = np.array([s for _, s in pairs], dtype=np.int64)
+            act_lo = -128 if op.act[0] == -math.inf else round(op.act[0] / out_q.scale) + out_q.zero_point
+            act_hi = 127 if op.act[1] == math.inf else round(op.act[1] / out_q.scale) + out_q.zero_point
+            op.act_q = (int(np.clip(act_lo, -128, 127)), int(np.clip(act_hi, -128, 127)))
+            op.out_q = out_q
+        else:
+            op.out_q = in_q  # Pools keep the input's scale and zero point
+            op.act_q = (-128, 127)
+        in_q = op.out_q
+
+
+# ---------------------------------------------------------------------------
+# 4. Int8 reference (Int8Kernels.cpp arithmetic)
+# ---------------------------------------------------------------------------
+
+def trunc_div(a, b):
+    """C integer division (rounds toward zero)."""
+    return np.sign(a) * (np.abs(a) // b)
+
+
+def multiply_by_quantized_multiplier(x, multiplier, shift):
+    left = np.maximum(shift, 0)
+    right = np.maximum(-shift, 0)
+    x = x * (np.int64(1) << left)
+    ab = x * multiplier
+    nudge = np.where(ab >= 0, 1 << 30, 1 - (1 << 30))
+    high = trunc_div(ab + nudge, 1 << 31)
+    mask = (np.int64(1) << right) - 1
+    remainder = high & mask
+    threshold = (mask >> 1) + (high < 0)
+    return (high >> right) + (remainder > threshold)
+
+
+def requantize(acc, op):
+    y = multiply_by_quantized_multiplier(acc + op.bias_q, op.multiplier, op.shift) + op.out_q.zero_point
+    return np.clip(y, op.act_q[0], op.act_q[1])
+
+
+def int8_forward(ops, q_input):
+    x = q_input.astype(np.int64)
+    for op in ops:
+        if op.kind == CONV2D:
+            acc = np.tensordot(patches(x, op, op.pad_q), op.weights_q.astype(np.int64), axes=([2, 3, 4], [0, 1, 2]))
+            y = requantize(acc, op)
+        elif op.kind == DEPTHWISE:
+            acc = np.einsum("yxijc,ijc->yxc", patches(x, op, op.pad_q), op.weights_q.astype(np.int64))
+            y = requantize(acc, op)
+        elif op.kind == DENSE:
+            acc = x.reshape(-1) @ op.weights_q.astype(np.int64)
+            y = requantize(acc, op).reshape(op.out_shape)
+        elif op.kind in (GLOBAL_AVERAGE_POOL, AVERAGE_POOL):
+            windows = x[np.newaxis, np.newaxis] if op.kind == GLOBAL_AVERAGE_POOL else patches(x, op, 0)
+            total = windows.sum(axis=(2, 3))
+            count = windows.shape[2] * windows.shape[3]
+            y = trunc_div(total + np.where(total > 0, count // 2, -(count // 2)), count).reshape(op.out_shape)
+        else:
+            y = patches(x, op, -128).max(axis=(2, 3))
+        x = y.astype(np.int64)
+    return x.reshape(-1).astype(np.int8)
+
+
+# ---------------------------------------------------------------------------
+# 5. BBM1 writer
+# ---------------------------------------------------------------------------
+
+def align(buf):
+    buf.extend(b"\0" * (-len(buf) % 4))
+
+
+def write_model(path, ops, class_names, self_test_input, self_test_output):
+    body = bytearray()
+    body.extend(b"\0" * HEADER_BYTES)
+    for name in class_names:
+        encoded = name.encode()[:CLASS_NAME_LENGTH - 1]
+        body.extend(encoded + b"\0" * (CLASS_NAME_LENGTH - len(encoded)))
+    align(body)
+    records_at = len(body)
+    body.extend(b"\0" * (LAYER_RECORD_BYTES * len(ops)))
+
+    for i, op in enumerate(ops):
+        weights_offset = params_offset = 0
+        if op.kind in (CONV2D, DEPTHWISE, DENSE):
+            if op.kind == CONV2D:
+                weights = op.weights_q.transpose(3, 0, 1, 2)  # HWIO -> [out][kh][kw][in]
+            elif op.kind == DEPTHWISE:
+                weights = op.weights_q                        # [kh][kw][C]
+            else:
+                weights = op.weights_q.T                      # [out][in]
+            align(body)
+            weights_offset = len(body)
+            body.extend(np.ascontiguousarray(weights).astype(np.int8).tobytes())
+            align(body)
+            params_offset = len(body)
+            body.extend(op.bias_q.astype("<i4").tobytes())
+            body.extend(op.multiplier.astype("<i4").tobytes())
+            body.extend(op.shift.astype(np.int8).tobytes())
+        kh, kw = op.kernel
+        sh, sw = op.stride
+        oh, ow, oc = op.out_shape
+        struct.pack_into("<8B4b3HH3I", body, records_at + i * LAYER_RECORD_BYTES,
+                         op.kind, kh, kw, sh, sw, op.pads[0], op.pads[2], 0,
+                         op.pad_q, op.out_q.zero_point if op.kind in (CONV2D, DEPTHWISE, DENSE) else 0,
+                         op.act_q[0], op.act_q[1],
+                         oh, ow, oc, 0, weights_offset, params_offset, 0)
+
+    align(body)
+    self_test_offset = len(body)
+    body.extend(self_test_input.astype(np.int8).tobytes())
+    body.extend(self_test_output.astype(np.int8).tobytes())
+    align(body)
+
+    h, w, c = ops[0].in_shape
+    out_q = ops[-1].out_q
+    struct.pack_into("<4sHH4HhHfiII", body, 0, b"BBM1", 1, len(ops), h, w, c, len(class_names),
+                     INPUT_OFFSET, 0, out_q.scale, out_q.zero_point, self_test_offset, len(body))
+    Path(path).write_bytes(bytes(body))
+    return len(body)
+
+
+# ---------------------------------------------------------------------------
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Quantise the on-device model and write model.bbm")
+    parser.add_argument("--model-dir", default="models_device",
+                        help="Directory with best_model.keras and class_names.json (default: models_device)")
+    parser.add_argument("--data", default="data_multiclass", help="Data directory (default: data_multiclass)")
+    parser.add_argument("--calibration", type=int, default=200, help="Validation images used for calibration")
+    parser.add_argument("--output", default="model.bbm", help="Output path (default: model.bbm)")
+    args = parser.parse_args()
+
+    model_dir = Path(args.model_dir)
+    class_names = json.loads((model_dir / "class_names.json").read_text())
+    if not class_names or class_names[0] != "Boots":
+        raise SystemExit(f"class_names[0] must be 'Boots' (the firmware's deterrent index), got {class_names}")
+    if not 2 <= len(class_names) <= MAX_CLASSES:
+        raise SystemExit(f"Between 2 and {MAX_CLASSES} classes are supported")
+
+    model = tf.keras.models.load_model(str(model_dir / "best_model.keras"))
+    ops = build_ops(model)
+    if len(ops) > MAX_LAYERS:
+        raise SystemExit(f"{len(ops)} layers - the firmware supports {MAX_LAYERS}")
+    if ops[-1].out_shape[2] != len(class_names):
+        raise SystemExit("Model outputs do not match class_names.json")
+
+    paths, labels = list_images(Path(args.data) / "validation")
+    if not paths:
+        raise SystemExit(f"No validation images under {args.data}/validation")
+    rng = np.random.default_rng(42)
+    order = rng.permutation(len(paths))
+    images = [load_pixels(paths[i]) for i in order]
+    labels = [labels[i] for i in order]
+
+    # The folded chain must reproduce Keras before anything is quantised
+    keras_logits = model.predict(np.stack(images[:8]).astype(np.float32), verbose=0)
+    ours = np.stack([float_forward(ops, image) for image in images[:8]])
+    if model.layers[-1].activation.__name__ != "softmax":
+        drift = np.abs(keras_logits - ours).max()
+        print(f"Folded float model vs Keras: max difference {drift:.2e}")
+        if drift > 1e-2:
+            raise SystemExit("Layer folding does not reproduce the Keras model")
+
+    print(f"Calibrating on {min(args.calibration, len(images))} images...")
+    lows = [math.inf] * len(ops)
+    highs = [-math.inf] * len(ops)
+    for image in images[:args.calibration]:
+        record = []
+        float_forward(ops, image, record)
+        for i, y in enumerate(record):
+            lows[i] = min(lows[i], float(y.min()))
+            highs[i] = max(highs[i], float(y.max()))
+    quantize(ops, list(zip(lows, highs)))
+
+    print(f"Evaluating float vs int8 on {len(images)} images...")
+    agree = float_correct = int8_correct = 0
+    for image, label in zip(images, labels):
+        float_top = int(np.argmax(float_forward(ops, image)))
+        int8_top = int(np.argmax(int8_forward(ops, image.astype(np.int16) + INPUT_OFFSET)))
+        agree += float_top == int8_top
+        float_correct += float_top == label
+        int8_correct += int8_top == label
+    n = len(images)
+    print(f"  float accuracy {float_correct / n:.3f}, int8 accuracy {int8_correct / n:.3f}, "
+          f"agreement {agree / n:.3f}")
+
+    self_test_input = (images[0].astype(np.int16) + INPUT_OFFSET).astype(np.int8)
+    self_test_output = int8_forward(ops, self_test_input)
+    size = write_model(args.output, ops, class_names, self_test_input, self_test_output)
+
+    macs = 0
+    for op in ops:
+        kh, kw = op.kernel
+        if op.kind == CONV2D:
+            macs += int(np.prod(op.out_shape)) * kh * kw * op.in_shape[2]
+        elif op.kind == DEPTHWISE:
+            macs += int(np.prod(op.out_shape)) * kh * kw
+        elif op.kind == DENSE:
+            macs += int(np.prod(op.in_shape)) * op.out_shape[2]
+    print(f"\nWrote {args.output}: {len(ops)} layers, {macs / 1e6:.1f}M MACs, {size / 1024:.0f} KB")
+    print("Upload it to the catcam's SPIFFS partition as /model.bbm (see README.md)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+BootBoots - On-device Model Training Script (M-series Mac)
+
+Trains a small Boots / NotBoots classifier for the catcam itself: MobileNetV1
+(alpha 0.25, ImageNet pretrained) at 128x128, about 13M multiply-accumulates
+per image. export_for_device.py quantises it to int8 for the firmware's
+LocalInference library.
+
+Uses the data_multiclass/ layout from download_data_multiclass.py; every
+class other than Boots becomes NotBoots.
+
+Run with:
+    python train_device.py
+    python export_for_device.py
+
+Requires Python 3.11 and:
+    pip install tensorflow-macos tensorflow-metal
+"""
+
+import argparse
+import json
+from pathlib import Path
+
+import tensorflow as tf
+from tensorflow.keras import callbacks, layers, optimizers
+from tensorflow.keras.applications import MobileNet
+
+IMG_SIZE = (128, 128)  # Matches the model input the firmware resizes to
+ALPHA = 0.25
+CLASS_NAMES = ["Boots", "NotBoots"]  # Index 0 must be Boots (the firmware's deterrent index)
+
+
+def list_images(split_dir: Path) -> tuple[list[str], list[int]]:
+    """Image paths under split_dir/<class>/ labelled 0 (Boots) or 1 (anything else)."""
+    paths, labels = [], []
+    for class_dir in sorted(p for p in split_dir.iterdir() if p.is_dir()):
+        label = 0 if class_dir.name == "Boots" else 1
+        for fpath in sorted(class_dir.iterdir()):
+            if fpath.suffix.lower() in (".jpg", ".jpeg"):
+                paths.append(str(fpath))
+                labels.append(label)
+    return paths, labels
+
+
+def load_image(path: tf.Tensor) -> tf.Tensor:
+    """Decode and resize the way the firmware does (bilinear, half-pixel centres), keeping 0-255."""
+    image = tf.image.decode_jpeg(tf.io.read_file(path), channels=3)
+    return tf.image.resize(image, IMG_SIZE, method="bilinear")
+
+
+def make_dataset(paths: list[str], labels: list[int], batch_size: int, training: bool) -> tf.data.Dataset:
+    ds = tf.data.Dataset.from_tensor_slices((paths, labels))
+    if training:
+        ds = ds.shuffle(len(paths), seed=42, reshuffle_each_iteration=True)
+    ds = ds.map(lambda p, y: (load_image(p), tf.one_hot(y, len(CLASS_NAMES))),
+                num_parallel_calls=tf.data.AUTOTUNE)
+    ds = ds.batch(batch_size)
+    if training:
+        augment = make_augmentation_layer()
+        ds = ds.map(lambda x, y: (augment(x, training=True), y), num_parallel_calls=tf.data.AUTOTUNE)
+    return ds.prefetch(tf.data.AUTOTUNE)
+
+
+def make_augmentation_layer() -> tf.keras.Sequential:
+    """Same augmentation as train_multiclass.py, in the data pipeline so the model exports cleanly."""
+    return tf.keras.Sequential([
+        layers.RandomFlip("horizontal"),
+        layers.RandomRotation(0.15),
+        layers.RandomZoom((-0.3, 0.0)),
+        layers.RandomContrast(0.2),
+        layers.RandomBrightness(0.2, value_range=(0, 255)),
+    ], name="augmentation")
+
+
+def build_model(dropout_rate: float) -> tuple[tf.keras.Model, tf.keras.Model]:
+    """
+    Only layers export_for_device.py understands: Rescaling, MobileNet's conv /
+    depthwise / batch norm / ReLU6 stack, global average pooling, dropout and a
+    dense head that outputs logits (the firmware applies the softmax).
+    """
+    base_model = MobileNet(input_shape=IMG_SIZE + (3,), alpha=ALPHA, include_top=False, weights="imagenet")
+    base_model.trainable = False
+
+    inputs = tf.keras.Input(shape=IMG_SIZE + (3,))
+    x = layers.Rescaling(1.0 / 127.5, offset=-1.0)(inputs)  # MobileNet expects [-1, 1]
+    x = base_model(x, training=False)
+    x = layers.GlobalAveragePooling2D()(x)
+    x = layers.Dropout(dropout_rate)(x)
+    outputs = layers.Dense(len(CLASS_NAMES))(x)
+    return tf.keras.Model(inputs, outputs), base_model
+
+
+def compile_model(model: tf.keras.Model, learning_rate: float) -> None:
+    model.compile(
+        optimizer=optimizers.Adam(learning_rate=learning_rate),
+        loss=tf.keras.losses.CategoricalCrossentropy(from_logits=True),
+        metrics=["accuracy"],
+    )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Train the BootBoots on-device Boots/NotBoots classifier")
+    parser.add_argument("--data", default="data_multiclass", help="Data directory (default: data_multiclass)")
+    parser.add_argument("--output", default="models_device", help="Output directory (default: models_device)")
+    parser.add_argument("--epochs", type=int, default=20, help="Epochs with the base frozen (default: 20)")
+    parser.add_argument("--fine-tune-epochs", type=int, default=30,
+                        help="Further epochs with the whole network trainable (default: 30, 0 = skip)")
+    parser.add_argument("--batch-size", type=int, default=32, help="Batch size (default: 32)")
+    parser.add_argument("--dropout", type=float, default=0.2, help="Dropout rate (default: 0.2)")
+    parser.add_argument("--lr", type=float, default=0.001, help="Learning rate for the head (default: 0.001)")
+    parser.add_argument("--patience", type=int, default=8, help="Early stopping patience (default: 8)")
+    args = parser.parse_args()
+
+    data_dir = Path(args.data)
+    output_dir = Path(args.output)
+    output_dir.mkdir(parents=True, exist_ok=True)
+
+    train_paths, train_labels = list_images(data_dir / "training")
+    val_paths, val_labels = list_images(data_dir / "validation")
+    if not train_paths:
+        print(f"ERROR: No training images under {data_dir / 'training'}")
+        print("Run download_data_multiclass.py first.")
+        raise SystemExit(1)
+
+    boots = train_labels.count(0)
+    not_boots = len(train_labels) - boots
+    print(f"Training: {boots} Boots, {not_boots} NotBoots; validation: {len(val_paths)} images")
+    class_weight = {0: len(train_labels) / (2 * max(boots, 1)), 1: len(train_labels) / (2 * max(not_boots, 1))}
+
+    train_ds = make_dataset(train_paths, train_labels, args.batch_size, training=True)
+    val_ds = make_dataset(val_paths, val_labels, args.batch_size, training=False).cache()
+
+    model, base_model = build_model(args.dropout)
+    model.summary()
+
+    best_path = output_dir / "best_model.keras"
+    cb_list = [
+        callbacks.EarlyStopping(monitor="val_accuracy", patience=args.patience, min_delta=0.001,
+                                restore_best_weights=True, verbose=1),
+        callbacks.ModelCheckpoint(str(best_path), monitor="val_accuracy", save_best_only=True, verbose=1),
+    ]
+
+    print(f"\nTraining the head for up to {args.epochs} epochs...")
+    compile_model(model, args.lr)
+    model.fit(train_ds, validation_data=val_ds, epochs=args.epochs, callbacks=cb_list, class_weight=class_weight)
+
+    if args.fine_tune_epochs > 0:
+        # Batch norm statistics stay frozen (training=False above) so small batches don't disturb them
+        print(f"\nFine-tuning the whole network for up to {args.fine_tune_epochs} epochs...")
+        base_model.trainable = True
+        compile_model(model, args.lr / 10)
+        model.fit(train_ds, validation_data=val_ds, epochs=args.fine_tune_epochs, callbacks=cb_list,
+                  class_weight=class_weight)
+
+    (output_dir / "class_names.json").write_text(json.dumps(CLASS_NAMES))
+    loss, accuracy = model.evaluate(val_ds, verbose=0)
+    print(f"\nBest model : {best_path}")
+    print(f"Validation accuracy: {accuracy:.4f}  ({accuracy * 100:.1f}%), loss {loss:.4f}")
+    print("Next: python export_for_device.py")
+
+
+if __name__ == "__main__":
+    main()